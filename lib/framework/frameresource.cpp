@@ -31,9 +31,14 @@
 
 #include "file.h"
 #include "resly.h"
+#include "wzapp.h"
 
 #include <list>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
 
 // Local prototypes
 static std::list<RES_TYPE *> psResTypes;
@@ -51,6 +56,32 @@ static void ResetResourceFile();
 // callback to resload screen.
 static RESLOAD_CALLBACK resLoadCallback = nullptr;
 
+/// Result of the prepare function of a resource type, for one file.
+struct RES_PREPARED
+{
+	void *pPrepared = nullptr;
+	bool success = false;
+	std::chrono::microseconds duration{0};
+};
+
+/// A file listed in the .wrf being loaded, waiting for its load function to be called.
+struct RES_PENDING
+{
+	RES_TYPE *psT;
+	std::string type;
+	std::string id;        ///< As listed in the .wrf (e.g. "TRON.PIE")
+	std::string fileName;  ///< Including the resource directory, and localized.
+	wz::packaged_task<RES_PREPARED()> prepareTask;  ///< Only if psT->prepare
+	wz::future<RES_PREPARED> prepared;
+};
+
+#define MAX_RESLOAD_THREADS 15
+
+// the files listed by the .wrf being parsed, if any (resLoadFile only lists them then)
+static std::vector<RES_PENDING> *pendingResources = nullptr;
+// the prepared data for the file being loaded, see resTakePreparedData()
+static void *currentPreparedData = nullptr;
+
 
 /* next four used in HashPJW */
 #define	BITS_IN_int		32
@@ -184,6 +215,34 @@ void resSetBaseDir(const char *pResDir)
 	sstrcpy(aResDir, pResDir);
 }
 
+static bool resLoadPending(RES_PENDING &pending, void *pPrepared);
+
+/// Runs the prepare tasks of pending resources, in order.
+struct RES_PREPARE_QUEUE
+{
+	std::vector<RES_PENDING *> tasks;
+	std::atomic<size_t> nextTask{0};
+
+	/// Runs the next task, if any.
+	bool runNext()
+	{
+		const size_t task = nextTask++;
+		if (task >= tasks.size())
+		{
+			return false;
+		}
+		tasks[task]->prepareTask();
+		return true;
+	}
+};
+
+static int resPrepareThreadFunc(void *pQueue)
+{
+	RES_PREPARE_QUEUE *queue = static_cast<RES_PREPARE_QUEUE *>(pQueue);
+	while (queue->runNext()) {}
+	return 0;
+}
+
 /* Parse the res file */
 bool resLoad(const char *pResFile, SDWORD blockID)
 {
@@ -206,17 +265,96 @@ bool resLoad(const char *pResFile, SDWORD blockID)
 		return false;
 	}
 
-	// and parse it
+	// and parse it, which lists the files to load
+	std::vector<RES_PENDING> resources;
+	std::vector<RES_PENDING> *prevPendingResources = pendingResources;
+	pendingResources = &resources;
 	res_set_extra(&input);
 	if (res_parse() != 0)
 	{
 		debug(LOG_FATAL, "Failed to parse %s", pResFile);
 		retval = false;
 	}
+	pendingResources = prevPendingResources;
 
 	res_lex_destroy();
 	PHYSFS_close(input.input.physfsfile);
 
+	// Prepare what can be prepared on worker threads, while the main thread loads the files in order
+	const auto startTime = std::chrono::steady_clock::now();
+	RES_PREPARE_QUEUE queue;
+	for (RES_PENDING &pending : resources)
+	{
+		if (pending.psT->prepare != nullptr)
+		{
+			RES_FILEPREPARE prepare = pending.psT->prepare;
+			const std::string *pFileName = &pending.fileName;
+			pending.prepareTask = wz::packaged_task<RES_PREPARED()>([prepare, pFileName]() {
+				RES_PREPARED result;
+				const auto prepareStart = std::chrono::steady_clock::now();
+				result.success = prepare(pFileName->c_str(), &result.pPrepared);
+				result.duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - prepareStart);
+				return result;
+			});
+			pending.prepared = pending.prepareTask.get_future();
+			queue.tasks.push_back(&pending);
+		}
+	}
+	std::vector<WZ_THREAD *> threads;
+	if (queue.tasks.size() > 1)
+	{
+		// subtract one for the main thread, which also prepares files when it has to wait for them
+		const size_t numThreads = std::min<size_t>({std::max<size_t>(wzGetLogicalCPUCount(), 1) - 1, MAX_RESLOAD_THREADS, queue.tasks.size()});
+		for (size_t i = 0; i < numThreads; ++i)
+		{
+			threads.push_back(wzThreadCreate(resPrepareThreadFunc, &queue, "wzResLoad"));
+			wzThreadStart(threads.back());
+		}
+	}
+
+	std::chrono::microseconds totalPrepareDuration{0};
+	std::chrono::microseconds totalLoadDuration{0};
+	size_t nextQueued = 0;
+	bool loadFailed = false;
+	for (RES_PENDING &pending : resources)
+	{
+		RES_PREPARED prepared;
+		if (pending.psT->prepare != nullptr)
+		{
+			// Don't wait for a task no thread has started yet
+			while (queue.nextTask <= nextQueued && queue.runNext()) {}
+			++nextQueued;
+			prepared = pending.prepared.get();
+			if (!prepared.success)
+			{
+				debug(LOG_WZ, "resLoad: Failed to prepare %s \"%s\", loading it on the main thread", pending.type.c_str(), pending.id.c_str());
+			}
+		}
+		const auto loadStart = std::chrono::steady_clock::now();
+		if (!loadFailed && !resLoadPending(pending, prepared.pPrepared))
+		{
+			// Don't load the rest (but still wait for the prepare tasks, and release what they prepared).
+			loadFailed = true;
+			retval = false;
+		}
+		else if (loadFailed && prepared.pPrepared != nullptr && pending.psT->releasePrepared != nullptr)
+		{
+			pending.psT->releasePrepared(prepared.pPrepared);
+		}
+		const auto loadDuration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - loadStart);
+		debug(LOG_WZ, "resLoad: %s \"%s\": prepared in %.2f ms, loaded in %.2f ms", pending.type.c_str(), pending.id.c_str(), prepared.duration.count() / 1000.0, loadDuration.count() / 1000.0);
+		totalPrepareDuration += prepared.duration;
+		totalLoadDuration += loadDuration;
+	}
+
+	for (WZ_THREAD *thread : threads)
+	{
+		wzThreadJoin(thread);
+	}
+	const auto totalDuration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime);
+	debug(LOG_WZ, "resLoad: %s: %zu files in %.2f ms (%zu prepared on %zu worker threads in %.2f ms of CPU time, %.2f ms of loading on the main thread)",
+	      pResFile, resources.size(), totalDuration.count() / 1000.0, queue.tasks.size(), threads.size(), totalPrepareDuration.count() / 1000.0, totalLoadDuration.count() / 1000.0);
+
 	return retval;
 }
 
@@ -256,6 +394,22 @@ bool resAddBufferLoad(const char *pType, RES_BUFFERLOAD buffLoad, RES_FREE relea
 }
 
 
+static RES_TYPE *resFindType(const char *pType)
+{
+	UDWORD HashedType = HashString(pType);
+	auto resTypeIt = std::find_if(psResTypes.begin(), psResTypes.end(), [pType, HashedType](const RES_TYPE* psT)
+	{
+		if (psT->HashedType == HashedType)
+		{
+			ASSERT(strcmp(psT->aType, pType) == 0, "Hash collision \"%s\" vs \"%s\"", psT->aType, pType);
+			return true;
+		}
+		return false;
+	});
+	return resTypeIt != psResTypes.end() ? *resTypeIt : nullptr;
+}
+
+
 /* Add a file name load function for a file type */
 bool resAddFileLoad(const char *pType, RES_FILELOAD fileLoad, RES_FREE release)
 {
@@ -270,6 +424,25 @@ bool resAddFileLoad(const char *pType, RES_FILELOAD fileLoad, RES_FREE release)
 	return true;
 }
 
+/* Add a prepare function for a file type */
+bool resAddFilePrepare(const char *pType, RES_FILEPREPARE prepare, RES_FREE releasePrepared)
+{
+	RES_TYPE *psT = resFindType(pType);
+	ASSERT_OR_RETURN(false, psT != nullptr && psT->fileLoad != nullptr, "No file load function for type: %s", pType);
+
+	psT->prepare = prepare;
+	psT->releasePrepared = releasePrepared;
+
+	return true;
+}
+
+void *resTakePreparedData()
+{
+	void *pPrepared = currentPreparedData;
+	currentPreparedData = nullptr;
+	return pPrepared;
+}
+
 // Make a string lower case
 void resToLower(char *pStr)
 {
@@ -349,7 +522,7 @@ static SDWORD FindEmptyResourceFile()
 
 
 // Get a resource data file ... either loads it or just returns a pointer
-static bool RetreiveResourceFile(char *ResourceName, RESOURCEFILE **NewResource)
+static bool RetreiveResourceFile(const char *ResourceName, RESOURCEFILE **NewResource)
 {
 	SDWORD ResID;
 	RESOURCEFILE *ResData;
@@ -459,36 +632,10 @@ static void makeLocaleFile(char *fileName, size_t maxlen)  // given string must
 }
 
 
-/*!
- * Call the load function (registered in data.c)
- * for this filetype
- */
-bool resLoadFile(const char *pType, const char *pFile)
+// Check for duplicates
+static bool resIsDuplicate(const RES_TYPE *psT, const char *pFile)
 {
-	void		*pData = nullptr;
-	char		aFileName[PATH_MAX];
-	UDWORD HashedName, HashedType = HashString(pType);
-
-	// Find the resource-type
-	auto resTypeIt = std::find_if(psResTypes.begin(), psResTypes.end(), [pType, HashedType](const RES_TYPE* psT)
-	{
-		if (psT->HashedType == HashedType)
-		{
-			ASSERT(strcmp(psT->aType, pType) == 0, "Hash collision \"%s\" vs \"%s\"", psT->aType, pType);
-			return true;
-		}
-		return false;
-	});
-
-	if (resTypeIt == psResTypes.end())
-	{
-		debug(LOG_WZ, "resLoadFile: Unknown type: %s", pType);
-		return false;
-	}
-	RES_TYPE* psT = *resTypeIt;
-
-	// Check for duplicates
-	HashedName = HashStringIgnoreCase(pFile);
+	UDWORD HashedName = HashStringIgnoreCase(pFile);
 	for (const RES_DATA* psRes : psT->psRes)
 	{
 		if (psRes->HashedID == HashedName)
@@ -496,22 +643,20 @@ bool resLoadFile(const char *pType, const char *pFile)
 			ASSERT(strcasecmp(psRes->aID, pFile) == 0, "Hash collision \"%s\" vs \"%s\"", psRes->aID, pFile);
 			debug(LOG_WZ, "Duplicate file name: %s (hash %x) for type %s",
 			      pFile, HashedName, psT->aType);
-			// assume that they are actually both the same and silently fail
-			// lovely little hack to allow some files to be loaded from disk (believe it or not!).
 			return true;
 		}
 	}
+	return false;
+}
 
-	// Create the file name
-	if (strlen(aCurrResDir) + strlen(pFile) + 1 >= PATH_MAX)
-	{
-		debug(LOG_ERROR, "resLoadFile: Filename too long!! %s%s", aCurrResDir, pFile);
-		return false;
-	}
-	sstrcpy(aFileName, aCurrResDir);
-	sstrcat(aFileName, pFile);
-
-	makeLocaleFile(aFileName, sizeof(aFileName));  // check for translated file
+/*!
+ * Call the load function (registered in data.c) for this filetype,
+ * with the data of its prepare function, if any
+ */
+static bool resLoadFileImpl(RES_TYPE *psT, const char *pFile, const char *aFileName, void *pPrepared)
+{
+	void		*pData = nullptr;
+	const char *pType = psT->aType;
 
 	SetLastResourceFilename(pFile); // Save the filename in case any routines need it
 
@@ -544,7 +689,16 @@ bool resLoadFile(const char *pType, const char *pFile)
 	else if (psT->fileLoad)
 	{
 		// Process data directly from file
-		if (!psT->fileLoad(aFileName, &pData))
+		void *outerPreparedData = currentPreparedData;  // In case a load function loads another file
+		currentPreparedData = pPrepared;
+		bool success = psT->fileLoad(aFileName, &pData);
+		if (currentPreparedData != nullptr && psT->releasePrepared != nullptr)
+		{
+			// Not taken by the load function
+			psT->releasePrepared(currentPreparedData);
+		}
+		currentPreparedData = outerPreparedData;
+		if (!success)
 		{
 			ASSERT(false, "The load function for resource type \"%s\" failed for file \"%s\"", pType, pFile);
 			if (psT->release != nullptr)
@@ -577,6 +731,70 @@ bool resLoadFile(const char *pType, const char *pFile)
 	return true;
 }
 
+static bool resLoadPending(RES_PENDING &pending, void *pPrepared)
+{
+	if (resIsDuplicate(pending.psT, pending.id.c_str()))
+	{
+		// assume that they are actually both the same and silently fail
+		if (pPrepared != nullptr && pending.psT->releasePrepared != nullptr)
+		{
+			pending.psT->releasePrepared(pPrepared);
+		}
+		return true;
+	}
+	return resLoadFileImpl(pending.psT, pending.id.c_str(), pending.fileName.c_str(), pPrepared);
+}
+
+/*!
+ * Call the load function (registered in data.c)
+ * for this filetype
+ */
+bool resLoadFile(const char *pType, const char *pFile)
+{
+	char		aFileName[PATH_MAX];
+
+	// Find the resource-type
+	RES_TYPE *psT = resFindType(pType);
+	if (psT == nullptr)
+	{
+		debug(LOG_WZ, "resLoadFile: Unknown type: %s", pType);
+		return false;
+	}
+
+	// Check for duplicates (when parsing a .wrf, that's done when it's loaded)
+	if (pendingResources == nullptr && resIsDuplicate(psT, pFile))
+	{
+		// assume that they are actually both the same and silently fail
+		// lovely little hack to allow some files to be loaded from disk (believe it or not!).
+		return true;
+	}
+
+	// Create the file name
+	if (strlen(aCurrResDir) + strlen(pFile) + 1 >= PATH_MAX)
+	{
+		debug(LOG_ERROR, "resLoadFile: Filename too long!! %s%s", aCurrResDir, pFile);
+		return false;
+	}
+	sstrcpy(aFileName, aCurrResDir);
+	sstrcat(aFileName, pFile);
+
+	makeLocaleFile(aFileName, sizeof(aFileName));  // check for translated file
+
+	if (pendingResources != nullptr)
+	{
+		// Parsing a .wrf: resLoad() loads it once the whole list is known
+		RES_PENDING pending;
+		pending.psT = psT;
+		pending.type = pType;
+		pending.id = pFile;
+		pending.fileName = aFileName;
+		pendingResources->push_back(std::move(pending));
+		return true;
+	}
+
+	return resLoadFileImpl(psT, pFile, aFileName, nullptr);
+}
+
 /* Return the resource for a type and hashedname */
 void *resGetDataFromHash(const char *pType, UDWORD HashedID)
 {
@@ -41,6 +41,11 @@ typedef bool (*RES_FILELOAD)(const char *pFile, void **pData);
 /** Function pointer for releasing a resource loaded by the above functions. */
 typedef void (*RES_FREE)(void *pData);
 
+/** Function pointer for a function that does the thread-safe part of loading a file
+ *  (reading, decoding, parsing) ahead of time, on a worker thread.
+ *  The result is available to the load function with resTakePreparedData(). */
+typedef bool (*RES_FILEPREPARE)(const char *pFile, void **ppPrepared);
+
 /** callback type for resload display callback. */
 typedef void (*RESLOAD_CALLBACK)();
 
@@ -72,6 +77,9 @@ struct RES_TYPE
 	UDWORD	HashedType;				// hashed version of the name of the id - // a null hashedtype indicates end of list
 
 	RES_FILELOAD	fileLoad;		// This isn't really used any more ?
+
+	RES_FILEPREPARE prepare = nullptr;		// optional, run on a worker thread before fileLoad
+	RES_FREE releasePrepared = nullptr;		// releases prepared data fileLoad didn't take (NULL indicates none)
 };
 
 
@@ -109,6 +117,14 @@ WZ_DECL_NONNULL(1) bool resAddBufferLoad(const char *pType, RES_BUFFERLOAD buffL
 /** Add a file name load and release function for a file type. */
 WZ_DECL_NONNULL(1) bool resAddFileLoad(const char *pType, RES_FILELOAD fileLoad, RES_FREE release);
 
+/** Add a prepare function for a file type, which must have a file load function.
+ *  When loading a .wrf, the prepare functions run on worker threads, while the load functions
+ *  still run on the main thread, in order. */
+WZ_DECL_NONNULL(1, 2) bool resAddFilePrepare(const char *pType, RES_FILEPREPARE prepare, RES_FREE releasePrepared);
+
+/** In a file load function, takes the data of the prepare function for the file, if any (or NULL). */
+void *resTakePreparedData();
+
 /** Call the load function for a file. */
 WZ_DECL_NONNULL(1, 2) bool resLoadFile(const char *pType, const char *pFile);
 
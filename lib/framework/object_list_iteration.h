@@ -38,11 +38,14 @@ enum class IterationResult
 ///
 /// Currently two callable signatures are supported:
 /// * `IterationResult(ObjectType*)`
-/// * `IterationResult(std::list<ObjectType*>::iterator)`
+/// * `IterationResult(ListType::iterator)`
 ///
 /// The latter overload is convenient when one needs to erase from or
 /// insert into the list being iterated directly inside the handler's body,
 /// avoiding additional lookups to obtain an iterator to the current element.
+///
+/// `ListType` is either `std::list<ObjectType*>` or any container with the same
+/// iterator invalidation rules, e.g. `PagedObjectList<ObjectType>`.
 /// </summary>
 /// <typeparam name="Callable">
 /// Can either be a function pointer or a lambda expression (or any other callable).
@@ -61,27 +64,27 @@ struct LoopBodyHandlerCallStrategy
 	//
 	// Choosing the correct overload is done via `std::enable_if<Cond, T>` helper from <type_traits>,
 	// which basically provides `using type = T` only when `Cond` is `true`.
-	template <typename ObjectType>
+	template <typename ListType>
 	static constexpr bool handler_accepts_ptr = std::is_convertible<
 		Callable,
-		std::function<IterationResult(ObjectType*)>>::value;
-	template <typename ObjectType>
+		std::function<IterationResult(typename ListType::value_type)>>::value;
+	template <typename ListType>
 	static constexpr bool handler_accepts_iter = std::is_convertible<
 		Callable,
-		std::function<IterationResult(typename std::list<ObjectType*>::iterator)>>::value;
+		std::function<IterationResult(typename ListType::iterator)>>::value;
 
 	// `Invoke` overload for Callable taking a list iterator as the argument
-	template <typename ObjectType>
-	static std::enable_if_t<handler_accepts_iter<ObjectType>, IterationResult>
-		Invoke(Callable handler, typename std::list<ObjectType*>::iterator iter)
+	template <typename ListType>
+	static std::enable_if_t<handler_accepts_iter<ListType>, IterationResult>
+		Invoke(Callable handler, typename ListType::iterator iter)
 	{
 		return handler(iter);
 	}
 
 	// `Invoke` overload for Callable taking a pointer to `ObjectType` as the argument
-	template <typename ObjectType>
-	static std::enable_if_t<handler_accepts_ptr<ObjectType>, IterationResult>
-		Invoke(Callable handler, typename std::list<ObjectType*>::iterator iter)
+	template <typename ListType>
+	static std::enable_if_t<handler_accepts_ptr<ListType>, IterationResult>
+		Invoke(Callable handler, typename ListType::iterator iter)
 	{
 		return handler(*iter);
 	}
@@ -90,14 +93,14 @@ struct LoopBodyHandlerCallStrategy
 // Common iteration helper for lists of game objects
 // with an ability to execute loop body handlers which can
 // possibly invalidate the any iterator in the range `[begin(), currentIterator]`.
-template <typename ObjectType, typename MaybeErasingLoopBodyHandler>
-void mutating_list_iterate(std::list<ObjectType*>& list, MaybeErasingLoopBodyHandler handler)
+template <typename ListType, typename MaybeErasingLoopBodyHandler>
+void mutating_list_iterate(ListType& list, MaybeErasingLoopBodyHandler handler)
 {
 	using HandlerCallStrategy = LoopBodyHandlerCallStrategy<MaybeErasingLoopBodyHandler>;
 
 	static_assert(
-		   HandlerCallStrategy::template handler_accepts_ptr<ObjectType>
-		|| HandlerCallStrategy::template handler_accepts_iter<ObjectType>,
+		   HandlerCallStrategy::template handler_accepts_ptr<ListType>
+		|| HandlerCallStrategy::template handler_accepts_iter<ListType>,
 		"Unsupported loop body handler signature: "
 		"should return IterationResult and take either an ObjectType* or an iterator");
 
@@ -111,7 +114,7 @@ void mutating_list_iterate(std::list<ObjectType*>& list, MaybeErasingLoopBodyHan
 	{
 		itNext = std::next(it);
 		// Can possibly invalidate `it` and anything before it.
-		const auto res = HandlerCallStrategy::template Invoke<ObjectType>(handler, it);
+		const auto res = HandlerCallStrategy::template Invoke<ListType>(handler, it);
 		if (res == IterationResult::BREAK_ITERATION)
 		{
 			break;
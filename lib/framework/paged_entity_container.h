@@ -382,6 +382,17 @@ public:
 
 	template <typename... Args>
 	T& emplace(Args&&... args)
+	{
+		SlotIndexType slot;
+		return emplace_with_slot(slot, std::forward<Args>(args)...);
+	}
+
+	/// <summary>
+	/// Same as `emplace()`, but also stores the global slot index of the new element in `slot`,
+	/// so that it can later be passed to `erase(SlotIndexType)` without searching the pages.
+	/// </summary>
+	template <typename... Args>
+	T& emplace_with_slot(SlotIndexType& slot, Args&&... args)
 	{
 		// Find first page with free slots available,
 		// record found page index,
@@ -398,6 +409,7 @@ public:
 			// Construct the element.
 			T* res = allocate_element_impl(page_index_to_storage_addr(pageIdx), std::forward<Args>(args)...);
 			++_size;
+			slot = page_index_to_global(pageIdx);
 			return *res;
 		}
 		if (_size == usable_capacity())
@@ -411,6 +423,7 @@ public:
 		// Construct the element.
 		T* res = allocate_element_impl(page_index_to_storage_addr(newIdx), std::forward<Args>(args)...);
 		++_size;
+		slot = _maxIndex;
 		return *res;
 	}
 
@@ -724,6 +737,12 @@ public:
 		{
 			erase(it);
 		}
+		if (_pages.empty())
+		{
+			// Constructed without capacity (or swapped with such a container),
+			// `emplace()` allocates the first page.
+			return;
+		}
 		// Shrink the storage to just a single page.
 		_pages.resize(1);
 		_capacity = MaxElementsPerPage;
@@ -745,6 +764,16 @@ public:
 		_expiredSlotsCount = 0;
 	}
 
+	// Exchanges the pages of both containers. Elements keep their addresses.
+	void swap(PagedEntityContainer& other) noexcept
+	{
+		_pages.swap(other._pages);
+		std::swap(_maxIndex, other._maxIndex);
+		std::swap(_size, other._size);
+		std::swap(_capacity, other._capacity);
+		std::swap(_expiredSlotsCount, other._expiredSlotsCount);
+	}
+
 private:
 
 	PageIndex allocate_new_idx()
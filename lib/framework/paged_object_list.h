@@ -0,0 +1,431 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2024  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file paged_object_list.h
+ * Ordered list of pointers to in-game objects, with the nodes
+ * packed into the pages of a `PagedEntityContainer`.
+ */
+#pragma once
+
+#include "paged_entity_container.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <cassert>
+#include <initializer_list>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/// <summary>
+/// Drop-in replacement for `std::list<ObjectType*>`, used for the per-player lists of game objects.
+///
+/// Elements are kept in a doubly-linked list, so the order of elements and the validity
+/// of iterators are exactly the same as for `std::list`: inserting never invalidates
+/// iterators, and erasing only invalidates iterators to the erased element.
+/// This matters, since the order in which objects are updated must be the same on all clients.
+///
+/// Unlike `std::list`, the nodes are not allocated one by one, but packed into the pages
+/// of a `PagedEntityContainer`, which recycles the slots of erased nodes. Iterating thus
+/// touches a few contiguous pages instead of nodes scattered all over the heap.
+///
+/// Each list also keeps an index from object pointers to nodes (open addressing,
+/// no allocations per element), so `remove()` and `find()` by value are `O(1)` on average,
+/// instead of searching the whole list.
+///
+/// Each object may only be in a given list once.
+/// </summary>
+/// <typeparam name="ObjectType">Type of the objects pointed to by the elements.</typeparam>
+/// <typeparam name="NodesPerPage">The fixed number of nodes each page may hold.</typeparam>
+template <typename ObjectType, size_t NodesPerPage = 128>
+class PagedObjectList
+{
+	struct Node
+	{
+		ObjectType* object;
+		Node* prev;
+		Node* next;
+		size_t slot; ///< Slot of the node in `_nodes`, so erasing doesn't have to search for it.
+	};
+
+public:
+
+	using value_type = ObjectType*;
+	using size_type = size_t;
+	using difference_type = ptrdiff_t;
+	using reference = value_type&;
+	using const_reference = const value_type&;
+	using pointer = value_type*;
+	using const_pointer = const value_type*;
+
+	template <bool IsConst>
+	class IteratorImpl
+	{
+	public:
+
+		using iterator_category = std::bidirectional_iterator_tag;
+		using value_type = ObjectType*;
+		using difference_type = ptrdiff_t;
+		using reference = std::conditional_t<IsConst, ObjectType* const&, ObjectType*&>;
+		using pointer = std::conditional_t<IsConst, ObjectType* const*, ObjectType**>;
+
+		IteratorImpl() = default;
+		explicit IteratorImpl(Node* node) : _node(node) {}
+
+		// Allow promotion of non-const iterator to const iterator.
+		template <bool DummyConst = IsConst, std::enable_if_t<DummyConst, bool> = true>
+		IteratorImpl(const IteratorImpl<false>& other) : _node(other._node) {}
+
+		bool operator==(const IteratorImpl& other) const { return _node == other._node; }
+		bool operator!=(const IteratorImpl& other) const { return _node != other._node; }
+
+		reference operator*() const { return _node->object; }
+		pointer operator->() const { return &_node->object; }
+
+		IteratorImpl& operator++() { _node = _node->next; return *this; }
+		IteratorImpl operator++(int) { IteratorImpl copy(*this); _node = _node->next; return copy; }
+		IteratorImpl& operator--() { _node = _node->prev; return *this; }
+		IteratorImpl operator--(int) { IteratorImpl copy(*this); _node = _node->prev; return copy; }
+
+	private:
+
+		template <bool IsConst2>
+		friend class IteratorImpl;
+
+		friend class PagedObjectList;
+
+		Node* _node = nullptr;
+	};
+
+	using iterator = IteratorImpl<false>;
+	using const_iterator = IteratorImpl<true>;
+	using reverse_iterator = std::reverse_iterator<iterator>;
+	using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+	PagedObjectList()
+		: _nodes(NodesPerPage)
+	{
+		_head.object = nullptr;
+		_head.prev = _head.next = &_head;
+	}
+
+	PagedObjectList(std::initializer_list<ObjectType*> objects)
+		: PagedObjectList()
+	{
+		for (ObjectType* object : objects)
+		{
+			push_back(object);
+		}
+	}
+
+	PagedObjectList(const PagedObjectList& other)
+		: PagedObjectList()
+	{
+		*this = other;
+	}
+
+	PagedObjectList& operator=(const PagedObjectList& other)
+	{
+		if (this != &other)
+		{
+			clear();
+			for (ObjectType* object : other)
+			{
+				push_back(object);
+			}
+		}
+		return *this;
+	}
+
+	/// Takes over the pages of `other`, which is left empty (and without pages until the next insertion).
+	PagedObjectList(PagedObjectList&& other) noexcept
+		: _nodes(0)
+	{
+		_head.object = nullptr;
+		_head.prev = _head.next = &_head;
+		swap(other);
+	}
+
+	PagedObjectList& operator=(PagedObjectList&& other) noexcept
+	{
+		if (this != &other)
+		{
+			PagedObjectList moved(std::move(other));
+			swap(moved);
+		}
+		return *this;
+	}
+
+	/// Exchanges the elements of both lists in `O(1)`, without copying or allocating nodes.
+	/// Iterators stay valid, but refer to the other list afterwards (except `end()`).
+	void swap(PagedObjectList& other) noexcept
+	{
+		_nodes.swap(other._nodes);
+		std::swap(_head, other._head);
+		std::swap(_size, other._size);
+		_index.swap(other._index);
+		std::swap(_indexUsed, other._indexUsed);
+		relinkHead();
+		other.relinkHead();
+	}
+
+	friend void swap(PagedObjectList& a, PagedObjectList& b) noexcept
+	{
+		a.swap(b);
+	}
+
+	iterator begin() { return iterator(_head.next); }
+	iterator end() { return iterator(&_head); }
+	const_iterator begin() const { return const_iterator(_head.next); }
+	const_iterator end() const { return const_iterator(const_cast<Node*>(&_head)); }
+	const_iterator cbegin() const { return begin(); }
+	const_iterator cend() const { return end(); }
+	reverse_iterator rbegin() { return reverse_iterator(end()); }
+	reverse_iterator rend() { return reverse_iterator(begin()); }
+	const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+	const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+	bool empty() const { return _size == 0; }
+	size_t size() const { return _size; }
+
+	reference front() { assert(!empty()); return _head.next->object; }
+	const_reference front() const { assert(!empty()); return _head.next->object; }
+	reference back() { assert(!empty()); return _head.prev->object; }
+	const_reference back() const { assert(!empty()); return _head.prev->object; }
+
+	iterator insert(const_iterator pos, ObjectType* object)
+	{
+		if ((_indexUsed + 1) * 2 > _index.size())
+		{
+			indexRebuild();
+		}
+		Node* next = pos._node;
+		size_t slot;
+		Node& node = _nodes.emplace_with_slot(slot, Node{object, next->prev, next, 0});
+		node.slot = slot;
+		next->prev->next = &node;
+		next->prev = &node;
+		++_size;
+		indexInsert(&node);
+		return iterator(&node);
+	}
+	iterator emplace(const_iterator pos, ObjectType* object) { return insert(pos, object); }
+
+	void push_front(ObjectType* object) { insert(begin(), object); }
+	void push_back(ObjectType* object) { insert(end(), object); }
+	reference emplace_front(ObjectType* object) { return *insert(begin(), object); }
+	reference emplace_back(ObjectType* object) { return *insert(end(), object); }
+	void pop_front() { erase(begin()); }
+	void pop_back() { erase(iterator(_head.prev)); }
+
+	iterator erase(const_iterator pos)
+	{
+		Node* node = pos._node;
+		assert(node != &_head);
+		Node* next = node->next;
+		node->prev->next = next;
+		next->prev = node->prev;
+		--_size;
+		indexErase(node);
+		_nodes.erase(node->slot);
+		return iterator(next);
+	}
+
+	iterator erase(const_iterator first, const_iterator last)
+	{
+		while (first != last)
+		{
+			first = erase(first);
+		}
+		return iterator(last._node);
+	}
+
+	/// Returns the position of object, or `end()` if not in the list. Average complexity is `O(1)`.
+	iterator find(const ObjectType* object)
+	{
+		Node* node = indexFind(object);
+		return node != nullptr ? iterator(node) : end();
+	}
+	const_iterator find(const ObjectType* object) const
+	{
+		return const_cast<PagedObjectList*>(this)->find(object);
+	}
+
+	bool contains(const ObjectType* object) const
+	{
+		return const_cast<PagedObjectList*>(this)->indexFind(object) != nullptr;
+	}
+
+	/// Removes object, if in the list. Average complexity is `O(1)`.
+	size_t remove(const ObjectType* object)
+	{
+		Node* node = indexFind(object);
+		if (node == nullptr)
+		{
+			return 0;
+		}
+		erase(const_iterator(node));
+		return 1;
+	}
+
+	template <typename Predicate>
+	size_t remove_if(Predicate pred)
+	{
+		size_t removed = 0;
+		for (auto it = begin(); it != end();)
+		{
+			if (pred(*it))
+			{
+				it = erase(it);
+				++removed;
+			}
+			else
+			{
+				++it;
+			}
+		}
+		return removed;
+	}
+
+	void reverse()
+	{
+		Node* node = &_head;
+		do
+		{
+			std::swap(node->prev, node->next);
+			node = node->prev;  // Was next.
+		} while (node != &_head);
+	}
+
+	void clear()
+	{
+		_nodes.clear();
+		_head.prev = _head.next = &_head;
+		_size = 0;
+		_index.clear();
+		_indexUsed = 0;
+	}
+
+private:
+
+	/// Marks erased entries of the index, which must not end a probe sequence.
+	/// Shared by all lists, so that `swap()` doesn't need to rewrite the index.
+	static Node* tombstone()
+	{
+		static Node sentinel = {nullptr, nullptr, nullptr};
+		return &sentinel;
+	}
+
+	/// Points the first and last nodes back at our own sentinel, after `swap()` exchanged them.
+	void relinkHead()
+	{
+		if (_size == 0)
+		{
+			_head.prev = _head.next = &_head;
+		}
+		else
+		{
+			_head.next->prev = &_head;
+			_head.prev->next = &_head;
+		}
+	}
+
+	static size_t hashObject(const ObjectType* object)
+	{
+		// Objects are at least 8-byte aligned, and Fibonacci hashing spreads the remaining bits.
+		return static_cast<size_t>((reinterpret_cast<uintptr_t>(object) >> 3) * UINT64_C(0x9E3779B97F4A7C15) >> 17);
+	}
+
+	Node* indexFind(const ObjectType* object)
+	{
+		if (_index.empty())
+		{
+			return nullptr;
+		}
+		const size_t mask = _index.size() - 1;
+		for (size_t i = hashObject(object) & mask; _index[i] != nullptr; i = (i + 1) & mask)
+		{
+			if (_index[i] != tombstone() && _index[i]->object == object)
+			{
+				return _index[i];
+			}
+		}
+		return nullptr;
+	}
+
+	/// Requires a free entry, see `insert()`.
+	void indexInsert(Node* node)
+	{
+		const size_t mask = _index.size() - 1;
+		size_t i = hashObject(node->object) & mask;
+		while (_index[i] != nullptr && _index[i] != tombstone())
+		{
+			assert(_index[i]->object != node->object && "Object is already in the list");
+			i = (i + 1) & mask;
+		}
+		if (_index[i] == nullptr)
+		{
+			++_indexUsed;  // Reusing a tombstone doesn't use another entry.
+		}
+		_index[i] = node;
+	}
+
+	void indexErase(Node* node)
+	{
+		const size_t mask = _index.size() - 1;
+		size_t i = hashObject(node->object) & mask;
+		while (_index[i] != node)
+		{
+			assert(_index[i] != nullptr);
+			i = (i + 1) & mask;
+		}
+		_index[i] = tombstone();
+	}
+
+	/// Resizes the index to fit twice the current size, dropping the tombstones.
+	void indexRebuild()
+	{
+		size_t capacity = 16;
+		while (capacity < (_size + 1) * 4)
+		{
+			capacity *= 2;
+		}
+		_index.assign(capacity, nullptr);
+		_indexUsed = 0;
+		const size_t mask = capacity - 1;
+		for (Node* node = _head.next; node != &_head; node = node->next)
+		{
+			size_t i = hashObject(node->object) & mask;
+			while (_index[i] != nullptr)
+			{
+				i = (i + 1) & mask;
+			}
+			_index[i] = node;
+			++_indexUsed;
+		}
+	}
+
+	PagedEntityContainer<Node, NodesPerPage> _nodes;
+	Node _head;                   ///< Sentinel, `end()` points here.
+	size_t _size = 0;
+	std::vector<Node*> _index;    ///< Nodes by hashObject(), `nullptr` if empty.
+	size_t _indexUsed = 0;        ///< Entries of `_index` which are not `nullptr`, including tombstones.
+};
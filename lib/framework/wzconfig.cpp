@@ -29,6 +29,9 @@
 #include <sstream>
 #include <limits>
 #include "physfs_ext.h"
+#include "wzapp.h"
+#include <mutex>
+#include <unordered_map>
 
 WzConfig::~WzConfig()
 {
@@ -96,34 +99,37 @@ WzConfig::WzConfig(const WzString &name, WzConfig::warning warning)
 			return;
 		}
 	}
-	if (!loadFile(name.toUtf8().c_str(), &data, &size))
+	if (!takePreloadedDocument(name, mRoot))
 	{
-		mStatus = false;
-		debug(LOG_FATAL, "Could not open \"%s\"", name.toUtf8().c_str());
-		return;
-	}
-	ASSERT_OR_RETURN(, data != nullptr, "Null data?");
+		if (!loadFile(name.toUtf8().c_str(), &data, &size))
+		{
+			mStatus = false;
+			debug(LOG_FATAL, "Could not open \"%s\"", name.toUtf8().c_str());
+			return;
+		}
+		ASSERT_OR_RETURN(, data != nullptr, "Null data?");
 
-	try {
-		mRoot = nlohmann::json::parse(data, data + size);
-	}
-	catch (const std::exception &e) {
-		ASSERT(false, "JSON document from %s is invalid: %s", name.toUtf8().c_str(), e.what());
-	}
-	catch (...) {
-		debug(LOG_FATAL, "Unexpected exception parsing JSON %s", name.toUtf8().c_str());
-	}
-	pCurrentObj = &mRoot;
-	ASSERT(!mRoot.is_null(), "JSON document from %s is null", name.toUtf8().c_str());
-	if (!mRoot.is_object())
-	{
-		ASSERT(mRoot.is_object(), "JSON document from %s is not an object. Read: \n%s", name.toUtf8().c_str(), data);
-		mRoot = nlohmann::json::object();
-		mStatus = false;
+		try {
+			mRoot = nlohmann::json::parse(data, data + size);
+		}
+		catch (const std::exception &e) {
+			ASSERT(false, "JSON document from %s is invalid: %s", name.toUtf8().c_str(), e.what());
+		}
+		catch (...) {
+			debug(LOG_FATAL, "Unexpected exception parsing JSON %s", name.toUtf8().c_str());
+		}
+		pCurrentObj = &mRoot;
+		ASSERT(!mRoot.is_null(), "JSON document from %s is null", name.toUtf8().c_str());
+		if (!mRoot.is_object())
+		{
+			ASSERT(mRoot.is_object(), "JSON document from %s is not an object. Read: \n%s", name.toUtf8().c_str(), data);
+			mRoot = nlohmann::json::object();
+			mStatus = false;
+			free(data);
+			return;
+		}
 		free(data);
-		return;
 	}
-	free(data);
 	WZ_PHYSFS_enumerateFolders("diffs", [&](const char *i) -> bool {
 		std::string str(std::string("diffs/") + i + std::string("/") + name.toUtf8().c_str());
 		if (!PHYSFS_exists(str.c_str()))
@@ -163,6 +169,57 @@ WzConfig::WzConfig(const WzString &name, WzConfig::warning warning)
 	pCurrentObj = &mRoot;
 }
 
+// Documents parsed by preloadDocument(), by file name
+static std::unordered_map<std::string, nlohmann::json> preloadedDocuments;
+static wz::mutex preloadedDocumentsMutex;
+
+bool WzConfig::preloadDocument(const WzString &name)
+{
+	const std::string fileName = name.toStdString();
+	std::vector<char> data;
+	if (!loadFileToBufferVector(fileName.c_str(), data, false, false))
+	{
+		return false;
+	}
+	nlohmann::json root;
+	try {
+		root = nlohmann::json::parse(data.begin(), data.end());
+	}
+	catch (const std::exception &) {
+		return false;  // Reported when the main thread parses it.
+	}
+	if (!root.is_object())
+	{
+		return false;
+	}
+	std::lock_guard<wz::mutex> lock(preloadedDocumentsMutex);
+	preloadedDocuments[fileName] = std::move(root);
+	return true;
+}
+
+void WzConfig::discardPreloadedDocument(const WzString &name)
+{
+	std::lock_guard<wz::mutex> lock(preloadedDocumentsMutex);
+	preloadedDocuments.erase(name.toStdString());
+}
+
+bool WzConfig::takePreloadedDocument(const WzString &name, nlohmann::json &output)
+{
+	std::lock_guard<wz::mutex> lock(preloadedDocumentsMutex);
+	if (preloadedDocuments.empty())
+	{
+		return false;
+	}
+	auto it = preloadedDocuments.find(name.toStdString());
+	if (it == preloadedDocuments.end())
+	{
+		return false;
+	}
+	output = std::move(it->second);
+	preloadedDocuments.erase(it);
+	return true;
+}
+
 bool WzConfig::isAtDocumentRoot() const
 {
 	return pCurrentObj == &mRoot;
@@ -114,6 +114,17 @@ public:
 	WzConfig(const WzString &name, WzConfig::warning warning);
 	~WzConfig();
 
+	/// Reads and parses the file ahead of time, from any thread, so that the next WzConfig
+	/// opened for it doesn't have to. Returns false if that failed (leaving it to the WzConfig).
+	static bool preloadDocument(const WzString &name);
+	/// Forgets the document of preloadDocument(), if no WzConfig used it.
+	static void discardPreloadedDocument(const WzString &name);
+
+private:
+	static bool takePreloadedDocument(const WzString &name, nlohmann::json &output);
+
+public:
+
 	Vector3f vector3f(const WzString &name);
 	void setVector3f(const WzString &name, const Vector3f &v);
 	Vector3i vector3i(const WzString &name);
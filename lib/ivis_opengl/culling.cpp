@@ -21,7 +21,11 @@
 #include <array>
 #include <glm/glm.hpp>
 #include <algorithm>
-#include <functional>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# define WZ_CULLING_SSE2
+# include <emmintrin.h>
+#endif
 
 BoundingBox transformBoundingBox(const glm::mat4& worldViewProjectionMatrix, const BoundingBox& worldSpaceBoundingBox)
 {
@@ -35,20 +39,78 @@ BoundingBox transformBoundingBox(const glm::mat4& worldViewProjectionMatrix, con
 	return bboxInClipSpace;
 }
 
+ClipSpaceBounds clipSpaceBounds(const BoundingBox& clipSpaceBoundingBox, bool yAxisInverted)
+{
+	ClipSpaceBounds bounds = {clipSpaceBoundingBox[0], clipSpaceBoundingBox[0]};
+	for (size_t i = 1, end = clipSpaceBoundingBox.size(); i < end; i++)
+	{
+		bounds.min = glm::min(bounds.min, clipSpaceBoundingBox[i]);
+		bounds.max = glm::max(bounds.max, clipSpaceBoundingBox[i]);
+	}
+	if (yAxisInverted)
+	{
+		std::swap(bounds.min.y, bounds.max.y);
+		bounds.min.y = -bounds.min.y;
+		bounds.max.y = -bounds.max.y;
+	}
+	return bounds;
+}
+
+void ClipSpaceBoundsList::clear()
+{
+	minX.clear(); minY.clear(); minZ.clear();
+	maxX.clear(); maxY.clear(); maxZ.clear();
+}
 
-bool isBBoxInClipSpace(const IntersectionOfHalfSpace& intersectionOfHalfSpace, const BoundingBox& points)
+void ClipSpaceBoundsList::reserve(size_t count)
 {
-	// We test against the complement of the half space
-	// If all points lies in the complement a half space, it can't be part of the intersection
-	auto CheckAllPointsInSpace = [&points](const HalfSpaceCheck& predicate)
-		{
-			return std::all_of(points.begin(), points.end(), [&predicate](const auto& v) { return !predicate(v); });
-		};
+	minX.reserve(count); minY.reserve(count); minZ.reserve(count);
+	maxX.reserve(count); maxY.reserve(count); maxZ.reserve(count);
+}
 
-	for (const auto& predicate : intersectionOfHalfSpace)
+void ClipSpaceBoundsList::push_back(const ClipSpaceBounds& bounds)
+{
+	minX.push_back(bounds.min.x); minY.push_back(bounds.min.y); minZ.push_back(bounds.min.z);
+	maxX.push_back(bounds.max.x); maxY.push_back(bounds.max.y); maxZ.push_back(bounds.max.z);
+}
+
+void ClipSpaceBoundsList::set(size_t index, const ClipSpaceBounds& bounds)
+{
+	minX[index] = bounds.min.x; minY[index] = bounds.min.y; minZ[index] = bounds.min.z;
+	maxX[index] = bounds.max.x; maxY[index] = bounds.max.y; maxZ[index] = bounds.max.z;
+}
+
+ClipSpaceBounds ClipSpaceBoundsList::operator[](size_t index) const
+{
+	return {glm::vec3(minX[index], minY[index], minZ[index]), glm::vec3(maxX[index], maxY[index], maxZ[index])};
+}
+
+void ClipSpaceBoundsList::intersect(const ClipSpaceBounds& region, std::vector<uint8_t>& visible) const
+{
+	const size_t count = size();
+	visible.resize(count);
+	size_t i = 0;
+#if defined(WZ_CULLING_SSE2)
+	const __m128 regionMinX = _mm_set1_ps(region.min.x), regionMaxX = _mm_set1_ps(region.max.x);
+	const __m128 regionMinY = _mm_set1_ps(region.min.y), regionMaxY = _mm_set1_ps(region.max.y);
+	const __m128 regionMinZ = _mm_set1_ps(region.min.z), regionMaxZ = _mm_set1_ps(region.max.z);
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 inside = _mm_and_ps(_mm_cmpge_ps(_mm_loadu_ps(&maxX[i]), regionMinX), _mm_cmple_ps(_mm_loadu_ps(&minX[i]), regionMaxX));
+		inside = _mm_and_ps(inside, _mm_and_ps(_mm_cmpge_ps(_mm_loadu_ps(&maxY[i]), regionMinY), _mm_cmple_ps(_mm_loadu_ps(&minY[i]), regionMaxY)));
+		inside = _mm_and_ps(inside, _mm_and_ps(_mm_cmpge_ps(_mm_loadu_ps(&maxZ[i]), regionMinZ), _mm_cmple_ps(_mm_loadu_ps(&minZ[i]), regionMaxZ)));
+		const int mask = _mm_movemask_ps(inside);
+		visible[i] = mask & 1;
+		visible[i + 1] = (mask >> 1) & 1;
+		visible[i + 2] = (mask >> 2) & 1;
+		visible[i + 3] = (mask >> 3) & 1;
+	}
+#endif
+	// The rest (or all of it, without SSE2 - simple enough for the compiler to vectorize)
+	for (; i < count; i++)
 	{
-		if (CheckAllPointsInSpace(predicate))
-			return false;
+		visible[i] = (maxX[i] >= region.min.x) & (minX[i] <= region.max.x)
+			& (maxY[i] >= region.min.y) & (minY[i] <= region.max.y)
+			& (maxZ[i] >= region.min.z) & (minZ[i] <= region.max.z);
 	}
-	return true;
 }
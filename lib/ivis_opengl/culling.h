@@ -21,18 +21,54 @@
 #pragma once
 
 #include <array>
+#include <vector>
+#include <stdint.h>
 #include <glm/glm.hpp>
-#include <algorithm>
-#include <functional>
 
 using BoundingBox = std::array<glm::vec3, 8>;
 
 /// Project a bounding box in clip space
 BoundingBox transformBoundingBox(const glm::mat4& worldViewProjectionMatrix, const BoundingBox& worldSpaceBoundingBox);
 
-/// Define a half space
-using HalfSpaceCheck = std::function<bool(const glm::vec3&)>;
-/// Define a view frustum (as an intersection of half space
-using IntersectionOfHalfSpace = std::array< HalfSpaceCheck, 6>;
+/// An axis aligned box in clip space, with y pointing up the screen
+/// (e.g. the view frustum, a part of it, or the bounds of a projected bounding box)
+struct ClipSpaceBounds
+{
+	glm::vec3 min;
+	glm::vec3 max;
+};
 
-bool isBBoxInClipSpace(const IntersectionOfHalfSpace& intersectionOfHalfSpace, const BoundingBox& points);
+/// The bounds of a bounding box projected with transformBoundingBox()
+ClipSpaceBounds clipSpaceBounds(const BoundingBox& clipSpaceBoundingBox, bool yAxisInverted);
+
+/// The part of clip space shown on screen
+const ClipSpaceBounds viewFrustumClipSpaceBounds = {glm::vec3(-1.f, -1.f, 0.f), glm::vec3(1.f, 1.f, 1.f)};
+
+/// Whether the bounds overlap the region. Since the region is axis aligned too, this is exact:
+/// the bounds are outside iff all the corners of the projected box are outside one of its faces.
+inline bool clipSpaceBoundsIntersect(const ClipSpaceBounds& bounds, const ClipSpaceBounds& region)
+{
+	return bounds.max.x >= region.min.x && bounds.min.x <= region.max.x
+		&& bounds.max.y >= region.min.y && bounds.min.y <= region.max.y
+		&& bounds.max.z >= region.min.z && bounds.min.z <= region.max.z;
+}
+
+/// The clip space bounds of a list of objects, stored as one array per coordinate,
+/// so that they can all be tested against a region in one go (4 at a time with SSE2).
+class ClipSpaceBoundsList
+{
+public:
+	void clear();
+	void reserve(size_t count);
+	size_t size() const { return minX.size(); }
+	void push_back(const ClipSpaceBounds& bounds);
+	void set(size_t index, const ClipSpaceBounds& bounds);
+	ClipSpaceBounds operator[](size_t index) const;
+
+	/// Sets visible[i] to 1 if the bounds i overlap the region, and to 0 otherwise
+	void intersect(const ClipSpaceBounds& region, std::vector<uint8_t>& visible) const;
+
+private:
+	std::vector<float> minX, minY, minZ;
+	std::vector<float> maxX, maxY, maxZ;
+};
@@ -75,4 +75,8 @@ void debugReloadAllDisplayModels();
 size_t getModelLoadingErrorCount();
 size_t getModelTextureLoadingFailuresCount();
 
+/// Parses the .pie file data with the text loader, reads it back through the binary model cache, and checks that
+/// both give the same levels, field by field. For --check-model-cache (doesn't touch the GPU, the model list, or the cache dir).
+bool modelCacheSelfCheck(const WzString &filename, const char *pFileData, size_t fileSize);
+
 #endif
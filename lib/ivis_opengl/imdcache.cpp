@@ -0,0 +1,389 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2025  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/**
+ * @file imdcache.cpp
+ *
+ * The file is a header and the version string of the game, followed by flat arrays, in the
+ * native byte order and struct layout (which the header records), so reading it is little
+ * more than a few memcpy()s.
+ */
+
+#include "imdcache.h"
+
+#include "lib/framework/frame.h"
+#include "lib/framework/file.h"
+#include "lib/framework/physfs_ext.h"
+#include "src/version.h"
+
+#include <cstring>
+#include <type_traits>
+
+#define IMD_CACHE_DIR "cache/models"
+// Bump when the loader in imdload.cpp, or the layout below, changes what ends up in the cache.
+#define IMD_CACHE_FORMAT_VERSION 2
+
+static const char imdCacheMagic[4] = {'W', 'Z', 'M', 'C'};
+static const uint32_t imdCacheByteOrderMark = 0x01020304;
+// More levels than this are surely a corrupt file.
+static const uint32_t imdCacheMaxLevels = 1024;
+
+static_assert(std::is_trivially_copyable<Vector3f>::value, "Vector3f must be trivially copyable");
+static_assert(std::is_trivially_copyable<Vector3i>::value, "Vector3i must be trivially copyable");
+static_assert(std::is_trivially_copyable<iIMDPoly>::value, "iIMDPoly must be trivially copyable");
+static_assert(std::is_trivially_copyable<ANIMFRAME>::value, "ANIMFRAME must be trivially copyable");
+
+struct IMDCacheHeader
+{
+	char magic[4];
+	uint32_t formatVersion;
+	uint32_t byteOrderMark;
+	uint16_t sizeOfPoly;
+	uint16_t sizeOfAnimFrame;
+	uint16_t sizeOfFloat;
+	uint16_t levelCount;
+};
+
+class IMDCacheWriter
+{
+public:
+	template <typename T>
+	void value(const T &v)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Only plain data can be written as is");
+		const uint8_t *pBytes = reinterpret_cast<const uint8_t *>(&v);
+		data.insert(data.end(), pBytes, pBytes + sizeof(T));
+	}
+
+	template <typename T>
+	void array(const std::vector<T> &v)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Only plain data can be written as is");
+		value(static_cast<uint32_t>(v.size()));
+		const uint8_t *pBytes = reinterpret_cast<const uint8_t *>(v.data());
+		data.insert(data.end(), pBytes, pBytes + v.size() * sizeof(T));
+	}
+
+	void string(const std::string &s)
+	{
+		value(static_cast<uint32_t>(s.size()));
+		data.insert(data.end(), s.begin(), s.end());
+	}
+
+	std::vector<uint8_t> data;
+};
+
+class IMDCacheReader
+{
+public:
+	IMDCacheReader(const uint8_t *pData, size_t size) : pCurr(pData), pEnd(pData + size) {}
+
+	template <typename T>
+	bool value(T &v)
+	{
+		if (static_cast<size_t>(pEnd - pCurr) < sizeof(T))
+		{
+			return false;
+		}
+		memcpy(&v, pCurr, sizeof(T));
+		pCurr += sizeof(T);
+		return true;
+	}
+
+	template <typename T>
+	bool array(std::vector<T> &v)
+	{
+		uint32_t count = 0;
+		if (!value(count) || static_cast<size_t>(pEnd - pCurr) / sizeof(T) < count)
+		{
+			return false;
+		}
+		v.resize(count);
+		memcpy(v.data(), pCurr, count * sizeof(T));
+		pCurr += count * sizeof(T);
+		return true;
+	}
+
+	bool string(std::string &s)
+	{
+		uint32_t length = 0;
+		if (!value(length) || static_cast<size_t>(pEnd - pCurr) < length)
+		{
+			return false;
+		}
+		s.assign(reinterpret_cast<const char *>(pCurr), length);
+		pCurr += length;
+		return true;
+	}
+
+	bool atEnd() const
+	{
+		return pCurr == pEnd;
+	}
+
+private:
+	const uint8_t *pCurr;
+	const uint8_t *pEnd;
+};
+
+static void writeLevel(IMDCacheWriter &writer, const iIMDShape &s, const IMDLevelVertexData &vertexData)
+{
+	writer.value(s.min);
+	writer.value(s.max);
+	writer.value(static_cast<int32_t>(s.sradius));
+	writer.value(static_cast<int32_t>(s.radius));
+	writer.value(s.ocen);
+	writer.array(s.connectors);
+	writer.value(static_cast<uint32_t>(s.flags));
+	writer.value(s.numFrames);
+	writer.value(s.animInterval);
+	writer.array(s.points);
+	writer.array(s.polys);
+	writer.array(s.altShadowPoints);
+	writer.array(s.altShadowPolys);
+	writer.value(s.vertexCount);
+	writer.array(s.objanimdata);
+	writer.value(static_cast<int32_t>(s.objanimframes));
+	writer.value(static_cast<int32_t>(s.objanimtime));
+	writer.value(static_cast<int32_t>(s.objanimcycles));
+	writer.value(static_cast<int32_t>(s.interpolate));
+	for (const TilesetTextureFiles &files : s.tilesetTextureFiles)
+	{
+		writer.string(files.texfile);
+		writer.string(files.tcmaskfile);
+		writer.string(files.normalfile);
+		writer.string(files.specfile);
+	}
+
+	writer.array(vertexData.vertices);
+	writer.array(vertexData.normals);
+	writer.array(vertexData.texcoords);
+	writer.array(vertexData.tangents);
+	writer.array(vertexData.indices);
+}
+
+static bool polysAreValid(const std::vector<iIMDPoly> &polys, size_t pointCount)
+{
+	for (const iIMDPoly &poly : polys)
+	{
+		for (uint32_t index : poly.pindex)
+		{
+			if (index >= pointCount)
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+static bool readLevel(IMDCacheReader &reader, iIMDShape &s, IMDLevelVertexData &vertexData)
+{
+	int32_t sradius = 0, radius = 0, objanimframes = 0, objanimtime = 0, objanimcycles = 0, interpolate = 0;
+	uint32_t flags = 0;
+	bool ok = reader.value(s.min) && reader.value(s.max) && reader.value(sradius) && reader.value(radius)
+		&& reader.value(s.ocen) && reader.array(s.connectors) && reader.value(flags)
+		&& reader.value(s.numFrames) && reader.value(s.animInterval)
+		&& reader.array(s.points) && reader.array(s.polys)
+		&& reader.array(s.altShadowPoints) && reader.array(s.altShadowPolys)
+		&& reader.value(s.vertexCount) && reader.array(s.objanimdata)
+		&& reader.value(objanimframes) && reader.value(objanimtime) && reader.value(objanimcycles) && reader.value(interpolate);
+	for (TilesetTextureFiles &files : s.tilesetTextureFiles)
+	{
+		ok = ok && reader.string(files.texfile) && reader.string(files.tcmaskfile) && reader.string(files.normalfile) && reader.string(files.specfile);
+	}
+	ok = ok && reader.array(vertexData.vertices) && reader.array(vertexData.normals) && reader.array(vertexData.texcoords)
+		&& reader.array(vertexData.tangents) && reader.array(vertexData.indices);
+	if (!ok)
+	{
+		return false;
+	}
+	s.sradius = sradius;
+	s.radius = radius;
+	s.flags = flags;
+	s.objanimframes = objanimframes;
+	s.objanimtime = objanimtime;
+	s.objanimcycles = objanimcycles;
+	s.interpolate = interpolate;
+	// As the text loader (and iIMDShape's move assignment) select them
+	if (!s.altShadowPoints.empty() && !s.altShadowPolys.empty())
+	{
+		s.pShadowPoints = &s.altShadowPoints;
+		s.pShadowPolys = &s.altShadowPolys;
+	}
+	else
+	{
+		s.pShadowPoints = &s.points;
+		s.pShadowPolys = &s.polys;
+	}
+
+	// The renderer trusts these, so don't take a damaged file's word for them
+	const size_t vertexCount = s.vertexCount;
+	if (objanimframes < 0 || static_cast<size_t>(objanimframes) != s.objanimdata.size()
+		|| !polysAreValid(s.polys, s.points.size()) || !polysAreValid(s.altShadowPolys, s.altShadowPoints.size())
+		|| s.altShadowPoints.empty() != s.altShadowPolys.empty()
+		|| vertexData.vertices.size() != vertexCount * 3 || vertexData.normals.size() != vertexCount * 3
+		|| vertexData.texcoords.size() != vertexCount * 4
+		|| (!vertexData.tangents.empty() && vertexData.tangents.size() != vertexCount * 4))
+	{
+		return false;
+	}
+	for (uint16_t index : vertexData.indices)
+	{
+		if (index >= vertexCount)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static IMDCacheHeader currentHeader(size_t levelCount)
+{
+	IMDCacheHeader header;
+	memcpy(header.magic, imdCacheMagic, sizeof(header.magic));
+	header.formatVersion = IMD_CACHE_FORMAT_VERSION;
+	header.byteOrderMark = imdCacheByteOrderMark;
+	header.sizeOfPoly = sizeof(iIMDPoly);
+	header.sizeOfAnimFrame = sizeof(ANIMFRAME);
+	header.sizeOfFloat = sizeof(gfx_api::gfxFloat);
+	header.levelCount = static_cast<uint16_t>(levelCount);
+	return header;
+}
+
+std::vector<uint8_t> imdCacheSerialize(const IMDProcessedModel &model)
+{
+	size_t levelCount = 0;
+	for (const iIMDShape *s = model.firstLevel.get(); s != nullptr; s = s->next.get())
+	{
+		++levelCount;
+	}
+	ASSERT_OR_RETURN({}, levelCount > 0 && levelCount <= imdCacheMaxLevels, "Invalid number of levels: %zu", levelCount);
+	ASSERT_OR_RETURN({}, model.levelVertexData.size() == levelCount, "Missing vertex data");
+
+	IMDCacheWriter writer;
+	writer.value(currentHeader(levelCount));
+	writer.string(version_getVersionString());
+	for (const std::string &animEvent : model.animEvents)
+	{
+		writer.string(animEvent);
+	}
+	size_t level = 0;
+	for (const iIMDShape *s = model.firstLevel.get(); s != nullptr; s = s->next.get(), ++level)
+	{
+		writeLevel(writer, *s, model.levelVertexData[level]);
+	}
+	return std::move(writer.data);
+}
+
+bool imdCacheDeserialize(const uint8_t *pData, size_t size, IMDProcessedModel &output)
+{
+	IMDCacheReader reader(pData, size);
+	IMDCacheHeader header;
+	if (!reader.value(header))
+	{
+		return false;
+	}
+	const IMDCacheHeader expectedHeader = currentHeader(header.levelCount);
+	if (memcmp(&header, &expectedHeader, sizeof(IMDCacheHeader)) != 0 || header.levelCount == 0 || header.levelCount > imdCacheMaxLevels)
+	{
+		return false;  // From another build, or not a model at all
+	}
+	// The loader may change between versions without anyone bumping IMD_CACHE_FORMAT_VERSION.
+	std::string wzVersion;
+	if (!reader.string(wzVersion) || wzVersion != version_getVersionString())
+	{
+		return false;
+	}
+
+	IMDProcessedModel model;
+	for (std::string &animEvent : model.animEvents)
+	{
+		if (!reader.string(animEvent))
+		{
+			return false;
+		}
+	}
+	model.levelVertexData.resize(header.levelCount);
+	iIMDShape *lastLevel = nullptr;
+	for (size_t level = 0; level < header.levelCount; ++level)
+	{
+		auto shape = std::make_unique<iIMDShape>();
+		if (!readLevel(reader, *shape, model.levelVertexData[level]))
+		{
+			return false;
+		}
+		if (lastLevel)
+		{
+			lastLevel->next = std::move(shape);
+			lastLevel = lastLevel->next.get();
+		}
+		else
+		{
+			model.firstLevel = std::move(shape);
+			lastLevel = model.firstLevel.get();
+		}
+	}
+	if (!reader.atEnd())
+	{
+		return false;
+	}
+	output = std::move(model);
+	return true;
+}
+
+static std::string imdCachePath(const Sha256 &sourceHash)
+{
+	return IMD_CACHE_DIR "/" + sourceHash.toString() + ".bin";
+}
+
+bool imdCacheLoad(const Sha256 &sourceHash, IMDProcessedModel &output)
+{
+	const std::string path = imdCachePath(sourceHash);
+	if (!PHYSFS_exists(path.c_str()))
+	{
+		return false;
+	}
+	std::vector<char> data;
+	if (!loadFileToBufferVector(path.c_str(), data, false, false))
+	{
+		return false;
+	}
+	if (!imdCacheDeserialize(reinterpret_cast<const uint8_t *>(data.data()), data.size(), output))
+	{
+		debug(LOG_3D, "Ignoring outdated / invalid model cache entry: %s", path.c_str());
+		return false;
+	}
+	return true;
+}
+
+void imdCacheStore(const Sha256 &sourceHash, const IMDProcessedModel &model)
+{
+	std::vector<uint8_t> data = imdCacheSerialize(model);
+	if (data.empty())
+	{
+		return;
+	}
+	if (!PHYSFS_exists(IMD_CACHE_DIR) && PHYSFS_mkdir(IMD_CACHE_DIR) == 0)
+	{
+		debug(LOG_WARNING, "Failed to create model cache directory: %s", WZ_PHYSFS_getLastError());
+		return;
+	}
+	const std::string path = imdCachePath(sourceHash);
+	saveFile(path.c_str(), reinterpret_cast<const char *>(data.data()), data.size());
+}
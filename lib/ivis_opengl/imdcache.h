@@ -0,0 +1,67 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2025  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Binary cache of processed IMD (.pie) models, so that loading a model again only needs
+ *  to read flat arrays, instead of parsing the text file and rebuilding the vertex data.
+ *
+ *  Entries are stored in the "cache/models" dir of the config dir, keyed by the hash of
+ *  the .pie file contents. They are only valid for the version of the game that wrote them
+ *  (and IMD_CACHE_FORMAT_VERSION), and are rebuilt from the .pie file otherwise.
+ */
+
+#ifndef __INCLUDED_LIB_IVIS_OPENGL_IMDCACHE_H__
+#define __INCLUDED_LIB_IVIS_OPENGL_IMDCACHE_H__
+
+#include "lib/framework/crc.h"
+#include "ivisdef.h"
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// The data of one model level, as it is uploaded to the GPU buffers.
+struct IMDLevelVertexData
+{
+	std::vector<gfx_api::gfxFloat> vertices;
+	std::vector<gfx_api::gfxFloat> normals;
+	std::vector<gfx_api::gfxFloat> texcoords;  ///< texcoords + texAnim
+	std::vector<gfx_api::gfxFloat> tangents;   ///< Empty, unless the model has normals.
+	std::vector<uint16_t> indices;
+};
+
+/// A model as read from a .pie file, before it is uploaded / linked to other models.
+struct IMDProcessedModel
+{
+	std::unique_ptr<iIMDShape> firstLevel;                  ///< Without modelName, modelLevel and objanimpie set.
+	std::vector<IMDLevelVertexData> levelVertexData;        ///< One per level.
+	std::array<std::string, ANIM_EVENT_COUNT> animEvents;   ///< The model names of the EVENT directives.
+};
+
+/// Serializes a processed model into the format of the cache.
+std::vector<uint8_t> imdCacheSerialize(const IMDProcessedModel &model);
+/// Reads a model written by imdCacheSerialize(). Returns false if the data is invalid, or from another build.
+bool imdCacheDeserialize(const uint8_t *pData, size_t size, IMDProcessedModel &output);
+
+/// Loads the cached model for the .pie file with the hash `sourceHash`, if there is one.
+bool imdCacheLoad(const Sha256 &sourceHash, IMDProcessedModel &output);
+/// Stores the model loaded from the .pie file with the hash `sourceHash`.
+void imdCacheStore(const Sha256 &sourceHash, const IMDProcessedModel &model);
+
+#endif // __INCLUDED_LIB_IVIS_OPENGL_IMDCACHE_H__
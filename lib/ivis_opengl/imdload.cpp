@@ -28,6 +28,7 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <array>
+#include <algorithm>
 
 #include "lib/framework/frame.h"
 #include "lib/framework/string_ext.h"
@@ -42,6 +43,7 @@
 
 #include "ivisdef.h" // for imd structures
 #include "imd.h" // for imd structures
+#include "imdcache.h"
 #include "tex.h" // texture page loading
 
 #include <glm/vec4.hpp>
@@ -64,7 +66,7 @@ static size_t currentTilesetIdx = 0;
 static size_t modelLoadingErrors = 0;
 static size_t modelTextureLoadingFailures = 0;
 
-static std::unique_ptr<iIMDShape> iV_ProcessIMD(const WzString &filename, const char **ppFileData, const char *FileDataEnd, bool skipGPUData, bool skipDuplicateLoadChecks = false);
+static std::unique_ptr<iIMDShape> iV_ProcessIMD(const WzString &filename, const char *pFileData, size_t fileSize, bool skipGPUData, bool skipDuplicateLoadChecks = false);
 static bool _imd_load_level_textures(const iIMDShape& s, size_t tilesetIdx, iIMDShapeTextures& output);
 static std::unique_ptr<iIMDShape> tryLoadDisplayModelInternal(const WzString &path, const WzString &filename, bool skipGPUupload, bool skipDuplicateLoadChecks = false);
 
@@ -343,16 +345,14 @@ static std::unique_ptr<iIMDShape> tryLoadDisplayModelInternal(const WzString &pa
 {
 	if (PHYSFS_exists(path + filename))
 	{
-		char *pFileData = nullptr, *fileEnd;
+		char *pFileData = nullptr;
 		UDWORD size = 0;
 		if (!loadFile(WzString(path + filename).toUtf8().c_str(), &pFileData, &size))
 		{
 			debug(LOG_ERROR, "Failed to load model file: %s", WzString(path + filename).toUtf8().c_str());
 			return nullptr;
 		}
-		fileEnd = pFileData + size;
-		const char *pFileDataPt = pFileData;
-		auto result = iV_ProcessIMD(filename, (const char **)&pFileDataPt, fileEnd, skipGPUupload, skipDuplicateLoadChecks);
+		auto result = iV_ProcessIMD(filename, pFileData, size, skipGPUupload, skipDuplicateLoadChecks);
 		free(pFileData);
 		return result;
 	}
@@ -1453,6 +1453,56 @@ void finishTangentsGeneration()
    }
 }
 
+static std::string _imd_level_key(const WzString &filename, uint32_t level)
+{
+	std::string key = filename.toStdString();
+	if (level > 0)
+	{
+		key += "_" + std::to_string(level);
+	}
+	return key;
+}
+
+static void _imd_upload_level(iIMDShape &s, const IMDLevelVertexData &vertexData)
+{
+	const char *key = s.modelName.toUtf8().c_str();
+
+	if (!vertexData.tangents.empty())
+	{
+		if (!s.buffers[VBO_TANGENT])
+			s.buffers[VBO_TANGENT] = gfx_api::context::get().create_buffer_object(gfx_api::buffer::usage::vertex_buffer, gfx_api::context::buffer_storage_hint::static_draw, "tangent buffer");
+		s.buffers[VBO_TANGENT]->upload(vertexData.tangents.size() * sizeof(gfx_api::gfxFloat), vertexData.tangents.data());
+	}
+
+	if (!s.buffers[VBO_VERTEX])
+		s.buffers[VBO_VERTEX] = gfx_api::context::get().create_buffer_object(gfx_api::buffer::usage::vertex_buffer, gfx_api::context::buffer_storage_hint::static_draw, "vertex buffer");
+	s.buffers[VBO_VERTEX]->upload(vertexData.vertices.size() * sizeof(gfx_api::gfxFloat), vertexData.vertices.data());
+
+	if (!s.buffers[VBO_NORMAL])
+		s.buffers[VBO_NORMAL] = gfx_api::context::get().create_buffer_object(gfx_api::buffer::usage::vertex_buffer, gfx_api::context::buffer_storage_hint::static_draw, "normals buffer");
+	if (vertexData.normals.empty())
+	{
+		debug(LOG_ERROR, "_imd_upload_level: file corrupt? - no normals?: %s", key);
+	}
+	s.buffers[VBO_NORMAL]->upload(vertexData.normals.size() * sizeof(gfx_api::gfxFloat), vertexData.normals.data());
+
+	if (!s.buffers[VBO_INDEX])
+		s.buffers[VBO_INDEX] = gfx_api::context::get().create_buffer_object(gfx_api::buffer::usage::index_buffer, gfx_api::context::buffer_storage_hint::static_draw, "index buffer");
+	if (vertexData.indices.empty())
+	{
+		debug(LOG_ERROR, "_imd_upload_level: file corrupt? - no indices?: %s", key);
+	}
+	s.buffers[VBO_INDEX]->upload(vertexData.indices.size() * sizeof(uint16_t), vertexData.indices.data());
+
+	if (!s.buffers[VBO_TEXCOORD])
+		s.buffers[VBO_TEXCOORD] = gfx_api::context::get().create_buffer_object(gfx_api::buffer::usage::vertex_buffer, gfx_api::context::buffer_storage_hint::static_draw, "tex coords buffer");
+	if (vertexData.texcoords.empty())
+	{
+		debug(LOG_ERROR, "_imd_upload_level: file corrupt? - no texcoords?: %s", key);
+	}
+	s.buffers[VBO_TEXCOORD]->upload(vertexData.texcoords.size() * sizeof(gfx_api::gfxFloat), vertexData.texcoords.data());
+}
+
 /*!
  * Load shape levels recursively
  * \param ppFileData Pointer to the data (usually read from a file)
@@ -1463,26 +1513,15 @@ void finishTangentsGeneration()
  * \post s allocated
  */
 static_assert(PATH_MAX >= 255, "PATH_MAX is insufficient!");
-static std::unique_ptr<iIMDShape> _imd_load_level(const WzString &filename, const char **ppFileData, const char *FileDataEnd, int pieVersion, uint32_t level, const LevelSettings &globalLevelSettings, bool skipGPUData, bool skipDuplicateLoadChecks)
+static std::unique_ptr<iIMDShape> _imd_load_level(const WzString &filename, const char **ppFileData, const char *FileDataEnd, int pieVersion, uint32_t level, const LevelSettings &globalLevelSettings, IMDLevelVertexData &vertexData)
 {
 	const char *pFileData = *ppFileData;
 	char buffer[PATH_MAX] = {'\0'}; uint32_t value = 0;
 	int cnt = 0, scanResult = 0;
 
-	// insert model
-	std::string key = filename.toStdString();
-	if (level > 0)
-	{
-		key += "_" + std::to_string(level);
-	}
-	if (!skipDuplicateLoadChecks)
-	{
-		ASSERT(models.count(key) == 0, "Duplicate model load for %s!", key.c_str());
-	}
+	const std::string key = _imd_level_key(filename, level);
 	auto pAllocatedShape = std::make_unique<iIMDShape>();
 	iIMDShape &s = *pAllocatedShape;
-	s.modelName = WzString::fromUtf8(key);
-	s.modelLevel = level;
 	s.pShadowPoints = &s.points;
 	s.pShadowPolys = &s.polys;
 
@@ -1738,72 +1777,41 @@ static std::unique_ptr<iIMDShape> _imd_load_level(const WzString &filename, cons
 	}
 
 	// FINALLY, massage the data into what can stream directly to GPU buffers
-	if (!skipGPUData)
+	vertexCount = 0;
+	// Go through all polygons for each frame
+	for (size_t npol = 0; npol < s.polys.size(); ++npol)
 	{
-		vertexCount = 0;
-		// Go through all polygons for each frame
-		for (size_t npol = 0; npol < s.polys.size(); ++npol)
-		{
-			const iIMDPoly& p = s.polys[npol];
-			// Do we already have the vertex data for this polygon?
-			indices.emplace_back(addVertex(s, 0, &p, npol, pie_level_normals));
-			indices.emplace_back(addVertex(s, 1, &p, npol, pie_level_normals));
-			indices.emplace_back(addVertex(s, 2, &p, npol, pie_level_normals));
-		}
-
-		s.vertexCount = vertexCount;
-
-		// Tangents are optional, only if normals were loaded and passed sanity check above
-		if (!pie_level_normals.empty())
-		{
-			tangents.resize(vertexCount * 4);
-			bitangents.resize(vertexCount * 3);
-
-			for (size_t i = 0; i < indices.size(); i += 3)
-				calculateTangentsForTriangle(indices[i], indices[i+1], indices[i+2]);
-			finishTangentsGeneration();
-
-			if (!tangents.empty())
-			{
-				if (!s.buffers[VBO_TANGENT])
-					s.buffers[VBO_TANGENT] = gfx_api::context::get().create_buffer_object(gfx_api::buffer::usage::vertex_buffer, gfx_api::context::buffer_storage_hint::static_draw, "tangent buffer");
-				s.buffers[VBO_TANGENT]->upload(tangents.size() * sizeof(gfx_api::gfxFloat), tangents.data());
-			}
-		}
+		const iIMDPoly& p = s.polys[npol];
+		// Do we already have the vertex data for this polygon?
+		indices.emplace_back(addVertex(s, 0, &p, npol, pie_level_normals));
+		indices.emplace_back(addVertex(s, 1, &p, npol, pie_level_normals));
+		indices.emplace_back(addVertex(s, 2, &p, npol, pie_level_normals));
+	}
 
-		if (!s.buffers[VBO_VERTEX])
-			s.buffers[VBO_VERTEX] = gfx_api::context::get().create_buffer_object(gfx_api::buffer::usage::vertex_buffer, gfx_api::context::buffer_storage_hint::static_draw, "vertex buffer");
-		if (vertices.empty())
-		{
-			debug(LOG_ERROR, "_imd_load_level: file corrupt? - no vertices?: %s (key: %s)", filename.toUtf8().c_str(), key.c_str());
-		}
-		s.buffers[VBO_VERTEX]->upload(vertices.size() * sizeof(gfx_api::gfxFloat), vertices.data());
+	s.vertexCount = vertexCount;
 
-		if (!s.buffers[VBO_NORMAL])
-			s.buffers[VBO_NORMAL] = gfx_api::context::get().create_buffer_object(gfx_api::buffer::usage::vertex_buffer, gfx_api::context::buffer_storage_hint::static_draw, "normals buffer");
-		if (normals.empty())
-		{
-			debug(LOG_ERROR, "_imd_load_level: file corrupt? - no normals?: %s (key: %s)", filename.toUtf8().c_str(), key.c_str());
-		}
-		s.buffers[VBO_NORMAL]->upload(normals.size() * sizeof(gfx_api::gfxFloat), normals.data());
+	// Tangents are optional, only if normals were loaded and passed sanity check above
+	if (!pie_level_normals.empty())
+	{
+		tangents.resize(vertexCount * 4);
+		bitangents.resize(vertexCount * 3);
 
-		if (!s.buffers[VBO_INDEX])
-			s.buffers[VBO_INDEX] = gfx_api::context::get().create_buffer_object(gfx_api::buffer::usage::index_buffer, gfx_api::context::buffer_storage_hint::static_draw, "index buffer");
-		if (indices.empty())
-		{
-			debug(LOG_ERROR, "_imd_load_level: file corrupt? - no indices?: %s (key: %s)", filename.toUtf8().c_str(), key.c_str());
-		}
-		s.buffers[VBO_INDEX]->upload(indices.size() * sizeof(uint16_t), indices.data());
+		for (size_t i = 0; i < indices.size(); i += 3)
+			calculateTangentsForTriangle(indices[i], indices[i+1], indices[i+2]);
+		finishTangentsGeneration();
+	}
 
-		if (!s.buffers[VBO_TEXCOORD])
-			s.buffers[VBO_TEXCOORD] = gfx_api::context::get().create_buffer_object(gfx_api::buffer::usage::vertex_buffer, gfx_api::context::buffer_storage_hint::static_draw, "tex coords buffer");
-		if (texcoords.empty())
-		{
-			debug(LOG_ERROR, "_imd_load_level: file corrupt? - no texcoords?: %s (key: %s)", filename.toUtf8().c_str(), key.c_str());
-		}
-		s.buffers[VBO_TEXCOORD]->upload(texcoords.size() * sizeof(gfx_api::gfxFloat), texcoords.data());
+	if (vertices.empty())
+	{
+		debug(LOG_ERROR, "_imd_load_level: file corrupt? - no vertices?: %s (key: %s)", filename.toUtf8().c_str(), key.c_str());
 	}
 
+	vertexData.vertices = vertices;
+	vertexData.normals = normals;
+	vertexData.texcoords = texcoords;
+	vertexData.tangents = tangents;
+	vertexData.indices = indices;
+
 	indices.resize(0);
 	vertices.resize(0);
 	texcoords.resize(0);
@@ -1826,13 +1834,14 @@ static std::unique_ptr<iIMDShape> _imd_load_level(const WzString &filename, cons
 }
 
 /*!
- * Load ppFileData into a shape
+ * Parse ppFileData into a processed model, without touching the GPU or other models
  * \param ppFileData Data from the IMD file
  * \param FileDataEnd Endpointer
- * \return The shape, constructed from the data read
+ * \param output The model, constructed from the data read
+ * \return false on error
  */
 // ppFileData is incremented to the end of the file on exit!
-static std::unique_ptr<iIMDShape> iV_ProcessIMD(const WzString &filename, const char **ppFileData, const char *FileDataEnd, bool skipGPUData, bool skipDuplicateLoadChecks)
+static bool iV_ParseIMD(const WzString &filename, const char **ppFileData, const char *FileDataEnd, IMDProcessedModel &output)
 {
 	const char *pFileData = *ppFileData;
 	char buffer[PATH_MAX] = {};
@@ -1840,7 +1849,6 @@ static std::unique_ptr<iIMDShape> iV_ProcessIMD(const WzString &filename, const
 	unsigned value = 0;
 	unsigned nlevels = 0;
 	int32_t imd_version;
-	iIMDBaseShape *objanimpie[ANIM_EVENT_COUNT];
 
 	IMD_Line lineToProcess;
 	if (!_imd_get_next_line(pFileData, FileDataEnd, lineToProcess) || sscanf(lineToProcess.lineContents.c_str(), "%255s %d", buffer, &imd_version) != 2)
@@ -1848,7 +1856,7 @@ static std::unique_ptr<iIMDShape> iV_ProcessIMD(const WzString &filename, const
 		debug(LOG_ERROR, "%s: bad PIE version: (%s)", filename.toUtf8().c_str(), buffer);
 		++modelLoadingErrors;
 		assert(false);
-		return nullptr;
+		return false;
 	}
 	pFileData = lineToProcess.pNextLineBegin;
 
@@ -1856,7 +1864,7 @@ static std::unique_ptr<iIMDShape> iV_ProcessIMD(const WzString &filename, const
 	{
 		debug(LOG_ERROR, "%s: Not an IMD file (%s %d)", filename.toUtf8().c_str(), buffer, imd_version);
 		++modelLoadingErrors;
-		return nullptr;
+		return false;
 	}
 
 	//Now supporting version PIE_VER and PIE_FLOAT_VER files
@@ -1864,7 +1872,7 @@ static std::unique_ptr<iIMDShape> iV_ProcessIMD(const WzString &filename, const
 	{
 		debug(LOG_ERROR, "%s: Version %d not supported", filename.toUtf8().c_str(), imd_version);
 		++modelLoadingErrors;
-		return nullptr;
+		return false;
 	}
 
 	LevelSettings globalLevelSettings;
@@ -1872,10 +1880,10 @@ static std::unique_ptr<iIMDShape> iV_ProcessIMD(const WzString &filename, const
 	{
 		debug(LOG_ERROR, "%s: Failed to load level settings", filename.toUtf8().c_str());
 		++modelLoadingErrors;
-		return nullptr;
+		return false;
 	}
 	// TYPE is required in the global scope
-	ASSERT_OR_RETURN(nullptr, globalLevelSettings.imd_flags.has_value(), "%s: Missing TYPE line", filename.toUtf8().c_str());
+	ASSERT_OR_RETURN(false, globalLevelSettings.imd_flags.has_value(), "%s: Missing TYPE line", filename.toUtf8().c_str());
 
 	auto getNextPossibleCommandLine = [&]() -> bool {
 		pFileData = lineToProcess.pNextLineBegin;
@@ -1899,13 +1907,9 @@ static std::unique_ptr<iIMDShape> iV_ProcessIMD(const WzString &filename, const
 	{
 		debug(LOG_ERROR, "%s: Expecting EVENT or LEVELS: %s", filename.toUtf8().c_str(), buffer);
 		++modelLoadingErrors;
-		return nullptr;
+		return false;
 	}
 
-	for (int i = 0; i < ANIM_EVENT_COUNT; i++)
-	{
-		objanimpie[i] = nullptr;
-	}
 	while (strncmp(buffer, "EVENT", 5) == 0)
 	{
 		char animpie[PATH_MAX];
@@ -1916,17 +1920,20 @@ static std::unique_ptr<iIMDShape> iV_ProcessIMD(const WzString &filename, const
 		{
 			debug(LOG_ERROR, "%s animation model corrupt: %s", filename.toUtf8().c_str(), buffer);
 			++modelLoadingErrors;
-			return nullptr;
+			return false;
 		}
 
-		objanimpie[value] = modelGet(animpie);
+		if (value < ANIM_EVENT_COUNT)
+		{
+			output.animEvents[value] = animpie;  // loaded by iV_FinishIMD()
+		}
 
 		/* Try -yet again- to read in LEVELS directive */
 		if (!getNextPossibleCommandLine())
 		{
 			debug(LOG_ERROR, "%s: Bad levels info: %s", filename.toUtf8().c_str(), buffer);
 			++modelLoadingErrors;
-			return nullptr;
+			return false;
 		}
 	}
 
@@ -1934,11 +1941,11 @@ static std::unique_ptr<iIMDShape> iV_ProcessIMD(const WzString &filename, const
 	{
 		debug(LOG_ERROR, "%s: Expecting 'LEVELS' directive (%s)", filename.toUtf8().c_str(), buffer);
 		++modelLoadingErrors;
-		return nullptr;
+		return false;
 	}
 	nlevels = value;
 
-	std::unique_ptr<iIMDShape> firstLevel = nullptr;
+	std::unique_ptr<iIMDShape> &firstLevel = output.firstLevel;
 	iIMDShape *lastLevel = nullptr;
 	for (uint32_t level = 0; level < nlevels; ++level)
 	{
@@ -1947,27 +1954,28 @@ static std::unique_ptr<iIMDShape> iV_ProcessIMD(const WzString &filename, const
 		{
 			debug(LOG_ERROR, "(_load_level) file corrupt -J");
 			++modelLoadingErrors;
-			return nullptr;
+			return false;
 		}
 		if (strncmp(buffer, "LEVEL", 5) != 0)
 		{
 			debug(LOG_ERROR, "%s: Expecting 'LEVEL' directive (%s)", filename.toUtf8().c_str(), buffer);
 			++modelLoadingErrors;
-			return nullptr;
+			return false;
 		}
 		if (value != (level + 1))
 		{
 			debug(LOG_ERROR, "%s: LEVEL %" PRIu32 " is invalid - expecting LEVEL %" PRIu32 " (LEVELS must be sequential, starting at 1)", filename.toUtf8().c_str(), value, level);
 			++modelLoadingErrors;
-			return nullptr;
+			return false;
 		}
 
-		std::unique_ptr<iIMDShape> shape = _imd_load_level(filename, &lineToProcess.pNextLineBegin, FileDataEnd, imd_version, level, globalLevelSettings, skipGPUData, skipDuplicateLoadChecks);
+		output.levelVertexData.emplace_back();
+		std::unique_ptr<iIMDShape> shape = _imd_load_level(filename, &lineToProcess.pNextLineBegin, FileDataEnd, imd_version, level, globalLevelSettings, output.levelVertexData.back());
 		if (shape == nullptr)
 		{
 			debug(LOG_ERROR, "%s: Unsuccessful loading level %" PRIu32, filename.toUtf8().c_str(), (level + 1));
 			++modelLoadingErrors;
-			return nullptr;
+			return false;
 		}
 
 		if (lastLevel)
@@ -1985,16 +1993,184 @@ static std::unique_ptr<iIMDShape> iV_ProcessIMD(const WzString &filename, const
 		pFileData = lineToProcess.pNextLineBegin;
 	}
 
-	ASSERT_OR_RETURN(nullptr, firstLevel != nullptr, "%s: Has no levels?", filename.toUtf8().c_str());
+	ASSERT_OR_RETURN(false, firstLevel != nullptr, "%s: Has no levels?", filename.toUtf8().c_str());
+
+	// TODO: once all levels have been loaded, re-calculate the bounds of the first level using all the levels' points?
+
+	*ppFileData = pFileData;
+	return true;
+}
+
+/*!
+ * Turn a processed model into a shape: name its levels, upload them, and load the models of its events
+ * \return The shape, or NULL on error
+ */
+static std::unique_ptr<iIMDShape> iV_FinishIMD(const WzString &filename, IMDProcessedModel &&model, bool skipGPUData, bool skipDuplicateLoadChecks)
+{
+	ASSERT_OR_RETURN(nullptr, model.firstLevel != nullptr, "%s: Has no levels?", filename.toUtf8().c_str());
+
+	uint32_t level = 0;
+	for (iIMDShape *s = model.firstLevel.get(); s != nullptr; s = s->next.get(), ++level)
+	{
+		// insert model
+		const std::string key = _imd_level_key(filename, level);
+		if (!skipDuplicateLoadChecks)
+		{
+			ASSERT(models.count(key) == 0, "Duplicate model load for %s!", key.c_str());
+		}
+		s->modelName = WzString::fromUtf8(key);
+		s->modelLevel = level;
+		if (!skipGPUData)
+		{
+			_imd_upload_level(*s, model.levelVertexData[level]);
+		}
+	}
 
 	// copy over model-wide animation information, stored only in the first level
 	for (int i = 0; i < ANIM_EVENT_COUNT; i++)
 	{
-		firstLevel->objanimpie[i] = objanimpie[i];
+		if (!model.animEvents[i].empty())
+		{
+			model.firstLevel->objanimpie[i] = modelGet(WzString::fromUtf8(model.animEvents[i]));
+		}
 	}
 
-	// TODO: once all levels have been loaded, re-calculate the bounds of the first level using all the levels' points?
+	return std::move(model.firstLevel);
+}
 
-	*ppFileData = pFileData;
-	return firstLevel;
+/*!
+ * Load a shape from the data of an IMD file, or from the model cache if it has seen the same data before
+ * \param pFileData Data from the IMD file
+ * \param fileSize Size of the data
+ * \return The shape, constructed from the data read
+ */
+static std::unique_ptr<iIMDShape> iV_ProcessIMD(const WzString &filename, const char *pFileData, size_t fileSize, bool skipGPUData, bool skipDuplicateLoadChecks)
+{
+	const Sha256 sourceHash = sha256Sum(pFileData, fileSize);
+	IMDProcessedModel model;
+	if (!imdCacheLoad(sourceHash, model))
+	{
+		const char *pFileDataPt = pFileData;
+		if (!iV_ParseIMD(filename, &pFileDataPt, pFileData + fileSize, model))
+		{
+			return nullptr;
+		}
+		imdCacheStore(sourceHash, model);
+	}
+	return iV_FinishIMD(filename, std::move(model), skipGPUData, skipDuplicateLoadChecks);
+}
+
+static bool imdPolysMatch(const std::vector<iIMDPoly> &a, const std::vector<iIMDPoly> &b)
+{
+	return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const iIMDPoly &x, const iIMDPoly &y) {
+		return x.texCoord == y.texCoord && x.texAnim == y.texAnim && x.flags == y.flags && x.zcentre == y.zcentre
+			&& x.normal == y.normal && std::equal(std::begin(x.pindex), std::end(x.pindex), std::begin(y.pindex));
+	});
+}
+
+static bool imdAnimFramesMatch(const std::vector<ANIMFRAME> &a, const std::vector<ANIMFRAME> &b)
+{
+	return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const ANIMFRAME &x, const ANIMFRAME &y) {
+		return x.scale == y.scale && x.pos == y.pos
+			&& x.rot.direction == y.rot.direction && x.rot.pitch == y.rot.pitch && x.rot.roll == y.rot.roll;
+	});
+}
+
+/// Which arrays the stencil shadows of the level are drawn from: 0 for its own points / polys, 1 for the
+/// SHADOWPOINTS / SHADOWPOLYGONS, and -1 if the pointers are not set up to point into the level.
+static int imdShadowSource(const iIMDShape &s)
+{
+	if (s.pShadowPoints == &s.points && s.pShadowPolys == &s.polys)
+	{
+		return 0;
+	}
+	if (s.pShadowPoints == &s.altShadowPoints && s.pShadowPolys == &s.altShadowPolys)
+	{
+		return 1;
+	}
+	return -1;
+}
+
+/// Returns the name of the first field that differs between the two levels, or nullptr if they match.
+static const char *imdLevelMismatch(const iIMDShape &a, const IMDLevelVertexData &aData, const iIMDShape &b, const IMDLevelVertexData &bData)
+{
+	bool texturesMatch = true;
+	for (size_t i = 0; i < a.tilesetTextureFiles.size(); ++i)
+	{
+		const TilesetTextureFiles &x = a.tilesetTextureFiles[i], &y = b.tilesetTextureFiles[i];
+		texturesMatch = texturesMatch && x.texfile == y.texfile && x.tcmaskfile == y.tcmaskfile && x.normalfile == y.normalfile && x.specfile == y.specfile;
+	}
+	const std::pair<bool, const char *> checks[] = {
+		{a.min == b.min && a.max == b.max, "bounds"},
+		{a.sradius == b.sradius && a.radius == b.radius, "radius"},
+		{a.ocen == b.ocen, "ocen"},
+		{a.connectors == b.connectors, "connectors"},
+		{a.flags == b.flags, "flags"},
+		{a.numFrames == b.numFrames && a.animInterval == b.animInterval, "texture animation"},
+		{a.points == b.points, "points"},
+		{imdPolysMatch(a.polys, b.polys), "polys"},
+		{a.altShadowPoints == b.altShadowPoints, "shadow points"},
+		{imdPolysMatch(a.altShadowPolys, b.altShadowPolys), "shadow polys"},
+		{imdShadowSource(a) != -1 && imdShadowSource(a) == imdShadowSource(b), "pShadowPoints / pShadowPolys"},
+		{a.vertexCount == b.vertexCount, "vertexCount"},
+		{imdAnimFramesMatch(a.objanimdata, b.objanimdata) && a.objanimframes == b.objanimframes, "objanimdata"},
+		{a.objanimtime == b.objanimtime && a.objanimcycles == b.objanimcycles, "object animation"},
+		{a.interpolate == b.interpolate, "interpolate"},
+		{texturesMatch, "tilesetTextureFiles"},
+		{aData.vertices == bData.vertices, "vertices"},
+		{aData.normals == bData.normals, "normals"},
+		{aData.texcoords == bData.texcoords, "texcoords"},
+		{aData.tangents == bData.tangents, "tangents"},
+		{aData.indices == bData.indices, "indices"},
+	};
+	for (const auto &check : checks)
+	{
+		if (!check.first)
+		{
+			return check.second;
+		}
+	}
+	return nullptr;
+}
+
+bool modelCacheSelfCheck(const WzString &filename, const char *pFileData, size_t fileSize)
+{
+	IMDProcessedModel textModel;
+	const char *pFileDataPt = pFileData;
+	if (!iV_ParseIMD(filename, &pFileDataPt, pFileData + fileSize, textModel))
+	{
+		debug(LOG_ERROR, "%s: Failed to parse model", filename.toUtf8().c_str());
+		return false;
+	}
+	const std::vector<uint8_t> serialized = imdCacheSerialize(textModel);
+	IMDProcessedModel cachedModel;
+	if (serialized.empty() || !imdCacheDeserialize(serialized.data(), serialized.size(), cachedModel))
+	{
+		debug(LOG_ERROR, "%s: Failed to read back cached model", filename.toUtf8().c_str());
+		return false;
+	}
+
+	if (cachedModel.levelVertexData.size() != textModel.levelVertexData.size() || cachedModel.animEvents != textModel.animEvents)
+	{
+		debug(LOG_ERROR, "%s: Cached model differs from the model parsed from text in its levels or events", filename.toUtf8().c_str());
+		return false;
+	}
+	const iIMDShape *pText = textModel.firstLevel.get();
+	const iIMDShape *pCached = cachedModel.firstLevel.get();
+	for (size_t level = 0; level < textModel.levelVertexData.size(); ++level, pText = pText->next.get(), pCached = pCached->next.get())
+	{
+		ASSERT_OR_RETURN(false, pText != nullptr && pCached != nullptr, "%s: Missing level %zu", filename.toUtf8().c_str(), level);
+		const char *mismatch = imdLevelMismatch(*pText, textModel.levelVertexData[level], *pCached, cachedModel.levelVertexData[level]);
+		if (mismatch != nullptr)
+		{
+			debug(LOG_ERROR, "%s: Level %zu of the cached model differs from the model parsed from text in: %s", filename.toUtf8().c_str(), level, mismatch);
+			return false;
+		}
+	}
+	if (pText != nullptr || pCached != nullptr)
+	{
+		debug(LOG_ERROR, "%s: Cached model has a different number of levels than the model parsed from text", filename.toUtf8().c_str());
+		return false;
+	}
+	return true;
 }
@@ -23,7 +23,6 @@
 #include <array>
 #include <glm/glm.hpp>
 #include <algorithm>
-#include <functional>
 #include <unordered_map>
 #include "culling.h"
 #include "src/profiling.h"
@@ -143,26 +142,13 @@ void renderingNew::LightingManager::ComputeFrameData(const LightingData& data, L
 	const bool yAxisInverted = gfx_api::context::get().isYAxisInverted();
 
 	// Pick the first lights inside the view frustum
-	auto viewFrustum = IntersectionOfHalfSpace{
-		[](const glm::vec3& in) { return in.x >= -1.f; },
-		[](const glm::vec3& in) { return in.x <= 1.f; },
-		[yAxisInverted](const glm::vec3& in) {
-			if (yAxisInverted)
-			{
-				return -in.y >= -1.f;
-			}
-			return in.y >= -1.f;
-		},
-		[yAxisInverted](const glm::vec3& in) {
-			if (yAxisInverted)
-			{
-				return -in.y <= 1.f;
-			}
-			return in.y <= 1.f;
-		},
-		[](const glm::vec3& in) { return in.z >= 0; },
-		[](const glm::vec3& in) { return in.z <= 1; }
-	};
+	lightBounds.clear();
+	lightBounds.reserve(data.lights.size());
+	for (const auto& light : data.lights)
+	{
+		lightBounds.push_back(clipSpaceBounds(transformBoundingBox(worldViewProjectionMatrix, getLightBoundingBox(light)), yAxisInverted));
+	}
+	lightBounds.intersect(viewFrustumClipSpaceBounds, lightVisible);
 
 	std::unordered_map<std::pair<int32_t, int32_t>, std::vector<size_t>, TileCoordsHasher> tileRangeLights; // map tile coordinates to vector of culledLight indexes
 	constexpr size_t maxRangedLightsPerTile = 16;
@@ -173,17 +159,18 @@ void renderingNew::LightingManager::ComputeFrameData(const LightingData& data, L
 	size_t tinyLightsSkipped = 0;
 
 	culledLights.clear();
-	for (const auto& light : data.lights)
+	for (size_t lightIndex = 0, end = data.lights.size(); lightIndex < end; lightIndex++)
 	{
 		if (culledLights.size() >= gfx_api::max_lights)
 		{
 			break;
 		}
-		auto clipSpaceBoundingBox = transformBoundingBox(worldViewProjectionMatrix, getLightBoundingBox(light));
-		if (!isBBoxInClipSpace(viewFrustum, clipSpaceBoundingBox))
+		if (!lightVisible[lightIndex])
 		{
 			continue;
 		}
+		const auto& light = data.lights[lightIndex];
+		const ClipSpaceBounds lightClipSpaceBounds = lightBounds[lightIndex];
 
 		if (light.range >= minLightRange)
 		{
@@ -216,7 +203,7 @@ void renderingNew::LightingManager::ComputeFrameData(const LightingData& data, L
 							calcLight.colour.z += (existingLight.light.colour.z) * weight;
 
 							existingLight.light = calcLight;
-							existingLight.clipSpaceBoundingBox = clipSpaceBoundingBox;
+							existingLight.clipSpaceBounds = lightClipSpaceBounds;
 						}
 						else
 						{
@@ -258,7 +245,7 @@ void renderingNew::LightingManager::ComputeFrameData(const LightingData& data, L
 		calcLight.colour = glm::vec3(light.colour.byte.r / 255.f, light.colour.byte.g / 255.f, light.colour.byte.b / 255.f);
 		calcLight.range = light.range;
 
-		culledLights.push_back({std::move(calcLight), std::move(clipSpaceBoundingBox)});
+		culledLights.push_back({std::move(calcLight), lightClipSpaceBounds});
 	}
 
 	if (lightsSkipped > 0 || lightsCombined > 0 || tinyLightsSkipped > 0)
@@ -266,8 +253,11 @@ void renderingNew::LightingManager::ComputeFrameData(const LightingData& data, L
 		// debug(LOG_INFO, "Point lights - merged: %zu, skipped (tile limit): %zu, skipped (tiny): %zu", lightsCombined, lightsSkipped, tinyLightsSkipped);
 	}
 
+	culledLightBounds.clear();
+	culledLightBounds.reserve(culledLights.size());
 	for (size_t lightIndex = 0, end = culledLights.size(); lightIndex < end; lightIndex++)
 	{
+		culledLightBounds.push_back(culledLights[lightIndex].clipSpaceBounds);
 		const auto& light = culledLights[lightIndex].light;
 		result.positions[lightIndex].x = light.position.x;
 		result.positions[lightIndex].y = light.position.y;
@@ -304,22 +294,11 @@ void renderingNew::LightingManager::ComputeFrameData(const LightingData& data, L
 				auto bucketFrustumY0 = -1.f + 2 * static_cast<float>(j) / bucketDimension;
 				auto bucketFrustumY1 = -1.f + 2 * static_cast<float>(j + 1) / bucketDimension;
 
-				auto frustum = IntersectionOfHalfSpace{
-					[bucketFrustumX0](const glm::vec3& in) { return in.x >= bucketFrustumX0; },
-					[bucketFrustumX1](const glm::vec3& in) { return in.x <= bucketFrustumX1; },
-					[bucketFrustumY0, yAxisInverted](const glm::vec3& in) {
-						if (yAxisInverted)
-							return -in.y >= bucketFrustumY0;
-						return in.y >= bucketFrustumY0;
-					},
-					[bucketFrustumY1, yAxisInverted](const glm::vec3& in) {
-						if (yAxisInverted)
-							return -in.y <= bucketFrustumY1;
-						return in.y <= bucketFrustumY1;
-					},
-					[](const glm::vec3& in) { return in.z >= 0; },
-					[](const glm::vec3& in) { return in.z <= 1; }
+				const ClipSpaceBounds bucketFrustum = {
+					glm::vec3(bucketFrustumX0, bucketFrustumY0, 0.f),
+					glm::vec3(bucketFrustumX1, bucketFrustumY1, 1.f)
 				};
+				culledLightBounds.intersect(bucketFrustum, lightVisible);
 
 				size_t bucketSize = 0;
 				for (size_t lightIndex = 0; lightIndex < culledLights.size(); lightIndex++)
@@ -330,9 +309,7 @@ void renderingNew::LightingManager::ComputeFrameData(const LightingData& data, L
 						reduceNumberOfBucketsNeeded = true;
 						break;
 					}
-					const BoundingBox& clipSpaceBoundingBox = culledLights[lightIndex].clipSpaceBoundingBox;
-
-					if (isBBoxInClipSpace(frustum, clipSpaceBoundingBox))
+					if (lightVisible[lightIndex])
 					{
 						lightList[overallId + bucketSize] = lightIndex;
 
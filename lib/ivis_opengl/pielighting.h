@@ -111,9 +111,12 @@ namespace renderingNew
 		struct CulledLightInfo
 		{
 			CalculatedPointLight light;
-			BoundingBox clipSpaceBoundingBox;
+			ClipSpaceBounds clipSpaceBounds;
 		};
 		std::vector<CulledLightInfo> culledLights;
+		ClipSpaceBoundsList lightBounds;        // of all the lights of the frame
+		ClipSpaceBoundsList culledLightBounds;  // of culledLights
+		std::vector<uint8_t> lightVisible;
 	};
 }
 
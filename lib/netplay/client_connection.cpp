@@ -21,6 +21,7 @@
 
 #include "client_connection.h"
 
+#include "lib/netplay/connection_receive_worker.h"
 #include "lib/netplay/error_categories.h"
 #include "lib/netplay/pending_writes_manager.h"
 #include "lib/netplay/polling_util.h"
@@ -35,6 +36,8 @@ IClientConnection::IClientConnection(WzConnectionProvider& connProvider, WzCompr
 	readAllDescriptorSet_(connProvider.newDescriptorSet(PollEventType::READABLE))
 {}
 
+IClientConnection::~IClientConnection() = default;
+
 net::result<ssize_t> IClientConnection::readAll(void* buf, size_t size, unsigned timeout)
 {
 	ASSERT_OR_RETURN(tl::make_unexpected(make_network_error_code(EINVAL)),
@@ -98,6 +101,33 @@ net::result<ssize_t> IClientConnection::readNoInt(void* buf, size_t max_size, si
 		return tl::make_unexpected(make_network_error_code(EBADF));
 	}
 
+	if (asyncDecompressionRequested_ && !receiveWorker_ && isCompressed() && compressionAdapter_->decompressionNeedInput())
+	{
+		// All input received so far is decompressed, so the worker can take over the decompression stream.
+		receiveWorker_ = std::make_unique<ConnectionReceiveWorker>(*compressionAdapter_);
+	}
+
+	if (receiveWorker_)
+	{
+		if (readReady())
+		{
+			receiveBuffer_.resize(max_size);
+			const auto recvRes = recvImpl(reinterpret_cast<char*>(receiveBuffer_.data()), receiveBuffer_.size());
+			if (!recvRes.has_value())
+			{
+				return recvRes;
+			}
+			setReadReady(false);
+			const auto received = recvRes.value();
+			if (rawByteCount)
+			{
+				*rawByteCount = received;
+			}
+			receiveWorker_->submit(std::vector<uint8_t>(receiveBuffer_.begin(), receiveBuffer_.begin() + received));
+		}
+		return receiveWorker_->read(buf, max_size);  // Whatever has been decompressed so far.
+	}
+
 	if (isCompressed())
 	{
 		if (compressionAdapter_->decompressionNeedInput())
@@ -253,7 +283,25 @@ net::result<void> IClientConnection::flush(size_t* rawByteCount)
 	return {};
 }
 
-void IClientConnection::enableCompression()
+net::result<void> IClientConnection::writeSharedFrame(const std::vector<uint8_t>& frame)
+{
+	if (!isValid())
+	{
+		debug(LOG_ERROR, "IClientConnection::writeSharedFrame: Invalid socket (EBADF)");
+		return tl::make_unexpected(make_network_error_code(EBADF));
+	}
+
+	auto writeErr = writeErrorCode();
+	if (writeErr.has_value())
+	{
+		return tl::make_unexpected(writeErr.value());
+	}
+
+	ASSERT_OR_RETURN(tl::make_unexpected(make_network_error_code(EINVAL)), acceptsSharedFrames(), "Socket doesn't accept shared frames");
+	return compressionAdapter_->appendSharedFrame(frame);
+}
+
+void IClientConnection::enableCompression(WzCompressionAlgorithm algorithm)
 {
 	if (isCompressed_)
 	{
@@ -262,9 +310,14 @@ void IClientConnection::enableCompression()
 
 	ASSERT_OR_RETURN(, compressionProvider_ != nullptr, "Invalid compression provider");
 
-	pwm_->executeUnderLock([this]
+	pwm_->executeUnderLock([this, algorithm]
 	{
-		compressionAdapter_ = compressionProvider_->newCompressionAdapter();
+		compressionAdapter_ = compressionProvider_->newCompressionAdapter(algorithm);
+		if (!compressionAdapter_)
+		{
+			debug(LOG_ERROR, "Unsupported compression algorithm %" PRIu32 ". Sockets won't work properly!", static_cast<uint32_t>(algorithm));
+			return;
+		}
 		const auto initRes = compressionAdapter_->initialize();
 		if (!initRes.has_value())
 		{
@@ -276,8 +329,20 @@ void IClientConnection::enableCompression()
 	});
 }
 
+void IClientConnection::enableAsyncDecompression()
+{
+	asyncDecompressionRequested_ = true;
+}
+
+bool IClientConnection::hasAsyncReceivedData()
+{
+	return receiveWorker_ && receiveWorker_->hasOutput();
+}
+
 void IClientConnection::close()
 {
+	// The worker uses the compression adapter, so must stop before the connection goes away.
+	receiveWorker_.reset();
 	pwm_->safeDispose(this);
 }
 
@@ -32,14 +32,15 @@
 #include "lib/framework/types.h" // bring in `ssize_t` for MSVC
 #include "lib/netplay/net_result.h"
 #include "lib/netplay/compression_adapter.h"
+#include "lib/netplay/wz_compression_provider.h" // for `WzCompressionAlgorithm`
 
 #include <nonstd/optional.hpp>
 using nonstd::optional;
 using nonstd::nullopt;
 
+class ConnectionReceiveWorker;
 class IDescriptorSet;
 class PendingWritesManager;
-class WzCompressionProvider;
 class WzConnectionProvider;
 
 /// <summary>
@@ -145,18 +146,47 @@ public:
 	/// to the submission queue by the flush operation.</param>
 	net::result<void> flush(size_t* rawByteCount);
 	/// <summary>
+	/// Queues a frame made by an `ISharedFrameCompressor`, as if the data
+	/// compressed into it had been written with `writeAll()`.
+	///
+	/// Only valid if `acceptsSharedFrames()` is `true`. Like with `writeAll()`,
+	/// the data is sent by the next `flush()`.
+	/// </summary>
+	/// <param name="frame">Complete frame, see `ISharedFrameCompressor::finishFrame()`</param>
+	net::result<void> writeSharedFrame(const std::vector<uint8_t>& frame);
+	/// <summary>
 	/// Enables compression for the current socket.
 	///
 	/// This makes all subsequent write operations asynchronous, plus
 	/// the written data will need to be flushed explicitly at some point.
+	///
+	/// Both sides of the connection must use the same `algorithm`, which is
+	/// negotiated during the connection handshake.
 	/// </summary>
-	void enableCompression();
+	void enableCompression(WzCompressionAlgorithm algorithm = WzCompressionAlgorithm::Zlib);
 
 	bool isCompressed() const
 	{
 		return isCompressed_;
 	}
 
+	/// <summary>
+	/// Makes `readNoInt()` decompress the received data on a separate thread (see `ConnectionReceiveWorker`).
+	/// `readNoInt()` then returns the data decompressed so far, which may be nothing even if the socket
+	/// was ready for reading, so use `hasAsyncReceivedData()` to check for more decompressed data.
+	///
+	/// Only has an effect on compressed connections. Takes effect once the decompression
+	/// stream has consumed all input received so far.
+	/// </summary>
+	void enableAsyncDecompression();
+	/// Whether `readNoInt()` has decompressed data (or an error) to return, even if the socket isn't ready for reading.
+	bool hasAsyncReceivedData();
+
+	bool acceptsSharedFrames() const
+	{
+		return isCompressed_ && compressionAdapter_->supportsSharedFrames();
+	}
+
 	ICompressionAdapter& compressionAdapter()
 	{
 		return *compressionAdapter_;
@@ -224,7 +254,7 @@ protected:
 	// Hide the destructor so that external code cannot accidentally
 	// `delete` the connection directly and has to use `close()` method
 	// to dispose of the connection object.
-	virtual ~IClientConnection() = default;
+	virtual ~IClientConnection();
 
 	// Pre-allocated (in ctor) connection list and descriptor sets, which
 	// only contain `this`.
@@ -262,6 +292,9 @@ private:
 
 	std::unique_ptr<ICompressionAdapter> compressionAdapter_;
 	std::unique_ptr<IDescriptorSet> readAllDescriptorSet_;
+	std::unique_ptr<ConnectionReceiveWorker> receiveWorker_;
+	std::vector<uint8_t> receiveBuffer_;  // Raw data for `receiveWorker_` is received here first.
+	bool asyncDecompressionRequested_ = false;
 	bool deleteLater_ = false;
 	bool isCompressed_ = false;
 };
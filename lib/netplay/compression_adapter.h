@@ -137,4 +137,65 @@ public:
 	/// </summary>
 	/// <param name="size">New size for the decompression input stream</param>
 	virtual void resetDecompressionStreamInputSize(size_t size) = 0;
+
+	/// <summary>
+	/// Returns `true` if frames made by the `ISharedFrameCompressor` of the same
+	/// compression algorithm can be appended to this compression stream
+	/// with `appendSharedFrame()`.
+	/// </summary>
+	virtual bool supportsSharedFrames() const = 0;
+	/// <summary>
+	/// Flushes the internal compression stream to the output buffer, in a way that
+	/// allows the stream to continue with data compressed elsewhere, and then appends
+	/// `frame` (as made by an `ISharedFrameCompressor`) to the output buffer.
+	///
+	/// The receiving side decompresses the frame as if it were part of this stream.
+	/// </summary>
+	/// <param name="frame">A complete frame, see `ISharedFrameCompressor::finishFrame()`</param>
+	/// <returns>
+	/// In case of failure, returns an error code describing the error.
+	/// </returns>
+	virtual net::result<void> appendSharedFrame(const std::vector<uint8_t>& frame) = 0;
+};
+
+/// <summary>
+/// Compresses data once into self-contained frames, which can then be appended to
+/// any number of compression streams (see `ICompressionAdapter::appendSharedFrame()`).
+///
+/// Used to send the same data to many connections without compressing it
+/// separately for each one of them.
+/// </summary>
+class ISharedFrameCompressor
+{
+public:
+
+	virtual ~ISharedFrameCompressor() = default;
+
+	/// <summary>
+	/// Initializes the compression stream, must be called before anything else.
+	/// </summary>
+	/// <returns>
+	/// In case of failure, returns an error code describing the error.
+	/// </returns>
+	virtual net::result<void> initialize() = 0;
+	/// <summary>
+	/// Compresses `size` bytes from `src` into the current frame.
+	/// </summary>
+	/// <returns>
+	/// In case of failure, returns an error code describing the error.
+	/// </returns>
+	virtual net::result<void> compress(const void* src, size_t size) = 0;
+	/// <summary>
+	/// Completes the current frame in `frameBuffer()`. The frame doesn't depend on
+	/// any data compressed before it, so the next `compress()` call starts a new frame.
+	/// </summary>
+	/// <returns>
+	/// In case of failure, returns an error code describing the error.
+	/// </returns>
+	virtual net::result<void> finishFrame() = 0;
+	/// <summary>
+	/// Accessor function for the output buffer of `compress()` and `finishFrame()`.
+	/// Should be cleared by the caller once the frame has been used.
+	/// </summary>
+	virtual std::vector<uint8_t>& frameBuffer() = 0;
 };
@@ -0,0 +1,155 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2025  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "connection_receive_worker.h"
+
+#include "lib/framework/frame.h" // for ASSERT
+#include "lib/framework/wzapp.h"
+#include "lib/netplay/compression_adapter.h"
+
+#include <algorithm>
+#include <cstring>
+
+// Decompressed data is handed over to the main thread in pieces of at most this size.
+static constexpr size_t DECOMPRESSED_CHUNK_SIZE = 64 * 1024;
+
+ConnectionReceiveWorker::ConnectionReceiveWorker(ICompressionAdapter& compressionAdapter)
+	: compressionAdapter_(compressionAdapter)
+	, input_(64)
+	, output_(64)
+{
+	thread_ = wzThreadCreate(connectionReceiveWorkerThreadFunction, reinterpret_cast<void*>(this), "WzNetReceive");
+	wzThreadStart(thread_);
+}
+
+ConnectionReceiveWorker::~ConnectionReceiveWorker()
+{
+	input_.enqueue(std::vector<uint8_t>());  // Ask the thread to stop.
+	wzThreadJoin(thread_);
+	thread_ = nullptr;
+}
+
+void ConnectionReceiveWorker::submit(std::vector<uint8_t>&& compressedData)
+{
+	if (compressedData.empty())
+	{
+		return;  // Would stop the thread.
+	}
+	input_.enqueue(std::move(compressedData));
+}
+
+bool ConnectionReceiveWorker::hasOutput()
+{
+	return currentPos_ < current_.data.size() || current_.error.has_value() || output_.peek() != nullptr;
+}
+
+net::result<ssize_t> ConnectionReceiveWorker::read(void* buf, size_t max_size)
+{
+	size_t copied = 0;
+	while (copied < max_size)
+	{
+		if (currentPos_ == current_.data.size())
+		{
+			if (current_.error.has_value())
+			{
+				if (copied > 0)
+				{
+					break;  // Return the error with the next call.
+				}
+				return tl::make_unexpected(current_.error.value());
+			}
+			if (!output_.try_dequeue(current_))
+			{
+				break;  // Nothing more decompressed yet.
+			}
+			currentPos_ = 0;
+			continue;
+		}
+		const size_t count = std::min(max_size - copied, current_.data.size() - currentPos_);
+		memcpy(static_cast<uint8_t*>(buf) + copied, current_.data.data() + currentPos_, count);
+		copied += count;
+		currentPos_ += count;
+	}
+	return static_cast<ssize_t>(copied);
+}
+
+void ConnectionReceiveWorker::decompress(std::vector<uint8_t>& compressedData)
+{
+	// Same as the compressed case of `IClientConnection::readNoInt()`, except for
+	// decompressing all the input at once.
+	const size_t inputSize = compressedData.size();
+	compressionAdapter_.decompressionInBuffer().swap(compressedData);
+	compressionAdapter_.resetDecompressionStreamInputSize(inputSize);
+	compressionAdapter_.setDecompressionNeedInput(false);
+
+	for (;;)
+	{
+		Output out;
+		out.data.resize(DECOMPRESSED_CHUNK_SIZE);
+		const auto decompressRes = compressionAdapter_.decompress(out.data.data(), out.data.size());
+		if (!decompressRes.has_value())
+		{
+			out.data.clear();
+			out.error = decompressRes.error();
+			output_.enqueue(std::move(out));
+			failed_ = true;
+			return;
+		}
+		const size_t availableSpace = compressionAdapter_.availableSpaceToDecompress();
+		out.data.resize(DECOMPRESSED_CHUNK_SIZE - availableSpace);
+		if (!out.data.empty())
+		{
+			output_.enqueue(std::move(out));
+		}
+		if (availableSpace != 0)
+		{
+			compressionAdapter_.setDecompressionNeedInput(true);
+			ASSERT(compressionAdapter_.decompressionStreamConsumedAllInput(), "Compression algorithm impl not consuming all input!");
+			return;
+		}
+	}
+}
+
+void ConnectionReceiveWorker::threadImplFunction()
+{
+	std::vector<uint8_t> compressedData;
+	for (;;)
+	{
+		input_.wait_dequeue(compressedData);
+		if (compressedData.empty())
+		{
+			return;  // Stop requested.
+		}
+		if (!failed_)
+		{
+			decompress(compressedData);
+		}
+		compressedData.clear();
+	}
+}
+
+int connectionReceiveWorkerThreadFunction(void* data)
+{
+	ConnectionReceiveWorker* inst = reinterpret_cast<ConnectionReceiveWorker*>(data);
+	inst->threadImplFunction();
+	// Return value ignored
+	return 0;
+}
@@ -0,0 +1,105 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2025  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#pragma once
+
+#include <system_error>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <3rdparty/readerwriterqueue/readerwriterqueue.h>
+
+#include "lib/framework/types.h" // bring in `ssize_t` for MSVC
+#include "lib/netplay/net_result.h"
+
+#include <nonstd/optional.hpp>
+using nonstd::optional;
+using nonstd::nullopt;
+
+struct WZ_THREAD;
+
+class ICompressionAdapter;
+
+/// This is a wrapper function that acts as a proxy to `ConnectionReceiveWorker::threadImplFunction`.
+/// Argument is `ConnectionReceiveWorker*` cast to `void*`.
+int connectionReceiveWorkerThreadFunction(void*);
+
+/// <summary>
+/// Decompresses the data received on a compressed connection on a separate thread,
+/// so that a large burst of data from one client doesn't hold up the main thread.
+///
+/// This is the receive-side counterpart of `PendingWritesManager`: the main thread still
+/// receives the raw data (since polling the connections isn't thread-safe with all backends),
+/// and hands it over with `submit()`. The worker feeds it to the decompression stream of the
+/// connection, and the main thread picks up the decompressed data with `read()`.
+///
+/// Both directions use single-producer single-consumer queues, so the main thread never waits
+/// for the worker. Only the worker touches the decompression side of the compression adapter
+/// from then on, while the main thread keeps using the compression side.
+///
+/// Owned by `IClientConnection` (see `IClientConnection::enableAsyncDecompression()`), and
+/// stopped before the connection gets disposed of.
+/// </summary>
+class ConnectionReceiveWorker
+{
+public:
+
+	explicit ConnectionReceiveWorker(ICompressionAdapter& compressionAdapter);
+	~ConnectionReceiveWorker();
+
+	ConnectionReceiveWorker(const ConnectionReceiveWorker&) = delete;
+	ConnectionReceiveWorker(ConnectionReceiveWorker&&) = delete;
+
+	/// Queues data received from the network for decompression. Main thread only.
+	void submit(std::vector<uint8_t>&& compressedData);
+
+	/// <summary>
+	/// Reads at most `max_size` bytes of the data decompressed so far into `buf`. Main thread only.
+	/// </summary>
+	/// <returns>The number of bytes read, which is 0 if nothing is ready yet, or the
+	/// error which made the worker stop, once all the data before it has been read.</returns>
+	net::result<ssize_t> read(void* buf, size_t max_size);
+
+	/// Whether `read()` would return something right now. Main thread only.
+	bool hasOutput();
+
+private:
+
+	struct Output
+	{
+		std::vector<uint8_t> data;
+		optional<std::error_code> error;
+	};
+
+	friend int connectionReceiveWorkerThreadFunction(void*);
+
+	void threadImplFunction();
+	void decompress(std::vector<uint8_t>& compressedData);
+
+	ICompressionAdapter& compressionAdapter_;
+	moodycamel::BlockingReaderWriterQueue<std::vector<uint8_t>> input_;  ///< An empty buffer asks the worker to stop.
+	moodycamel::ReaderWriterQueue<Output> output_;
+	WZ_THREAD* thread_ = nullptr;
+	bool failed_ = false;           ///< Worker thread only.
+	Output current_;                ///< Main thread only, the output being read.
+	size_t currentPos_ = 0;         ///< Main thread only, how much of `current_` has been read.
+};
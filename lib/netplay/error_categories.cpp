@@ -30,6 +30,10 @@
 #endif
 
 #include <zlib.h>
+#if defined(WZ_NETPLAY_ZSTD)
+# include <zstd.h>
+# include <zstd_errors.h>
+#endif
 
 std::string GenericSystemErrorCategory::message(int ev) const
 {
@@ -122,6 +126,13 @@ std::string ZlibErrorCategory::message(int ev) const
 	}
 }
 
+#if defined(WZ_NETPLAY_ZSTD)
+std::string ZstdErrorCategory::message(int ev) const
+{
+	return ZSTD_getErrorString(static_cast<ZSTD_ErrorCode>(ev));
+}
+#endif
+
 const std::error_category& generic_system_error_category()
 {
 	static GenericSystemErrorCategory instance;
@@ -154,3 +165,17 @@ std::error_code make_zlib_error_code(int ev)
 {
 	return { ev, zlib_error_category() };
 }
+
+#if defined(WZ_NETPLAY_ZSTD)
+
+const std::error_category& zstd_error_category()
+{
+	static ZstdErrorCategory instance;
+	return instance;
+}
+
+std::error_code make_zstd_error_code(size_t zstdResult)
+{
+	return { static_cast<int>(ZSTD_getErrorCode(zstdResult)), zstd_error_category() };
+}
+#endif
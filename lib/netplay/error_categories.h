@@ -88,6 +88,26 @@ public:
 	std::string message(int ev) const override;
 };
 
+#if defined(WZ_NETPLAY_ZSTD)
+/// <summary>
+/// Custom error category which maps error codes from Zstd (as returned by
+/// `ZSTD_getErrorCode()`) to the appropriate error messages.
+/// </summary>
+class ZstdErrorCategory : public std::error_category
+{
+public:
+
+	constexpr ZstdErrorCategory() = default;
+
+	const char* name() const noexcept override
+	{
+		return "zstd";
+	}
+
+	std::string message(int ev) const override;
+};
+#endif
+
 const std::error_category& generic_system_error_category();
 const std::error_category& getaddrinfo_error_category();
 const std::error_category& zlib_error_category();
@@ -95,3 +115,8 @@ const std::error_category& zlib_error_category();
 std::error_code make_network_error_code(int ev);
 std::error_code make_getaddrinfo_error_code(int ev);
 std::error_code make_zlib_error_code(int ev);
+#if defined(WZ_NETPLAY_ZSTD)
+const std::error_category& zstd_error_category();
+/// Makes an error code from the result of a Zstd function, for which `ZSTD_isError()` is true.
+std::error_code make_zstd_error_code(size_t zstdResult);
+#endif
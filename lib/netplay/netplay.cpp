@@ -45,6 +45,7 @@
 #include <limits>
 #include <sodium.h>
 #include <chrono>
+#include <array>
 
 #include "netplay.h"
 #include "netlog.h"
@@ -56,6 +57,8 @@
 #include "lib/netplay/connection_provider_registry.h"
 #include "lib/netplay/pending_writes_manager.h"
 #include "lib/netplay/pending_writes_manager_map.h"
+#include "lib/netplay/wz_compression_provider.h"
+#include "lib/netplay/compression_adapter.h"
 #include "netpermissions.h"
 #include "sync_debug.h"
 #include "port_mapping_manager.h"
@@ -117,6 +120,8 @@ static void NETplayerDropped(UDWORD player);		// Broadcast NET_PLAYER_DROPPED &
 static void NETallowJoining();
 static void NETfixPlayerCount();
 static void NETclientHandleHostDisconnected();
+static void NETresetBroadcastFrame();
+static void NETcloseBroadcastFrame();
 /*
  * Network globals, these are part of the new network API
  */
@@ -258,6 +263,12 @@ static IListenSocket* server_listen_socket = nullptr;
 static IClientConnection* bsocket = nullptr;                  ///< Socket used to talk to the host (clients only). If bsocket != NULL, then client_transient_socket == NULL.
 static optional<std::string> lastHostAddress = nullopt;
 static IClientConnection* connected_bsocket[MAX_CONNECTED_PLAYERS] = { nullptr };  ///< Sockets used to talk to clients (host only).
+// Broadcasts to clients whose sockets accept shared frames are compressed only once, into a frame which is then
+// appended to the compression stream of each of those sockets (host only). Consecutive broadcasts to the same
+// set of clients go into the same frame, which is closed before anything else is written to one of its recipients.
+static std::unique_ptr<ISharedFrameCompressor> broadcastFrameCompressor;
+static std::array<IClientConnection*, MAX_CONNECTED_PLAYERS> broadcastFrameRecipients = {};  ///< Recipients of the open frame (nullptr if not a recipient).
+static bool broadcastFrameOpen = false;
 // Client-side socket set. Contains of only 1 socket at most: `bsocket` (which is a stable client connection to the host).
 static IConnectionPollGroup* client_socket_set = nullptr;
 // Server-side socket set. Contains up to `MAX_CONNECTED_PLAYERS` sockets:
@@ -273,7 +284,7 @@ struct TmpSocketInfo
 {
 	std::string ip;
 	std::chrono::steady_clock::time_point connectTime;
-	char buffer[10] = {'\0'};
+	char buffer[16] = {'\0'};
 	size_t usedBuffer = 0;
 	std::vector<uint8_t> connectChallenge;
 	enum class TmpConnectState
@@ -351,6 +362,8 @@ static NETSTATS nStats              = {{0, 0}, {0, 0}, {0, 0}};
 static NETSTATS nStatsLastSec       = {{0, 0}, {0, 0}, {0, 0}};
 static NETSTATS nStatsSecondLastSec = {{0, 0}, {0, 0}, {0, 0}};
 static const NETSTATS nZeroStats    = {{0, 0}, {0, 0}, {0, 0}};
+static NetMessageBufferCounters nBufferCountersLastSec;
+static NetMessageBufferCounters nBufferCountersSecondLastSec;
 static int nStatsLastUpdateTime = 0;
 
 unsigned NET_PlayerConnectionStatus[CONNECTIONSTATUS_NORMAL][MAX_CONNECTED_PLAYERS];
@@ -584,7 +597,7 @@ static size_t NET_fillBuffer(IClientConnection** pSocket, IConnectionPollGroup*
 {
 	IClientConnection* socket = *pSocket;
 
-	if (!socket->readReady())
+	if (!socket->readReady() && !socket->hasAsyncReceivedData())
 	{
 		return 0;
 	}
@@ -1073,6 +1086,7 @@ static void NETplayerCloseSocket(UDWORD index, bool quietSocketClose)
 		server_socket_set->remove(connected_bsocket[index]);
 		connected_bsocket[index]->close();
 		connected_bsocket[index] = nullptr;
+		broadcastFrameRecipients[index] = nullptr;
 	}
 	else
 	{
@@ -1716,6 +1730,9 @@ int NETshutdown()
 	nStats = nZeroStats;
 	nStatsLastSec = nZeroStats;
 	nStatsSecondLastSec = nZeroStats;
+	netMessageBufferCounters() = NetMessageBufferCounters();
+	nBufferCountersLastSec = NetMessageBufferCounters();
+	nBufferCountersSecondLastSec = NetMessageBufferCounters();
 
 	return 0;
 }
@@ -1747,6 +1764,7 @@ int NETclose()
 	server_not_there = false;
 	allow_joining = false;
 
+	NETresetBroadcastFrame();
 	for (i = 0; i < MAX_CONNECTED_PLAYERS; i++)
 	{
 		if (connected_bsocket[i])
@@ -1815,6 +1833,19 @@ int NETclose()
 // ////////////////////////////////////////////////////////////////////////
 // Send and Recv functions
 
+static void NETupdateStatisticSnapshots()
+{
+	int time = wzGetTicks();
+	if ((unsigned)(time - nStatsLastUpdateTime) >= (unsigned)GAME_TICKS_PER_SEC)
+	{
+		nStatsLastUpdateTime = time;
+		nStatsSecondLastSec = nStatsLastSec;
+		nStatsLastSec = nStats;
+		nBufferCountersSecondLastSec = nBufferCountersLastSec;
+		nBufferCountersLastSec = netMessageBufferCounters();
+	}
+}
+
 // ////////////////////////////////////////////////////////////////////////
 // return bytes of data sent recently.
 size_t NETgetStatistic(NetStatisticType type, bool sent, bool isTotal)
@@ -1829,13 +1860,7 @@ size_t NETgetStatistic(NetStatisticType type, bool sent, bool isTotal)
 	default: ASSERT(false, " "); return 0;
 	}
 
-	int time = wzGetTicks();
-	if ((unsigned)(time - nStatsLastUpdateTime) >= (unsigned)GAME_TICKS_PER_SEC)
-	{
-		nStatsLastUpdateTime = time;
-		nStatsSecondLastSec = nStatsLastSec;
-		nStatsLastSec = nStats;
-	}
+	NETupdateStatisticSnapshots();
 
 	if (isTotal)
 	{
@@ -1844,6 +1869,27 @@ size_t NETgetStatistic(NetStatisticType type, bool sent, bool isTotal)
 	return nStatsLastSec.*statsType.*statisticType - nStatsSecondLastSec.*statsType.*statisticType;
 }
 
+// ////////////////////////////////////////////////////////////////////////
+// return how often message data was allocated or copied recently.
+size_t NETgetBufferStatistic(NetBufferStatisticType type, bool isTotal)
+{
+	size_t NetMessageBufferCounters::*counter;
+	switch (type)
+	{
+	case NetBufferStatisticAllocations: counter = &NetMessageBufferCounters::allocations; break;
+	case NetBufferStatisticCopiedBytes: counter = &NetMessageBufferCounters::copiedBytes; break;
+	default: ASSERT(false, " "); return 0;
+	}
+
+	NETupdateStatisticSnapshots();
+
+	if (isTotal)
+	{
+		return netMessageBufferCounters().*counter;
+	}
+	return nBufferCountersLastSec.*counter - nBufferCountersSecondLastSec.*counter;
+}
+
 static std::set<uint32_t> netSendPendingDisconnectPlayerIndexes;
 
 void NETsendProcessDelayedActions()
@@ -1870,6 +1916,61 @@ void NETsendProcessDelayedActions()
 	NETplayerClientsDisconnect(pendingDisconnectPlayers);
 }
 
+/// Drops the open broadcast frame, without sending it.
+static void NETresetBroadcastFrame()
+{
+	if (broadcastFrameCompressor)
+	{
+		if (broadcastFrameOpen)
+		{
+			// Finish it anyway, so that nothing is left in the compression stream for the next frame.
+			broadcastFrameCompressor->finishFrame();
+		}
+		broadcastFrameCompressor->frameBuffer().clear();
+	}
+	broadcastFrameRecipients.fill(nullptr);
+	broadcastFrameOpen = false;
+}
+
+/// Appends the open broadcast frame (if any) to the sockets of its recipients.
+static void NETcloseBroadcastFrame()
+{
+	if (!broadcastFrameOpen)
+	{
+		return;
+	}
+	broadcastFrameOpen = false;
+
+	if (!broadcastFrameCompressor->finishFrame().has_value())
+	{
+		debug(LOG_ERROR, "Failed to finish broadcast frame");
+	}
+	auto& frame = broadcastFrameCompressor->frameBuffer();
+	for (uint32_t player = 0; player < MAX_CONNECTED_PLAYERS; ++player)
+	{
+		IClientConnection* recipient = broadcastFrameRecipients[player];
+		if (recipient == nullptr)
+		{
+			continue;
+		}
+		if (recipient != connected_bsocket[player])
+		{
+			ASSERT(false, "Socket of player %" PRIu32 " changed with a broadcast frame pending", player);
+			continue;
+		}
+		const auto writeResult = recipient->writeSharedFrame(frame);
+		if (!writeResult.has_value())
+		{
+			const auto writeErrMsg = writeResult.error().message();
+			// Write error, most likely client disconnect.
+			debug(LOG_ERROR, "Failed to send broadcast frame (size: %zu) to %" PRIu32 ": %s", frame.size(), player, writeErrMsg.c_str());
+			netSendPendingDisconnectPlayerIndexes.insert(player);
+		}
+	}
+	frame.clear();
+	broadcastFrameRecipients.fill(nullptr);
+}
+
 // ////////////////////////////////////////////////////////////////////////
 // Send a message to a player, option to guarantee message
 bool NETsend(NETQUEUE queue, NetMessage const& message)
@@ -1903,6 +2004,8 @@ bool NETsend(NETQUEUE queue, NetMessage const& message)
 
 	if (NetPlay.isHost)
 	{
+		std::array<IClientConnection*, MAX_CONNECTED_PLAYERS> frameRecipients = {};
+		size_t frameRecipientCount = 0;
 		int firstPlayer = player == NET_ALL_PLAYERS ? 0                         : player;
 		int lastPlayer  = player == NET_ALL_PLAYERS ? MAX_CONNECTED_PLAYERS - 1 : player;
 		for (player = firstPlayer; player <= lastPlayer; ++player)
@@ -1910,16 +2013,30 @@ bool NETsend(NETQUEUE queue, NetMessage const& message)
 			// We are the host, send directly to player.
 			if (sockets[player] != nullptr && player != queue.exclude)
 			{
-				const auto& rawData = message.rawData();
-				if (rawData.empty())
+				if (!isTmpQueue)
+				{
+					if (queue.queueType == QUEUE_BROADCAST && broadcastFrameCompressor && sockets[player]->acceptsSharedFrames())
+					{
+						// Compressed below, once for all of these.
+						frameRecipients[player] = sockets[player];
+						++frameRecipientCount;
+						continue;
+					}
+					if (broadcastFrameRecipients[player] != nullptr)
+					{
+						NETcloseBroadcastFrame();  // Earlier broadcasts must arrive first.
+					}
+				}
+				const uint8_t* rawData = message.rawData();
+				if (message.rawDataSize() == 0)
 				{
 					debug(LOG_FATAL, "Failed to allocate raw data (message type: %" PRIu8 ", player: %d)", message.type(), player);
 					abort();
 				}
 				uint8_t msgType = message.type();
-				ssize_t rawLen = rawData.size();
+				ssize_t rawLen = message.rawDataSize();
 				size_t compressedRawLen;
-				const auto writeResult = sockets[player]->writeAll(rawData.data(), rawLen, &compressedRawLen);
+				const auto writeResult = sockets[player]->writeAll(rawData, rawLen, &compressedRawLen);
 				const auto res = writeResult.value_or(SOCKET_ERROR);
 
 				if (res == rawLen)
@@ -1941,6 +2058,33 @@ bool NETsend(NETQUEUE queue, NetMessage const& message)
 				}
 			}
 		}
+		if (frameRecipientCount > 0)
+		{
+			if (broadcastFrameOpen && frameRecipients != broadcastFrameRecipients)
+			{
+				NETcloseBroadcastFrame();
+			}
+			if (!broadcastFrameOpen)
+			{
+				broadcastFrameRecipients = frameRecipients;
+				broadcastFrameOpen = true;
+			}
+			const uint8_t* rawData = message.rawData();
+			if (message.rawDataSize() == 0)
+			{
+				debug(LOG_FATAL, "Failed to allocate raw data (message type: %" PRIu8 ", broadcast)", message.type());
+				abort();
+			}
+			const auto compressResult = broadcastFrameCompressor->compress(rawData, message.rawDataSize());
+			if (!compressResult.has_value())
+			{
+				const auto compressErrMsg = compressResult.error().message();
+				debug(LOG_ERROR, "Failed to compress broadcast message (type: %" PRIu8 ", rawLen: %zu): %s", message.type(), message.rawDataSize(), compressErrMsg.c_str());
+				return false;
+			}
+			nStats.uncompressedBytes.sent += message.rawDataSize() * frameRecipientCount;
+			nStats.packets.sent           += frameRecipientCount;
+		}
 		return true;
 	}
 	else if (player == NetPlay.hostPlayer)
@@ -1948,10 +2092,10 @@ bool NETsend(NETQUEUE queue, NetMessage const& message)
 		// We are a client, send directly to player, who happens to be the host.
 		if (bsocket && NetPlay.isHostAlive)
 		{
-			const auto& rawData = message.rawData();
-			ssize_t rawLen = rawData.size();
+			const uint8_t* rawData = message.rawData();
+			ssize_t rawLen = message.rawDataSize();
 			size_t compressedRawLen;
-			const auto writeResult = bsocket->writeAll(rawData.data(), rawLen, &compressedRawLen);
+			const auto writeResult = bsocket->writeAll(rawData, rawLen, &compressedRawLen);
 			const auto res = writeResult.value_or(SOCKET_ERROR);
 
 			if (res == rawLen)
@@ -2051,6 +2195,8 @@ void NETflush()
 	size_t compressedRawLen = 0;
 	if (NetPlay.isHost)
 	{
+		NETcloseBroadcastFrame();
+
 		// Preliminary check to see if any player sockets are still valid.
 		std::set<uint32_t> invalidPlayerIndices;
 		for (int player = 0; player < MAX_CONNECTED_PLAYERS; ++player)
@@ -2129,6 +2275,7 @@ static bool swapPlayerIndexes(uint32_t playerIndexA, uint32_t playerIndexB)
 	NETend(w);
 
 	// Then swap the networking stuff for these slots
+	NETcloseBroadcastFrame(); // the NET_PLAYER_SWAP_INDEX message must go to the sockets as they were
 	std::swap(connected_bsocket[playerIndexA], connected_bsocket[playerIndexB]);
 	// should be no need to call SocketSet_AddSocket, since should already be in the socket_set
 	NETswapQueues(NETnetQueue(playerIndexA), NETnetQueue(playerIndexB));
@@ -2635,6 +2782,8 @@ static bool NETprocessSystemMessage(NETQUEUE playerQueue, uint8_t *type)
 			NETuint8_t(r, receiver);
 			NETnetMessage(r, &message);  // Must delete message later.
 			std::unique_ptr<NetMessage> deleteLater(message);
+			// If the embedded message is the (unmodified) end of this one, this one can be relayed as it is.
+			const bool canRelayAsIs = r.atEnd() && message->rawData() + message->rawDataSize() == r.msgData + r.msgSize;
 			if (!NETend(r))
 			{
 				debug(LOG_ERROR, "Incomplete NET_SEND_TO_PLAYER.");
@@ -2650,7 +2799,7 @@ static bool NETprocessSystemMessage(NETQUEUE playerQueue, uint8_t *type)
 				// Message was sent to us via the host.
 				if (sender != selectedPlayer)  // Make sure host didn't send us our own broadcast messages, which shouldn't happen anyway.
 				{
-					NETlogPacket(message->type(), static_cast<uint32_t>(message->rawData().size()), true);
+					NETlogPacket(message->type(), static_cast<uint32_t>(message->rawDataSize()), true);
 					NETinsertMessageFromNet(NETnetQueue(sender), std::move(*message));
 				}
 			}
@@ -2727,14 +2876,22 @@ static bool NETprocessSystemMessage(NETQUEUE playerQueue, uint8_t *type)
 					LogChatMsg(msgType, *message, sender, receiver);
 				}
 
-				size_t rawLen = message->rawData().size();
+				size_t rawLen = message->rawDataSize();
 
 				// We are the host, and player is asking us to send the message to receiver.
-				auto w = NETbeginEncode(NETnetQueue(receiver, sender), NET_SEND_TO_PLAYER);
-				NETuint8_t(w, sender);
-				NETuint8_t(w, receiver);
-				NETnetMessage(w, *message);
-				NETend(w);
+				if (canRelayAsIs)
+				{
+					// Same data as re-encoding it below would give, but without copying.
+					NETforward(NETnetQueue(receiver, sender), *r.message);
+				}
+				else
+				{
+					auto w = NETbeginEncode(NETnetQueue(receiver, sender), NET_SEND_TO_PLAYER);
+					NETuint8_t(w, sender);
+					NETuint8_t(w, receiver);
+					NETnetMessage(w, *message);
+					NETend(w);
+				}
 
 				if (receiver == NET_ALL_PLAYERS)
 				{
@@ -2785,7 +2942,7 @@ static bool NETprocessSystemMessage(NETQUEUE playerQueue, uint8_t *type)
 			{
 				NETnetMessage(r, &message);
 
-				NETlogPacket(message->type(), static_cast<uint32_t>(message->rawData().size()), true);
+				NETlogPacket(message->type(), static_cast<uint32_t>(message->rawDataSize()), true);
 				NETinsertMessageFromNet(NETgameQueue(player), std::move(*message));
 
 				delete message;
@@ -3131,6 +3288,24 @@ static void NETcheckPlayers()
 	}
 }
 
+// Whether any client connection has data decompressed by its receive worker, which
+// NET_fillBuffer() can read even if nothing new arrived.
+static bool NETanyAsyncReceivedData()
+{
+	if (!NetPlay.isHost)
+	{
+		return false;
+	}
+	for (IClientConnection* socket : connected_bsocket)
+	{
+		if (socket != nullptr && socket->hasAsyncReceivedData())
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
 // ////////////////////////////////////////////////////////////////////////
 // Receive a message over the current connection. We return true if there
 // is a message for the higher level code to process, and false otherwise.
@@ -3157,7 +3332,7 @@ bool NETrecvNet(NETQUEUE *queue, uint8_t *type)
 	}
 
 	IConnectionPollGroup* pollGroup = NetPlay.isHost ? server_socket_set : client_socket_set;
-	if (pollGroup == nullptr || pollGroup->checkConnectionsReadable(NET_READ_TIMEOUT).value_or(0) <= 0)
+	if (pollGroup == nullptr || (pollGroup->checkConnectionsReadable(NET_READ_TIMEOUT).value_or(0) <= 0 && !NETanyAsyncReceivedData()))
 	{
 		goto checkMessages;
 	}
@@ -3195,6 +3370,7 @@ bool NETrecvNet(NETQUEUE *queue, uint8_t *type)
 				// Send message type specifically for dropped / disconnects
 				NETplayerDropped(current);
 				connected_bsocket[current] = nullptr;		// clear their socket
+				broadcastFrameRecipients[current] = nullptr;
 			}
 		}
 	}
@@ -4129,6 +4305,7 @@ static void NEThostPromoteTempSocketToPermanentPlayerConnection(unsigned int tem
 	tmp_socket_set->remove(tmp_socket[tempSocketIdx]);
 	connected_bsocket[index] = tmp_socket[tempSocketIdx];
 	tmp_socket[tempSocketIdx] = nullptr;
+	connected_bsocket[index]->enableAsyncDecompression();  // Don't let bursts of data from clients hold up the game.
 	NET_waitingForIndexChangeAckSince[index] = nullopt;
 	server_socket_set->add(connected_bsocket[index]);
 	NETmoveQueue(NETnetTmpQueue(tempSocketIdx), NETnetQueue(index));
@@ -4237,7 +4414,22 @@ static void NETallowJoining()
 			{
 				char *p_buffer = tmp_connectState[i].buffer;
 
-				const auto sizeReadResult = tmp_socket[i]->readNoInt(p_buffer + tmp_connectState[i].usedBuffer, 8 - tmp_connectState[i].usedBuffer, nullptr);
+				// Clients send NETCODE_VERSION_MAJOR and NETCODE_VERSION_MINOR, followed by the mask of the
+				// compression algorithms they support. The mask is only read once the version is known to
+				// match ours, since clients of other versions may not send it.
+				size_t expectedSize = sizeof(uint32_t) * 2;
+				if (tmp_connectState[i].usedBuffer >= expectedSize)
+				{
+					uint32_t sentMajor, sentMinor;
+					memcpy(&sentMajor, p_buffer, sizeof(uint32_t));
+					memcpy(&sentMinor, p_buffer + sizeof(uint32_t), sizeof(uint32_t));
+					if (NETisCorrectVersion(wz_ntohl(sentMajor), wz_ntohl(sentMinor)))
+					{
+						expectedSize += sizeof(uint32_t);
+					}
+				}
+
+				const auto sizeReadResult = tmp_socket[i]->readNoInt(p_buffer + tmp_connectState[i].usedBuffer, expectedSize - tmp_connectState[i].usedBuffer, nullptr);
 				if (sizeReadResult.has_value())
 				{
 					tmp_connectState[i].usedBuffer += sizeReadResult.value();
@@ -4294,16 +4486,26 @@ static void NETallowJoining()
 						}
 						connectFailed = true;
 					}
+					else if (NETisCorrectVersion(major, minor) && tmp_connectState[i].usedBuffer < sizeof(uint32_t) * 3)
+					{
+						// Continue to wait (until timeout) for the supported compression algorithms
+						continue;
+					}
 					else if (NETisCorrectVersion(major, minor))
 					{
-						result = wz_htonl(ERROR_NOERROR);
-						memcpy(&tmp_connectState[i].buffer, &result, sizeof(result));
-						const auto writeResult = tmp_socket[i]->writeAll(&tmp_connectState[i].buffer, sizeof(result), nullptr);
+						uint32_t clientCompressionAlgorithms;
+						memcpy(&clientCompressionAlgorithms, tmp_connectState[i].buffer + sizeof(uint32_t) * 2, sizeof(uint32_t));
+						const WzCompressionAlgorithm compressionAlgorithm = WzCompressionProvider::Instance().negotiateAlgorithm(wz_ntohl(clientCompressionAlgorithms));
+
+						// Reply with the result, followed by the compression algorithm picked for this connection.
+						uint32_t reply[2] = {wz_htonl(ERROR_NOERROR), wz_htonl(static_cast<uint32_t>(compressionAlgorithm))};
+						const auto writeResult = tmp_socket[i]->writeAll(reply, sizeof(reply), nullptr);
 						if (!writeResult.has_value())
 						{
 							debug(LOG_NET, "writeAll to tmpSocket[%u] failed with error?: %d", i, writeResult.error().value());
 						}
-						tmp_socket[i]->enableCompression();
+						debug(LOG_NET, "Using compression algorithm %" PRIu32 " for tmpSocket[%u]", static_cast<uint32_t>(compressionAlgorithm), i);
+						tmp_socket[i]->enableCompression(compressionAlgorithm);
 
 						// Connection is successful.
 						connectFailed = false;
@@ -5004,6 +5206,13 @@ bool NEThostGame(const char *SessionName, const char *PlayerName, bool spectator
 		connected_bsocket[i] = nullptr;
 		NETinitQueue(NETnetQueue(i));
 	}
+	NETresetBroadcastFrame();
+	broadcastFrameCompressor = WzCompressionProvider::Instance().newSharedFrameCompressor();
+	if (!broadcastFrameCompressor->initialize().has_value())
+	{
+		debug(LOG_ERROR, "Failed to initialize broadcast compression, compressing broadcasts for each client separately");
+		broadcastFrameCompressor.reset();
+	}
 
 	NetPlay.isHost = true;
 	NETlogEntry("Hosting game, resetting ban list.", SYNC_FLAG, 0);
@@ -385,6 +385,8 @@ void NETinitPortMapping();
 
 enum NetStatisticType {NetStatisticRawBytes, NetStatisticUncompressedBytes, NetStatisticPackets};
 size_t NETgetStatistic(NetStatisticType type, bool sent, bool isTotal = false);     // Return some statistic. Call regularly for good results.
+enum NetBufferStatisticType {NetBufferStatisticAllocations, NetBufferStatisticCopiedBytes};
+size_t NETgetBufferStatistic(NetBufferStatisticType type, bool isTotal = false);   // Return how often net message data was allocated or copied. Call regularly for good results.
 
 void NETplayerKicked(UDWORD index, bool quiet = false);			// Cleanup after player has been kicked
 
@@ -107,31 +107,47 @@ bool decode_uint32_t(uint8_t b, uint32_t &v, unsigned n)
 	return !isLastByte;
 }
 
+NetMessageBufferCounters& netMessageBufferCounters()
+{
+	static NetMessageBufferCounters counters;
+	return counters;
+}
+
+static std::shared_ptr<const NetMsgDataVector> makeSharedMessageBuffer(NetMsgDataVector&& data)
+{
+	++netMessageBufferCounters().allocations;
+	// The control block comes from the same pool as the data.
+	return std::allocate_shared<NetMsgDataVector>(MsgDataAllocator(defaultMemoryPool()), std::move(data));
+}
+
 NetMessage::NetMessage(NetMsgDataVector&& data)
-	: data_(std::move(data))
+	: buffer_(makeSharedMessageBuffer(std::move(data)))
+	, data_(buffer_->data())
+	, size_(buffer_->size())
+{}
+
+NetMessage::NetMessage(SharedBuffer buffer, const uint8_t* data, size_t size)
+	: buffer_(std::move(buffer))
+	, data_(data)
+	, size_(size)
 {}
 
 uint8_t NetMessage::type() const
 {
-	ASSERT_OR_RETURN(0, !data_.empty(), "Invalid message data");
+	ASSERT_OR_RETURN(0, size_ > 0, "Invalid message data");
 	return data_[0];
 }
 
-const NetMsgDataVector& NetMessage::rawData() const
-{
-	return data_;
-}
-
 const uint8_t* NetMessage::payload() const
 {
-	ASSERT_OR_RETURN(nullptr, !data_.empty() && data_.size() >= HEADER_LENGTH, "Invalid message data");
-	return &data_[HEADER_LENGTH];
+	ASSERT_OR_RETURN(nullptr, size_ >= HEADER_LENGTH, "Invalid message data");
+	return data_ + HEADER_LENGTH;
 }
 
 size_t NetMessage::payloadSize() const
 {
-	ASSERT_OR_RETURN(0, data_.size() >= HEADER_LENGTH, "Invalid message data");
-	return data_.size() - HEADER_LENGTH;
+	ASSERT_OR_RETURN(0, size_ >= HEADER_LENGTH, "Invalid message data");
+	return size_ - HEADER_LENGTH;
 }
 
 optional<NetMessage> NetMessage::tryFromRawData(const uint8_t* buffer, size_t bufferLen)
@@ -153,11 +169,27 @@ optional<NetMessage> NetMessage::tryFromRawData(const uint8_t* buffer, size_t bu
 	return optional<NetMessage>{msg.build()};
 }
 
+optional<NetMessage> NetMessage::tryFromSharedData(const NetMessage& container, size_t offset, size_t length)
+{
+	if (offset > container.size_ || container.size_ - offset < length || length < HEADER_LENGTH)
+	{
+		return nullopt;
+	}
+	const uint8_t* data = container.data_ + offset;
+	uint16_t len = 0;
+	wz_ntohs_load_unaligned(len, data + 1);
+	if (len != length - HEADER_LENGTH)
+	{
+		return nullopt;  // Not exactly one message.
+	}
+	return optional<NetMessage>{NetMessage(container.buffer_, data, length)};
+}
+
 void NetMessage::rawDataAppendToVector(std::vector<uint8_t>& output) const
 {
 	const size_t oldLen = output.size();
-	output.resize(output.size() + data_.size());
-	std::memcpy(&output[oldLen], data_.data(), data_.size());
+	output.resize(output.size() + size_);
+	std::memcpy(&output[oldLen], data_, size_);
 }
 
 NetMessageBuilder::NetMessageBuilder(uint8_t type, size_t reservedCapacity /* = 16 */)
@@ -176,6 +208,7 @@ NetQueue::NetQueue()
 	: canGetMessagesForNet(true)
 	, canGetMessages(true)
 	, messages(MsgAllocator(defaultMemoryPool()))
+	, incompleteReceivedMessageData(MsgDataAllocator(defaultMemoryPool()))
 	, pendingGameTimeUpdateMessages(0)
 	, bCurrentMessageWasDecrypted(false)
 {
@@ -186,15 +219,14 @@ NetQueue::NetQueue()
 void NetQueue::writeRawData(const uint8_t *netData, size_t netLen)
 {
 	size_t used = 0;
-	std::vector<uint8_t> &buffer = incompleteReceivedMessageData;  // Short alias.
+	NetMsgDataVector &buffer = incompleteReceivedMessageData;  // Short alias.
 
 	// Insert the data.
 	buffer.insert(buffer.end(), netData, netData + netLen);
 
-	// Extract the messages.
+	// Find the complete messages.
 	while (buffer.size() - used >= NetMessage::HEADER_LENGTH)
 	{
-		uint8_t type = buffer[used];
 		uint16_t len = 0;
 		// Load payload length from uint16_t (network byte order) starting at the second byte of the data buffer.
 		wz_ntohs_load_unaligned(len, &buffer[used + 1]);
@@ -203,20 +235,34 @@ void NetQueue::writeRawData(const uint8_t *netData, size_t netLen)
 		{
 			break;  // Don't have a whole message ready yet.
 		}
+		used += NetMessage::HEADER_LENGTH + len;
+	}
+	if (used == 0)
+	{
+		return;
+	}
 
-		NetMessageBuilder msg(type, len);
-		msg.append(buffer.data() + used + NetMessage::HEADER_LENGTH, len);
-		messages.emplace_front(msg.build());
+	// The complete messages keep referring to the received data, instead of each getting a copy of their own.
+	const size_t total = buffer.size();
+	NetMessage::SharedBuffer shared = makeSharedMessageBuffer(std::move(buffer));
+	buffer.clear();  // Moved from.
+	const uint8_t* data = shared->data();
+	for (size_t pos = 0; pos < used;)
+	{
+		uint8_t type = data[pos];
+		uint16_t len = 0;
+		wz_ntohs_load_unaligned(len, &data[pos + 1]);
+		messages.emplace_front(NetMessage(shared, data + pos, NetMessage::HEADER_LENGTH + len));
 
 		if (type == GAME_GAME_TIME)
 		{
 			++pendingGameTimeUpdateMessages;
 		}
-		used += NetMessage::HEADER_LENGTH + len;
+		pos += NetMessage::HEADER_LENGTH + len;
 	}
 
-	// Recycle old data.
-	buffer.erase(buffer.begin(), buffer.begin() + used);
+	// Keep the start of the next message.
+	buffer.assign(data + used, data + total);
 }
 
 size_t NetQueue::currentIncompleteDataBuffered() const
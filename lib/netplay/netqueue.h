@@ -29,6 +29,7 @@
 #include "lib/netplay/byteorder_funcs_wrapper.h"
 #include <vector>
 #include <list>
+#include <memory>
 
 #include <nonstd/optional.hpp>
 using nonstd::optional;
@@ -37,6 +38,14 @@ using nonstd::nullopt;
 using MsgDataAllocator = PoolAllocator<uint8_t, MemoryPool>;
 using NetMsgDataVector = std::vector<uint8_t, MsgDataAllocator>;
 
+/// Counters for the data of NetMessages, to keep track of how often it gets allocated and copied.
+struct NetMessageBufferCounters
+{
+	size_t allocations = 0;  ///< Buffers allocated for the data of messages.
+	size_t copiedBytes = 0;  ///< Bytes of existing messages copied into other buffers (e.g. when wrapping or recording messages).
+};
+NetMessageBufferCounters& netMessageBufferCounters();
+
 // At game level:
 // There should be a NetQueue representing each client.
 // Clients should serialise messages to their own queue.
@@ -61,6 +70,13 @@ using NetMsgDataVector = std::vector<uint8_t, MsgDataAllocator>;
 /// from the `MESSAGE_TYPES` enumeration.
 ///
 /// The payload length is the size of the payload in bytes, stored as a `uint16_t` in network byte order (big endian).
+///
+/// The data is kept in a reference-counted buffer (allocated from the default `MemoryPool`), which is shared by
+/// all copies of the message, so copying a `NetMessage` doesn't copy the data. A message may also be a view of
+/// a part of a larger buffer: the messages received from the network, or embedded in other messages (see
+/// `NETnetMessage()`), refer to the data of the enclosing buffer instead of copying it.
+///
+/// Since the buffers come from a `MemoryPool`, messages must only be copied and destroyed on the main thread.
 /// </summary>
 class NetMessage
 {
@@ -69,6 +85,9 @@ public:
 
 	// Static factory method to create from raw data
 	static optional<NetMessage> tryFromRawData(const uint8_t* buffer, size_t bufferLen);
+	/// Returns the message stored at `offset` in the raw data of `container`, sharing the data of `container`,
+	/// or `nullopt` if there isn't a complete, valid message of exactly `length` bytes.
+	static optional<NetMessage> tryFromSharedData(const NetMessage& container, size_t offset, size_t length);
 
 	NetMessage(NetMessage&&) = default;
 	NetMessage& operator=(NetMessage&&) = default;
@@ -77,7 +96,15 @@ public:
 	NetMessage& operator=(const NetMessage&) = default;
 
 	uint8_t type() const;
-	const NetMsgDataVector& rawData() const;
+	/// The whole message (header and payload), `rawDataSize()` bytes.
+	const uint8_t* rawData() const
+	{
+		return data_;
+	}
+	size_t rawDataSize() const
+	{
+		return size_;
+	}
 	/// Returns a pointer to the payload data (offset by `HEADER_LENGTH` from the beginning of the raw data).
 	const uint8_t* payload() const;
 	size_t payloadSize() const;
@@ -87,12 +114,18 @@ public:
 
 private:
 
+	using SharedBuffer = std::shared_ptr<const NetMsgDataVector>;
+
 	// Meant to be executed only by NetMessageBuilder
 	explicit NetMessage(NetMsgDataVector&& data);
+	NetMessage(SharedBuffer buffer, const uint8_t* data, size_t size);
 
 	friend class NetMessageBuilder;
+	friend class NetQueue;
 
-	NetMsgDataVector data_;
+	SharedBuffer buffer_;
+	const uint8_t* data_ = nullptr;  ///< Points into `*buffer_`.
+	size_t size_ = 0;
 };
 
 /// <summary>
@@ -202,7 +235,7 @@ class MessageReader
 public:
 
 	explicit MessageReader(const NetMessage& m)
-		: msgData(&m.rawData()), index(NetMessage::HEADER_LENGTH), msgType(m.type())
+		: message(&m), msgData(m.rawData()), msgSize(m.rawDataSize()), index(NetMessage::HEADER_LENGTH), msgType(m.type())
 	{}
 
 	MessageReader(MessageReader&&) = default;
@@ -211,15 +244,15 @@ public:
 
 	void byte(uint8_t &v) const
 	{
-		v = index >= msgData->size() ? 0x00 : (*msgData)[index];
+		v = index >= msgSize ? 0x00 : msgData[index];
 		++index;
 	}
 	void bytes(uint8_t *pOut, size_t numBytes) const
 	{
-		size_t numCopyBytes = (index >= msgData->size()) ? 0 : std::min<size_t>(msgData->size() - index, numBytes);
+		size_t numCopyBytes = (index >= msgSize) ? 0 : std::min<size_t>(msgSize - index, numBytes);
 		if (numCopyBytes > 0)
 		{
-			memcpy(pOut, &((*msgData)[index]), numCopyBytes);
+			memcpy(pOut, &msgData[index], numCopyBytes);
 		}
 		if (numCopyBytes < numBytes)
 		{
@@ -232,21 +265,28 @@ public:
 	{
 		static_assert(std::is_same<typename VecT::value_type, uint8_t>::value, "Expected vector<uint8_t> as the argument");
 
-		size_t numCopyBytes = (index >= msgData->size()) ? 0 : std::min<size_t>(msgData->size() - index, desiredBytes);
+		size_t numCopyBytes = (index >= msgSize) ? 0 : std::min<size_t>(msgSize - index, desiredBytes);
 		if (numCopyBytes > 0)
 		{
 			size_t startIdx = vOut.size();
 			vOut.resize(vOut.size() + numCopyBytes);
-			memcpy(&(vOut[startIdx]), &((*msgData)[index]), numCopyBytes);
+			memcpy(&(vOut[startIdx]), &msgData[index], numCopyBytes);
 		}
 		index += numCopyBytes;
 	}
 	bool valid() const
 	{
-		return index <= msgData->size();
+		return index <= msgSize;
+	}
+	/// Returns true if all of the message has been read.
+	bool atEnd() const
+	{
+		return index == msgSize;
 	}
 
-	const NetMsgDataVector* msgData;
+	const NetMessage* message;  ///< The message being read, which must outlive the reader.
+	const uint8_t* msgData;
+	size_t msgSize;
 	mutable size_t index = NetMessage::HEADER_LENGTH;
 	uint8_t msgType;
 };
@@ -322,7 +362,7 @@ private:
 	List::iterator                dataPos;                             ///< Last message which was sent over the network.
 	List::iterator                messagePos;                          ///< Last message which was popped.
 	List                          messages;                            ///< List of messages. Messages are added to the front and read from the back.
-	std::vector<uint8_t>          incompleteReceivedMessageData;       ///< Data from network which has not yet formed an entire message.
+	NetMsgDataVector              incompleteReceivedMessageData;       ///< Data from network which has not yet formed an entire message.
 	size_t                        pendingGameTimeUpdateMessages;       ///< Pending GAME_GAME_TIME messages added to this queue
 	bool						  bCurrentMessageWasDecrypted;
 };
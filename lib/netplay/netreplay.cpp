@@ -293,7 +293,9 @@ void NETreplaySaveNetMessage(NetMessage const *message, uint8_t player)
 	if (message->type() > GAME_MIN_TYPE && message->type() < GAME_MAX_TYPE)
 	{
 		latestWriteBuffer.push_back(player);
+		// Copied, since the message data must not be released by the save thread.
 		message->rawDataAppendToVector(latestWriteBuffer);
+		netMessageBufferCounters().copiedBytes += message->rawDataSize();
 
 		if (latestWriteBuffer.size() >= minBufferSizeToQueue)
 		{
@@ -408,7 +408,7 @@ bool NETdecryptSecuredNetMessage(NETQUEUE queue, uint8_t& type)
 		return false;
 	}
 
-	NETlogPacket(NET_SECURED_NET_MESSAGE, static_cast<uint32_t>(encryptedMessage.rawData().size()), true);
+	NETlogPacket(NET_SECURED_NET_MESSAGE, static_cast<uint32_t>(encryptedMessage.rawDataSize()), true);
 
 	type = decryptedMessage->type(); // must update type!
 	pReceiveQueue->replaceCurrentWithDecrypted(std::move(*decryptedMessage));
@@ -427,6 +427,53 @@ bool NETend(MessageReader& r)
 
 static std::vector<uint8_t> tmpMessageRawDataBuffer;
 
+static void NETpushAndSendMessage(NETQUEUE queueInfo, NetQueue* queue, NetMessage&& msg)
+{
+	auto msgType = msg.type();
+	auto msgRawDataSize = msg.rawDataSize();
+
+	NETlogPacket(msgType, static_cast<uint32_t>(msgRawDataSize), false);
+	queue->pushMessage(std::move(msg));
+
+	if (queueInfo.queueType == QUEUE_GAME || queueInfo.queueType == QUEUE_GAME_FORCED)
+	{
+		ASSERT(msgType > GAME_MIN_TYPE && msgType < GAME_MAX_TYPE, "Inserting %s into game queue.", messageTypeToString(msgType));
+	}
+	else
+	{
+		ASSERT(msgType > NET_MIN_TYPE && msgType < NET_MAX_TYPE, "Inserting %s into net queue.", messageTypeToString(msgType));
+	}
+
+	if (queueInfo.queueType == QUEUE_NET || queueInfo.queueType == QUEUE_BROADCAST || queueInfo.queueType == QUEUE_TMP)
+	{
+		NETsend(queueInfo, queue->getMessageForNet());
+		queue->popMessageForNet();
+		ASSERT(queue->numMessagesForNet() == 0, "Queue not empty (%u messages remaining). (message = type: %" PRIu8 ", size: %zu), (queue = index: %" PRIu8 "; queueType: %" PRIu8 "; exclude: %" PRIu8 "; isPair: %d)", queue->numMessagesForNet(), msgType, msgRawDataSize, queueInfo.index, queueInfo.queueType, queueInfo.exclude, (int)queueInfo.isPair);
+	}
+
+	// Process any delayed actions from the NETsend call
+	NETsendProcessDelayedActions();
+}
+
+bool NETforward(NETQUEUE queueInfo, const NetMessage& msg)
+{
+	if (bIsReplay && queueInfo.index != realSelectedPlayer)
+	{
+		// don't bother adding to the send queue if we're playing a replay
+		return true;
+	}
+
+	NetQueue* queue = sendQueue(queueInfo);
+	if (queue == nullptr)
+	{
+		debug(LOG_WARNING, "Sending %s to null queue, type %d.", messageTypeToString(msg.type()), queueInfo.queueType);
+		return true;
+	}
+
+	NETpushAndSendMessage(queueInfo, queue, NetMessage(msg));  // Shares the data of msg.
+	return true;
+}
+
 bool NETend(MessageWriter& w)
 {
 	bool shouldWrapSecretMessage = w.bSecretMessageWrap;
@@ -491,44 +538,18 @@ bool NETend(MessageWriter& w)
 		NETuint8_t(sendToPlayerWriter, player);
 		NETuint8_t(sendToPlayerWriter, allPlayers);
 		NETnetMessage(sendToPlayerWriter, builtShareGameQueueMessage);
-		NETend(sendToPlayerWriter);  // This time we actually send it.
+		auto builtSendToPlayerMessage = sendToPlayerWriter.msgBuilder.build();
+		NETforward(sendToPlayerWriter.queueInfo, builtSendToPlayerMessage);  // This time we actually send it.
 
-		// Also insert the NET_SEND_TO_PLAYER into the ** host queue **
+		// Also insert the same NET_SEND_TO_PLAYER into the ** host queue **
 		// - The broadcast above doesn't do this, since broadcasts don't get sent to self
 		// - Insert into the host queue so that it gets processed just like on the clients
-		auto sendToHostSelfWriter = NETbeginEncode(NETnetQueue(NetPlay.hostPlayer), NET_SEND_TO_PLAYER);
-		NETuint8_t(sendToHostSelfWriter, player);
-		NETuint8_t(sendToHostSelfWriter, allPlayers);
-		NETnetMessage(sendToHostSelfWriter, builtShareGameQueueMessage);
-		NETinsertMessageFromNet(NETnetQueue(NetPlay.hostPlayer), sendToHostSelfWriter.msgBuilder.build());
+		NETinsertMessageFromNet(NETnetQueue(NetPlay.hostPlayer), std::move(builtSendToPlayerMessage));
 
 		return true;
 	}
 
-	auto msgType = msg.type();
-	auto msgRawDataSize = msg.rawData().size();
-
-	NETlogPacket(msgType, static_cast<uint32_t>(msgRawDataSize), false);
-	queue->pushMessage(std::move(msg));
-
-	if (w.queueInfo.queueType == QUEUE_GAME || w.queueInfo.queueType == QUEUE_GAME_FORCED)
-	{
-		ASSERT(msgType > GAME_MIN_TYPE && msgType < GAME_MAX_TYPE, "Inserting %s into game queue.", messageTypeToString(msgType));
-	}
-	else
-	{
-		ASSERT(msgType > NET_MIN_TYPE && msgType < NET_MAX_TYPE, "Inserting %s into net queue.", messageTypeToString(msgType));
-	}
-
-	if (w.queueInfo.queueType == QUEUE_NET || w.queueInfo.queueType == QUEUE_BROADCAST || w.queueInfo.queueType == QUEUE_TMP)
-	{
-		NETsend(w.queueInfo, queue->getMessageForNet());
-		queue->popMessageForNet();
-		ASSERT(queue->numMessagesForNet() == 0, "Queue not empty (%u messages remaining). (message = type: %" PRIu8 ", size: %zu), (queue = index: %" PRIu8 "; queueType: %" PRIu8 "; exclude: %" PRIu8 "; isPair: %d)", queue->numMessagesForNet(), msgType, msgRawDataSize, w.queueInfo.index, w.queueInfo.queueType, w.queueInfo.exclude, (int)w.queueInfo.isPair);
-	}
-
-	// Process any delayed actions from the NETsend call
-	NETsendProcessDelayedActions();
+	NETpushAndSendMessage(w.queueInfo, queue, std::move(msg));
 
 	return true;  // Serialising never fails.
 }
@@ -793,8 +814,28 @@ void NETVector2i(MessageReader& r, Vector2i& vec)
 
 void NETnetMessage(MessageReader& r, NetMessage** msg)
 {
+	uint32_t len = 0;
+	NETuint32_t(r, len);
+	if (r.valid())
+	{
+		// Normally, the embedded message is exactly as long as its header says, and can refer to the data of the enclosing message.
+		auto embedded = NetMessage::tryFromSharedData(*r.message, r.index, len);
+		if (embedded.has_value())
+		{
+			r.index += len;
+			*msg = new NetMessage(std::move(*embedded));
+			return;
+		}
+	}
+
+	// Truncated or inconsistent, so copy whatever is there, and fix the header.
 	NetMsgDataVector rawData{MsgDataAllocator(defaultMemoryPool())};
-	NETbytes(r, rawData, std::numeric_limits<uint32_t>::max());
+	if (r.valid())
+	{
+		r.bytesVector(rawData, len);
+	}
+	netMessageBufferCounters().copiedBytes += rawData.size();
+	rawData.resize(std::max(rawData.size(), NetMessage::HEADER_LENGTH));
 	*msg = new NetMessage(NetMessageBuilder(std::move(rawData)).build());
 }
 
@@ -936,5 +977,7 @@ void NETVector2i(MessageWriter& w, const Vector2i& vec)
 
 void NETnetMessage(MessageWriter& w, const NetMessage& msg)
 {
-	NETbytes(w, msg.rawData(), std::numeric_limits<uint32_t>::max());
+	NETuint32_t(w, static_cast<uint32_t>(msg.rawDataSize()));
+	w.bytes(msg.rawData(), msg.rawDataSize());
+	netMessageBufferCounters().copiedBytes += msg.rawDataSize();
 }
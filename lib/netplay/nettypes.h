@@ -183,6 +183,8 @@ static void NETenum(MessageWriter& w, EnumT val)
 }
 
 bool NETend(MessageWriter& w);
+/// Sends an already built message, like `NETend()` does for the message being written, without copying its data.
+bool NETforward(NETQUEUE queue, const NetMessage& msg);
 
 void NETbytesOutputToVector(const std::vector<uint8_t> &data, std::vector<uint8_t>& output);
 
@@ -22,6 +22,9 @@
 #include "wz_compression_provider.h"
 
 #include "lib/netplay/zlib_compression_adapter.h"
+#if defined(WZ_NETPLAY_ZSTD)
+# include "lib/netplay/zstd_compression_adapter.h"
+#endif
 
 WzCompressionProvider& WzCompressionProvider::Instance()
 {
@@ -29,11 +32,53 @@ WzCompressionProvider& WzCompressionProvider::Instance()
 	return instance;
 }
 
-std::unique_ptr<ICompressionAdapter> WzCompressionProvider::newCompressionAdapter()
+static constexpr uint32_t algorithmBit(WzCompressionAlgorithm algorithm)
 {
-	// Only support Zlib for the time being.
-	// TODO: in the future, we might want to support more compression algorithms, e.g. Zstd.
-	// In this case, we would need to somehow configure `WzCompressionAdapter` from
-	// the global WZ config to specify compression algorithm to use.
-	return std::make_unique<ZlibCompressionAdapter>();
+	return 1u << static_cast<uint32_t>(algorithm);
+}
+
+uint32_t WzCompressionProvider::supportedAlgorithmsMask() const
+{
+	uint32_t mask = algorithmBit(WzCompressionAlgorithm::Zlib);
+#if defined(WZ_NETPLAY_ZSTD)
+	mask |= algorithmBit(WzCompressionAlgorithm::Zstd);
+#endif
+	return mask;
+}
+
+bool WzCompressionProvider::isSupported(WzCompressionAlgorithm algorithm) const
+{
+	return static_cast<uint32_t>(algorithm) < 32 && (supportedAlgorithmsMask() & algorithmBit(algorithm)) != 0;
+}
+
+WzCompressionAlgorithm WzCompressionProvider::negotiateAlgorithm(uint32_t remoteSupportedAlgorithmsMask) const
+{
+	const uint32_t common = supportedAlgorithmsMask() & remoteSupportedAlgorithmsMask;
+	// In order of preference. Zlib is always supported.
+	if (common & algorithmBit(WzCompressionAlgorithm::Zstd))
+	{
+		return WzCompressionAlgorithm::Zstd;
+	}
+	return WzCompressionAlgorithm::Zlib;
+}
+
+std::unique_ptr<ICompressionAdapter> WzCompressionProvider::newCompressionAdapter(WzCompressionAlgorithm algorithm)
+{
+	switch (algorithm)
+	{
+	case WzCompressionAlgorithm::Zlib:
+		return std::make_unique<ZlibCompressionAdapter>();
+	case WzCompressionAlgorithm::Zstd:
+#if defined(WZ_NETPLAY_ZSTD)
+		return std::make_unique<ZstdCompressionAdapter>();
+#else
+		break;
+#endif
+	}
+	return nullptr;
+}
+
+std::unique_ptr<ISharedFrameCompressor> WzCompressionProvider::newSharedFrameCompressor()
+{
+	return std::make_unique<ZlibSharedFrameCompressor>();
 }
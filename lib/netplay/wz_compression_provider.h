@@ -22,8 +22,20 @@
 #pragma once
 
 #include <memory>
+#include <stdint.h>
 
 class ICompressionAdapter;
+class ISharedFrameCompressor;
+
+/// <summary>
+/// Compression algorithms for net messages. The values are sent over the network
+/// during the connection handshake, so they must never change.
+/// </summary>
+enum class WzCompressionAlgorithm : uint32_t
+{
+	Zlib = 0,
+	Zstd = 1
+};
 
 /// <summary>
 /// This class provides is responsible for creating `ICompressionAdapter:s`,
@@ -36,7 +48,20 @@ public:
 
 	static WzCompressionProvider& Instance();
 
-	std::unique_ptr<ICompressionAdapter> newCompressionAdapter();
+	/// Bit mask (`1 << algorithm`) of the algorithms supported by this build,
+	/// which is sent to the host when joining a game.
+	uint32_t supportedAlgorithmsMask() const;
+	bool isSupported(WzCompressionAlgorithm algorithm) const;
+	/// Picks the best algorithm supported by both this build and the other side,
+	/// given the `supportedAlgorithmsMask()` of the other side. Used by the host.
+	WzCompressionAlgorithm negotiateAlgorithm(uint32_t remoteSupportedAlgorithmsMask) const;
+
+	/// Returns `nullptr` if `algorithm` isn't supported.
+	std::unique_ptr<ICompressionAdapter> newCompressionAdapter(WzCompressionAlgorithm algorithm = WzCompressionAlgorithm::Zlib);
+	/// Creates a compressor for frames which can be appended to the streams of
+	/// the adapters made by `newCompressionAdapter()` for the algorithms which
+	/// support them (see `ICompressionAdapter::supportsSharedFrames()`).
+	std::unique_ptr<ISharedFrameCompressor> newSharedFrameCompressor();
 
 private:
 
@@ -67,7 +67,7 @@ net::result<void> ZlibCompressionAdapter::initialize()
 	return {};
 }
 
-void ZlibCompressionAdapter::resetCompressionStreamInput(const void* src, size_t size)
+static void resetDeflateStreamInput(z_stream& stream, const void* src, size_t size)
 {
 #if ZLIB_VERNUM < 0x1252
 	// zlib < 1.2.5.2 does not support `#define ZLIB_CONST`
@@ -82,7 +82,7 @@ void ZlibCompressionAdapter::resetCompressionStreamInput(const void* src, size_t
 #endif
 
 	// cast away the const for earlier zlib versions
-	deflateStream_.next_in = (Bytef*)src; // -Wcast-qual
+	stream.next_in = (Bytef*)src; // -Wcast-qual
 
 #if defined(__clang__)
 #  pragma clang diagnostic pop
@@ -91,28 +91,40 @@ void ZlibCompressionAdapter::resetCompressionStreamInput(const void* src, size_t
 #endif
 #else
 	// zlib >= 1.2.5.2 supports ZLIB_CONST
-	deflateStream_.next_in = (const Bytef*)src;
+	stream.next_in = (const Bytef*)src;
 #endif
 
-	deflateStream_.avail_in = size;
+	stream.avail_in = size;
 }
 
-net::result<void> ZlibCompressionAdapter::compress(const void* src, size_t size)
+/// Runs `deflate()` with the given `flush` mode until it has no more output, appending the output to `out`.
+static void deflateToBuffer(z_stream& stream, std::vector<uint8_t>& out, size_t extraSpace, int flush)
 {
-	resetCompressionStreamInput(src, size);
 	do
 	{
-		const size_t alreadyHave = deflateOutBuf_.size();
-		deflateOutBuf_.resize(alreadyHave + size + 20);  // A bit more than size should be enough to always do everything in one go.
-		deflateStream_.next_out = (Bytef*)&deflateOutBuf_[alreadyHave];
-		deflateStream_.avail_out = deflateOutBuf_.size() - alreadyHave;
+		const size_t alreadyHave = out.size();
+		out.resize(alreadyHave + extraSpace);
+		stream.next_out = (Bytef*)&out[alreadyHave];
+		stream.avail_out = out.size() - alreadyHave;
 
-		int ret = deflate(&deflateStream_, Z_NO_FLUSH);
+		int ret = deflate(&stream, flush);
 		ASSERT(ret != Z_STREAM_ERROR, "zlib compression failed!");
 
 		// Remove unused part of buffer.
-		deflateOutBuf_.resize(deflateOutBuf_.size() - deflateStream_.avail_out);
-	} while (deflateStream_.avail_out == 0);
+		out.resize(out.size() - stream.avail_out);
+	} while (stream.avail_out == 0);
+}
+
+void ZlibCompressionAdapter::resetCompressionStreamInput(const void* src, size_t size)
+{
+	resetDeflateStreamInput(deflateStream_, src, size);
+}
+
+net::result<void> ZlibCompressionAdapter::compress(const void* src, size_t size)
+{
+	resetCompressionStreamInput(src, size);
+	// A bit more than size should be enough to always do everything in one go.
+	deflateToBuffer(deflateStream_, deflateOutBuf_, size + 20, Z_NO_FLUSH);
 
 	ASSERT(deflateStream_.avail_in == 0, "zlib didn't compress everything!");
 
@@ -122,21 +134,21 @@ net::result<void> ZlibCompressionAdapter::compress(const void* src, size_t size)
 net::result<void> ZlibCompressionAdapter::flushCompressionStream()
 {
 	// Flush data out of zlib compression state.
-	do
-	{
-		deflateStream_.next_in = (Bytef*)nullptr;
-		deflateStream_.avail_in = 0;
-		const size_t alreadyHave = deflateOutBuf_.size();
-		deflateOutBuf_.resize(alreadyHave + 1000);  // 100 bytes would probably be enough to flush the rest in one go.
-		deflateStream_.next_out = (Bytef*)&deflateOutBuf_[alreadyHave];
-		deflateStream_.avail_out = deflateOutBuf_.size() - alreadyHave;
-
-		int ret = deflate(&deflateStream_, Z_PARTIAL_FLUSH);
-		ASSERT(ret != Z_STREAM_ERROR, "zlib compression failed!");
+	resetCompressionStreamInput(nullptr, 0);
+	// 1000 bytes would probably be enough to flush the rest in one go.
+	deflateToBuffer(deflateStream_, deflateOutBuf_, 1000, Z_PARTIAL_FLUSH);
 
-		// Remove unused part of buffer.
-		deflateOutBuf_.resize(deflateOutBuf_.size() - deflateStream_.avail_out);
-	} while (deflateStream_.avail_out == 0);
+	return {};
+}
+
+net::result<void> ZlibCompressionAdapter::appendSharedFrame(const std::vector<uint8_t>& frame)
+{
+	// A full flush leaves the output byte-aligned, so the raw deflate blocks of the frame
+	// can follow directly, and it keeps the data compressed after the frame from referring
+	// back to anything before it (which would be off by the size of the frame on the receiving side).
+	resetCompressionStreamInput(nullptr, 0);
+	deflateToBuffer(deflateStream_, deflateOutBuf_, 1000, Z_FULL_FLUSH);
+	deflateOutBuf_.insert(deflateOutBuf_.end(), frame.begin(), frame.end());
 
 	return {};
 }
@@ -190,3 +202,49 @@ void ZlibCompressionAdapter::resetDecompressionStreamOutput(void* buf, size_t si
 	inflateStream_.next_out = (Bytef*)buf;
 	inflateStream_.avail_out = size;
 }
+
+ZlibSharedFrameCompressor::ZlibSharedFrameCompressor()
+{
+	std::memset(&deflateStream_, 0, sizeof(deflateStream_));
+}
+
+ZlibSharedFrameCompressor::~ZlibSharedFrameCompressor()
+{
+	deflateEnd(&deflateStream_);
+}
+
+net::result<void> ZlibSharedFrameCompressor::initialize()
+{
+	deflateStream_.zalloc = Z_NULL;
+	deflateStream_.zfree = Z_NULL;
+	deflateStream_.opaque = Z_NULL;
+	// Raw deflate (negative window bits), since the frames are appended to existing zlib streams,
+	// which have already written their zlib header.
+	int ret = deflateInit2(&deflateStream_, 6, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+	ASSERT(ret == Z_OK, "deflateInit2 failed! Broadcasts won't be compressed once.");
+	if (ret != Z_OK)
+	{
+		return tl::make_unexpected(make_zlib_error_code(ret));
+	}
+	return {};
+}
+
+net::result<void> ZlibSharedFrameCompressor::compress(const void* src, size_t size)
+{
+	resetDeflateStreamInput(deflateStream_, src, size);
+	deflateToBuffer(deflateStream_, frameBuf_, size + 20, Z_NO_FLUSH);
+
+	ASSERT(deflateStream_.avail_in == 0, "zlib didn't compress everything!");
+
+	return {};
+}
+
+net::result<void> ZlibSharedFrameCompressor::finishFrame()
+{
+	// A full flush ends the frame byte-aligned, without the "last block" bit set,
+	// and resets the compression state, so the next frame doesn't depend on this one.
+	resetDeflateStreamInput(deflateStream_, nullptr, 0);
+	deflateToBuffer(deflateStream_, frameBuf_, 1000, Z_FULL_FLUSH);
+
+	return {};
+}
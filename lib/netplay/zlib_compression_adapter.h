@@ -77,6 +77,12 @@ public:
 
 	virtual void resetDecompressionStreamInputSize(size_t size) override;
 
+	virtual bool supportsSharedFrames() const override
+	{
+		return true;
+	}
+	virtual net::result<void> appendSharedFrame(const std::vector<uint8_t>& frame) override;
+
 private:
 
 	void resetCompressionStreamInput(const void* src, size_t size);
@@ -88,3 +94,31 @@ private:
 	z_stream inflateStream_;
 	bool inflateNeedInput_ = false;
 };
+
+/// <summary>
+/// Implementation of `ISharedFrameCompressor` interface for `ZlibCompressionAdapter`.
+///
+/// Frames are raw deflate blocks, ending with a full flush, so that they are
+/// byte-aligned and don't refer to any data outside of the frame.
+/// </summary>
+class ZlibSharedFrameCompressor : public ISharedFrameCompressor
+{
+public:
+
+	explicit ZlibSharedFrameCompressor();
+	virtual ~ZlibSharedFrameCompressor() override;
+
+	virtual net::result<void> initialize() override;
+	virtual net::result<void> compress(const void* src, size_t size) override;
+	virtual net::result<void> finishFrame() override;
+
+	virtual std::vector<uint8_t>& frameBuffer() override
+	{
+		return frameBuf_;
+	}
+
+private:
+
+	std::vector<uint8_t> frameBuf_;
+	z_stream deflateStream_;
+};
@@ -0,0 +1,169 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2025  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "zstd_compression_adapter.h"
+#include "error_categories.h"
+
+#include "lib/framework/frame.h" // for `ASSERT`
+
+// Zstd's default level. Use tools/netcompressbench to compare the settings on the messages of actual games.
+static constexpr int ZstdCompressionLevel = 3;
+// Limits the memory used by each connection (on both sides) to a 512 KiB window.
+static constexpr int ZstdWindowLog = 19;
+
+ZstdCompressionAdapter::ZstdCompressionAdapter()
+{}
+
+ZstdCompressionAdapter::~ZstdCompressionAdapter()
+{
+	ZSTD_freeCCtx(compressStream_);
+	ZSTD_freeDCtx(decompressStream_);
+}
+
+net::result<void> ZstdCompressionAdapter::initialize()
+{
+	// Init compression stream
+	compressStream_ = ZSTD_createCCtx();
+	ASSERT(compressStream_ != nullptr, "ZSTD_createCCtx failed! Sockets won't work.");
+	if (compressStream_ == nullptr)
+	{
+		return tl::make_unexpected(make_network_error_code(ENOMEM));
+	}
+	size_t ret = ZSTD_CCtx_setParameter(compressStream_, ZSTD_c_compressionLevel, ZstdCompressionLevel);
+	if (!ZSTD_isError(ret))
+	{
+		ret = ZSTD_CCtx_setParameter(compressStream_, ZSTD_c_windowLog, ZstdWindowLog);
+	}
+	ASSERT(!ZSTD_isError(ret), "ZSTD_CCtx_setParameter failed! Sockets won't work.");
+	if (ZSTD_isError(ret))
+	{
+		return tl::make_unexpected(make_zstd_error_code(ret));
+	}
+
+	// Init decompression stream
+	decompressStream_ = ZSTD_createDCtx();
+	ASSERT(decompressStream_ != nullptr, "ZSTD_createDCtx failed! Sockets won't work.");
+	if (decompressStream_ == nullptr)
+	{
+		return tl::make_unexpected(make_network_error_code(ENOMEM));
+	}
+	// Don't let the other side make us allocate more than the window we use ourselves.
+	ret = ZSTD_DCtx_setParameter(decompressStream_, ZSTD_d_windowLogMax, ZstdWindowLog);
+	ASSERT(!ZSTD_isError(ret), "ZSTD_DCtx_setParameter failed! Sockets won't work.");
+	if (ZSTD_isError(ret))
+	{
+		return tl::make_unexpected(make_zstd_error_code(ret));
+	}
+
+	decompressNeedInput_ = true;
+
+	return {};
+}
+
+/// Runs `ZSTD_compressStream2()` with the given `mode` until it has consumed all of `input`
+/// (and, unless `mode` is `ZSTD_e_continue`, flushed everything), appending the output to `out`.
+static size_t compressToBuffer(ZSTD_CCtx* stream, std::vector<uint8_t>& out, ZSTD_inBuffer& input, size_t extraSpace, ZSTD_EndDirective mode)
+{
+	size_t ret = 0;
+	do
+	{
+		const size_t alreadyHave = out.size();
+		out.resize(alreadyHave + extraSpace);
+		ZSTD_outBuffer output = { &out[alreadyHave], extraSpace, 0 };
+
+		ret = ZSTD_compressStream2(stream, &output, &input, mode);
+
+		// Remove unused part of buffer.
+		out.resize(alreadyHave + output.pos);
+		if (ZSTD_isError(ret))
+		{
+			break;
+		}
+	} while (input.pos < input.size || (mode != ZSTD_e_continue && ret != 0));
+	return ret;
+}
+
+net::result<void> ZstdCompressionAdapter::compress(const void* src, size_t size)
+{
+	ZSTD_inBuffer input = { src, size, 0 };
+	// The bound should be enough to always do everything in one go.
+	const size_t ret = compressToBuffer(compressStream_, compressOutBuf_, input, ZSTD_compressBound(size), ZSTD_e_continue);
+	ASSERT(!ZSTD_isError(ret), "zstd compression failed: %s", ZSTD_getErrorName(ret));
+	if (ZSTD_isError(ret))
+	{
+		return tl::make_unexpected(make_zstd_error_code(ret));
+	}
+
+	return {};
+}
+
+net::result<void> ZstdCompressionAdapter::flushCompressionStream()
+{
+	// Flush data out of zstd compression state.
+	ZSTD_inBuffer input = { nullptr, 0, 0 };
+	// 1000 bytes would probably be enough to flush the rest in one go.
+	const size_t ret = compressToBuffer(compressStream_, compressOutBuf_, input, 1000, ZSTD_e_flush);
+	ASSERT(!ZSTD_isError(ret), "zstd compression failed: %s", ZSTD_getErrorName(ret));
+	if (ZSTD_isError(ret))
+	{
+		return tl::make_unexpected(make_zstd_error_code(ret));
+	}
+
+	return {};
+}
+
+net::result<void> ZstdCompressionAdapter::appendSharedFrame(const std::vector<uint8_t>& /*frame*/)
+{
+	ASSERT(false, "zstd streams don't support shared frames");
+	return tl::make_unexpected(make_network_error_code(EINVAL));
+}
+
+net::result<void> ZstdCompressionAdapter::decompress(void* dst, size_t size)
+{
+	decompressOutput_ = { dst, size, 0 };
+
+	// Always run at least once, to get any output left over from a previous call which filled `dst`.
+	// `ZSTD_decompressStream()` may also stop at the end of a block, so keep going
+	// until either the input is exhausted or the output is full, like `inflate()` does.
+	do
+	{
+		const size_t ret = ZSTD_decompressStream(decompressStream_, &decompressOutput_, &decompressInput_);
+		if (ZSTD_isError(ret))
+		{
+			debug(LOG_ERROR, "Couldn't decompress data from socket. zstd error %s", ZSTD_getErrorName(ret));
+			return tl::make_unexpected(make_zstd_error_code(ret));
+		}
+	} while (decompressInput_.pos < decompressInput_.size && decompressOutput_.pos < decompressOutput_.size);
+	return {};
+}
+
+size_t ZstdCompressionAdapter::availableSpaceToDecompress() const
+{
+	return decompressOutput_.size - decompressOutput_.pos;
+}
+
+bool ZstdCompressionAdapter::decompressionStreamConsumedAllInput() const
+{
+	return decompressInput_.pos == decompressInput_.size;
+}
+
+void ZstdCompressionAdapter::resetDecompressionStreamInputSize(size_t size)
+{
+	decompressInput_ = { decompressInBuf_.data(), size, 0 };
+}
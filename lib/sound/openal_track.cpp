@@ -40,6 +40,8 @@
 #include <math.h>
 #include <limits>
 #include <list>
+#include <memory>
+#include <vector>
 
 #include "tracklib.h"
 #include "audio.h"
@@ -565,68 +567,96 @@ bool sound_QueueSamplePlaying()
 	return false;
 }
 
-/** Decodes *entirely* an opened OggVorbis file into an OpenAL buffer.
+/** PCM data of a sound effect, decoded from its OggVorbis file. */
+struct DECODED_TRACK
+{
+	std::vector<uint8_t> pcm;
+	unsigned channels = 0;
+	size_t frequency = 0;
+};
+
+/** Decodes *entirely* an OggVorbis file into PCM data.
  *  This is used to play sound effects, not "music". Assumes .ogg file.
+ *  Doesn't use OpenAL, so may run on any thread.
  *
- *  \param psTrack pointer to object which will contain the final buffer
- *  \param PHYSFS_fileHandle file handle given by PhysicsFS to the opened file
- *  \return true on success
+ *  \param fileName the file to decode
+ *  \return the decoded data, or nullptr on failure
  */
-static inline bool sound_DecodeOggVorbisTrack(TRACK *psTrack, const char* fileName)
+DECODED_TRACK *sound_DecodeTrackFile(const char *fileName)
 {
-	if (!openal_initialized)
-	{
-		return false;
-	}
-
 	WZVorbisDecoder* decoder = WZVorbisDecoder::fromFilename(fileName);
 	if (!decoder)
 	{
 		debug(LOG_ERROR, "couldn't allocate decoder for %s", fileName);
-		return false;
+		return nullptr;
 	}
 	const unsigned estimate = decoder->totalSamples() * decoder->channels() * 2;
-	uint8_t* buffer = (uint8_t*) malloc(estimate);
-	if (buffer == nullptr)
-	{
-		debug(LOG_ERROR, "couldn't allocate temp buffer to load track %s", fileName);
-		delete decoder;
-		return false;
-	}
-	memset(buffer, 0, estimate);
-	auto res = decoder->decode(buffer, estimate);
+	DECODED_TRACK *psDecoded = new DECODED_TRACK;
+	psDecoded->pcm.resize(estimate, 0);
+	auto res = decoder->decode(psDecoded->pcm.data(), estimate);
 	if (!res.has_value())
 	{
 		debug(LOG_ERROR, "failed decoding %s", fileName);
-		free(buffer);
+		delete psDecoded;
 		delete decoder;
-		return false;
+		return nullptr;
 	}
+	psDecoded->channels = decoder->channels();
+	psDecoded->frequency = decoder->frequency();
+	delete decoder;
+	return psDecoded;
+}
+
+void sound_FreeDecodedTrack(DECODED_TRACK *psDecoded)
+{
+	delete psDecoded;
+}
 
+/** Uploads decoded PCM data into an OpenAL buffer.
+ *
+ *  \param psTrack pointer to object which will contain the final buffer
+ *  \param decoded the data from sound_DecodeTrackFile
+ */
+static void sound_UploadTrack(TRACK *psTrack, const DECODED_TRACK &decoded)
+{
 	// Determine PCM data format
-	ALenum format = (decoder->channels() == 1) ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
+	ALenum format = (decoded.channels == 1) ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
 	ALuint alBuffer;
 	// Create an OpenAL buffer and fill it with the decoded data
 	alGenBuffers(1, &alBuffer);
 	sound_GetError();
-	ASSERT(estimate <= static_cast<size_t>(std::numeric_limits<ALsizei>::max()), "soundBuffer->size (%u) exceeds ALsizei::max", estimate);
-	ASSERT(decoder->frequency() <= static_cast<size_t>(std::numeric_limits<ALsizei>::max()), "decoder->frequency() (%zu) exceeds ALsizei::max ??", decoder->frequency());
-	alBufferData(alBuffer, format, buffer, static_cast<ALsizei>(estimate), static_cast<ALsizei>(decoder->frequency()));
+	ASSERT(decoded.pcm.size() <= static_cast<size_t>(std::numeric_limits<ALsizei>::max()), "soundBuffer->size (%zu) exceeds ALsizei::max", decoded.pcm.size());
+	ASSERT(decoded.frequency <= static_cast<size_t>(std::numeric_limits<ALsizei>::max()), "decoder->frequency() (%zu) exceeds ALsizei::max ??", decoded.frequency);
+	alBufferData(alBuffer, format, decoded.pcm.data(), static_cast<ALsizei>(decoded.pcm.size()), static_cast<ALsizei>(decoded.frequency));
 	sound_GetError();
 
 	// save buffer name in track
 	psTrack->iBufferName = alBuffer;
-	free(buffer);
-	delete decoder;
-	return true;
 }
 
 /** This is used to play sound effets (not "music"). Assumes .ogg file.
  * \param [in] fileName: <soundeffect>.ogg
+ * \param [in] psDecoded: the file decoded by sound_DecodeTrackFile ahead of time, or nullptr to decode it now
  * \returns Track pointer, or nullptr on failure
 */
-TRACK *sound_LoadTrackFromFile(const char *fileName)
+TRACK *sound_LoadTrackFromFile(const char *fileName, const DECODED_TRACK *psDecoded)
 {
+	if (!openal_initialized)
+	{
+		return nullptr;
+	}
+
+	std::unique_ptr<DECODED_TRACK> decodedNow;
+	if (psDecoded == nullptr)
+	{
+		decodedNow.reset(sound_DecodeTrackFile(fileName));
+		if (!decodedNow)
+		{
+			return nullptr;
+		}
+		psDecoded = decodedNow.get();
+	}
+
 	TRACK *pTrack;
 	size_t filename_size;
 	char *track_name;
@@ -667,12 +697,7 @@ TRACK *sound_LoadTrackFromFile(const char *fileName)
 	}
 	pTrack->fileName = track_name;
 
-	// Now use sound_ReadTrackFromBuffer to decode the file's contents
-	if (!sound_DecodeOggVorbisTrack(pTrack, fileName))
-	{
-		free(pTrack);
-		return nullptr;
-	}
+	sound_UploadTrack(pTrack, *psDecoded);
 
 	return pTrack;
 }
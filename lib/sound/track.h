@@ -81,7 +81,10 @@ struct TRACK
 bool	sound_Init(HRTFMode hrtf);
 bool	sound_Shutdown();
 
-TRACK 	*sound_LoadTrackFromFile(const char *fileName);
+struct DECODED_TRACK;
+DECODED_TRACK *sound_DecodeTrackFile(const char *fileName);
+void	sound_FreeDecodedTrack(DECODED_TRACK *psDecoded);
+TRACK 	*sound_LoadTrackFromFile(const char *fileName, const DECODED_TRACK *psDecoded = nullptr);
 unsigned int sound_SetTrackVals(const char *fileName, bool loop, unsigned int volume, unsigned int audibleRadius);
 void	sound_ReleaseTrack(TRACK *psTrack);
 
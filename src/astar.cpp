@@ -38,6 +38,11 @@
  *  Up to 30 pathfinding maps from A* are cached, in a LRU list. The PathNode heap con-
  *  tains the  priority-heap-sorted  nodes which are to be explored.  The path back  is
  *  stored in the PathExploredTile 2D array of tiles.
+ *  Long routes first search a coarse graph (PathRegionGraph) of the connected regions
+ *  of each PATH_CLUSTER_SIZE² cluster of tiles.  The A* search on tiles is then limited
+ *  to the corridor of regions along the abstract route, instead of flooding the whole
+ *  map.  If no abstract route exists, the unrestricted search is used,  so that  the
+ *  nearest reachable tile is found as before.
  */
 
 #ifndef WZ_TESTING
@@ -53,6 +58,7 @@
 #include <memory>
 #include <iterator>
 #include <cstddef>
+#include <mutex>
 
 #include "lib/netplay/sync_debug.h"
 
@@ -110,27 +116,168 @@ struct PathExploredTile
 	bool     visited;
 };
 
-struct PathBlockingType
+/// Routes with an estimated length below this many tiles are searched directly on the tile map.
+static constexpr unsigned PATH_HIERARCHICAL_MIN_TILES = 3 * PATH_CLUSTER_SIZE;
+/// Region of a blocking tile.
+static constexpr uint32_t PATH_NO_REGION = 0xFFFFFFFF;
+
+/** Abstraction of a blocking map for the hierarchical pathfinding layer.
+ *
+ *  Each cluster of tiles is split into its 4-connected regions of nonblocking tiles, and regions
+ *  which touch across a cluster border are linked. Since A* never cuts corners, two tiles are
+ *  connected on the tile map exactly if their regions are connected in this graph.
+ *
+ *  @ingroup pathfinding
+ */
+struct PathRegionGraph
+{
+	struct Region
+	{
+		PathCoord centre;               ///< Tile of the region nearest to its centroid, used for abstract distances.
+		uint32_t  firstEdge = 0;        ///< Index of the first neighbour in edges.
+		uint32_t  numEdges = 0;         ///< Number of neighbours.
+	};
+
+	uint32_t regionAt(int x, int y) const
+	{
+		return tileRegion[x + y * width];
+	}
+
+	int width = 0;
+	int height = 0;
+	std::vector<uint32_t> tileRegion;       ///< Region of each tile, or PATH_NO_REGION if blocking.
+	std::vector<Region> regions;
+	std::vector<uint32_t> edges;            ///< Neighbouring regions, indexed by Region::firstEdge.
+};
+
+/** Bitmap of map tiles, surrounded by a border of one tile on each side.
+ *  Rows are padded to a multiple of 8 bytes, so the 3×3 tiles around any tile on the map can be read
+ *  with one unaligned 16-bit load per row, without any bounds checks.
+ */
+class PathTileBits
 {
-	uint32_t gameTime;
+public:
+	/// Resizes to width×height tiles, all clear, with the border tiles set to border.
+	void reset(int width, int height, bool border)
+	{
+		stride = ((width + 2 + 8) / 8 + 7) & ~7;  // Bytes per row, including an extra byte for the 16-bit loads.
+		bits.assign(static_cast<size_t>(stride) * static_cast<size_t>(height + 2), 0);
+		if (border)
+		{
+			for (int x = -1; x <= width; ++x)
+			{
+				set(x, -1, true);
+				set(x, height, true);
+			}
+			for (int y = 0; y < height; ++y)
+			{
+				set(-1, y, true);
+				set(width, y, true);
+			}
+		}
+	}
+	void clear()
+	{
+		bits.clear();
+		stride = 0;
+	}
+	bool empty() const
+	{
+		return bits.empty();
+	}
+	/// Valid for -1 ≤ x ≤ width and -1 ≤ y ≤ height.
+	bool get(int x, int y) const
+	{
+		return bits[index(x, y) >> 3] >> (index(x, y) & 7) & 1;
+	}
+	void set(int x, int y, bool value)
+	{
+		const size_t i = index(x, y);
+		bits[i >> 3] = (bits[i >> 3] & ~(1 << (i & 7))) | value << (i & 7);
+	}
+	/// Returns the 8 tiles around (x, y) as a bitmask, with bit dir set if the tile at aDirOffset[dir] is set. Valid for tiles on the map.
+	unsigned neighbours(int x, int y) const
+	{
+		const size_t i = index(x - 1, y - 1);
+		const uint8_t *row = &bits[i >> 3];
+		const unsigned shift = i & 7;
+		const unsigned top = ((row[0] | row[1] << 8) >> shift) & 7;                             // (x - 1, y - 1), (x, y - 1), (x + 1, y - 1)
+		const unsigned mid = ((row[stride] | row[stride + 1] << 8) >> shift) & 7;               // (x - 1, y), (x, y), (x + 1, y)
+		const unsigned bot = ((row[2 * stride] | row[2 * stride + 1] << 8) >> shift) & 7;       // (x - 1, y + 1), (x, y + 1), (x + 1, y + 1)
+		return (bot >> 1 & 1) | (bot & 1) << 1 | (mid & 1) << 2 | top << 3 | (mid & 4) << 4 | (bot & 4) << 5;
+	}
+
+private:
+	size_t index(int x, int y) const
+	{
+		return static_cast<size_t>(y + 1) * stride * 8 + (x + 1);
+	}
 
+	int stride = 0;
+	std::vector<uint8_t> bits;
+};
+
+static void fpathBuildRegionGraph(PathRegionGraph &graph, PathTileBits const &blockingMap);
+
+struct PathBlockingType
+{
 	PROPULSION_TYPE propulsion;
 	int owner;
 	FPATH_MOVETYPE moveType;
 };
+/// Game state which a blocking map was generated from. If any of it changes, the map must be regenerated instead of patched.
+struct PathBlockingSource
+{
+	bool operator ==(PathBlockingSource const &z) const
+	{
+		return width == z.width && height == z.height && blockMap == z.blockMap && auxChangeEpoch == z.auxChangeEpoch && dangerOwner == z.dangerOwner &&
+		       scrollMinX == z.scrollMinX && scrollMinY == z.scrollMinY && scrollMaxX == z.scrollMaxX && scrollMaxY == z.scrollMaxY;
+	}
+	bool operator !=(PathBlockingSource const &z) const
+	{
+		return !(*this == z);
+	}
+
+	int width = 0;
+	int height = 0;
+	uint8_t const *blockMap = nullptr;      ///< Changes when switching between the mission map and the home map.
+	uint32_t auxChangeEpoch = 0;            ///< See auxChangeEpoch().
+	int dangerOwner = -1;                   ///< Player whose threat bits are in dangerMap, or -1 if there is no danger map.
+	int scrollMinX = 0;
+	int scrollMinY = 0;
+	int scrollMaxX = 0;
+	int scrollMaxY = 0;
+};
 /// Pathfinding blocking map
 struct PathBlockingMap
 {
 	bool operator ==(PathBlockingType const &z) const
 	{
-		return type.gameTime == z.gameTime &&
-		       fpathIsEquivalentBlocking(type.propulsion, type.owner, type.moveType,
+		return fpathIsEquivalentBlocking(type.propulsion, type.owner, type.moveType,
 		                                 z.propulsion,    z.owner,    z.moveType);
 	}
 
+	/// Returns the region graph of map, building it on first use. Function is thread-safe.
+	PathRegionGraph const &regionGraph() const
+	{
+		std::call_once(regionGraphBuilt, [this]() {
+			fpathBuildRegionGraph(regionGraphData, map);
+		});
+		return regionGraphData;
+	}
+
 	PathBlockingType type;
-	std::vector<bool> map;
-	std::vector<bool> dangerMap;	// using threatBits
+	PathTileBits map;                       ///< Blocking tiles, with the border outside the map blocking.
+	PathTileBits dangerMap;                 ///< Tiles with threatBits, empty if there is no danger map.
+
+	PathBlockingSource source;
+	size_t auxChangesApplied = 0;           ///< Number of auxChangedTiles() entries already applied to map and dangerMap.
+	uint32_t checksumMap = 0;               ///< For syncDebug, kept up to date when patching.
+	uint32_t checksumDangerMap = 0;         ///< For syncDebug, kept up to date when patching.
+
+private:
+	mutable std::once_flag regionGraphBuilt;
+	mutable PathRegionGraph regionGraphData;
 };
 
 struct PathNonblockingArea
@@ -159,7 +306,7 @@ struct PathNonblockingArea
 // Data structures used for pathfinding, can contain cached results.
 struct PathfindContext
 {
-	PathfindContext() : myGameTime(0), iteration(0), blockingMap(nullptr) {}
+	PathfindContext() : iteration(0), blockingMap(nullptr) {}
 	bool isBlocked(int x, int y) const
 	{
 		if (dstIgnore.isNonblocking(x, y))
@@ -167,23 +314,27 @@ struct PathfindContext
 			return false;  // The path is actually blocked here by a structure, but ignore it since it's where we want to go (or where we came from).
 		}
 		// Not sure whether the out-of-bounds check is needed, can only happen if pathfinding is started on a blocking tile (or off the map).
-		return x < 0 || y < 0 || x >= mapWidth || y >= mapHeight || blockingMap->map[x + y * mapWidth];
+		if (x < 0 || y < 0 || x >= mapWidth || y >= mapHeight || blockingMap->map.get(x, y))
+		{
+			return true;
+		}
+		return !corridor.empty() && !corridor[regionGraph->regionAt(x, y)];  // Outside the regions picked by the hierarchical search.
 	}
+	/// Returns a bitmask with bit dir set if isBlocked(p + aDirOffset[dir]). p must be on the map.
+	unsigned blockedNeighbours(PathCoord p) const;
 	bool isDangerous(int x, int y) const
 	{
-		return !blockingMap->dangerMap.empty() && blockingMap->dangerMap[x + y * mapWidth];
+		return !blockingMap->dangerMap.empty() && blockingMap->dangerMap.get(x, y);
 	}
 	bool matches(const std::shared_ptr<const PathBlockingMap> &blockingMap_, PathCoord tileS_, PathNonblockingArea dstIgnore_) const
 	{
-		// Must check myGameTime == blockingMap_->type.gameTime, otherwise blockingMap could be a deleted pointer which coincidentally compares equal to the valid pointer blockingMap_.
-		return myGameTime == blockingMap_->type.gameTime && blockingMap == blockingMap_ && tileS == tileS_ && dstIgnore == dstIgnore_;
+		return blockingMap == blockingMap_ && tileS == tileS_ && dstIgnore == dstIgnore_;
 	}
 	void assign(const std::shared_ptr<const PathBlockingMap> &blockingMap_, PathCoord tileS_, PathNonblockingArea dstIgnore_)
 	{
 		blockingMap = blockingMap_;
 		tileS = tileS_;
 		dstIgnore = dstIgnore_;
-		myGameTime = blockingMap->type.gameTime;
 		nodes.clear();
 
 		// Make the iteration not match any value of iteration in map.
@@ -196,7 +347,6 @@ struct PathfindContext
 	}
 
 	PathCoord       tileS;                // Start tile for pathfinding. (May be either source or target tile.)
-	uint32_t        myGameTime;
 
 	PathCoord       nearestCoord;         // Nearest reachable tile to destination.
 
@@ -210,12 +360,19 @@ struct PathfindContext
 	std::vector<PathExploredTile> map;  ///< Map, with paths leading back to tileS.
 	std::shared_ptr<const PathBlockingMap> blockingMap; ///< Map of blocking tiles for the type of object which needs a path.
 	PathNonblockingArea dstIgnore;      ///< Area of structure at destination which should be considered nonblocking.
+
+	/// Regions of regionGraph which may be explored, or empty if the whole map may be explored. Kept when reversing the search direction.
+	std::vector<bool> corridor;
+	PathRegionGraph const *regionGraph = nullptr;  ///< Owned by blockingMap, only valid if corridor is not empty.
 };
 
-/// Lists of blocking maps from current tick.
-static std::vector<std::shared_ptr<PathBlockingMap>> fpathBlockingMaps;
-/// Game time for all blocking maps in fpathBlockingMaps.
-static uint32_t fpathCurrentGameTime;
+/// Blocking map for each kind of PathBlockingType which has been used, kept up to date by fpathSetBlockingMap.
+struct PathBlockingMapEntry
+{
+	std::shared_ptr<PathBlockingMap> map;
+	uint32_t lastUsedGameTime;              ///< The map is only updated on its first use in each tick, so all jobs of a tick see the same map.
+};
+static std::vector<PathBlockingMapEntry> fpathBlockingMaps;
 
 // Convert a direction into an offset
 // dir 0 => x = 0, y = -1
@@ -231,6 +388,97 @@ static const Vector2i aDirOffset[] =
 	Vector2i(1, 1),
 };
 
+unsigned PathfindContext::blockedNeighbours(PathCoord p) const
+{
+	unsigned blocked = blockingMap->map.neighbours(p.x, p.y);
+	if (!corridor.empty())
+	{
+		for (unsigned dir = 0; dir < ARRAY_SIZE(aDirOffset); ++dir)
+		{
+			if ((blocked & 1 << dir) == 0 && !corridor[regionGraph->regionAt(p.x + aDirOffset[dir].x, p.y + aDirOffset[dir].y)])
+			{
+				blocked |= 1 << dir;
+			}
+		}
+	}
+	if (p.x + 1 >= dstIgnore.x1 && p.x - 1 < dstIgnore.x2 && p.y + 1 >= dstIgnore.y1 && p.y - 1 < dstIgnore.y2)
+	{
+		for (unsigned dir = 0; dir < ARRAY_SIZE(aDirOffset); ++dir)
+		{
+			if (dstIgnore.isNonblocking(p.x + aDirOffset[dir].x, p.y + aDirOffset[dir].y))
+			{
+				blocked &= ~(1 << dir);
+			}
+		}
+	}
+	return blocked;
+}
+
+static size_t fpathTileBitsBytes(int width, int height)
+{
+	return (static_cast<size_t>(width) * static_cast<size_t>(height) + 7) / 8;
+}
+
+static void fpathPackTileBits(PathTileBits const &bits, int width, int height, std::vector<uint8_t> &output)
+{
+	const size_t start = output.size();
+	output.resize(start + fpathTileBitsBytes(width, height), 0);
+	size_t i = 0;
+	for (int y = 0; y < height; ++y)
+		for (int x = 0; x < width; ++x, ++i)
+		{
+			output[start + i / 8] |= bits.get(x, y) << (i & 7);
+		}
+}
+
+static void fpathUnpackTileBits(const uint8_t *pData, int width, int height, bool border, PathTileBits &bits)
+{
+	bits.reset(width, height, border);
+	size_t i = 0;
+	for (int y = 0; y < height; ++y)
+		for (int x = 0; x < width; ++x, ++i)
+		{
+			bits.set(x, y, pData[i / 8] >> (i & 7) & 1);
+		}
+}
+
+void fpathWriteBlockingMap(PathBlockingMap const &blockingMap, std::vector<uint8_t> &output)
+{
+	const int width = blockingMap.source.width;
+	const int height = blockingMap.source.height;
+	fpathPackTileBits(blockingMap.map, width, height, output);
+	output.push_back(!blockingMap.dangerMap.empty());
+	if (!blockingMap.dangerMap.empty())
+	{
+		fpathPackTileBits(blockingMap.dangerMap, width, height, output);
+	}
+}
+
+std::shared_ptr<const PathBlockingMap> fpathReadBlockingMap(const uint8_t *&pData, const uint8_t *pEnd, int width, int height)
+{
+	const size_t bytes = fpathTileBitsBytes(width, height);
+	if (static_cast<size_t>(pEnd - pData) < bytes + 1)
+	{
+		return nullptr;
+	}
+	auto blockingMap = std::make_shared<PathBlockingMap>();
+	blockingMap->source.width = width;
+	blockingMap->source.height = height;
+	fpathUnpackTileBits(pData, width, height, true, blockingMap->map);
+	pData += bytes;
+	const bool hasDangerMap = *pData++ != 0;
+	if (hasDangerMap)
+	{
+		if (static_cast<size_t>(pEnd - pData) < bytes)
+		{
+			return nullptr;
+		}
+		fpathUnpackTileBits(pData, width, height, false, blockingMap->dangerMap);
+		pData += bytes;
+	}
+	return blockingMap;
+}
+
 void fpathHardTableReset()
 {
 	fpathBlockingMaps.clear();
@@ -350,8 +598,8 @@ static void fpathAStarReestimate(PathfindContext &context, PathCoord tileF)
 	std::make_heap(context.nodes.begin(), context.nodes.end());
 }
 
-/// Returns nearest explored tile to tileF.
-static PathCoord fpathAStarExplore(PathfindContext &context, PathCoord tileF)
+/// Returns nearest explored tile to tileF. Adds the number of tiles visited to nodesExpanded.
+static PathCoord fpathAStarExplore(PathfindContext &context, PathCoord tileF, uint64_t &nodesExpanded)
 {
 	PathCoord       nearestCoord(0, 0);
 	unsigned        nearestDist = 0xFFFFFFFF;
@@ -366,6 +614,7 @@ static PathCoord fpathAStarExplore(PathfindContext &context, PathCoord tileF)
 			continue;  // Already been here.
 		}
 		context.map[node.p.x + node.p.y * mapWidth].visited = true;
+		++nodesExpanded;
 
 		// note the nearest node to the target so far
 		if (node.est - node.dist < nearestDist)
@@ -382,52 +631,277 @@ static PathCoord fpathAStarExplore(PathfindContext &context, PathCoord tileF)
 		}
 
 		// loop through possible moves in 8 directions to find a valid move
+		/*
+		   5  6  7
+		     \|/
+		   4 -I- 0
+		     /|\
+		   3  2  1
+		   odd:orthogonal-adjacent tiles even:non-orthogonal-adjacent tiles
+		*/
+		const unsigned blocked = context.blockedNeighbours(node.p);
+		const unsigned cornerBlocked = (blocked >> 1 | blocked << 7 | blocked << 1 | blocked >> 7) & 0xAA;  // Odd dirs next to a blocked tile.
+		const bool nodeIgnored = context.dstIgnore.isNonblocking(node.p.x, node.p.y);
 		for (unsigned dir = 0; dir < ARRAY_SIZE(aDirOffset); ++dir)
 		{
+			// See if the node is a blocking tile
+			if (blocked & 1 << dir)
+			{
+				// tile is blocked, skip it
+				continue;
+			}
+
 			// Try a new location
 			int x = node.p.x + aDirOffset[dir].x;
 			int y = node.p.y + aDirOffset[dir].y;
 
-			/*
-			   5  6  7
-			     \|/
-			   4 -I- 0
-			     /|\
-			   3  2  1
-			   odd:orthogonal-adjacent tiles even:non-orthogonal-adjacent tiles
-			*/
-			if (dir % 2 != 0 && !context.dstIgnore.isNonblocking(node.p.x, node.p.y) && !context.dstIgnore.isNonblocking(x, y))
+			// We cannot cut corners
+			if ((cornerBlocked & 1 << dir) && !nodeIgnored && !context.dstIgnore.isNonblocking(x, y))
 			{
-				int x2, y2;
+				continue;
+			}
+
+			// Now insert the point into the appropriate list, if not already visited.
+			fpathNewNode(context, tileF, PathCoord(x, y), node.dist, node.p);
+		}
+	}
+
+	return nearestCoord;
+}
 
-				// We cannot cut corners
-				x2 = node.p.x + aDirOffset[(dir + 1) % 8].x;
-				y2 = node.p.y + aDirOffset[(dir + 1) % 8].y;
-				if (context.isBlocked(x2, y2))
+static void fpathBuildRegionGraph(PathRegionGraph &graph, PathTileBits const &blockingMap)
+{
+	graph.width = mapWidth;
+	graph.height = mapHeight;
+	graph.tileRegion.assign(static_cast<size_t>(mapWidth) * static_cast<size_t>(mapHeight), PATH_NO_REGION);
+	graph.regions.clear();
+	graph.edges.clear();
+
+	// Flood fill each cluster, in a fixed order so the region numbering is the same on all clients.
+	std::vector<PathCoord> members;
+	for (int clusterY = 0; clusterY < mapHeight; clusterY += PATH_CLUSTER_SIZE)
+		for (int clusterX = 0; clusterX < mapWidth; clusterX += PATH_CLUSTER_SIZE)
+		{
+			const int x2 = std::min(clusterX + PATH_CLUSTER_SIZE, mapWidth);
+			const int y2 = std::min(clusterY + PATH_CLUSTER_SIZE, mapHeight);
+			for (int y = clusterY; y < y2; ++y)
+				for (int x = clusterX; x < x2; ++x)
 				{
-					continue;
+					if (blockingMap.get(x, y) || graph.tileRegion[x + y * mapWidth] != PATH_NO_REGION)
+					{
+						continue;
+					}
+					const uint32_t region = graph.regions.size();
+					members.clear();
+					members.push_back(PathCoord(x, y));
+					graph.tileRegion[x + y * mapWidth] = region;
+					int sumX = 0, sumY = 0;
+					for (size_t n = 0; n < members.size(); ++n)
+					{
+						const PathCoord p = members[n];
+						sumX += p.x;
+						sumY += p.y;
+						for (unsigned dir = 0; dir < ARRAY_SIZE(aDirOffset); dir += 2)  // Orthogonal neighbours only.
+						{
+							const int nx = p.x + aDirOffset[dir].x;
+							const int ny = p.y + aDirOffset[dir].y;
+							if (nx < clusterX || ny < clusterY || nx >= x2 || ny >= y2
+							    || blockingMap.get(nx, ny) || graph.tileRegion[nx + ny * mapWidth] != PATH_NO_REGION)
+							{
+								continue;
+							}
+							graph.tileRegion[nx + ny * mapWidth] = region;
+							members.push_back(PathCoord(nx, ny));
+						}
+					}
+
+					// Use the member nearest the centroid as centre, since the centroid itself may be blocking or in another region.
+					const Vector2i centroid(sumX / (int)members.size(), sumY / (int)members.size());
+					PathRegionGraph::Region info;
+					int bestDistSq = INT32_MAX;
+					for (const PathCoord &p : members)
+					{
+						const Vector2i diff = Vector2i(p.x, p.y) - centroid;
+						if (dot(diff, diff) < bestDistSq)
+						{
+							bestDistSq = dot(diff, diff);
+							info.centre = p;
+						}
+					}
+					graph.regions.push_back(info);
 				}
-				x2 = node.p.x + aDirOffset[(dir + 7) % 8].x;
-				y2 = node.p.y + aDirOffset[(dir + 7) % 8].y;
-				if (context.isBlocked(x2, y2))
+		}
+
+	// Link regions which touch across the border between two clusters.
+	std::vector<std::pair<uint32_t, uint32_t>> links;
+	auto link = [&](uint32_t regionA, uint32_t regionB) {
+		if (regionA != PATH_NO_REGION && regionB != PATH_NO_REGION)
+		{
+			links.emplace_back(regionA, regionB);
+			links.emplace_back(regionB, regionA);
+		}
+	};
+	for (int x = PATH_CLUSTER_SIZE; x < mapWidth; x += PATH_CLUSTER_SIZE)
+		for (int y = 0; y < mapHeight; ++y)
+		{
+			link(graph.regionAt(x - 1, y), graph.regionAt(x, y));
+		}
+	for (int y = PATH_CLUSTER_SIZE; y < mapHeight; y += PATH_CLUSTER_SIZE)
+		for (int x = 0; x < mapWidth; ++x)
+		{
+			link(graph.regionAt(x, y - 1), graph.regionAt(x, y));
+		}
+	std::sort(links.begin(), links.end());
+	links.erase(std::unique(links.begin(), links.end()), links.end());
+	graph.edges.reserve(links.size());
+	for (const auto &link : links)
+	{
+		PathRegionGraph::Region &info = graph.regions[link.first];
+		if (info.numEdges == 0)
+		{
+			info.firstEdge = graph.edges.size();
+		}
+		++info.numEdges;
+		graph.edges.push_back(link.second);
+	}
+}
+
+/// Node of the abstract search in fpathFindCorridor.
+struct PathRegionNode
+{
+	bool operator <(PathRegionNode const &z) const
+	{
+		// Sort descending est, fallback to ascending dist, fallback to sorting by region, so the heap order is fully deterministic.
+		if (est != z.est)
+		{
+			return est > z.est;
+		}
+		if (dist != z.dist)
+		{
+			return dist < z.dist;
+		}
+		return region > z.region;
+	}
+
+	uint32_t region;
+	unsigned dist, est;
+};
+
+/** Searches the region graph for a route from tileS to tileF (or to the area of dstIgnore), and marks the regions
+ *  along the route, and their neighbours, in corridor.
+ *
+ *  @return false if there is no abstract route, in which case the caller should search the whole map.
+ */
+static bool fpathFindCorridor(PathRegionGraph const &graph, PathCoord tileS, PathCoord tileF, PathNonblockingArea const &dstIgnore, std::vector<bool> &corridor)
+{
+	const uint32_t startRegion = graph.regionAt(tileS.x, tileS.y);
+	if (startRegion == PATH_NO_REGION)
+	{
+		return false;
+	}
+
+	// The goal is the region of tileF, or any region next to the structure at the destination, since the structure tiles are passable for this route.
+	std::vector<bool> isGoal(graph.regions.size(), false);
+	bool haveGoal = false;
+	if (graph.regionAt(tileF.x, tileF.y) != PATH_NO_REGION)
+	{
+		isGoal[graph.regionAt(tileF.x, tileF.y)] = true;
+		haveGoal = true;
+	}
+	if (dstIgnore.x1 < dstIgnore.x2)
+	{
+		for (int y = std::max(dstIgnore.y1 - 1, 0); y < std::min<int>(dstIgnore.y2 + 1, graph.height); ++y)
+			for (int x = std::max(dstIgnore.x1 - 1, 0); x < std::min<int>(dstIgnore.x2 + 1, graph.width); ++x)
+			{
+				if (graph.regionAt(x, y) != PATH_NO_REGION)
 				{
-					continue;
+					isGoal[graph.regionAt(x, y)] = true;
+					haveGoal = true;
 				}
 			}
+	}
+	if (!haveGoal)
+	{
+		return false;
+	}
 
-			// See if the node is a blocking tile
-			if (context.isBlocked(x, y))
+	std::vector<unsigned> dist(graph.regions.size(), UINT32_MAX);
+	std::vector<uint32_t> previous(graph.regions.size(), PATH_NO_REGION);
+	std::vector<bool> closed(graph.regions.size(), false);
+	std::vector<PathRegionNode> nodes;
+
+	dist[startRegion] = 0;
+	nodes.push_back({startRegion, 0, fpathEstimate(graph.regions[startRegion].centre, tileF)});
+	uint32_t goalRegion = PATH_NO_REGION;
+	while (!nodes.empty())
+	{
+		std::pop_heap(nodes.begin(), nodes.end());
+		const PathRegionNode node = nodes.back();
+		nodes.pop_back();
+		if (closed[node.region])
+		{
+			continue;
+		}
+		closed[node.region] = true;
+		if (isGoal[node.region])
+		{
+			goalRegion = node.region;
+			break;
+		}
+
+		const PathRegionGraph::Region &info = graph.regions[node.region];
+		for (uint32_t edge = info.firstEdge; edge < info.firstEdge + info.numEdges; ++edge)
+		{
+			const uint32_t next = graph.edges[edge];
+			const PathCoord nextCentre = graph.regions[next].centre;
+			const unsigned nextDist = node.dist + fpathEstimate(info.centre, nextCentre);
+			if (closed[next] || nextDist >= dist[next])
 			{
-				// tile is blocked, skip it
 				continue;
 			}
+			dist[next] = nextDist;
+			previous[next] = node.region;
+			nodes.push_back({next, nextDist, nextDist + fpathEstimate(nextCentre, tileF)});
+			std::push_heap(nodes.begin(), nodes.end());
+		}
+	}
+	if (goalRegion == PATH_NO_REGION)
+	{
+		return false;  // Not reachable, need to explore everything to find the nearest reachable tile.
+	}
 
-			// Now insert the point into the appropriate list, if not already visited.
-			fpathNewNode(context, tileF, PathCoord(x, y), node.dist, node.p);
+	// Allow the regions next to the abstract route too, so the route on tiles is not forced through the region centres.
+	corridor.assign(graph.regions.size(), false);
+	for (uint32_t region = goalRegion; region != PATH_NO_REGION; region = previous[region])
+	{
+		corridor[region] = true;
+		const PathRegionGraph::Region &info = graph.regions[region];
+		for (uint32_t edge = info.firstEdge; edge < info.firstEdge + info.numEdges; ++edge)
+		{
+			corridor[graph.edges[edge]] = true;
 		}
 	}
+	return true;
+}
 
-	return nearestCoord;
+/// Limits the exploration of context to a corridor around the abstract route from tileS to tileF, if the route is long enough to be worth it.
+static void fpathSetCorridor(PathfindContext &context, PathCoord tileS, PathCoord tileF, PathNonblockingArea const &dstIgnore)
+{
+	context.corridor.clear();
+	context.regionGraph = nullptr;
+	if (fpathEstimate(tileS, tileF) < PATH_HIERARCHICAL_MIN_TILES * 140)
+	{
+		return;
+	}
+	PathRegionGraph const &graph = context.blockingMap->regionGraph();
+	if (fpathFindCorridor(graph, tileS, tileF, dstIgnore, context.corridor))
+	{
+		context.regionGraph = &graph;
+	}
+	else
+	{
+		context.corridor.clear();
+	}
 }
 
 static void fpathInitContext(PathfindContext &context, const std::shared_ptr<const PathBlockingMap> &blockingMap, PathCoord tileS, PathCoord tileRealS, PathCoord tileF, PathNonblockingArea dstIgnore)
@@ -555,6 +1029,14 @@ public:
 	PathfindContextList fpathContexts;
 	/// Used to avoid extra allocations in fpathAStarRoute
 	std::vector<Vector2i> pathBuffer;
+	/// Game time of the jobs the contexts in fpathContexts were made for.
+	uint32_t contextsGameTime = 0;
+	/// Total number of tiles visited by fpathAStarExplore.
+	uint64_t nodesExpanded = 0;
+	/// Used by fpathAStarSpliceRoute, which does not reuse explorations.
+	PathfindContext spliceContext;
+	/// The region set in spliceContext.corridor, so the next local route only needs to reset that one.
+	uint32_t spliceRegion = 0;
 };
 
 FPathExecuteContext::~FPathExecuteContext()
@@ -565,9 +1047,11 @@ FPathExecuteContextImpl::~FPathExecuteContextImpl()
 
 void FPathExecuteContextImpl::resetForNewGameTimeIfNeeded(const PATHJOB& job)
 {
-	if (!fpathContexts.empty() && job.blockingMap->type.gameTime != fpathContexts.front().myGameTime)
+	// Contexts are only reused within a tick, since results may differ depending on whether a context is reused.
+	if (job.gameTime != contextsGameTime)
 	{
 		fpathContexts.clear();
+		contextsGameTime = job.gameTime;
 	}
 }
 
@@ -576,6 +1060,43 @@ std::shared_ptr<FPathExecuteContext> makeFPathExecuteContext()
 	return std::make_shared<FPathExecuteContextImpl>();
 }
 
+uint64_t fpathAStarNodesExpanded(const std::shared_ptr<FPathExecuteContext>& ctx)
+{
+	return std::static_pointer_cast<FPathExecuteContextImpl>(ctx)->nodesExpanded;
+}
+
+/// Appends the route from endCoord back to context.tileS to path.
+static bool fpathAStarWalkBack(PathfindContext const &context, PathCoord endCoord, std::vector<Vector2i> &path)
+{
+	Vector2i newP(0, 0);
+	for (Vector2i p(world_coord(endCoord.x) + TILE_UNITS / 2, world_coord(endCoord.y) + TILE_UNITS / 2); true; p = newP)
+	{
+		ASSERT_OR_RETURN(false, worldOnMap(p.x, p.y), "Assigned XY coordinates (%d, %d) not on map!", (int)p.x, (int)p.y);
+		ASSERT_OR_RETURN(false, path.size() < (static_cast<size_t>(mapWidth) * static_cast<size_t>(mapHeight)), "Pathfinding got in a loop.");
+
+		path.push_back(p);
+
+		PathExploredTile const &tile = context.map[map_coord(p.x) + map_coord(p.y) * mapWidth];
+		newP = p - Vector2i(tile.dx, tile.dy) * (TILE_UNITS / 64);
+		Vector2i mapP = map_coord(newP);
+		int xSide = newP.x - world_coord(mapP.x) > TILE_UNITS / 2 ? 1 : -1; // 1 if newP is on right-hand side of the tile, or -1 if newP is on the left-hand side of the tile.
+		int ySide = newP.y - world_coord(mapP.y) > TILE_UNITS / 2 ? 1 : -1; // 1 if newP is on bottom side of the tile, or -1 if newP is on the top side of the tile.
+		if (context.isBlocked(mapP.x + xSide, mapP.y))
+		{
+			newP.x = world_coord(mapP.x) + TILE_UNITS / 2; // Point too close to a blocking tile on left or right side, so move the point to the middle.
+		}
+		if (context.isBlocked(mapP.x, mapP.y + ySide))
+		{
+			newP.y = world_coord(mapP.y) + TILE_UNITS / 2; // Point too close to a blocking tile on rop or bottom side, so move the point to the middle.
+		}
+		if (map_coord(p) == Vector2i(context.tileS.x, context.tileS.y) || p == newP)
+		{
+			break;  // We stopped moving, because we reached the destination or the closest reachable tile to context.tileS. Give up now.
+		}
+	}
+	return true;
+}
+
 ASR_RETVAL fpathAStarRoute(const std::shared_ptr<FPathExecuteContext>& ctx, MOVE_CONTROL *psMove, PATHJOB *psJob)
 {
 	ASR_RETVAL      retval = ASR_OK;
@@ -603,6 +1124,12 @@ ASR_RETVAL fpathAStarRoute(const std::shared_ptr<FPathExecuteContext>& ctx, MOVE
 
 		// We have tried going to tileDest before.
 
+		if (!contextIterator->corridor.empty() && contextIterator->isBlocked(tileOrig.x, tileOrig.y))
+		{
+			// orig is outside the corridor this context was limited to, so it cannot be found by continuing the exploration.
+			continue;
+		}
+
 		if (contextIterator->map[tileOrig.x + tileOrig.y * mapWidth].iteration == contextIterator->iteration
 		    && contextIterator->map[tileOrig.x + tileOrig.y * mapWidth].visited)
 		{
@@ -613,7 +1140,7 @@ ASR_RETVAL fpathAStarRoute(const std::shared_ptr<FPathExecuteContext>& ctx, MOVE
 		{
 			// Need to find the path from orig to dest, continue previous exploration.
 			fpathAStarReestimate(*contextIterator, tileOrig);
-			endCoord = fpathAStarExplore(*contextIterator, tileOrig);
+			endCoord = fpathAStarExplore(*contextIterator, tileOrig, ctxImpl->nodesExpanded);
 		}
 
 		if (endCoord != tileOrig)
@@ -634,7 +1161,15 @@ ASR_RETVAL fpathAStarRoute(const std::shared_ptr<FPathExecuteContext>& ctx, MOVE
 		// Init a new context, overwriting the oldest one if we are caching too many.
 		// We will be searching from orig to dest, since we don't know where the nearest reachable tile to dest is.
 		fpathInitContext(*contextIterator, psJob->blockingMap, tileOrig, tileOrig, tileDest, dstIgnore);
-		endCoord = fpathAStarExplore(*contextIterator, tileDest);
+		fpathSetCorridor(*contextIterator, tileOrig, tileDest, dstIgnore);
+		endCoord = fpathAStarExplore(*contextIterator, tileDest, ctxImpl->nodesExpanded);
+		if (endCoord != tileDest && !contextIterator->corridor.empty())
+		{
+			// Should not happen, since the corridor is connected, but never return a worse route than the unrestricted search.
+			contextIterator->corridor.clear();
+			fpathInitContext(*contextIterator, psJob->blockingMap, tileOrig, tileOrig, tileDest, dstIgnore);
+			endCoord = fpathAStarExplore(*contextIterator, tileDest, ctxImpl->nodesExpanded);
+		}
 		contextIterator->nearestCoord = endCoord;
 	}
 
@@ -650,31 +1185,9 @@ ASR_RETVAL fpathAStarRoute(const std::shared_ptr<FPathExecuteContext>& ctx, MOVE
 	std::vector<Vector2i>& path = ctxImpl->pathBuffer;
 	path.clear();
 
-	Vector2i newP(0, 0);
-	for (Vector2i p(world_coord(endCoord.x) + TILE_UNITS / 2, world_coord(endCoord.y) + TILE_UNITS / 2); true; p = newP)
+	if (!fpathAStarWalkBack(context, endCoord, path))
 	{
-		ASSERT_OR_RETURN(ASR_FAILED, worldOnMap(p.x, p.y), "Assigned XY coordinates (%d, %d) not on map!", (int)p.x, (int)p.y);
-		ASSERT_OR_RETURN(ASR_FAILED, path.size() < (static_cast<size_t>(mapWidth) * static_cast<size_t>(mapHeight)), "Pathfinding got in a loop.");
-
-		path.push_back(p);
-
-		PathExploredTile &tile = context.map[map_coord(p.x) + map_coord(p.y) * mapWidth];
-		newP = p - Vector2i(tile.dx, tile.dy) * (TILE_UNITS / 64);
-		Vector2i mapP = map_coord(newP);
-		int xSide = newP.x - world_coord(mapP.x) > TILE_UNITS / 2 ? 1 : -1; // 1 if newP is on right-hand side of the tile, or -1 if newP is on the left-hand side of the tile.
-		int ySide = newP.y - world_coord(mapP.y) > TILE_UNITS / 2 ? 1 : -1; // 1 if newP is on bottom side of the tile, or -1 if newP is on the top side of the tile.
-		if (context.isBlocked(mapP.x + xSide, mapP.y))
-		{
-			newP.x = world_coord(mapP.x) + TILE_UNITS / 2; // Point too close to a blocking tile on left or right side, so move the point to the middle.
-		}
-		if (context.isBlocked(mapP.x, mapP.y + ySide))
-		{
-			newP.y = world_coord(mapP.y) + TILE_UNITS / 2; // Point too close to a blocking tile on rop or bottom side, so move the point to the middle.
-		}
-		if (map_coord(p) == Vector2i(context.tileS.x, context.tileS.y) || p == newP)
-		{
-			break;  // We stopped moving, because we reached the destination or the closest reachable tile to context.tileS. Give up now.
-		}
+		return ASR_FAILED;
 	}
 	if (retval == ASR_OK)
 	{
@@ -732,62 +1245,266 @@ ASR_RETVAL fpathAStarRoute(const std::shared_ptr<FPathExecuteContext>& ctx, MOVE
 	return retval;
 }
 
-void fpathSetBlockingMap(PATHJOB *psJob)
+/// Appends the route from tileFrom to tileTo to path, without leaving region. Returns false if there is no such route.
+static bool fpathAStarLocalRoute(FPathExecuteContextImpl &ctx, const std::shared_ptr<const PathBlockingMap> &blockingMap, PathCoord tileFrom, PathCoord tileTo, uint32_t region, std::vector<Vector2i> &path)
 {
-	if (fpathCurrentGameTime != gameTime)
+	PathfindContext &context = ctx.spliceContext;
+	PathRegionGraph const &graph = blockingMap->regionGraph();
+	fpathInitContext(context, blockingMap, tileTo, tileTo, tileFrom, PathNonblockingArea());  // Only bumps the iteration of the explored tiles.
+	if (context.corridor.size() == graph.regions.size())
+	{
+		context.corridor[ctx.spliceRegion] = false;  // The region of the previous local route is the only one set.
+	}
+	else
+	{
+		context.corridor.assign(graph.regions.size(), false);
+	}
+	context.corridor[region] = true;
+	context.regionGraph = &graph;
+	ctx.spliceRegion = region;
+	if (fpathAStarExplore(context, tileFrom, ctx.nodesExpanded) != tileFrom)
 	{
-		// New tick, remove maps which are no longer needed.
-		fpathCurrentGameTime = gameTime;
-		fpathBlockingMaps.clear();
+		return false;
 	}
+	return fpathAStarWalkBack(context, tileFrom, path);  // Walks back from tileFrom to tileTo, so already in the right order.
+}
 
+ASR_RETVAL fpathAStarSpliceRoute(const std::shared_ptr<FPathExecuteContext>& ctx, MOVE_CONTROL *psMove, PATHJOB *psJob, std::vector<Vector2i> const &route)
+{
+	auto ctxImpl = std::static_pointer_cast<FPathExecuteContextImpl>(ctx);
+	const PathCoord tileOrig(map_coord(psJob->origX), map_coord(psJob->origY));
+	const PathCoord tileDest(map_coord(psJob->destX), map_coord(psJob->destY));
+	const PathNonblockingArea dstIgnore(psJob->dstStructure);
+	if (dstIgnore.x1 < dstIgnore.x2 && dstIgnore.y1 < dstIgnore.y2)
+	{
+		return ASR_FAILED;  // The destination may be inside a structure, which is not part of any region.
+	}
+
+	PathRegionGraph const &graph = psJob->blockingMap->regionGraph();
+	const uint32_t regionOrig = graph.regionAt(tileOrig.x, tileOrig.y);
+	const uint32_t regionDest = graph.regionAt(tileDest.x, tileDest.y);
+	if (regionOrig == PATH_NO_REGION || regionDest == PATH_NO_REGION || regionOrig == regionDest)
+	{
+		return ASR_FAILED;
+	}
+
+	// Leave the route at its last point in the region of orig, and join it at its first following point in the region of dest.
+	size_t leave = route.size(), join = route.size();
+	for (size_t n = 0; n < route.size(); ++n)
+	{
+		const Vector2i tile = map_coord(route[n]);
+		if (tile.x < 0 || tile.y < 0 || tile.x >= graph.width || tile.y >= graph.height)
+		{
+			return ASR_FAILED;
+		}
+		const uint32_t region = graph.regionAt(tile.x, tile.y);
+		if (region == regionOrig)
+		{
+			leave = n;
+			join = route.size();
+		}
+		else if (region == regionDest && leave != route.size() && join == route.size())
+		{
+			join = n;
+		}
+	}
+	if (join == route.size())
+	{
+		return ASR_FAILED;
+	}
+
+	std::vector<Vector2i> &path = ctxImpl->pathBuffer;
+	path.clear();
+	const Vector2i tileLeave = map_coord(route[leave]);
+	const Vector2i tileJoin = map_coord(route[join]);
+	if (!fpathAStarLocalRoute(*ctxImpl, psJob->blockingMap, tileOrig, PathCoord(tileLeave.x, tileLeave.y), regionOrig, path))
+	{
+		return ASR_FAILED;
+	}
+	path.insert(path.end(), route.begin() + leave + 1, route.begin() + join);
+	if (!fpathAStarLocalRoute(*ctxImpl, psJob->blockingMap, PathCoord(tileJoin.x, tileJoin.y), tileDest, regionDest, path))
+	{
+		return ASR_FAILED;
+	}
+	path.back() = Vector2i(psJob->destX, psJob->destY);
+
+	psMove->asPath = path;
+	psMove->destination = psMove->asPath.back();
+	return ASR_OK;
+}
+
+/// Returns the factor of tile index in the blocking map checksums, which are built with factor = 3 * factor + 1 for each successive tile.
+static uint32_t fpathChecksumFactor(size_t index)
+{
+	// factor(index) = (3^(index + 1) - 1)/2, and 3^(index + 1) mod 2^64 is enough to get the lower 32 bits of that.
+	uint64_t power = 1;
+	uint64_t base = 3;
+	for (size_t exponent = index + 1; exponent != 0; exponent >>= 1)
+	{
+		if (exponent & 1)
+		{
+			power *= base;
+		}
+		base *= base;
+	}
+	return static_cast<uint32_t>((power - 1) >> 1);
+}
+
+static PathBlockingSource fpathCurrentBlockingSource(PathBlockingType const &type)
+{
+	PathBlockingSource source;
+	source.width = mapWidth;
+	source.height = mapHeight;
+	source.blockMap = psBlockMap[AUX_MAP].get();
+	source.auxChangeEpoch = auxChangeEpoch();
+	source.dangerOwner = !isHumanPlayer(type.owner) && type.moveType == FMT_MOVE ? type.owner : -1;
+	source.scrollMinX = scrollMinX;
+	source.scrollMinY = scrollMinY;
+	source.scrollMaxX = scrollMaxX;
+	source.scrollMaxY = scrollMaxY;
+	return source;
+}
+
+static void fpathGenerateBlockingMap(PathBlockingMap &blockMap)
+{
+	PathBlockingType const &type = blockMap.type;
+	PathTileBits &map = blockMap.map;
+	map.reset(mapWidth, mapHeight, true);
+	uint32_t checksumMap = 0, checksumDangerMap = 0, factor = 0;
+	for (int y = 0; y < mapHeight; ++y)
+		for (int x = 0; x < mapWidth; ++x)
+		{
+			const bool blocking = fpathBaseBlockingTile(x, y, type.propulsion, type.owner, type.moveType);
+			map.set(x, y, blocking);
+			checksumMap ^= blocking * (factor = 3 * factor + 1);
+		}
+	blockMap.dangerMap.clear();
+	if (blockMap.source.dangerOwner >= 0)
+	{
+		PathTileBits &dangerMap = blockMap.dangerMap;
+		dangerMap.reset(mapWidth, mapHeight, false);
+		for (int y = 0; y < mapHeight; ++y)
+			for (int x = 0; x < mapWidth; ++x)
+			{
+				const bool danger = auxTile(x, y, blockMap.source.dangerOwner) & AUXBITS_THREAT;
+				dangerMap.set(x, y, danger);
+				checksumDangerMap ^= danger * (factor = 3 * factor + 1);
+			}
+	}
+	blockMap.checksumMap = checksumMap;
+	blockMap.checksumDangerMap = checksumDangerMap;
+	blockMap.auxChangesApplied = auxChangedTiles().size();
+}
+
+/// Applies the tiles changed since blockMap was last generated or patched.
+static void fpathPatchBlockingMap(PathBlockingMap &blockMap)
+{
+	PathBlockingType const &type = blockMap.type;
+	std::vector<uint32_t> const &changes = auxChangedTiles();
+	const size_t mapSize = static_cast<size_t>(mapWidth) * static_cast<size_t>(mapHeight);
+	for (size_t n = blockMap.auxChangesApplied; n < changes.size(); ++n)
+	{
+		const uint32_t i = changes[n];
+		const int x = i % mapWidth;
+		const int y = i / mapWidth;
+		const bool blocking = fpathBaseBlockingTile(x, y, type.propulsion, type.owner, type.moveType);
+		if (blocking != blockMap.map.get(x, y))
+		{
+			blockMap.map.set(x, y, blocking);
+			blockMap.checksumMap ^= fpathChecksumFactor(i);
+		}
+		if (blockMap.source.dangerOwner >= 0)
+		{
+			const bool danger = auxTile(x, y, blockMap.source.dangerOwner) & AUXBITS_THREAT;
+			if (danger != blockMap.dangerMap.get(x, y))
+			{
+				blockMap.dangerMap.set(x, y, danger);
+				blockMap.checksumDangerMap ^= fpathChecksumFactor(mapSize + i);
+			}
+		}
+	}
+	blockMap.auxChangesApplied = changes.size();
+}
+
+/// Returns whether applying the tiles changed since blockMap was last generated or patched would change any of its bits.
+static bool fpathBlockingMapNeedsPatch(PathBlockingMap const &blockMap)
+{
+	PathBlockingType const &type = blockMap.type;
+	std::vector<uint32_t> const &changes = auxChangedTiles();
+	for (size_t n = blockMap.auxChangesApplied; n < changes.size(); ++n)
+	{
+		const uint32_t i = changes[n];
+		const int x = i % mapWidth;
+		const int y = i / mapWidth;
+		if (fpathBaseBlockingTile(x, y, type.propulsion, type.owner, type.moveType) != blockMap.map.get(x, y))
+		{
+			return true;
+		}
+		if (blockMap.source.dangerOwner >= 0 && bool(auxTile(x, y, blockMap.source.dangerOwner) & AUXBITS_THREAT) != blockMap.dangerMap.get(x, y))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void fpathSetBlockingMap(PATHJOB *psJob)
+{
 	// Figure out which map we are looking for.
 	PathBlockingType type;
-	type.gameTime = gameTime;
 	type.propulsion = psJob->propulsion;
 	type.owner = psJob->owner;
 	type.moveType = psJob->moveType;
 
 	// Find the map.
-	auto i = std::find_if(fpathBlockingMaps.begin(), fpathBlockingMaps.end(), [&](std::shared_ptr<PathBlockingMap> const &ptr) {
-		return *ptr == type;
+	auto i = std::find_if(fpathBlockingMaps.begin(), fpathBlockingMaps.end(), [&](PathBlockingMapEntry const &entry) {
+		return *entry.map == type;
 	});
-	if (i == fpathBlockingMaps.end())
+	if (i != fpathBlockingMaps.end() && i->lastUsedGameTime == gameTime)
 	{
-		// Didn't find the map, so i does not point to a map.
-		auto blockMap = std::make_shared<PathBlockingMap>();
-		fpathBlockingMaps.push_back(blockMap);
+		syncDebug("blockingMap(%d,%d,%d,%d) = cached", gameTime, psJob->propulsion, psJob->owner, psJob->moveType);
 
-		// blockMap now points to an empty map with no data. Fill the map.
+		psJob->blockingMap = i->map;
+		return;
+	}
+
+	// First use of the map in this tick, bring it up to date.
+	PathBlockingSource source = fpathCurrentBlockingSource(type);
+	if (i == fpathBlockingMaps.end() || i->map->source != source || type.owner < 0 || type.owner >= MAX_PLAYERS)
+	{
+		// Didn't find the map, or it can't be patched, so generate it from scratch.
+		auto blockMap = std::make_shared<PathBlockingMap>();
 		blockMap->type = type;
-		std::vector<bool> &map = blockMap->map;
-		map.resize(static_cast<size_t>(mapWidth) * static_cast<size_t>(mapHeight));
-		uint32_t checksumMap = 0, checksumDangerMap = 0, factor = 0;
-		for (int y = 0; y < mapHeight; ++y)
-			for (int x = 0; x < mapWidth; ++x)
-			{
-				map[x + y * mapWidth] = fpathBaseBlockingTile(x, y, type.propulsion, type.owner, type.moveType);
-				checksumMap ^= map[x + y * mapWidth] * (factor = 3 * factor + 1);
-			}
-		if (!isHumanPlayer(type.owner) && type.moveType == FMT_MOVE)
+		blockMap->source = source;
+		fpathGenerateBlockingMap(*blockMap);
+		if (i == fpathBlockingMaps.end())
 		{
-			std::vector<bool> &dangerMap = blockMap->dangerMap;
-			dangerMap.resize(static_cast<size_t>(mapWidth) * static_cast<size_t>(mapHeight));
-			for (int y = 0; y < mapHeight; ++y)
-				for (int x = 0; x < mapWidth; ++x)
-				{
-					dangerMap[x + y * mapWidth] = auxTile(x, y, type.owner) & AUXBITS_THREAT;
-					checksumDangerMap ^= dangerMap[x + y * mapWidth] * (factor = 3 * factor + 1);
-				}
+			i = fpathBlockingMaps.insert(fpathBlockingMaps.end(), PathBlockingMapEntry{blockMap, gameTime});
 		}
-		syncDebug("blockingMap(%d,%d,%d,%d) = %08X %08X", gameTime, psJob->propulsion, psJob->owner, psJob->moveType, checksumMap, checksumDangerMap);
-
-		psJob->blockingMap = blockMap;
+		i->map = blockMap;
 	}
-	else
+	else if (i->map->auxChangesApplied != auxChangedTiles().size() && !fpathBlockingMapNeedsPatch(*i->map))
 	{
-		syncDebug("blockingMap(%d,%d,%d,%d) = cached", gameTime, psJob->propulsion, psJob->owner, psJob->moveType);
-
-		psJob->blockingMap = *i;
+		// Most changed tiles (threat bits of other players, gates of allies) don't affect this map.
+		// Keep it, so its region graph and the routes cached for it stay valid.
+		i->map->auxChangesApplied = auxChangedTiles().size();
 	}
+	else if (i->map->auxChangesApplied != auxChangedTiles().size())
+	{
+		// Path threads may still be using the old map, so patch a copy.
+		auto blockMap = std::make_shared<PathBlockingMap>();
+		blockMap->type = i->map->type;
+		blockMap->map = i->map->map;
+		blockMap->dangerMap = i->map->dangerMap;
+		blockMap->source = i->map->source;
+		blockMap->auxChangesApplied = i->map->auxChangesApplied;
+		blockMap->checksumMap = i->map->checksumMap;
+		blockMap->checksumDangerMap = i->map->checksumDangerMap;
+		fpathPatchBlockingMap(*blockMap);
+		i->map = blockMap;
+	}
+	i->lastUsedGameTime = gameTime;
+	syncDebug("blockingMap(%d,%d,%d,%d) = %08X %08X", gameTime, psJob->propulsion, psJob->owner, psJob->moveType, i->map->checksumMap, i->map->checksumDangerMap);
+
+	psJob->blockingMap = i->map;
 }
@@ -44,16 +44,38 @@ public:
 };
 std::shared_ptr<FPathExecuteContext> makeFPathExecuteContext();
 
+/// Returns the number of tiles explored by fpathAStarRoute using ctx, for benchmarking.
+uint64_t fpathAStarNodesExpanded(const std::shared_ptr<FPathExecuteContext>& ctx);
+
 /** Use the A* algorithm to find a path
  *
  *  @ingroup pathfinding
  */
 ASR_RETVAL fpathAStarRoute(const std::shared_ptr<FPathExecuteContext>& ctx, MOVE_CONTROL *psMove, PATHJOB *psJob);
 
+/** Find a path by reusing route, an ASR_OK path found with the same blocking map for a job which started and ended
+ *  in the same clusters as psJob. Only the parts from the start of psJob to route, and from route to the end of
+ *  psJob, are searched, within the regions of the start and end tiles.
+ *
+ *  @return ASR_OK, or ASR_FAILED if route can't be reused, in which case fpathAStarRoute must be used instead.
+ *
+ *  @ingroup pathfinding
+ */
+ASR_RETVAL fpathAStarSpliceRoute(const std::shared_ptr<FPathExecuteContext>& ctx, MOVE_CONTROL *psMove, PATHJOB *psJob, std::vector<Vector2i> const &route);
+
+/// Side length, in tiles, of the clusters used by the hierarchical pathfinding layer.
+static constexpr int PATH_CLUSTER_SIZE = 16;
+
 /// Call from main thread.
 /// Sets psJob->blockingMap for later use by pathfinding thread, generating the required map if not already generated.
+/// Maps are kept between ticks, and patched using auxChangedTiles() on their first use in each tick.
 void fpathSetBlockingMap(PATHJOB *psJob);
 
+/// Appends the blocking and danger tiles of blockingMap to output, one bit per tile, for recordings of path jobs.
+void fpathWriteBlockingMap(PathBlockingMap const &blockingMap, std::vector<uint8_t> &output);
+/// Reads a map of width×height tiles written by fpathWriteBlockingMap, and advances pData past it. Returns nullptr if the data is too short.
+std::shared_ptr<const PathBlockingMap> fpathReadBlockingMap(const uint8_t *&pData, const uint8_t *pEnd, int width, int height);
+
 /** Clean up the path finding node table.
  *
  *  @note Call this on shutdown to prevent memory from leaking, or if loading/saving, to prevent stale data from being reused.
@@ -120,6 +120,7 @@ BASE_OBJECT::BASE_OBJECT(OBJECT_TYPE type, uint32_t id, unsigned player)
 
 BASE_OBJECT::~BASE_OBJECT()
 {
+	objmemUnregisterObject(this);
 	visRemoveVisibility(this);
 }
 
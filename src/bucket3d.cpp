@@ -49,17 +49,81 @@
 
 struct BUCKET_TAG
 {
-	bool operator <(BUCKET_TAG const &b) const
-	{
-		return actualZ > b.actualZ;    // Sort in reverse z order.
-	}
-
 	RENDER_TYPE     objectType; //type of object held
 	void           *pObject;    //pointer to the object
-	int32_t         actualZ;
 };
 
+// The draw order of a tag, as a 64 bit key sorted in increasing order:
+// - bits 32-63: the reverse z order (for opaque objects, z stands for the texpage, which draws them first, grouped by texpage)
+// - bits 28-31: the type of object, to render objects of the same z in batches of the same type
+// - bits 0-27: the index of the tag in bucketArray, which keeps the sort stable
+#define BUCKET_KEY_TYPE_SHIFT 28
+#define BUCKET_KEY_INDEX_MASK ((UINT64_C(1) << BUCKET_KEY_TYPE_SHIFT) - 1)
+static_assert(RENDER_PARTICLE < 16, "RENDER_TYPE must fit in 4 bits of the key");
+
+// These keep their allocations from frame to frame
 static std::vector<BUCKET_TAG> bucketArray;
+static std::vector<uint64_t> bucketKeys;
+static std::vector<uint64_t> bucketSortScratch;
+
+static inline uint64_t bucketMakeKey(int32_t z, RENDER_TYPE objectType, size_t index)
+{
+	const uint32_t reverseZ = ~(static_cast<uint32_t>(z) ^ UINT32_C(0x80000000));  // Larger z first.
+	return (static_cast<uint64_t>(reverseZ) << 32) | (static_cast<uint64_t>(objectType) << BUCKET_KEY_TYPE_SHIFT) | index;
+}
+
+static inline uint32_t bucketKeyType(uint64_t key)
+{
+	return static_cast<uint32_t>(key >> BUCKET_KEY_TYPE_SHIFT) & 0xF;
+}
+
+/// LSD radix sort of the keys, 8 bits at a time, skipping the digits which are the same for all keys
+static void bucketSortKeys(std::vector<uint64_t> &keys, std::vector<uint64_t> &scratch)
+{
+	const size_t count = keys.size();
+	if (count < 2)
+	{
+		return;
+	}
+	scratch.resize(count);
+
+	size_t histograms[8][256] = {};
+	for (uint64_t key : keys)
+	{
+		for (unsigned digit = 0; digit < 8; ++digit)
+		{
+			++histograms[digit][(key >> (digit * 8)) & 0xFF];
+		}
+	}
+
+	uint64_t *pSrc = keys.data();
+	uint64_t *pDst = scratch.data();
+	for (unsigned digit = 0; digit < 8; ++digit)
+	{
+		size_t *histogram = histograms[digit];
+		if (histogram[(pSrc[0] >> (digit * 8)) & 0xFF] == count)
+		{
+			continue;  // Nothing to do, all keys have the same digit.
+		}
+		size_t offset = 0;
+		for (size_t bin = 0; bin < 256; ++bin)
+		{
+			const size_t binCount = histogram[bin];
+			histogram[bin] = offset;
+			offset += binCount;
+		}
+		for (size_t i = 0; i < count; ++i)
+		{
+			const uint64_t key = pSrc[i];
+			pDst[histogram[(key >> (digit * 8)) & 0xFF]++] = key;
+		}
+		std::swap(pSrc, pDst);
+	}
+	if (pSrc != keys.data())
+	{
+		keys.swap(scratch);
+	}
+}
 
 static SDWORD bucketCalculateZ(RENDER_TYPE objectType, void *pObject, const glm::mat4 &perspectiveViewMatrix)
 {
@@ -377,49 +441,73 @@ void bucketAddTypeToList(RENDER_TYPE objectType, void *pObject, const glm::mat4
 	//put the object data into the tag
 	newTag.objectType = objectType;
 	newTag.pObject = pObject;
-	newTag.actualZ = z;
 
 	//add tag to bucketArray
+	ASSERT_OR_RETURN(, bucketArray.size() <= BUCKET_KEY_INDEX_MASK, "Too many objects to render");
+	bucketKeys.push_back(bucketMakeKey(z, objectType, bucketArray.size()));
 	bucketArray.push_back(newTag);
 }
 
+/* render a run of objects of the same type, in the order of the keys */
+template <typename Object, typename RenderFunction>
+static inline void bucketRenderRun(const uint64_t *pKeys, const uint64_t *pKeysEnd, RenderFunction renderFunction)
+{
+	for (; pKeys != pKeysEnd; ++pKeys)
+	{
+		renderFunction(static_cast<Object *>(bucketArray[*pKeys & BUCKET_KEY_INDEX_MASK].pObject));
+	}
+}
+
 /* render Objects in list */
 void bucketRenderCurrentList(const glm::mat4 &viewMatrix, const glm::mat4 &perspectiveViewMatrix)
 {
 	WZ_PROFILE_SCOPE(bucketRenderCurrentList);
-	std::sort(bucketArray.begin(), bucketArray.end());
+	bucketSortKeys(bucketKeys, bucketSortScratch);
 
-	for (auto thisTag = bucketArray.cbegin(); thisTag != bucketArray.cend(); ++thisTag)
+	const uint64_t *pKeys = bucketKeys.data();
+	const uint64_t *const pKeysEnd = pKeys + bucketKeys.size();
+	while (pKeys != pKeysEnd)
 	{
-		switch (thisTag->objectType)
+		// Find the run of objects of the same type, and render it in one go
+		const uint32_t keyType = bucketKeyType(*pKeys);
+		const uint64_t *pRunEnd = pKeys + 1;
+		while (pRunEnd != pKeysEnd && bucketKeyType(*pRunEnd) == keyType)
+		{
+			++pRunEnd;
+		}
+		const RENDER_TYPE objectType = static_cast<RENDER_TYPE>(keyType);
+
+		switch (objectType)
 		{
 		case RENDER_PARTICLE:
-			renderParticle((ATPART *)thisTag->pObject, viewMatrix);
+			bucketRenderRun<ATPART>(pKeys, pRunEnd, [&](ATPART *psPart) { renderParticle(psPart, viewMatrix); });
 			break;
 		case RENDER_EFFECT:
-			renderEffect((EFFECT *)thisTag->pObject, viewMatrix);
+			bucketRenderRun<EFFECT>(pKeys, pRunEnd, [&](EFFECT *psEffect) { renderEffect(psEffect, viewMatrix); });
 			break;
 		case RENDER_DROID:
-			displayComponentObject((DROID *)thisTag->pObject, viewMatrix, perspectiveViewMatrix);
+			bucketRenderRun<DROID>(pKeys, pRunEnd, [&](DROID *psDroid) { displayComponentObject(psDroid, viewMatrix, perspectiveViewMatrix); });
 			break;
 		case RENDER_STRUCTURE:
-			renderStructure((STRUCTURE *)thisTag->pObject, viewMatrix, perspectiveViewMatrix);
+			bucketRenderRun<STRUCTURE>(pKeys, pRunEnd, [&](STRUCTURE *psStructure) { renderStructure(psStructure, viewMatrix, perspectiveViewMatrix); });
 			break;
 		case RENDER_FEATURE:
-			renderFeature((FEATURE *)thisTag->pObject, viewMatrix, perspectiveViewMatrix);
+			bucketRenderRun<FEATURE>(pKeys, pRunEnd, [&](FEATURE *psFeature) { renderFeature(psFeature, viewMatrix, perspectiveViewMatrix); });
 			break;
 		case RENDER_PROXMSG:
-			renderProximityMsg((PROXIMITY_DISPLAY *)thisTag->pObject, viewMatrix, perspectiveViewMatrix);
+			bucketRenderRun<PROXIMITY_DISPLAY>(pKeys, pRunEnd, [&](PROXIMITY_DISPLAY *psProxDisp) { renderProximityMsg(psProxDisp, viewMatrix, perspectiveViewMatrix); });
 			break;
 		case RENDER_PROJECTILE:
-			renderProjectile((PROJECTILE *)thisTag->pObject, viewMatrix, perspectiveViewMatrix);
+			bucketRenderRun<PROJECTILE>(pKeys, pRunEnd, [&](PROJECTILE *psProj) { renderProjectile(psProj, viewMatrix, perspectiveViewMatrix); });
 			break;
 		case RENDER_DELIVPOINT:
-			renderDeliveryPoint((FLAG_POSITION *)thisTag->pObject, false, viewMatrix, perspectiveViewMatrix);
+			bucketRenderRun<FLAG_POSITION>(pKeys, pRunEnd, [&](FLAG_POSITION *psPosition) { renderDeliveryPoint(psPosition, false, viewMatrix, perspectiveViewMatrix); });
 			break;
 		}
+		pKeys = pRunEnd;
 	}
 
 	//reset the bucket array as we go
 	bucketArray.resize(0);
+	bucketKeys.resize(0);
 }
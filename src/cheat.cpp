@@ -96,6 +96,7 @@ static CHEAT_ENTRY cheatCodes[] =
 	{"autogame off", kf_AutoGame},
 	{"shakey", kf_ToggleShakeStatus}, //shakey
 	{"list droids", kf_ListDroids},
+	{"path cache", kf_PathCacheStats}, // show path route cache hits and misses
 
 };
 
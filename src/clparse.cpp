@@ -26,10 +26,13 @@
 
 #include "lib/framework/frame.h"
 #include "lib/framework/string_ext.h"
+#include "lib/framework/file.h"
+#include "lib/framework/physfs_ext.h"
 #include "lib/ivis_opengl/screen.h"
 #include "lib/netplay/netplay.h"
 #include "lib/ivis_opengl/pieclip.h"
 #include "lib/ivis_opengl/png_util.h"
+#include "lib/ivis_opengl/imd.h"
 
 #include "levels.h"
 #include "clparse.h"
@@ -47,6 +50,8 @@
 #include "gamehistorylogger.h"
 #include "stdinreader.h"
 #include "seqdisp.h"
+#include "qtscript.h"
+#include "fpath.h"
 
 #include <cwchar>
 
@@ -90,6 +95,7 @@ static bool wz_cli_headless = false;
 static bool wz_streamer_spectator_mode = false;
 static bool wz_lobby_slashcommands = false;
 static int wz_min_autostart_players = -1;
+static bool wz_replay_simulate = false;
 
 #if defined(WZ_OS_WIN)
 
@@ -357,6 +363,10 @@ typedef enum
 	CLI_GAMELOG_FRAMEINTERVAL,
 	CLI_GAMETIMELIMITMINUTES,
 	CLI_CONVERT_SPECULAR_MAP,
+	CLI_CHECK_MODEL_CACHE,
+	CLI_CHECK_SCRIPT_TIMERS,
+	CLI_PATH_RECORD,
+	CLI_PATH_BENCH,
 	CLI_DEBUG_VERBOSE_SYNCLOG_OUTPUT,
 	CLI_ALLOW_VULKAN_IMPLICIT_LAYERS,
 	CLI_HOST_CHAT_CONFIG,
@@ -366,6 +376,8 @@ typedef enum
 	CLI_VIDEOURL,
 #endif
 	CLI_HOST_CONNECTION_PROVIDER,
+	CLI_SCRIPT_WARNING_THRESHOLD,
+	CLI_REPLAYSIMULATE,
 } CLI_OPTIONS;
 
 // Separate table that avoids *any* translated strings, to avoid any risk of gettext / libintl function calls
@@ -451,6 +463,10 @@ static const struct poptOption *getOptionsTable()
 		{ "gamelog-frameinterval", POPT_ARG_STRING, CLI_GAMELOG_FRAMEINTERVAL, N_("Game history log frame interval"), N_("interval in seconds")},
 		{ "gametimelimit", POPT_ARG_STRING, CLI_GAMETIMELIMITMINUTES, N_("Multiplayer game time limit (in minutes)"), N_("number of minutes")},
 		{ "convert-specular-map", POPT_ARG_STRING, CLI_CONVERT_SPECULAR_MAP, N_("Convert a specular-map .png to a luma, single-channel, grayscale .png (and exit)"), "inputpath/filename.png:outputpath/filename.png" },
+		{ "check-model-cache", POPT_ARG_STRING, CLI_CHECK_MODEL_CACHE, N_("Check that every .pie model in a directory reads back unchanged from the model cache (and exit)"), N_("directory") },
+		{ "check-script-timers", POPT_ARG_NONE, CLI_CHECK_SCRIPT_TIMERS, N_("Check that removing script timers keeps the other timers indexed (and exit)"), nullptr },
+		{ "path-record", POPT_ARG_STRING, CLI_PATH_RECORD, N_("Record the path jobs of the game to a file in the config dir, for --path-bench"), N_("file name") },
+		{ "path-bench", POPT_ARG_STRING, CLI_PATH_BENCH, N_("Replay the path jobs recorded with --path-record, and report the nodes expanded per second (and exit)"), "path/filename" },
 		{ "debug-verbose-sync-logs-until", POPT_ARG_STRING, CLI_DEBUG_VERBOSE_SYNCLOG_OUTPUT, nullptr, nullptr },
 		{ "allow-vulkan-implicit-layers", POPT_ARG_NONE, CLI_ALLOW_VULKAN_IMPLICIT_LAYERS, N_("Allow Vulkan implicit layers (that may be default-disabled due to potential crashes or bugs)"), nullptr },
 		{ "host-chat-config", POPT_ARG_STRING, CLI_HOST_CHAT_CONFIG, N_("Set the default hosting chat configuration / permissions"), "[allow,quickchat]" },
@@ -460,6 +476,8 @@ static const struct poptOption *getOptionsTable()
 		{ "videourl", POPT_ARG_STRING, CLI_VIDEOURL,   N_("Base URL for on-demand video downloads"), N_("Base video URL") },
 #endif
 		{ "host-connection-provider", POPT_ARG_STRING, CLI_HOST_CONNECTION_PROVIDER, N_("Specify connection provider type to use when hosting game sessions"), "[tcp]" },
+		{ "script-warn-threshold", POPT_ARG_STRING, CLI_SCRIPT_WARNING_THRESHOLD, N_("Log a warning when a script function call takes longer than this"), N_("microseconds") },
+		{ "replay-simulate", POPT_ARG_NONE, CLI_REPLAYSIMULATE, N_("Simulate a loaded replay as fast as possible and report the speed (headless only)"), nullptr },
 
 		// Terminating entry
 		{ nullptr, 0, 0,              nullptr,                                    nullptr },
@@ -697,6 +715,82 @@ ParseCLIEarlyResult ParseCommandLineEarly(int argc, const char * const *argv)
 				exit(0);
 			}
 			break;
+		case CLI_CHECK_MODEL_CACHE:
+			{
+				token = poptGetOptArg(poptCon);
+				if (token == nullptr || strlen(token) == 0)
+				{
+					qFatal("Missing check-model-cache value");
+				}
+				if (!PHYSFS_mount(token, "input", PHYSFS_APPEND))
+				{
+					qFatal("check-model-cache - unable to mount directory: %s", token);
+				}
+
+				size_t modelCount = 0;
+				size_t failureCount = 0;
+				WZ_PHYSFS_enumerateFilesEx("input", [&](const char *file) -> bool {
+					if (!strEndsWith(file, ".pie"))
+					{
+						return true;
+					}
+					const std::string path = std::string("input/") + file;
+					char *pFileData = nullptr;
+					UDWORD fileSize = 0;
+					// the model loader names models by the file name, without the directory
+					const char *name = strrchr(file, '/');
+					name = (name != nullptr) ? name + 1 : file;
+					++modelCount;
+					if (!loadFile(path.c_str(), &pFileData, &fileSize, false) || !modelCacheSelfCheck(WzString::fromUtf8(name), pFileData, fileSize))
+					{
+						fprintf(stderr, "check-model-cache - failed: %s\n", file);
+						++failureCount;
+					}
+					free(pFileData);
+					return true;
+				}, true);
+
+				printf("check-model-cache - %zu models checked, %zu failed\n", modelCount, failureCount);
+				PHYSFS_deinit();
+				exit((modelCount > 0 && failureCount == 0) ? 0 : 1);
+			}
+			break;
+		case CLI_CHECK_SCRIPT_TIMERS:
+			{
+				const bool ok = scripting_engine::instance().timersSelfCheck();
+				printf("check-script-timers - %s\n", ok ? "passed" : "failed");
+				exit(ok ? 0 : 1);
+			}
+			break;
+		case CLI_PATH_BENCH:
+			{
+				token = poptGetOptArg(poptCon);
+				if (token == nullptr || strlen(token) == 0)
+				{
+					qFatal("Missing path-bench value");
+				}
+				std::string inputFilename;
+				std::string inputDir = specialGetBaseDir(token, inputFilename);
+				if (inputDir.empty())
+				{
+					qFatal("path-bench value does not seem to include the path to a file (including its directory)");
+				}
+				PHYSFS_mount(inputDir.c_str(), "input", PHYSFS_APPEND);
+
+				char *pFileData = nullptr;
+				UDWORD fileSize = 0;
+				if (!loadFile(("input/" + inputFilename).c_str(), &pFileData, &fileSize, false))
+				{
+					qFatal("path-bench - unable to read: %s", token);
+				}
+				std::string summary;
+				const bool ok = fpathBenchmark(reinterpret_cast<const uint8_t *>(pFileData), fileSize, summary);
+				printf("%s\n", summary.c_str());
+				free(pFileData);
+				PHYSFS_deinit();
+				exit(ok ? 0 : 1);
+			}
+			break;
 		default:
 			break;
 		};
@@ -755,6 +849,9 @@ bool ParseCommandLine(int argc, const char * const *argv)
 		case CLI_WZ_CRASH_RPT:
 		case CLI_WZ_DEBUG_CRASH_HANDLER:
 		case CLI_CONVERT_SPECULAR_MAP:
+		case CLI_CHECK_MODEL_CACHE:
+		case CLI_CHECK_SCRIPT_TIMERS:
+		case CLI_PATH_BENCH:
 			// These options are parsed in ParseCommandLineEarly() already, so ignore them
 			break;
 
@@ -1298,6 +1395,35 @@ bool ParseCommandLine(int argc, const char * const *argv)
 			break;
 		}
 
+		case CLI_SCRIPT_WARNING_THRESHOLD:
+		{
+			token = poptGetOptArg(poptCon);
+			if (token == nullptr)
+			{
+				qFatal("Bad script warning threshold");
+			}
+			int token_intval = atoi(token);
+			if (token_intval < 0)
+			{
+				qFatal("Invalid script warning threshold");
+			}
+			scriptSetCallWarningThreshold(static_cast<uint32_t>(token_intval));
+			break;
+		}
+
+		case CLI_REPLAYSIMULATE:
+			wz_replay_simulate = true;
+			break;
+
+		case CLI_PATH_RECORD:
+			token = poptGetOptArg(poptCon);
+			if (token == nullptr || strlen(token) == 0)
+			{
+				qFatal("Missing path-record file name");
+			}
+			fpathRecordJobs(token);
+			break;
+
 		case CLI_DEBUG_VERBOSE_SYNCLOG_OUTPUT:
 			token = poptGetOptArg(poptCon);
 			if (token == nullptr)
@@ -1400,3 +1526,8 @@ int min_autostart_player_count()
 {
 	return wz_min_autostart_players;
 }
+
+bool replay_simulate_enabled()
+{
+	return wz_replay_simulate;
+}
@@ -42,5 +42,6 @@ bool streamer_spectator_mode();
 bool lobby_slashcommands_enabled();
 
 int min_autostart_player_count();
+bool replay_simulate_enabled();
 
 #endif // __INCLUDED_SRC_CLPARSE_H__
@@ -517,6 +517,12 @@ static void dataSMSGRelease(void *pData)
  */
 static bool dataImageLoad(const char *fileName, void **ppData)
 {
+	if (iV_Image *psPrepared = static_cast<iV_Image *>(resTakePreparedData()))
+	{
+		*ppData = psPrepared;
+		return true;
+	}
+
 	iV_Image *psSprite = new iV_Image();
 	if (!psSprite)
 	{
@@ -536,6 +542,21 @@ static bool dataImageLoad(const char *fileName, void **ppData)
 }
 
 
+/*!
+ * Decode an image ahead of time, on a worker thread
+ */
+static bool dataImagePrepare(const char *fileName, void **ppPrepared)
+{
+	iV_Image *psSprite = new iV_Image();
+	if (!iV_loadImage_PNG(fileName, psSprite))
+	{
+		delete psSprite;
+		return false;  // dataImageLoad() tries again, and reports it
+	}
+	*ppPrepared = psSprite;
+	return true;
+}
+
 // Tertiles (terrain tiles) loader.
 static bool dataTERTILESLoad(const char *fileName, void **ppData)
 {
@@ -591,12 +612,32 @@ static bool dataAudioLoad(const char *fileName, void **ppData)
 		return true;
 	}
 
-	// Load the track from a file
-	*ppData = sound_LoadTrackFromFile(fileName);
+	// Load the track from a file, or upload the data decoded by dataAudioPrepare()
+	DECODED_TRACK *psDecoded = static_cast<DECODED_TRACK *>(resTakePreparedData());
+	*ppData = sound_LoadTrackFromFile(fileName, psDecoded);
+	sound_FreeDecodedTrack(psDecoded);
 
 	return *ppData != nullptr;
 }
 
+/*!
+ * Decode an audio file ahead of time, on a worker thread. Only creating the OpenAL buffer needs the main thread.
+ */
+static bool dataAudioPrepare(const char *fileName, void **ppPrepared)
+{
+	if (audio_Disabled())
+	{
+		return true;  // dataAudioLoad() skips it
+	}
+	*ppPrepared = sound_DecodeTrackFile(fileName);
+	return *ppPrepared != nullptr;  // otherwise dataAudioLoad() tries again, and reports it
+}
+
+static void dataAudioPrepareRelease(void *pPrepared)
+{
+	sound_FreeDecodedTrack(static_cast<DECODED_TRACK *>(pPrepared));
+}
+
 /* Load an audio file */
 static bool dataAudioCfgLoad(const char *fileName, void **ppData)
 {
@@ -654,6 +695,26 @@ static bool jsLoad(const char *fileName, void **ppData)
 	return loadGlobalScript(fileName);
 }
 
+/* Parse a JSON stats file ahead of time, on a worker thread, for the WzConfig of its load function */
+static bool dataJSONPrepare(const char *fileName, void **ppPrepared)
+{
+	WzString *pFilename = new WzString(fileName);
+	if (!WzConfig::preloadDocument(*pFilename))
+	{
+		delete pFilename;
+		return false;
+	}
+	*ppPrepared = pFilename;
+	return true;
+}
+
+static void dataJSONRelease(void *pPrepared)
+{
+	WzString *pFilename = static_cast<WzString *>(pPrepared);
+	WzConfig::discardPreloadedDocument(*pFilename);
+	delete pFilename;
+}
+
 // New reduced resource type ... specially for PSX
 // These are statically defined in data.c
 // this is also defined in frameresource.c - needs moving to a .h file
@@ -712,6 +773,34 @@ static const RES_TYPE_MIN_FILE FileResourceTypes[] =
 	{"FLIC", dataFlicMsgLoad, dataSMSGRelease },
 };
 
+struct RES_TYPE_MIN_PREPARE
+{
+	const char *aType;                      ///< the file type, which must be in FileResourceTypes
+	RES_FILEPREPARE prepare;                ///< routine doing the thread-safe part of loading the file
+	RES_FREE release;                       ///< routine to release the prepared data, if the load function didn't take it
+};
+
+static const RES_TYPE_MIN_PREPARE PrepareResourceTypes[] =
+{
+	{"SFEAT", dataJSONPrepare, dataJSONRelease},
+	{"SWEAPON", dataJSONPrepare, dataJSONRelease},
+	{"SBRAIN", dataJSONPrepare, dataJSONRelease},
+	{"SSENSOR", dataJSONPrepare, dataJSONRelease},
+	{"SECM", dataJSONPrepare, dataJSONRelease},
+	{"SREPAIR", dataJSONPrepare, dataJSONRelease},
+	{"SCONSTR", dataJSONPrepare, dataJSONRelease},
+	{"SPROP", dataJSONPrepare, dataJSONRelease},
+	{"SPROPTYPES", dataJSONPrepare, dataJSONRelease},
+	{"STERRTABLE", dataJSONPrepare, dataJSONRelease},
+	{"SBODY", dataJSONPrepare, dataJSONRelease},
+	{"SWEAPMOD", dataJSONPrepare, dataJSONRelease},
+	{"SSTRMOD", dataJSONPrepare, dataJSONRelease},
+	{"SSTRUCT", dataJSONPrepare, dataJSONRelease},
+	{"RESCH", dataJSONPrepare, dataJSONRelease},
+	{"IMGPAGE", dataImagePrepare, dataImageRelease},
+	{"WAV", dataAudioPrepare, dataAudioPrepareRelease},
+};
+
 /* Pass all the data loading functions to the framework library */
 bool dataInitLoadFuncs()
 {
@@ -750,5 +839,14 @@ bool dataInitLoadFuncs()
 		}
 	}
 
+	// iterate through file prepare functions
+	for (const RES_TYPE_MIN_PREPARE &CurrentType : PrepareResourceTypes)
+	{
+		if (!resAddFilePrepare(CurrentType.aType, CurrentType.prepare, CurrentType.release))
+		{
+			return false;
+		}
+	}
+
 	return true;
 }
@@ -872,7 +872,7 @@ void droidUpdate(DROID *psDroid)
 	// Check that we are (still) in the sensor list
 	if (psDroid->droidType == DROID_SENSOR)
 	{
-		const auto sensor = std::find(apsSensorList[0].begin(), apsSensorList[0].end(), (BASE_OBJECT*)psDroid);
+		const auto sensor = apsSensorList[0].find(psDroid);
 		ASSERT(sensor != apsSensorList[0].end(), "%s(%p) not in sensor list!",
 			   droidGetName(psDroid), static_cast<void *>(psDroid));
 	}
@@ -1868,6 +1868,7 @@ DROID *reallyBuildDroid(const DROID_TEMPLATE *pTemplate, Position pos, UDWORD pl
 	ASSERT_OR_RETURN(nullptr, player < MAX_PLAYERS, "Invalid player: %" PRIu32 "", player);
 
 	DROID& droid = GlobalDroidContainer().emplace(id, player);
+	objmemRegisterObject(&droid);
 	droidSetName(&droid, getLocalizedStatsName(pTemplate));
 
 	// Set the droids type
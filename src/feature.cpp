@@ -237,6 +237,7 @@ FEATURE *buildFeature(FEATURE_STATS *psStats, UDWORD x, UDWORD y, bool FromSave,
 	//try and create the Feature, obtain stable address.
 	FEATURE& feature = GlobalFeatureContainer().emplace(id, psStats);
 	FEATURE* psFeature = &feature;
+	objmemRegisterObject(psFeature);
 
 	//add the feature to the list - this enables it to be drawn whilst being built
 	addFeature(psFeature);
@@ -24,11 +24,16 @@
  *
  */
 
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <deque>
 #include <future>
 #include <unordered_map>
 
 #include "lib/framework/frame.h"
 #include "lib/framework/crc.h"
+#include "lib/framework/physfs_ext.h"
 #include "lib/netplay/sync_debug.h"
 
 #include "lib/framework/wzapp.h"
@@ -53,27 +58,156 @@ struct PATHRESULT
 	MOVE_CONTROL	sMove;		///< New movement values for the droid.
 	FPATH_RETVAL	retval;		///< Result value from path-finding.
 	Vector2i        originalDest;   ///< Used to check if the pathfinding job is to the right destination.
+	Vector2i        originalOrig;   ///< Start of the route, for fpathRouteCache.
+	std::shared_ptr<const PathBlockingMap> blockingMap;  ///< Set if the route was searched for and found, so can be added to fpathRouteCache.
 };
 
+/** Key of fpathRouteCache.
+ *
+ *  Routes are only reused with the blocking map they were found with, so they stay valid until the map changes.
+ */
+struct PathRouteCacheKey
+{
+	bool operator ==(PathRouteCacheKey const &z) const
+	{
+		return blockingMap == z.blockingMap && startCluster == z.startCluster && goalCluster == z.goalCluster;
+	}
+
+	const PathBlockingMap *blockingMap;
+	Vector2i startCluster;
+	Vector2i goalCluster;
+};
+
+struct PathRouteCacheKeyHash
+{
+	size_t operator()(PathRouteCacheKey const &key) const
+	{
+		return std::hash<const PathBlockingMap *>()(key.blockingMap) ^ (key.startCluster.x * 7919 + key.startCluster.y * 104729 + key.goalCluster.x * 1299709 + key.goalCluster.y * 15485863);
+	}
+};
+
+struct PathRouteCacheEntry
+{
+	std::weak_ptr<const PathBlockingMap> blockingMap;  ///< If expired, another map may have the same address as the key.
+	std::shared_ptr<const std::vector<Vector2i>> route;
+};
+
+/// Routes found by earlier jobs, only accessed by the main thread, so that whether a job hits the cache is the same on all clients.
+static std::unordered_map<PathRouteCacheKey, PathRouteCacheEntry, PathRouteCacheKeyHash> fpathRouteCache;
+#define MAX_CACHED_ROUTES 256
+
+static uint64_t fpathRouteCacheHits = 0;
+static uint64_t fpathRouteCacheMisses = 0;
+static std::atomic<uint64_t> fpathRouteCacheSpliceFailures{0};  ///< Hits which could not be spliced, and were searched instead.
+// Cost of the jobs run by the path threads, to compare splicing cached routes with searching them.
+static std::atomic<uint64_t> fpathSplicedJobs{0};
+static std::atomic<uint64_t> fpathSplicedNodes{0};
+static std::atomic<uint64_t> fpathSplicedMicroseconds{0};
+static std::atomic<uint64_t> fpathSearchedJobs{0};
+static std::atomic<uint64_t> fpathSearchedNodes{0};
+static std::atomic<uint64_t> fpathSearchedMicroseconds{0};
+
+
+/// A job queued by fpathRoute while recording, with what fpathAStarRoute needs of it.
+struct RecordedPathJob
+{
+	uint32_t mapIndex;              ///< Index of the blocking map of the job in the recording.
+	uint32_t gameTime;
+	int32_t origX, origY, destX, destY;
+	int32_t dstX, dstY, dstWidth, dstHeight;
+};
+
+/// Header of the recordings written by fpathRecordJobs, in native byte order, followed by the maps and then the jobs.
+struct RecordedPathJobsHeader
+{
+	char magic[4];
+	uint32_t formatVersion;
+	uint32_t sizeOfJob;
+	int32_t mapWidth, mapHeight;
+	uint32_t mapCount, jobCount;
+};
+static const char recordedPathJobsMagic[4] = {'W', 'Z', 'P', 'J'};
+#define RECORDED_PATH_JOBS_FORMAT_VERSION 1
+
+/// Jobs queued by fpathRoute while recording, replayed by fpathBenchmark.
+struct PathJobRecording
+{
+	std::string fileName;           ///< Empty if not recording.
+	int mapWidth = 0;
+	int mapHeight = 0;
+	/// Blocking maps already in maps, by address. Only weak, so that recording doesn't keep the maps alive.
+	std::unordered_map<const PathBlockingMap *, std::pair<std::weak_ptr<const PathBlockingMap>, uint32_t>> mapIndices;
+	uint32_t mapCount = 0;
+	std::vector<uint8_t> maps;      ///< Each distinct blocking map, written once by fpathWriteBlockingMap.
+	std::vector<RecordedPathJob> jobs;
+};
+static PathJobRecording pathJobRecording;
+/// Recording stops when the maps and jobs take this much memory. Maps are only recorded when they change, so this is many ticks.
+#define MAX_PATH_JOB_RECORDING_BYTES (64 * 1024 * 1024)
+static void fpathRecordJob(PATHJOB const &job);
+static void fpathFinishRecording();
 
 // threading stuff
 using packagedPathJob = wz::packaged_task<PATHRESULT(const std::shared_ptr<FPathExecuteContext>& ctx)>;
 
+/** Jobs which may share a PathfindContext, see fpathJobDispatchThreadId.
+ *
+ *  The jobs of a cohort are run in the order they were queued, one at a time, using the cohort's own context,
+ *  so the results do not depend on which thread runs them. A cohort is in at most one thread's queue at a time,
+ *  and idle threads steal cohorts from the queues of other threads.
+ */
+struct PathCohort
+{
+	PathCohort() : mutex(wzMutexCreate()), ctx(makeFPathExecuteContext()) {}
+	~PathCohort()
+	{
+		wzMutexDestroy(mutex);
+	}
+
+	PathCohort(PathCohort const &) = delete;
+	PathCohort &operator =(PathCohort const &) = delete;
+
+	WZ_MUTEX *mutex;                                ///< Protects pathJobs and scheduled.
+	std::list<packagedPathJob> pathJobs;
+	bool scheduled = false;                         ///< In a thread's queue, or being run by a thread.
+	const std::shared_ptr<FPathExecuteContext> ctx; ///< Only used by the thread which is running the cohort.
+};
+
+/// Identifies a cohort. Jobs with the same key have the same blocking map and tileDest.
+struct PathCohortKey
+{
+	bool operator ==(PathCohortKey const &z) const
+	{
+		return domain == z.domain && owner == z.owner && moveType == z.moveType && tileDest == z.tileDest;
+	}
+
+	size_t domain;
+	int owner;
+	int moveType;
+	Vector2i tileDest;
+	size_t hash;                                    ///< Also picks the thread whose queue the cohort is added to.
+};
+
+struct PathCohortKeyHash
+{
+	size_t operator()(PathCohortKey const &key) const
+	{
+		return key.hash;
+	}
+};
+
 struct FpathThreadInfo
 {
 public:
 	FpathThreadInfo()
 	{
 		mutex = wzMutexCreate();
-		semaphore = wzSemaphoreCreate(0);
 	}
 
 	~FpathThreadInfo()
 	{
 		wzMutexDestroy(mutex);
 		mutex = nullptr;
-		wzSemaphoreDestroy(semaphore);
-		semaphore = nullptr;
 	}
 
 	FpathThreadInfo(FpathThreadInfo&&) = delete;
@@ -81,17 +215,23 @@ public:
 	FpathThreadInfo(const FpathThreadInfo&) = delete;
 	FpathThreadInfo& operator=(const FpathThreadInfo&) = delete;
 public:
-	WZ_SEMAPHORE *semaphore;
 	WZ_MUTEX *mutex;
-	std::list<packagedPathJob> pathJobs;
+	std::deque<std::shared_ptr<PathCohort>> cohorts;  ///< Cohorts with jobs, taken from the front by this thread and from the back by other threads.
+#ifdef DEBUG
+	std::atomic<size_t> numJobsThisTick{0};
+#endif
 };
 
 static std::vector<WZ_THREAD *> fpathThreads;
 static std::vector<std::unique_ptr<FpathThreadInfo>> fpathThreadsInfo;
+static WZ_SEMAPHORE *fpathSemaphore = nullptr;  ///< Counts the cohorts in the queues of all threads.
 static std::unordered_map<uint32_t, wz::future<PATHRESULT>> pathResults;
 
+/// Cohorts of the jobs queued in cohortsGameTime. Only accessed by the main thread.
+static std::unordered_map<PathCohortKey, std::shared_ptr<PathCohort>, PathCohortKeyHash> pathCohorts;
+static uint32_t pathCohortsGameTime = 0;
+
 #ifdef DEBUG
-static std::vector<size_t> numJobsPerThreadThisTick;
 static uint32_t currentFpathTick = 0;
 #endif
 
@@ -100,45 +240,80 @@ constexpr size_t MAX_FPATH_THREADS = 2;
 static PATHRESULT fpathExecute(const std::shared_ptr<FPathExecuteContext>& ctx, PATHJOB psJob);
 
 
+/// Takes a cohort from the queue of thread threadIndex, or steals one from another thread if that queue is empty.
+static std::shared_ptr<PathCohort> fpathTakeCohort(size_t threadIndex)
+{
+	std::shared_ptr<PathCohort> cohort;
+	// The caller waited on fpathSemaphore, so there is a cohort somewhere, but another thread may take the one we see first.
+	while (cohort == nullptr)
+	{
+		for (size_t i = 0; i < fpathThreadsInfo.size() && cohort == nullptr; ++i)
+		{
+			const bool steal = i != 0;
+			FpathThreadInfo &threadInfo = *fpathThreadsInfo[(threadIndex + i) % fpathThreadsInfo.size()];
+			wzMutexLock(threadInfo.mutex);
+			if (!threadInfo.cohorts.empty())
+			{
+				if (steal)
+				{
+					cohort = std::move(threadInfo.cohorts.back());
+					threadInfo.cohorts.pop_back();
+				}
+				else
+				{
+					cohort = std::move(threadInfo.cohorts.front());
+					threadInfo.cohorts.pop_front();
+				}
+			}
+			wzMutexUnlock(threadInfo.mutex);
+		}
+		if (cohort == nullptr)
+		{
+			wzYieldCurrentThread();
+		}
+	}
+	return cohort;
+}
+
 /** This runs in a separate thread */
 static int fpathThreadFunc(void *data)
 {
-	FpathThreadInfo* threadInfo = static_cast<FpathThreadInfo*>(data);
-	WZ_SEMAPHORE *fpathSemaphore = threadInfo->semaphore;
-	WZ_MUTEX *fpathMutex = threadInfo->mutex;
-	std::list<packagedPathJob>& pathJobs = threadInfo->pathJobs;
-
-	// create an fpath astar job context
-	auto ctx = makeFPathExecuteContext();
+	const size_t threadIndex = reinterpret_cast<size_t>(data);
 
 	while (true)
 	{
 		wzSemaphoreWait(fpathSemaphore);  // Wait until needed.
-		wzMutexLock(fpathMutex);
 
 		if (fpathQuit)
 		{
-			wzMutexUnlock(fpathMutex);
 			break;
 		}
 
-		if (pathJobs.empty())
-		{
-			// should not happen - semaphore was signaled!
-			ASSERT(!pathJobs.empty(), "Received a signal but no job to consume!");
-			wzMutexUnlock(fpathMutex);
-			continue;
+		std::shared_ptr<PathCohort> cohort = fpathTakeCohort(threadIndex);
 
-		}
+		// Run the jobs of the cohort in order, until there are none left.
+		while (true)
+		{
+			wzMutexLock(cohort->mutex);
+			if (cohort->pathJobs.empty())
+			{
+				cohort->scheduled = false;  // The next job queued for this cohort will queue it again.
+				wzMutexUnlock(cohort->mutex);
+				break;
+			}
 
-		WZ_PROFILE_SCOPE(fpathJob);
-		// Copy the first job from the queue.
-		packagedPathJob job = std::move(pathJobs.front());
-		pathJobs.pop_front();
+			WZ_PROFILE_SCOPE(fpathJob);
+			// Copy the first job from the queue.
+			packagedPathJob job = std::move(cohort->pathJobs.front());
+			cohort->pathJobs.pop_front();
 
-		wzMutexUnlock(fpathMutex);
+			wzMutexUnlock(cohort->mutex);
 
-		job(ctx);
+			job(cohort->ctx);
+#ifdef DEBUG
+			++fpathThreadsInfo[threadIndex]->numJobsThisTick;
+#endif
+		}
 	}
 	return 0;
 }
@@ -166,13 +341,14 @@ bool fpathInitialise()
 		debug(LOG_INFO, "Using threads: %zu", numThreads);
 		fpathThreads.resize(numThreads, nullptr);
 		fpathThreadsInfo.resize(numThreads);
-#ifdef DEBUG
-		numJobsPerThreadThisTick.resize(numThreads);
-#endif
+		fpathSemaphore = wzSemaphoreCreate(0);
 		for (size_t i = 0; i < fpathThreads.size(); ++i)
 		{
 			fpathThreadsInfo[i] = std::make_unique<FpathThreadInfo>();
-			fpathThreads[i] = wzThreadCreate(fpathThreadFunc, fpathThreadsInfo[i].get(), "wzPath");
+		}
+		for (size_t i = 0; i < fpathThreads.size(); ++i)
+		{
+			fpathThreads[i] = wzThreadCreate(fpathThreadFunc, reinterpret_cast<void *>(i), "wzPath");
 			wzThreadStart(fpathThreads[i]);
 		}
 	}
@@ -187,9 +363,9 @@ void fpathShutdown()
 	{
 		// Signal the path finding thread(s) to quit
 		fpathQuit = true;
-		for (size_t i = 0; i < fpathThreadsInfo.size(); ++i)
+		for (size_t i = 0; i < fpathThreads.size(); ++i)
 		{
-			wzSemaphorePost(fpathThreadsInfo[i]->semaphore);  // Wake up a thread
+			wzSemaphorePost(fpathSemaphore);  // Wake up a thread
 		}
 		for (size_t i = 0; i < fpathThreads.size(); ++i)
 		{
@@ -197,13 +373,17 @@ void fpathShutdown()
 		}
 		fpathThreads.clear();
 		fpathThreadsInfo.clear();
+		wzSemaphoreDestroy(fpathSemaphore);
+		fpathSemaphore = nullptr;
+		pathCohorts.clear();
+		fpathRouteCache.clear();
 
 #ifdef DEBUG
-		numJobsPerThreadThisTick.clear();
 		currentFpathTick = 0;
 #endif
 	}
 	fpathHardTableReset();
+	fpathFinishRecording();
 }
 
 
@@ -241,34 +421,37 @@ inline void hash_combine(std::size_t& seed, const T& v, Rest... rest) {
 	hash_combine(seed, rest...);
 }
 
-static inline size_t fpathJobDispatchThreadId(const PATHJOB& job, size_t numThreads)
+static PathCohortKey fpathJobCohortKey(const PATHJOB& job)
 {
-	if (numThreads == 1) { return 0; }
-
-	// Every job that matches a PathfindContext must be processed by the same thread, as the result of fpathAStarRoute is dependent upon jobs
-	// within each matching "cohort" having access to the same PathfindContext (and PathfindContexts are not shared between threads).
+	// Every job that matches a PathfindContext must be processed in the same cohort, as the result of fpathAStarRoute is dependent upon jobs
+	// within each matching "cohort" having access to the same PathfindContext, in the same order.
 	//
 	// (In other words, the results may slightly differ depending on whether an existing PathfindContext is reused versus starting from scratch.)
 
-	std::size_t h = 0;
-	auto domain = fpathPropulsionDomain(job.propulsion);
-	const Vector2i tileDest(map_coord(job.destX), map_coord(job.destY));
+	PathCohortKey key;
+	key.domain = fpathPropulsionDomain(job.propulsion);
+	key.tileDest = Vector2i(map_coord(job.destX), map_coord(job.destY));
+	key.hash = 0;
 
 	// Note: We use part of the behavior of PathfindContext::matches() (which is called by fpathAStarRoute)
 	// Specifically, we match using the same logic as fpathIsEquivalentBlocking, plus tileDest
-	if (domain == fpathPropulsionDomain(PROPULSION_TYPE_LIFT))
+	if (key.domain == fpathPropulsionDomain(PROPULSION_TYPE_LIFT))
 	{
 		// Air units ignore move type and player (see: fpathIsEquivalentBlocking)
 		// So just use the domain + tileDest
-		hash_combine(h, domain, tileDest.x, tileDest.y);
+		key.owner = 0;
+		key.moveType = 0;
+		hash_combine(key.hash, key.domain, key.tileDest.x, key.tileDest.y);
 	}
 	else
 	{
 		// All other unit types care about domain + player + moveType (see: fpathIsEquivalentBlocking)
 		// So use those + tileDest
-		hash_combine(h, domain, job.owner, job.moveType, tileDest.x, tileDest.y);
+		key.owner = job.owner;
+		key.moveType = job.moveType;
+		hash_combine(key.hash, key.domain, job.owner, job.moveType, key.tileDest.x, key.tileDest.y);
 	}
-	return h % numThreads;
+	return key;
 }
 
 bool fpathIsEquivalentBlocking(PROPULSION_TYPE propulsion1, int player1, FPATH_MOVETYPE moveType1,
@@ -416,6 +599,80 @@ void fpathRemoveDroidData(int id)
 	pathResults.erase(id);
 }
 
+/// Returns whether routes for job may be cached, and sets key if so.
+static bool fpathRouteCacheKey(PathRouteCacheKey &key, const std::shared_ptr<const PathBlockingMap> &blockingMap, Vector2i orig, Vector2i dest, StructureBounds const &dstStructure)
+{
+	if (dstStructure.size.x > 0 && dstStructure.size.y > 0)
+	{
+		return false;  // Routes into structures end outside of any region.
+	}
+	key.blockingMap = blockingMap.get();
+	key.startCluster = map_coord(orig) / PATH_CLUSTER_SIZE;
+	key.goalCluster = map_coord(dest) / PATH_CLUSTER_SIZE;
+	return key.startCluster != key.goalCluster;  // Short routes are not worth caching.
+}
+
+/// Sets job.cachedRoute, if a route between the same clusters was found with the same blocking map.
+static void fpathRouteCacheLookup(PATHJOB &job)
+{
+	PathRouteCacheKey key;
+	if (!fpathRouteCacheKey(key, job.blockingMap, Vector2i(job.origX, job.origY), Vector2i(job.destX, job.destY), job.dstStructure))
+	{
+		return;
+	}
+	auto i = fpathRouteCache.find(key);
+	if (i == fpathRouteCache.end())
+	{
+		++fpathRouteCacheMisses;
+		return;
+	}
+	if (i->second.blockingMap.lock() != job.blockingMap)
+	{
+		// The map the route was found with no longer exists, and job.blockingMap happens to have the same address.
+		fpathRouteCache.erase(i);
+		++fpathRouteCacheMisses;
+		return;
+	}
+	job.cachedRoute = i->second.route;
+	++fpathRouteCacheHits;
+}
+
+static void fpathRouteCacheInsert(PATHRESULT const &result)
+{
+	PathRouteCacheKey key;
+	if (!fpathRouteCacheKey(key, result.blockingMap, result.originalOrig, result.originalDest, StructureBounds()))
+	{
+		return;
+	}
+	if (fpathRouteCache.size() >= MAX_CACHED_ROUTES && fpathRouteCache.count(key) == 0)
+	{
+		fpathRouteCache.clear();  // Most entries are probably for old blocking maps by now.
+	}
+	PathRouteCacheEntry &entry = fpathRouteCache[key];
+	entry.blockingMap = result.blockingMap;
+	entry.route = std::make_shared<const std::vector<Vector2i>>(result.sMove.asPath);
+}
+
+std::string fpathRouteCacheStats()
+{
+	const uint64_t lookups = fpathRouteCacheHits + fpathRouteCacheMisses;
+	const uint64_t spliced = fpathSplicedJobs.load(), searched = fpathSearchedJobs.load();
+	return astringf("Path route cache: %" PRIu64 " hits, %" PRIu64 " misses (%.1f%% hits), %" PRIu64 " hits not spliced, %zu routes cached; "
+	                "splice: %.0f nodes, %.1f us per job; search: %.0f nodes, %.1f us per job",
+	                fpathRouteCacheHits, fpathRouteCacheMisses, lookups ? 100. * fpathRouteCacheHits / lookups : 0., fpathRouteCacheSpliceFailures.load(), fpathRouteCache.size(),
+	                spliced ? double(fpathSplicedNodes.load()) / spliced : 0., spliced ? double(fpathSplicedMicroseconds.load()) / spliced : 0.,
+	                searched ? double(fpathSearchedNodes.load()) / searched : 0., searched ? double(fpathSearchedMicroseconds.load()) / searched : 0.);
+}
+
+/// Adds the nodes expanded and the time spent since nodesBefore and start to the counters.
+static void fpathCountJobCost(const std::shared_ptr<FPathExecuteContext>& ctx, uint64_t nodesBefore, std::chrono::steady_clock::time_point start,
+                              std::atomic<uint64_t> &jobs, std::atomic<uint64_t> &nodes, std::atomic<uint64_t> &microseconds)
+{
+	++jobs;
+	nodes += fpathAStarNodesExpanded(ctx) - nodesBefore;
+	microseconds += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
 static FPATH_RETVAL fpathRoute(MOVE_CONTROL *psMove, unsigned id, int startX, int startY, int tX, int tY, PROPULSION_TYPE propulsionType,
                                DROID_TYPE droidType, FPATH_MOVETYPE moveType, int owner, bool acceptNearest, StructureBounds const &dstStructure)
 {
@@ -428,16 +685,16 @@ static FPATH_RETVAL fpathRoute(MOVE_CONTROL *psMove, unsigned id, int startX, in
 		{
 			static std::string tmpDgbStr;
 			tmpDgbStr = "Last tick fpath jobs per thread:";
-			for (const auto& c : numJobsPerThreadThisTick)
+			for (const auto& threadInfo : fpathThreadsInfo)
 			{
-				tmpDgbStr += " " + std::to_string(c) + ",";
+				tmpDgbStr += " " + std::to_string(threadInfo->numJobsThisTick.load()) + ",";
 			}
 			debug(LOG_MOVEMENT, "%s", tmpDgbStr.c_str());
 		}
 		currentFpathTick = gameTime;
-		for (auto& c : numJobsPerThreadThisTick)
+		for (auto& threadInfo : fpathThreadsInfo)
 		{
-			c = 0;
+			threadInfo->numJobsThisTick = 0;
 		}
 	}
 #endif
@@ -477,6 +734,10 @@ static FPATH_RETVAL fpathRoute(MOVE_CONTROL *psMove, unsigned id, int startX, in
 		psMove->asPath = result.sMove.asPath;
 		FPATH_RETVAL retval = result.retval;
 		ASSERT(retval != FPR_OK || psMove->asPath.size() > 0, "Ok result but no path after copy");
+		if (result.blockingMap != nullptr)
+		{
+			fpathRouteCacheInsert(result);
+		}
 
 		// Remove it from the result list
 		pathResults.erase(id);
@@ -505,9 +766,16 @@ queuePathfinding:
 	job.propulsion = propulsionType;
 	job.moveType = moveType;
 	job.owner = owner;
+	job.gameTime = gameTime;
 	job.acceptNearest = acceptNearest;
 	job.deleted = false;
 	fpathSetBlockingMap(&job);
+	fpathRouteCacheLookup(job);
+
+	if (!pathJobRecording.fileName.empty())
+	{
+		fpathRecordJob(job);
+	}
 
 	debug(LOG_NEVER, "starting new job for droid %d 0x%x", id, id);
 	// Clear any results or jobs waiting already. It is a vital assumption that there is only one
@@ -517,21 +785,37 @@ queuePathfinding:
 	packagedPathJob task([job](const std::shared_ptr<FPathExecuteContext>& ctx) { return fpathExecute(ctx, job); });
 	pathResults[id] = task.get_future();
 
-	// Get target thread for job
-	auto targetThreadId = fpathJobDispatchThreadId(job, fpathThreads.size());
-	auto& threadInfo = *fpathThreadsInfo[targetThreadId];
+	// Contexts are only reused within a tick, so start new cohorts each tick.
+	if (pathCohortsGameTime != gameTime)
+	{
+		pathCohorts.clear();
+		pathCohortsGameTime = gameTime;
+	}
+	const PathCohortKey key = fpathJobCohortKey(job);
+	std::shared_ptr<PathCohort> &cohort = pathCohorts[key];
+	if (cohort == nullptr)
+	{
+		cohort = std::make_shared<PathCohort>();
+	}
 
-	// Add to end of appropriate list
-	wzMutexLock(threadInfo.mutex);
-	bool isFirstJob = threadInfo.pathJobs.empty();
-	threadInfo.pathJobs.push_back(std::move(task));
-	wzMutexUnlock(threadInfo.mutex);
+	// Add to end of the cohort's jobs
+	wzMutexLock(cohort->mutex);
+	bool isFirstJob = cohort->pathJobs.empty();
+	cohort->pathJobs.push_back(std::move(task));
+	bool mustSchedule = !cohort->scheduled;
+	cohort->scheduled = true;
+	wzMutexUnlock(cohort->mutex);
 
-	wzSemaphorePost(threadInfo.semaphore);  // Increment semaphore
+	if (mustSchedule)
+	{
+		// Add the cohort to the queue of a thread, other threads may steal it if idle.
+		auto& threadInfo = *fpathThreadsInfo[key.hash % fpathThreadsInfo.size()];
+		wzMutexLock(threadInfo.mutex);
+		threadInfo.cohorts.push_back(cohort);
+		wzMutexUnlock(threadInfo.mutex);
 
-#ifdef DEBUG
-	numJobsPerThreadThisTick[targetThreadId]++;
-#endif
+		wzSemaphorePost(fpathSemaphore);  // Increment semaphore
+	}
 
 	objTrace(id, "Queued up a path-finding request to (%d, %d), at least %d items earlier in queue", tX, tY, isFirstJob);
 	syncDebug("fpathRoute(..., %d, %d, %d, %d, %d, %d, %d, %d, %d) = FPR_WAIT", id, startX, startY, tX, tY, propulsionType, droidType, moveType, owner);
@@ -591,8 +875,32 @@ PATHRESULT fpathExecute(const std::shared_ptr<FPathExecuteContext>& ctx, PATHJOB
 	result.droidID = job.droidID;
 	result.retval = FPR_FAILED;
 	result.originalDest = Vector2i(job.destX, job.destY);
+	result.originalOrig = Vector2i(job.origX, job.origY);
 
-	ASR_RETVAL retval = fpathAStarRoute(ctx, &result.sMove, &job);
+	ASR_RETVAL retval = ASR_FAILED;
+	if (job.cachedRoute != nullptr)
+	{
+		const uint64_t nodesBefore = fpathAStarNodesExpanded(ctx);
+		const auto start = std::chrono::steady_clock::now();
+		retval = fpathAStarSpliceRoute(ctx, &result.sMove, &job, *job.cachedRoute);
+		fpathCountJobCost(ctx, nodesBefore, start, fpathSplicedJobs, fpathSplicedNodes, fpathSplicedMicroseconds);
+		if (retval != ASR_OK)
+		{
+			++fpathRouteCacheSpliceFailures;
+		}
+	}
+	if (retval != ASR_OK)
+	{
+		const uint64_t nodesBefore = fpathAStarNodesExpanded(ctx);
+		const auto start = std::chrono::steady_clock::now();
+		retval = fpathAStarRoute(ctx, &result.sMove, &job);
+		fpathCountJobCost(ctx, nodesBefore, start, fpathSearchedJobs, fpathSearchedNodes, fpathSearchedMicroseconds);
+		PathRouteCacheKey key;
+		if (retval == ASR_OK && fpathRouteCacheKey(key, job.blockingMap, result.originalOrig, result.originalDest, job.dstStructure))
+		{
+			result.blockingMap = job.blockingMap;  // Only cache searched routes, so splices don't accumulate detours.
+		}
+	}
 
 	ASSERT(retval != ASR_OK || result.sMove.asPath.size() > 0, "Ok result but no path in result");
 	switch (retval)
@@ -631,16 +939,180 @@ PATHRESULT fpathExecute(const std::shared_ptr<FPathExecuteContext>& ctx, PATHJOB
 	return result;
 }
 
-/** Find the length of the job queue. Function is thread-safe. */
+void fpathRecordJobs(const std::string &fileName)
+{
+	pathJobRecording = PathJobRecording();
+	pathJobRecording.fileName = fileName;
+}
+
+static void fpathRecordJob(PATHJOB const &job)
+{
+	PathJobRecording &recording = pathJobRecording;
+	if (recording.jobs.empty())
+	{
+		recording.mapWidth = mapWidth;
+		recording.mapHeight = mapHeight;
+	}
+	else if (recording.mapWidth != mapWidth || recording.mapHeight != mapHeight)
+	{
+		fpathFinishRecording();  // Another map was loaded.
+		return;
+	}
+
+	auto &mapIndex = recording.mapIndices[job.blockingMap.get()];
+	if (mapIndex.first.expired())  // New map, or another map at the address of one which was freed.
+	{
+		mapIndex = std::make_pair(std::weak_ptr<const PathBlockingMap>(job.blockingMap), recording.mapCount++);
+		fpathWriteBlockingMap(*job.blockingMap, recording.maps);
+	}
+
+	RecordedPathJob recordedJob;
+	recordedJob.mapIndex = mapIndex.second;
+	recordedJob.gameTime = job.gameTime;
+	recordedJob.origX = job.origX;
+	recordedJob.origY = job.origY;
+	recordedJob.destX = job.destX;
+	recordedJob.destY = job.destY;
+	recordedJob.dstX = job.dstStructure.map.x;
+	recordedJob.dstY = job.dstStructure.map.y;
+	recordedJob.dstWidth = job.dstStructure.size.x;
+	recordedJob.dstHeight = job.dstStructure.size.y;
+	recording.jobs.push_back(recordedJob);
+
+	if (recording.maps.size() + recording.jobs.size() * sizeof(RecordedPathJob) >= MAX_PATH_JOB_RECORDING_BYTES)
+	{
+		debug(LOG_INFO, "Path job recording is full");
+		fpathFinishRecording();
+	}
+}
+
+static void fpathFinishRecording()
+{
+	PathJobRecording &recording = pathJobRecording;
+	if (recording.fileName.empty() || recording.jobs.empty())
+	{
+		return;
+	}
+
+	RecordedPathJobsHeader header;
+	memcpy(header.magic, recordedPathJobsMagic, sizeof(header.magic));
+	header.formatVersion = RECORDED_PATH_JOBS_FORMAT_VERSION;
+	header.sizeOfJob = sizeof(RecordedPathJob);
+	header.mapWidth = recording.mapWidth;
+	header.mapHeight = recording.mapHeight;
+	header.mapCount = recording.mapCount;
+	header.jobCount = static_cast<uint32_t>(recording.jobs.size());
+
+	PHYSFS_file *fileHandle = PHYSFS_openWrite(recording.fileName.c_str());
+	if (fileHandle == nullptr)
+	{
+		debug(LOG_ERROR, "Could not open %s for writing: %s", recording.fileName.c_str(), WZ_PHYSFS_getLastError());
+	}
+	else
+	{
+		const bool ok = WZ_PHYSFS_writeBytes(fileHandle, &header, sizeof(header)) == sizeof(header)
+			&& WZ_PHYSFS_writeBytes(fileHandle, recording.maps.data(), static_cast<PHYSFS_uint32>(recording.maps.size())) == static_cast<PHYSFS_sint64>(recording.maps.size())
+			&& WZ_PHYSFS_writeBytes(fileHandle, recording.jobs.data(), static_cast<PHYSFS_uint32>(recording.jobs.size() * sizeof(RecordedPathJob))) == static_cast<PHYSFS_sint64>(recording.jobs.size() * sizeof(RecordedPathJob));
+		PHYSFS_close(fileHandle);
+		if (ok)
+		{
+			debug(LOG_INFO, "Recorded %zu path jobs with %" PRIu32 " blocking maps to %s%s%s", recording.jobs.size(), recording.mapCount,
+			      PHYSFS_getWriteDir(), PHYSFS_getDirSeparator(), recording.fileName.c_str());
+		}
+		else
+		{
+			debug(LOG_ERROR, "Could not write %s: %s", recording.fileName.c_str(), WZ_PHYSFS_getLastError());
+		}
+	}
+	pathJobRecording = PathJobRecording();  // Only record one game.
+}
+
+bool fpathBenchmark(const uint8_t *pData, size_t size, std::string &summary)
+{
+	const uint8_t *pEnd = pData + size;
+	RecordedPathJobsHeader header;
+	if (size < sizeof(header))
+	{
+		summary = "Not a path job recording.";
+		return false;
+	}
+	memcpy(&header, pData, sizeof(header));
+	pData += sizeof(header);
+	if (memcmp(header.magic, recordedPathJobsMagic, sizeof(header.magic)) != 0 || header.formatVersion != RECORDED_PATH_JOBS_FORMAT_VERSION
+		|| header.sizeOfJob != sizeof(RecordedPathJob) || header.mapWidth <= 0 || header.mapHeight <= 0
+		|| header.mapWidth > MAP_MAXWIDTH || header.mapHeight > MAP_MAXHEIGHT)
+	{
+		summary = "Not a path job recording, or recorded by another build.";
+		return false;
+	}
+
+	std::vector<std::shared_ptr<const PathBlockingMap>> blockingMaps;
+	for (uint32_t i = 0; i < header.mapCount; ++i)
+	{
+		blockingMaps.push_back(fpathReadBlockingMap(pData, pEnd, header.mapWidth, header.mapHeight));
+		if (blockingMaps.back() == nullptr)
+		{
+			summary = "Path job recording is truncated.";
+			return false;
+		}
+	}
+	if (static_cast<size_t>(pEnd - pData) != header.jobCount * sizeof(RecordedPathJob))
+	{
+		summary = "Path job recording is truncated.";
+		return false;
+	}
+	std::vector<PATHJOB> jobs(header.jobCount);
+	for (PATHJOB &job : jobs)
+	{
+		RecordedPathJob recordedJob;
+		memcpy(&recordedJob, pData, sizeof(recordedJob));
+		pData += sizeof(recordedJob);
+		if (recordedJob.mapIndex >= blockingMaps.size())
+		{
+			summary = "Path job recording is corrupt.";
+			return false;
+		}
+		job.blockingMap = blockingMaps[recordedJob.mapIndex];
+		job.gameTime = recordedJob.gameTime;
+		job.origX = recordedJob.origX;
+		job.origY = recordedJob.origY;
+		job.destX = recordedJob.destX;
+		job.destY = recordedJob.destY;
+		job.dstStructure = StructureBounds(Vector2i(recordedJob.dstX, recordedJob.dstY), Vector2i(recordedJob.dstWidth, recordedJob.dstHeight));
+	}
+
+	// No game is loaded, and A* only needs the size of the map besides the blocking maps.
+	mapWidth = header.mapWidth;
+	mapHeight = header.mapHeight;
+
+	// Replay in the order the jobs were queued, with one context, so the searches are the same each time.
+	auto ctx = makeFPathExecuteContext();
+	MOVE_CONTROL sMove;
+	unsigned results[3] = {0, 0, 0};
+	const auto start = std::chrono::steady_clock::now();
+	for (PATHJOB &job : jobs)
+	{
+		sMove.asPath.clear();
+		++results[fpathAStarRoute(ctx, &sMove, &job)];
+	}
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	const uint64_t nodes = fpathAStarNodesExpanded(ctx);
+
+	summary = astringf("Replayed %zu path jobs on %zu blocking maps (%u ok, %u nearest, %u failed) in %.1f ms: %" PRIu64 " nodes expanded, %.0f nodes/s",
+	                   jobs.size(), blockingMaps.size(), results[ASR_OK], results[ASR_NEAREST], results[ASR_FAILED], seconds * 1000, nodes, seconds > 0 ? nodes / seconds : 0.);
+	return true;
+}
+
+/** Find the length of the job queue, excepting jobs being run. Function must be called from the main thread. */
 static size_t fpathJobQueueLength()
 {
 	size_t count = 0;
 
-	for (const auto& threadInfo : fpathThreadsInfo)
+	for (const auto& cohort : pathCohorts)
 	{
-		wzMutexLock(threadInfo->mutex);
-		count += threadInfo->pathJobs.size(); // O(N) function call for std::list. .empty() is faster, but this function isn't used except in tests.
-		wzMutexUnlock(threadInfo->mutex);
+		wzMutexLock(cohort.second->mutex);
+		count += cohort.second->pathJobs.size(); // O(N) function call for std::list. .empty() is faster, but this function isn't used except in tests.
+		wzMutexUnlock(cohort.second->mutex);
 	}
 	return count;
 }
@@ -676,8 +1148,8 @@ void fpathTest(int x, int y, int x2, int y2)
 	for (const auto& threadInfo : fpathThreadsInfo)
 	{
 		ASSERT(threadInfo->mutex != nullptr, "Failed to initialize mutex?");
-		ASSERT(threadInfo->semaphore != nullptr, "Failed to initialize semaphore?");
 	}
+	ASSERT(fpathSemaphore != nullptr, "Failed to initialize semaphore?");
 	assert(fpathJobQueueLength() == 0);
 	assert(pathResults.empty());
 	fpathRemoveDroidData(0);	// should not crash
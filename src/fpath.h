@@ -54,7 +54,9 @@ struct PATHJOB
 	UDWORD		droidID;
 	FPATH_MOVETYPE	moveType;
 	int		owner;		///< Player owner
+	uint32_t	gameTime;	///< Game time when the job was queued.
 	std::shared_ptr<const PathBlockingMap> blockingMap;   ///< Map of blocking tiles.
+	std::shared_ptr<const std::vector<Vector2i>> cachedRoute;  ///< Route found with blockingMap between the same clusters, to splice instead of searching, or null.
 	bool		acceptNearest;
 	bool            deleted;        ///< Droid was deleted, so throw away result when complete. Must still process this PATHJOB, since processing order can affect resulting paths (but can't affect the path length).
 };
@@ -124,6 +126,18 @@ bool fpathCheck(Position orig, Position dest, PROPULSION_TYPE propulsion);
 /** Unit testing. */
 void fpathTest(int x, int y, int x2, int y2);
 
+/** Returns the hit and miss counters of the cache of routes, which are reused by droids going between the same clusters. */
+std::string fpathRouteCacheStats();
+
+/** Record the path jobs queued by droids in the next game, with the blocking maps they were queued with, to fileName in
+ *  the config dir. Each distinct blocking map is stored once. The recording is written when the game ends, or when it
+ *  reaches its memory limit. */
+void fpathRecordJobs(const std::string &fileName);
+
+/** Benchmark A* by replaying a recording written by fpathRecordJobs on the calling thread. Only for use when no game
+ *  is loaded, since it sets the map size. Sets summary to the number of nodes expanded per second, or to the error. */
+bool fpathBenchmark(const uint8_t *pData, size_t size, std::string &summary);
+
 /** @} */
 
 #endif // __INCLUDED_SRC_FPATH_H__
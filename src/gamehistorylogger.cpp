@@ -447,6 +447,11 @@ void GameStoryLogger::logGameOver()
 	}
 }
 
+bool GameStoryLogger::hasLoggedGameOver() const
+{
+	return gameEndRealTime != std::chrono::system_clock::time_point();
+}
+
 void GameStoryLogger::setOutputKey(OutputKey key)
 {
 	outputKey = key;
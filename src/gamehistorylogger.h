@@ -133,6 +133,7 @@ public:
 	const std::vector<FixedPlayerAttributes>& getFixedPlayerAttributes();
 	const std::vector<GameFrame>& getGameFrames();
 	const std::vector<ResearchEvent>& getResearchLog();
+	bool hasLoggedGameOver() const;
 
 	// configuring output
 	void setFrameLoggingInterval(uint32_t seconds);
@@ -150,7 +150,7 @@ void DROID_GROUP::remove(DROID *psDroid)
 		// update group list of droids
 		if (psDroid->droidType != DROID_COMMAND || type != GT_COMMAND)
 		{
-			auto it = std::find(psList.begin(), psList.end(), psDroid);
+			auto it = psList.find(psDroid);
 			if (it != psList.end())
 			{
 				psList.erase(it);
@@ -72,6 +72,7 @@
 #include "loadsave.h"
 #include "loop.h"
 #include "mapgrid.h"
+#include "mapindexcache.h"
 #include "mechanics.h"
 #include "miscimd.h"
 #include "mission.h"
@@ -1002,8 +1003,23 @@ bool buildMapList(bool campaignOnly)
 	}
 	MapFileList realFileNames = listMapFiles();
 	auto debugLoggerInstance = std::make_shared<WzMapLoadDebugLogger>();
+	size_t numParsed = 0;
+	mapIndexCacheBeginRefresh();
 	for (auto &realFileName : realFileNames)
 	{
+		// Unchanged archives don't need to be opened at all - any problem with them shows up when the map actually gets loaded
+		auto cachedEntry = mapIndexCacheFind(realFileName.platformIndependent);
+		if (cachedEntry.has_value())
+		{
+			if (!levAddWzMap(cachedEntry->levelDetails, mod_multiplay, realFileName.platformIndependent.c_str()))
+			{
+				debug(LOG_ERROR, "Corrupt / invalid map file: %s", realFileName.platformIndependent.c_str());
+				continue;
+			}
+			WZ_Maps.insert(WZMapInfo_Map::value_type(realFileName.platformIndependent, WZmapInfo(cachedEntry->isMapMod, cachedEntry->isRandom)));
+			continue;
+		}
+
 		const char * pRealDirStr = PHYSFS_getRealDir(realFileName.platformIndependent.c_str());
 		if (!pRealDirStr)
 		{
@@ -1042,7 +1058,16 @@ bool buildMapList(bool campaignOnly)
 
 		auto WZmapInfoResult = CheckInMap(*mapPackage);
 		WZ_Maps.insert(WZMapInfo_Map::value_type(realFileName.platformIndependent, WZmapInfoResult));
+
+		MapIndexCacheEntry newEntry;
+		newEntry.levelDetails = mapPackage->levelDetails();
+		newEntry.isMapMod = WZmapInfoResult.isMapMod;
+		newEntry.isRandom = WZmapInfoResult.isRandom;
+		mapIndexCacheStore(realFileName.platformIndependent, newEntry);
+		++numParsed;
 	}
+	mapIndexCacheEndRefresh();
+	debug(LOG_WZ, "Listed %zu map archives, parsed %zu", realFileNames.size(), numParsed);
 
 	return true;
 }
@@ -1443,6 +1468,8 @@ bool stageOneShutDown()
 
 	gridShutDown();
 
+	visShutdown();
+
 	debug(LOG_TEXTURE, "== stageOneShutDown ==");
 	modelShutdown();
 	pie_TexShutDown();
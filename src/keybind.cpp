@@ -48,6 +48,7 @@
 #include "component.h"
 #include "radar.h"
 #include "structure.h"
+#include "fpath.h"
 // FIXME Direct iVis implementation include!
 #include "lib/ivis_opengl/screen.h"
 
@@ -717,6 +718,9 @@ void	kf_FrameRate()
 		                          NETgetStatistic(NetStatisticUncompressedBytes, false),
 		                          NETgetStatistic(NetStatisticPackets, true),
 		                          NETgetStatistic(NetStatisticPackets, false));
+		CONPRINTF("NETWORK:  Message buffers: %zu  Copied Bytes: %zu",
+		                          NETgetBufferStatistic(NetBufferStatisticAllocations),
+		                          NETgetBufferStatistic(NetBufferStatisticCopiedBytes));
 	}
 	gameStats = !gameStats;
 	CONPRINTF("Built: %s %s", getCompileDate(), __TIME__);
@@ -743,6 +747,14 @@ void kf_ShowNumObjects()
 }
 
 
+// --------------------------------------------------------------------------
+/// Show how often droids reused the routes of other droids.
+void kf_PathCacheStats()
+{
+	std::string cmsg = fpathRouteCacheStats();
+	addConsoleMessage(cmsg.c_str(), LEFT_JUSTIFY, SYSTEM_MESSAGE);
+}
+
 void kf_ListDroids()
 {
 	// Bail out if we're running a _true_ multiplayer game (to prevent MP cheating)
@@ -39,6 +39,7 @@
 #include "objects.h"
 #include "hci.h"
 #include "levels.h"
+#include "mapindexcache.h"
 #include "mission.h"
 #include "levelint.h"
 #include "game.h"
@@ -246,8 +247,15 @@ Sha256 levGetFileHash(LEVEL_DATASET *level)
 {
 	if (level->realFileName != nullptr && level->realFileHash.isZero())
 	{
+		auto cachedHash = mapIndexCacheFindHash(level->realFileName);
+		if (cachedHash.has_value())
+		{
+			level->realFileHash = cachedHash.value();
+			return level->realFileHash;
+		}
 		level->realFileHash = findHashOfFile(level->realFileName);
 		debug(LOG_WZ, "Hash of file \"%s\" is %s.", level->realFileName, level->realFileHash.toString().c_str());
+		mapIndexCacheStoreHash(level->realFileName, level->realFileHash);
 	}
 	return level->realFileHash;
 }
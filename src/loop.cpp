@@ -95,6 +95,8 @@
 #include "objmem.h"
 #endif
 
+#include <chrono>
+#include <limits>
 #include <numeric>
 
 
@@ -130,6 +132,11 @@ static PAUSE_STATE pauseState;
 static VIDEO_TIME_SKIP_STATE videoTimeSkipState;
 static size_t maxFastForwardTicks = WZ_DEFAULT_MAX_FASTFORWARD_TICKS;
 static bool fastForwardTicksFixedToNormalTickRate = true; // can be set to false to "catch-up" as quickly as possible (but this may result in more jerky behavior)
+static bool replaySimulation = false; // headless replay, simulated as fast as possible
+static bool replaySimulationReported = false;
+static std::chrono::steady_clock::time_point replaySimulationStartTime;
+static uint32_t replaySimulationStartGameTime = 0;
+static const std::chrono::milliseconds replaySimulationMaxTicksDuration(250); // per call of gameLoop, so events still get processed
 static std::chrono::milliseconds sequenceMinSkipTime = std::chrono::milliseconds(800);
 
 static unsigned numDroids[MAX_PLAYERS];
@@ -162,7 +169,10 @@ static GAMECODE renderLoop()
 
 	bool skipDrawing = !gfx_api::context::get().shouldDraw();
 
-	audio_Update();
+	if (!replaySimulation)
+	{
+		audio_Update();
+	}
 
 	wzShowMouse(true);
 
@@ -170,10 +180,13 @@ static GAMECODE renderLoop()
 	if (!paused)
 	{
 		/* Always refresh the widgets' backing stores if needed, even if we don't process clicks below */
-		intDoScreenRefresh();
+		if (!replaySimulation)
+		{
+			intDoScreenRefresh();
+		}
 
 		/* Run the in game interface and see if it grabbed any mouse clicks */
-		if (!getRotActive() && getWidgetsStatus() && dragBox3D.status != DRAG_DRAGGING && wallDrag.status != DRAG_DRAGGING)
+		if (!replaySimulation && !getRotActive() && getWidgetsStatus() && dragBox3D.status != DRAG_DRAGGING && wallDrag.status != DRAG_DRAGGING)
 		{
 			intRetVal = intRunWidgets();
 			screen_FlipIfBackDropTransition();
@@ -208,7 +221,7 @@ static GAMECODE renderLoop()
 				multiPlayerLoop();
 			}
 
-			for (unsigned i = 0; i < MAX_PLAYERS; i++)
+			for (unsigned i = 0; i < MAX_PLAYERS && !replaySimulation; i++)
 			{
 				for (DROID *psCurr : apsDroidLists[i])
 				{
@@ -630,6 +643,53 @@ void setMaxFastForwardTicks(optional<size_t> value, bool fixedToNormalTickRate)
 	fastForwardTicksFixedToNormalTickRate = fixedToNormalTickRate;
 }
 
+void startReplaySimulation()
+{
+	ASSERT_OR_RETURN(, NETisReplay() && headlessGameMode(), "Replay simulation requires a replay in headless mode");
+	replaySimulation = true;
+	replaySimulationReported = false;
+	replaySimulationStartTime = std::chrono::steady_clock::now();
+	replaySimulationStartGameTime = gameTime;
+	// No tick limit (other than replaySimulationMaxTicksDuration), and don't let the null backend pace the frames either
+	setMaxFastForwardTicks(std::numeric_limits<size_t>::max(), false);
+	gfx_api::context::get().setSwapInterval(gfx_api::context::swap_interval_mode::immediate, nullptr);
+}
+
+bool isReplaySimulation()
+{
+	return replaySimulation;
+}
+
+void reportReplaySimulation()
+{
+	if (!replaySimulation || replaySimulationReported)
+	{
+		return;
+	}
+	replaySimulationReported = true;
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - replaySimulationStartTime).count();
+	const uint32_t ticks = (gameTime - replaySimulationStartGameTime) / GAME_TICKS_PER_UPDATE;
+	const double ticksPerSec = (seconds > 0) ? ticks / seconds : 0;
+	const double speedup = ticksPerSec / GAME_UPDATES_PER_SEC;
+	debug(LOG_INFO, "Replay simulation: %u ticks in %.3f seconds, %.0f ticks/sec (x%.1f)", ticks, seconds, ticksPerSec, speedup);
+	fprintf(stdout, " * Replay simulated: %u ticks (gameTime %u) in %.3f seconds, %.0f ticks/sec (x%.1f)\n", ticks, gameTime, seconds, ticksPerSec, speedup);
+	fflush(stdout);
+}
+
+void finishReplaySimulation()
+{
+	ASSERT_OR_RETURN(, replaySimulation, "Not simulating a replay");
+	if (!GameStoryLogger::instance().hasLoggedGameOver())
+	{
+		// The replay ended without a winner (players left, etc)
+		GameStoryLogger::instance().logGameOver();
+	}
+	stdOutGameSummary(0);
+	reportReplaySimulation();
+	wzQuit(0); // Trigger a *graceful* shutdown
+}
+
 static int renderBudget = 0;  // Scaled time spent rendering minus scaled time spent updating.
 const Rational renderFraction(2, 5);  // Minimum fraction of time spent rendering.
 const Rational updateFraction = Rational(1) - renderFraction;
@@ -659,6 +719,7 @@ GAMECODE gameLoop()
 
 	size_t numRegularUpdatesTicks = 0;
 	size_t numFastForwardTicks = 0;
+	const auto ticksDeadline = std::chrono::steady_clock::now() + replaySimulationMaxTicksDuration;
 	gameTimeUpdateBegin();
 	while (true)
 	{
@@ -673,9 +734,11 @@ GAMECODE gameLoop()
 			&& !NetPlay.isHost					// AND NOT THE HOST (!)
 			&& !multiplayerHostDisconnected		// and the multiplayer host must not be disconnected ("host quit")
 			&& numFastForwardTicks < maxFastForwardTicks // and the number of forced updates this call of gameLoop must not exceed the max allowed
-			&& checkPlayerGameTime(NET_ALL_PLAYERS);	// and there must be a new game tick available to process from all players
+			&& checkPlayerGameTime(NET_ALL_PLAYERS)	// and there must be a new game tick available to process from all players
+			&& (!replaySimulation || std::chrono::steady_clock::now() < ticksDeadline); // and a replay simulation must return now and then
 
-		bool forceTryGameTickUpdate = canFastForwardGameTime && ((!fastForwardTicksFixedToNormalTickRate && numForcedUpdatesLastCall > 0) || numRegularUpdatesTicks > 0) && NETgameIsBehindPlayersByAtLeast(4);
+		// A replay simulation doesn't wait for real time at all, every available tick gets processed right away
+		bool forceTryGameTickUpdate = canFastForwardGameTime && (replaySimulation || (((!fastForwardTicksFixedToNormalTickRate && numForcedUpdatesLastCall > 0) || numRegularUpdatesTicks > 0) && NETgameIsBehindPlayersByAtLeast(4)));
 
 		// Update gameTime and graphicsTime, and corresponding deltas. Note that gameTime and graphicsTime pause, if we aren't getting our GAME_GAME_TIME messages.
 		auto timeUpdateResult = gameTimeUpdate(renderBudget > 0 || previousUpdateWasRender, forceTryGameTickUpdate);
@@ -80,6 +80,14 @@ constexpr size_t WZ_DEFAULT_MAX_FASTFORWARD_TICKS = 1;
 size_t getMaxFastForwardTicks();
 void setMaxFastForwardTicks(optional<size_t> value = nullopt, bool fixedToNormalTickRate = true);
 
+// Headless replays only: simulates the replay as fast as possible, without rendering, audio or UI work,
+// and reports the number of ticks per second when it's done.
+void startReplaySimulation();
+bool isReplaySimulation();
+void reportReplaySimulation();
+// Logs the game over (if not done already), reports and quits.
+void finishReplaySimulation();
+
 void setGameUpdatePause(bool state);
 void setAudioPause(bool state);
 void setScriptPause(bool state);
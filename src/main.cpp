@@ -892,7 +892,12 @@ static bool startGameLoop()
 	setMaxFastForwardTicks(WZ_DEFAULT_MAX_FASTFORWARD_TICKS, true); // default value / spectator "catch-up" behavior
 	if (NETisReplay())
 	{
-		if (!headlessGameMode() && !autogame_enabled())
+		if (replay_simulate_enabled() && headlessGameMode())
+		{
+			// batch analysis - no need to watch it, just get to the end as quickly as possible
+			startReplaySimulation();
+		}
+		else if (!headlessGameMode() && !autogame_enabled())
 		{
 			// for replays, ensure we don't start off fast-forwarding
 			setMaxFastForwardTicks(0, true);
@@ -114,6 +114,9 @@ SDWORD	mapWidth = 0, mapHeight = 0;
 std::unique_ptr<MAPTILE[]> psMapTiles;
 std::unique_ptr<uint8_t[]> psBlockMap[AUX_MAX];
 std::unique_ptr<uint8_t[]> psAuxMap[MAX_PLAYERS + AUX_MAX];        // yes, we waste one element... eyes wide open... makes API nicer
+static std::vector<uint32_t> auxChanges;      ///< Tiles passed to auxMarkChanged(), in order.
+static uint32_t auxChangesEpoch = 0;          ///< Incremented whenever auxChanges is reset.
+static uint8_t const *auxChangesMap = nullptr;  ///< Block map the tiles in auxChanges belong to.
 
 #define WATER_MIN_DEPTH 500
 #define WATER_MAX_DEPTH (WATER_MIN_DEPTH + 400)
@@ -1160,6 +1163,8 @@ static bool afterMapLoad()
 
 	/* Allocate aux maps */
 	ASSERT(mapWidth >= 0 && mapHeight >= 0, "Invalid mapWidth or mapHeight (%d x %d)", mapWidth, mapHeight);
+	auxChanges.clear();
+	++auxChangesEpoch;  // Everything changed.
 	const size_t mapSize = static_cast<size_t>(mapWidth) * static_cast<size_t>(mapHeight);
 	psBlockMap[AUX_MAP] = std::make_unique<uint8_t[]>(mapSize);
 	psBlockMap[AUX_ASTARMAP] =  std::make_unique<uint8_t[]>(mapSize);
@@ -2180,6 +2185,29 @@ static void threatUpdate(int player)
 	}
 }
 
+void auxMarkChanged(int x, int y)
+{
+	// Once a large part of the map changed, it is cheaper for users to regenerate their copies than to patch them.
+	// Also start over after switching between the mission map and the home map, since the tile indices refer to a different map.
+	if (auxChanges.size() >= static_cast<size_t>(mapWidth) * static_cast<size_t>(mapHeight) / 4 || auxChangesMap != psBlockMap[AUX_MAP].get())
+	{
+		auxChanges.clear();
+		++auxChangesEpoch;
+		auxChangesMap = psBlockMap[AUX_MAP].get();
+	}
+	auxChanges.push_back(x + y * mapWidth);
+}
+
+uint32_t auxChangeEpoch()
+{
+	return auxChangesEpoch;
+}
+
+std::vector<uint32_t> const &auxChangedTiles()
+{
+	return auxChanges;
+}
+
 void mapInit()
 {
 	int player;
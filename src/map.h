@@ -115,6 +115,17 @@ size_t getNumGroundTypes();
 extern std::unique_ptr<uint8_t[]> psBlockMap[AUX_MAX];
 extern std::unique_ptr<uint8_t[]> psAuxMap[MAX_PLAYERS + AUX_MAX];	// yes, we waste one element... eyes wide open... makes API nicer
 
+/** Record that the aux bits of a player, or the blocking bits, of a tile changed.
+ *
+ *  The changed tiles are kept in order, so that cached copies of the aux maps (such as the pathfinding
+ *  blocking maps) can be patched instead of regenerated. Must be called from the main thread.
+ */
+void auxMarkChanged(int x, int y);
+/// Incremented whenever the list of changed tiles is reset, after which every tile must be considered changed.
+uint32_t auxChangeEpoch();
+/// Tile indices (x + y * mapWidth) passed to auxMarkChanged since the last change of auxChangeEpoch(). May contain duplicates.
+std::vector<uint32_t> const &auxChangedTiles();
+
 /// Find aux bitfield for a given tile
 WZ_DECL_ALWAYS_INLINE static inline uint8_t auxTile(int x, int y, int player)
 {
@@ -146,6 +157,10 @@ static inline void auxMapRestore(int player, int slot, int mask)
 		original = psAuxMap[player][i];
 		cached = psAuxMap[MAX_PLAYERS + slot][i];
 		psAuxMap[player][i] = original ^ ((original ^ cached) & mask);
+		if ((original ^ cached) & mask & AUXBITS_THREAT)
+		{
+			auxMarkChanged(i % mapWidth, i / mapWidth);
+		}
 	}
 }
 
@@ -153,6 +168,10 @@ static inline void auxMapRestore(int player, int slot, int mask)
 WZ_DECL_ALWAYS_INLINE static inline void auxSet(int x, int y, int player, int state)
 {
 	psAuxMap[player][x + y * mapWidth] |= state;
+	if (player < MAX_PLAYERS)  // The shadow copies are also written by the danger thread, and are not tracked.
+	{
+		auxMarkChanged(x, y);
+	}
 }
 
 /// Set aux bits. Always set identically for all players. States not set are retained.
@@ -164,6 +183,7 @@ WZ_DECL_ALWAYS_INLINE static inline void auxSetAll(int x, int y, int state)
 	{
 		psAuxMap[i][x + y * mapWidth] |= state;
 	}
+	auxMarkChanged(x, y);
 }
 
 /// Set aux bits. Always set identically for all players. States not set are retained.
@@ -178,6 +198,7 @@ WZ_DECL_ALWAYS_INLINE static inline void auxSetAllied(int x, int y, int player,
 			psAuxMap[i][x + y * mapWidth] |= state;
 		}
 	}
+	auxMarkChanged(x, y);
 }
 
 /// Set aux bits. Always set identically for all players. States not set are retained.
@@ -192,12 +213,17 @@ WZ_DECL_ALWAYS_INLINE static inline void auxSetEnemy(int x, int y, int player, i
 			psAuxMap[i][x + y * mapWidth] |= state;
 		}
 	}
+	auxMarkChanged(x, y);
 }
 
 /// Clear aux bits. Always set identically for all players. States not cleared are retained.
 WZ_DECL_ALWAYS_INLINE static inline void auxClear(int x, int y, int player, int state)
 {
 	psAuxMap[player][x + y * mapWidth] &= ~state;
+	if (player < MAX_PLAYERS)  // The shadow copies are also written by the danger thread, and are not tracked.
+	{
+		auxMarkChanged(x, y);
+	}
 }
 
 /// Clear all aux bits. Always set identically for all players. States not cleared are retained.
@@ -209,18 +235,21 @@ WZ_DECL_ALWAYS_INLINE static inline void auxClearAll(int x, int y, int state)
 	{
 		psAuxMap[i][x + y * mapWidth] &= ~state;
 	}
+	auxMarkChanged(x, y);
 }
 
 /// Set blocking bits. Always set identically for all players. States not set are retained.
 WZ_DECL_ALWAYS_INLINE static inline void auxSetBlocking(int x, int y, int state)
 {
 	psBlockMap[0][x + y * mapWidth] |= state;
+	auxMarkChanged(x, y);
 }
 
 /// Clear blocking bits. Always set identically for all players. States not cleared are retained.
 WZ_DECL_ALWAYS_INLINE static inline void auxClearBlocking(int x, int y, int state)
 {
 	psBlockMap[0][x + y * mapWidth] &= ~state;
+	auxMarkChanged(x, y);
 }
 
 /**
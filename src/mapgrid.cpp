@@ -49,57 +49,60 @@ bool gridInitialise()
 	return true;  // Yay, nothing failed!
 }
 
+static void gridResetSeenThisTick(BASE_OBJECT *psObj)
+{
+	for (unsigned char& viewer : psObj->seenThisTick)
+	{
+		viewer = 0;
+	}
+}
+
+/// Sorts objects in the same place in the order that the object lists are walked in gridReset().
+static uint32_t gridObjectOrder(unsigned player, unsigned listType, unsigned index)
+{
+	return player << 26 | listType << 24 | index;
+}
+
 // reset the grid system
 void gridReset()
 {
 	gridPointTree->clear();
 
 	// Put all existing objects into the point tree.
+	// Structures and features don't move, so the point tree only needs to sort them again if some were added or removed.
 	for (unsigned player = 0; player < MAX_PLAYERS; player++)
 	{
+		unsigned index = 0;
 		for (BASE_OBJECT* psObj : apsDroidLists[player])
 		{
 			if (!psObj->died)
 			{
-				gridPointTree->insert(psObj, psObj->pos.x, psObj->pos.y);
-				for (unsigned char& viewer : psObj->seenThisTick)
-				{
-					viewer = 0;
-				}
+				gridPointTree->insert(psObj, psObj->pos.x, psObj->pos.y, gridObjectOrder(player, 0, index++));
+				gridResetSeenThisTick(psObj);
 			}
 		}
+		index = 0;
 		for (BASE_OBJECT* psObj : apsStructLists[player])
 		{
 			if (!psObj->died)
 			{
-				gridPointTree->insert(psObj, psObj->pos.x, psObj->pos.y);
-				for (unsigned char& viewer : psObj->seenThisTick)
-				{
-					viewer = 0;
-				}
+				gridPointTree->insertStatic(psObj, psObj->pos.x, psObj->pos.y, gridObjectOrder(player, 1, index++));
+				gridResetSeenThisTick(psObj);
 			}
 		}
+		index = 0;
 		for (BASE_OBJECT* psObj : apsFeatureLists[player])
 		{
 			if (!psObj->died)
 			{
-				gridPointTree->insert(psObj, psObj->pos.x, psObj->pos.y);
-				for (unsigned char& viewer : psObj->seenThisTick)
-				{
-					viewer = 0;
-				}
+				gridPointTree->insertStatic(psObj, psObj->pos.x, psObj->pos.y, gridObjectOrder(player, 2, index++));
+				gridResetSeenThisTick(psObj);
 			}
 		}
 	}
 
+	// The filters are reset when first used after sorting.
 	gridPointTree->sort();
-
-	for (unsigned player = 0; player < MAX_PLAYERS; ++player)
-	{
-		gridFiltersUnseen[player].reset(*gridPointTree);
-		gridFiltersDroidsByPlayer[player].reset(*gridPointTree);
-		gridFiltersDroidsRepairCandidates[player].reset(*gridPointTree);
-	}
 }
 
 // shutdown the grid system
@@ -111,6 +114,8 @@ void gridShutDown()
 	gridFiltersUnseen = nullptr;
 	delete[] gridFiltersDroidsByPlayer;
 	gridFiltersDroidsByPlayer = nullptr;
+	delete[] gridFiltersDroidsRepairCandidates;
+	gridFiltersDroidsRepairCandidates = nullptr;
 }
 
 static bool isInRadius(int32_t x, int32_t y, uint32_t radius)
@@ -119,59 +124,63 @@ static bool isInRadius(int32_t x, int32_t y, uint32_t radius)
 	return ((int64_t)x * (int64_t)x + (int64_t)y * (int64_t)y) <= ((int64_t)radius * (int64_t)radius);
 }
 
-// initialise the grid system to start iterating through units that
-// could affect a location (x,y in world coords)
+// Scratch buffers for the point tree queries, one per thread, so that queries don't allocate once warmed up.
+static thread_local PointTree::ResultVector gridQueryPoints;
+static thread_local PointTree::IndexVector gridQueryIndices;
+
+// find the units that could affect a location (x,y in world coords)
+// If filter is nullptr, the objects which don't pass condition are skipped, otherwise they are also erased from the filter.
 template<class Condition>
-static GridList const &gridStartIterateFiltered(int32_t x, int32_t y, uint32_t radius, PointTree::Filter *filter, Condition const &condition)
+static void gridFindFiltered(GridList &gridList, int32_t x, int32_t y, uint32_t radius, PointTree::Filter *filter, Condition const &condition)
 {
 	if (filter == nullptr)
 	{
-		gridPointTree->query(x, y, radius);
+		gridPointTree->query(gridQueryPoints, x, y, radius);
 	}
 	else
 	{
-		gridPointTree->query(*filter, x, y, radius);
+		gridPointTree->query(gridQueryPoints, gridQueryIndices, *filter, x, y, radius);
 	}
-	PointTree::ResultVector::iterator w = gridPointTree->lastQueryResults.begin(), i;
-	for (i = w; i != gridPointTree->lastQueryResults.end(); ++i)
+	gridList.clear();
+	for (size_t n = 0; n < gridQueryPoints.size(); ++n)
 	{
-		BASE_OBJECT *obj = static_cast<BASE_OBJECT *>(*i);
+		BASE_OBJECT *obj = static_cast<BASE_OBJECT *>(gridQueryPoints[n]);
 		if (!condition.test(obj))  // Check if we should skip this object.
 		{
-			filter->erase(gridPointTree->lastFilteredQueryIndices[i - gridPointTree->lastQueryResults.begin()]);  // Stop the object from appearing in future searches.
+			if (filter != nullptr)
+			{
+				filter->erase(gridQueryIndices[n]);  // Stop the object from appearing in future searches.
+			}
 		}
 		else if (isInRadius(obj->pos.x - x, obj->pos.y - y, radius))  // Check that search result is less than radius (since they can be up to a factor of sqrt(2) more).
 		{
-			*w = *i;
-			++w;
+			gridList.push_back(obj);
 		}
 	}
-	gridPointTree->lastQueryResults.erase(w, i);  // Erase all points that were a bit too far.
 
 	// In case you are curious.
-	//debug(LOG_WARNING, "gridStartIterateFiltered(%d, %d, %u) found %u objects", x, y, radius, (unsigned)gridPointTree->lastQueryResults.size());
-	
+	//debug(LOG_WARNING, "gridFindFiltered(%d, %d, %u) found %u objects", x, y, radius, (unsigned)gridList.size());
+}
+
+// initialise the grid system to start iterating through units that
+// could affect a location (x,y in world coords)
+template<class Condition>
+static GridList const &gridStartIterateFiltered(int32_t x, int32_t y, uint32_t radius, PointTree::Filter *filter, Condition const &condition)
+{
 	static GridList gridList;
-	gridList.resize(gridPointTree->lastQueryResults.size());
-	for (unsigned n = 0; n < gridList.size(); ++n)
-	{
-		gridList[n] = (BASE_OBJECT *)gridPointTree->lastQueryResults[n];
-	}
+	gridFindFiltered(gridList, x, y, radius, filter, condition);
 	return gridList;
 }
 
-template<class Condition>
-static GridList const &gridStartIterateFilteredArea(int32_t x, int32_t y, int32_t x2, int32_t y2, Condition const &condition)
+static void gridFindArea(GridList &gridList, int32_t x, int32_t y, int32_t x2, int32_t y2)
 {
-	gridPointTree->query(x, y, x2, y2);
+	gridPointTree->query(gridQueryPoints, x, y, x2, y2);
 
-	static GridList gridList;
-	gridList.resize(gridPointTree->lastQueryResults.size());
+	gridList.resize(gridQueryPoints.size());
 	for (unsigned n = 0; n < gridList.size(); ++n)
 	{
-		gridList[n] = (BASE_OBJECT *)gridPointTree->lastQueryResults[n];
+		gridList[n] = (BASE_OBJECT *)gridQueryPoints[n];
 	}
-	return gridList;
 }
 
 struct ConditionTrue
@@ -187,9 +196,21 @@ GridList const &gridStartIterate(int32_t x, int32_t y, uint32_t radius)
 	return gridStartIterateFiltered(x, y, radius, nullptr, ConditionTrue());
 }
 
+void gridStartIterate(int32_t x, int32_t y, uint32_t radius, GridList &results)
+{
+	gridFindFiltered(results, x, y, radius, nullptr, ConditionTrue());
+}
+
 GridList const &gridStartIterateArea(int32_t x, int32_t y, uint32_t x2, uint32_t y2)
 {
-	return gridStartIterateFilteredArea(x, y, x2, y2, ConditionTrue());
+	static GridList gridList;
+	gridFindArea(gridList, x, y, x2, y2);
+	return gridList;
+}
+
+void gridStartIterateArea(int32_t x, int32_t y, uint32_t x2, uint32_t y2, GridList &results)
+{
+	gridFindArea(results, x, y, x2, y2);
 }
 
 struct ConditionDroidsByPlayer
@@ -207,6 +228,11 @@ GridList const &gridStartIterateDroidsByPlayer(int32_t x, int32_t y, uint32_t ra
 	return gridStartIterateFiltered(x, y, radius, &gridFiltersDroidsByPlayer[player], ConditionDroidsByPlayer(player));
 }
 
+void gridStartIterateDroidsByPlayer(int32_t x, int32_t y, uint32_t radius, int player, GridList &results)
+{
+	gridFindFiltered(results, x, y, radius, nullptr, ConditionDroidsByPlayer(player));
+}
+
 struct ConditionDroidCandidateForRepair
 {
 	ConditionDroidCandidateForRepair(int32_t player_) : player(player_) {}
@@ -229,6 +255,11 @@ GridList const &gridStartIterateRepairCandidates(int32_t x, int32_t y, uint32_t
 	return gridStartIterateFiltered(x, y, radius, &gridFiltersDroidsRepairCandidates[player], ConditionDroidCandidateForRepair(player));
 }
 
+void gridStartIterateRepairCandidates(int32_t x, int32_t y, uint32_t radius, int player, GridList &results)
+{
+	gridFindFiltered(results, x, y, radius, nullptr, ConditionDroidCandidateForRepair(player));
+}
+
 struct ConditionUnseen
 {
 	ConditionUnseen(int32_t player_) : player(player_) {}
@@ -244,10 +275,7 @@ GridList const &gridStartIterateUnseen(int32_t x, int32_t y, uint32_t radius, in
 	return gridStartIterateFiltered(x, y, radius, &gridFiltersUnseen[player], ConditionUnseen(player));
 }
 
-BASE_OBJECT **gridIterateDup()
+void gridStartIterateUnseen(int32_t x, int32_t y, uint32_t radius, int player, GridList &results)
 {
-	size_t bytes = gridPointTree->lastQueryResults.size() * sizeof(void *);
-	BASE_OBJECT **ret = (BASE_OBJECT **)malloc(bytes);
-	memcpy(ret, &gridPointTree->lastQueryResults[0], bytes);
-	return ret;
+	gridFindFiltered(results, x, y, radius, nullptr, ConditionUnseen(player));
 }
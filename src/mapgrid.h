@@ -53,4 +53,14 @@ GridList const &gridStartIterateRepairCandidates(int32_t x, int32_t y, uint32_t
 /// Find all objects within radius where object->seenThisTick[player] != 255.
 GridList const &gridStartIterateUnseen(int32_t x, int32_t y, uint32_t radius, int player);
 
+// The functions above return a list which is reused by the next call, and must only be called from the main thread.
+// The overloads below write the objects into results instead (in the same order), and don't allocate once results is big
+// enough. They may be called from any number of threads at once, while gridReset() isn't running. Any concurrent changes to
+// objects checked by the query (position, player, seenThisTick, etc.) are up to the caller to avoid.
+void gridStartIterate(int32_t x, int32_t y, uint32_t radius, GridList &results);
+void gridStartIterateArea(int32_t x, int32_t y, uint32_t x2, uint32_t y2, GridList &results);
+void gridStartIterateDroidsByPlayer(int32_t x, int32_t y, uint32_t radius, int player, GridList &results);
+void gridStartIterateRepairCandidates(int32_t x, int32_t y, uint32_t radius, int player, GridList &results);
+void gridStartIterateUnseen(int32_t x, int32_t y, uint32_t radius, int player, GridList &results);
+
 #endif // __INCLUDED_SRC_MAPGRID_H__
@@ -0,0 +1,332 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2025  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/**
+ * @file mapindexcache.cpp
+ */
+
+#include "mapindexcache.h"
+
+#include "lib/framework/frame.h"
+#include "lib/framework/file.h"
+#include "lib/framework/physfs_ext.h"
+
+#include "version.h"
+#include "wzjsonhelpers.h"
+
+#include <unordered_map>
+
+#define MAP_INDEX_CACHE_DIR "cache"
+#define MAP_INDEX_CACHE_FORMAT_VERSION 1
+
+static const char mapIndexCachePath[] = MAP_INDEX_CACHE_DIR "/mapindex.json";
+
+struct CachedMapArchive
+{
+	int64_t fileSize = -1;
+	int64_t modTime = -1;
+	MapIndexCacheEntry entry;
+	optional<Sha256> hash;
+	bool seen = false;  ///< Listed by the current (or last) refresh.
+};
+
+static std::unordered_map<std::string, CachedMapArchive> cachedMaps;  ///< By real path.
+static bool cacheLoaded = false;
+static bool cacheDirty = false;
+
+/// The key and current size / modification time of a map archive in the virtual filesystem.
+struct MapArchiveStat
+{
+	std::string realPath;
+	int64_t fileSize = -1;
+	int64_t modTime = -1;
+};
+
+static optional<MapArchiveStat> statMapArchive(const std::string& realFileName)
+{
+	const char *pRealDirStr = PHYSFS_getRealDir(realFileName.c_str());
+	PHYSFS_Stat metaData;
+	if (pRealDirStr == nullptr || PHYSFS_stat(realFileName.c_str(), &metaData) == 0)
+	{
+		return nullopt;
+	}
+	if (metaData.filesize < 0 || metaData.modtime < 0)
+	{
+		return nullopt;  // Can't tell whether it changed.
+	}
+	MapArchiveStat result;
+	result.realPath = std::string(pRealDirStr) + "/" + realFileName;
+	result.fileSize = metaData.filesize;
+	result.modTime = metaData.modtime;
+	return result;
+}
+
+static CachedMapArchive *findUnchanged(const MapArchiveStat& stat)
+{
+	auto it = cachedMaps.find(stat.realPath);
+	if (it == cachedMaps.end() || it->second.fileSize != stat.fileSize || it->second.modTime != stat.modTime)
+	{
+		return nullptr;
+	}
+	return &it->second;
+}
+
+static nlohmann::json levelDetailsToJson(const WzMap::LevelDetails& details)
+{
+	nlohmann::json result = nlohmann::json::object();
+	result["name"] = details.name;
+	result["type"] = static_cast<int>(details.type);
+	result["players"] = details.players;
+	result["tileset"] = static_cast<int>(details.tileset);
+	result["mapFolderPath"] = details.mapFolderPath;
+	result["createdDate"] = details.createdDate;
+	result["uploadedDate"] = details.uploadedDate;
+	result["author"] = details.author;
+	result["additionalAuthors"] = details.additionalAuthors;
+	result["license"] = details.license;
+	if (details.generator.has_value())
+	{
+		result["generator"] = details.generator.value();
+	}
+	return result;
+}
+
+static optional<WzMap::LevelDetails> levelDetailsFromJson(const nlohmann::json& obj)
+{
+	WzMap::LevelDetails details;
+	details.name = obj.at("name").get<std::string>();
+	int type = obj.at("type").get<int>();
+	if (type < static_cast<int>(WzMap::MapType::CAMPAIGN) || type > static_cast<int>(WzMap::MapType::SKIRMISH))
+	{
+		return nullopt;
+	}
+	details.type = static_cast<WzMap::MapType>(type);
+	details.players = obj.at("players").get<uint8_t>();
+	int tileset = obj.at("tileset").get<int>();
+	if (tileset < static_cast<int>(MAP_TILESET::ARIZONA) || tileset > static_cast<int>(MAP_TILESET::ROCKIES))
+	{
+		return nullopt;
+	}
+	details.tileset = static_cast<MAP_TILESET>(tileset);
+	details.mapFolderPath = obj.at("mapFolderPath").get<std::string>();
+	details.createdDate = obj.at("createdDate").get<std::string>();
+	details.uploadedDate = obj.at("uploadedDate").get<std::string>();
+	details.author = obj.at("author").get<std::string>();
+	details.additionalAuthors = obj.at("additionalAuthors").get<std::vector<std::string>>();
+	details.license = obj.at("license").get<std::string>();
+	auto it = obj.find("generator");
+	if (it != obj.end())
+	{
+		details.generator = it->get<std::string>();
+	}
+	return details;
+}
+
+static void loadMapIndexCache()
+{
+	cacheLoaded = true;
+	cachedMaps.clear();
+
+	auto root = wzLoadJsonObjectFromFile(mapIndexCachePath, true);
+	if (!root.has_value() || !root->is_object())
+	{
+		return;
+	}
+	try
+	{
+		// Parsing a map package may change between versions, so start over after an update.
+		if (root->at("version").get<int>() != MAP_INDEX_CACHE_FORMAT_VERSION
+			|| root->at("wz_version").get<std::string>() != version_getVersionString())
+		{
+			debug(LOG_INFO, "Discarding map index from another version");
+			return;
+		}
+		for (const auto& it : root->at("maps").items())
+		{
+			const auto& obj = it.value();
+			auto levelDetails = levelDetailsFromJson(obj.at("level"));
+			if (!levelDetails.has_value())
+			{
+				continue;
+			}
+			CachedMapArchive cached;
+			cached.fileSize = obj.at("size").get<int64_t>();
+			cached.modTime = obj.at("modtime").get<int64_t>();
+			cached.entry.levelDetails = std::move(levelDetails.value());
+			cached.entry.isMapMod = obj.at("mapMod").get<bool>();
+			cached.entry.isRandom = obj.at("random").get<bool>();
+			auto hashIt = obj.find("hash");
+			if (hashIt != obj.end())
+			{
+				Sha256 hash;
+				hash.fromString(hashIt->get<std::string>());
+				if (!hash.isZero())
+				{
+					cached.hash = hash;
+				}
+			}
+			cachedMaps.emplace(it.key(), std::move(cached));
+		}
+	}
+	catch (const std::exception& e)
+	{
+		debug(LOG_WARNING, "Invalid map index (%s), rebuilding it", e.what());
+		cachedMaps.clear();
+	}
+	debug(LOG_WZ, "Loaded map index with %zu entries", cachedMaps.size());
+}
+
+static void saveMapIndexCache()
+{
+	nlohmann::json maps = nlohmann::json::object();
+	for (const auto& it : cachedMaps)
+	{
+		const auto& cached = it.second;
+		nlohmann::json obj = nlohmann::json::object();
+		obj["size"] = cached.fileSize;
+		obj["modtime"] = cached.modTime;
+		obj["level"] = levelDetailsToJson(cached.entry.levelDetails);
+		obj["mapMod"] = cached.entry.isMapMod;
+		obj["random"] = cached.entry.isRandom;
+		if (cached.hash.has_value())
+		{
+			obj["hash"] = cached.hash->toString();
+		}
+		maps[it.first] = std::move(obj);
+	}
+	nlohmann::json root = nlohmann::json::object();
+	root["version"] = MAP_INDEX_CACHE_FORMAT_VERSION;
+	root["wz_version"] = version_getVersionString();
+	root["maps"] = std::move(maps);
+
+	std::string jsonString;
+	try
+	{
+		jsonString = root.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+	}
+	catch (const std::exception &e)
+	{
+		debug(LOG_ERROR, "Failed to serialize map index: %s", e.what());
+		return;
+	}
+	if (!PHYSFS_exists(MAP_INDEX_CACHE_DIR) && PHYSFS_mkdir(MAP_INDEX_CACHE_DIR) == 0)
+	{
+		debug(LOG_WARNING, "Failed to create cache directory: %s", WZ_PHYSFS_getLastError());
+		return;
+	}
+	if (saveFile(mapIndexCachePath, jsonString.c_str(), jsonString.size()))
+	{
+		cacheDirty = false;
+	}
+}
+
+void mapIndexCacheBeginRefresh()
+{
+	if (!cacheLoaded)
+	{
+		loadMapIndexCache();
+	}
+	for (auto& it : cachedMaps)
+	{
+		it.second.seen = false;
+	}
+}
+
+void mapIndexCacheEndRefresh()
+{
+	for (auto it = cachedMaps.begin(); it != cachedMaps.end();)
+	{
+		if (!it->second.seen)
+		{
+			// Removed, or not in the search path at the moment (e.g. a mod isn't loaded). Re-parsing it later is cheap enough.
+			it = cachedMaps.erase(it);
+			cacheDirty = true;
+		}
+		else
+		{
+			++it;
+		}
+	}
+	if (cacheDirty)
+	{
+		saveMapIndexCache();
+	}
+}
+
+optional<MapIndexCacheEntry> mapIndexCacheFind(const std::string& realFileName)
+{
+	auto stat = statMapArchive(realFileName);
+	if (!stat.has_value())
+	{
+		return nullopt;
+	}
+	CachedMapArchive *cached = findUnchanged(stat.value());
+	if (cached == nullptr)
+	{
+		return nullopt;
+	}
+	cached->seen = true;
+	return cached->entry;
+}
+
+void mapIndexCacheStore(const std::string& realFileName, const MapIndexCacheEntry& entry)
+{
+	auto stat = statMapArchive(realFileName);
+	if (!stat.has_value())
+	{
+		return;
+	}
+	CachedMapArchive& cached = cachedMaps[stat->realPath];
+	cached.fileSize = stat->fileSize;
+	cached.modTime = stat->modTime;
+	cached.entry = entry;
+	cached.hash.reset();
+	cached.seen = true;
+	cacheDirty = true;
+}
+
+optional<Sha256> mapIndexCacheFindHash(const std::string& realFileName)
+{
+	auto stat = statMapArchive(realFileName);
+	if (!stat.has_value())
+	{
+		return nullopt;
+	}
+	CachedMapArchive *cached = findUnchanged(stat.value());
+	if (cached == nullptr)
+	{
+		return nullopt;
+	}
+	return cached->hash;
+}
+
+void mapIndexCacheStoreHash(const std::string& realFileName, const Sha256& hash)
+{
+	auto stat = statMapArchive(realFileName);
+	if (!stat.has_value())
+	{
+		return;
+	}
+	CachedMapArchive *cached = findUnchanged(stat.value());
+	if (cached == nullptr || (cached->hash.has_value() && cached->hash.value() == hash))
+	{
+		return;
+	}
+	cached->hash = hash;
+	cacheDirty = true;  // Written with the next refresh of the map list.
+}
@@ -0,0 +1,59 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2025  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Persistent index of the map archives found by buildMapList(), so that only new or
+ *  changed archives need to be opened and parsed on startup.
+ *
+ *  Entries are keyed by the real path of the archive, and are only used while its size
+ *  and modification time are unchanged.
+ */
+
+#ifndef __INCLUDED_SRC_MAPINDEXCACHE_H__
+#define __INCLUDED_SRC_MAPINDEXCACHE_H__
+
+#include "lib/framework/crc.h"
+#include <wzmaplib/map_package.h>
+
+#include <string>
+
+#include <nonstd/optional.hpp>
+using nonstd::optional;
+using nonstd::nullopt;
+
+struct MapIndexCacheEntry
+{
+	WzMap::LevelDetails levelDetails;
+	bool isMapMod = false;
+	bool isRandom = false;
+};
+
+/// Starts a refresh of the map list. Entries not looked up / stored until mapIndexCacheEndRefresh() are dropped.
+void mapIndexCacheBeginRefresh();
+/// Drops stale entries, and writes the index if anything changed.
+void mapIndexCacheEndRefresh();
+
+/// Returns the cached details of the map archive at `realFileName` (a path in the virtual filesystem), if it's unchanged.
+optional<MapIndexCacheEntry> mapIndexCacheFind(const std::string& realFileName);
+void mapIndexCacheStore(const std::string& realFileName, const MapIndexCacheEntry& entry);
+
+/// The hash of the map archive at `realFileName`, if known and the archive is unchanged (checked on every call).
+optional<Sha256> mapIndexCacheFindHash(const std::string& realFileName);
+void mapIndexCacheStoreHash(const std::string& realFileName, const Sha256& hash);
+
+#endif // __INCLUDED_SRC_MAPINDEXCACHE_H__
@@ -871,7 +871,7 @@ void restoreMissionData()
 	apsSensorList[0] = std::move(mission.apsSensorList[0]);
 	apsOilList[0] = std::move(mission.apsOilList[0]);
 	mission.apsSensorList[0].clear();
-	apsOilList[0].clear();
+	mission.apsOilList[0].clear();
 	//swap mission data over
 
 	psMapTiles = std::move(mission.psMapTiles);
@@ -1404,14 +1404,14 @@ void swapMissionPointers()
 	std::swap(scrollMaxY, mission.scrollMaxY);
 	for (unsigned inc = 0; inc < MAX_PLAYERS; inc++)
 	{
-		std::swap(apsDroidLists[inc],     mission.apsDroidLists[inc]);
-		std::swap(apsStructLists[inc],    mission.apsStructLists[inc]);
-		std::swap(apsFeatureLists[inc],   mission.apsFeatureLists[inc]);
-		std::swap(apsFlagPosLists[inc],   mission.apsFlagPosLists[inc]);
-		std::swap(apsExtractorLists[inc], mission.apsExtractorLists[inc]);
+		apsDroidLists[inc].swap(mission.apsDroidLists[inc]);
+		apsStructLists[inc].swap(mission.apsStructLists[inc]);
+		apsFeatureLists[inc].swap(mission.apsFeatureLists[inc]);
+		apsFlagPosLists[inc].swap(mission.apsFlagPosLists[inc]);
+		apsExtractorLists[inc].swap(mission.apsExtractorLists[inc]);
 	}
-	std::swap(apsSensorList[0], mission.apsSensorList[0]);
-	std::swap(apsOilList[0],    mission.apsOilList[0]);
+	apsSensorList[0].swap(mission.apsSensorList[0]);
+	apsOilList[0].swap(mission.apsOilList[0]);
 }
 
 void endMission()
@@ -45,6 +45,7 @@
 #include "display3d.h"								// for changing the viewpoint
 #include "console.h"								// for screen messages
 #include "clparse.h"
+#include "loop.h"
 #include "data.h"
 #include "power.h"
 #include "cmddroid.h"								//  for commanddroidupdatekills
@@ -1555,6 +1556,10 @@ bool recvMessage()
 				}
 				addConsoleMessage(_("REPLAY HAS ENDED"), CENTRE_JUSTIFY, SYSTEM_MESSAGE, false, MAX_CONSOLE_MESSAGE_DURATION);
 				addConsoleMessage(_("(Press ESC to quit.)"), CENTRE_JUSTIFY, SYSTEM_MESSAGE, false, MAX_CONSOLE_MESSAGE_DURATION);
+				if (isReplaySimulation())
+				{
+					finishReplaySimulation();
+				}
 				break;
 			default:
 				processedMessage1 = false;
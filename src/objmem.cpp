@@ -46,6 +46,7 @@
 #include "wzcrashhandlingproviders.h"
 
 #include <algorithm>
+#include <unordered_map>
 
 // the initial value for the object ID
 #define OBJ_ID_INIT 20000
@@ -70,9 +71,13 @@ PerPlayerFlagPositionLists apsFlagPosLists;
 /* The list of destroyed objects */
 DestroyedObjectsList psDestroyedObj;
 
+/* All droids, structures and features which have not been freed yet, by id */
+static std::unordered_map<uint32_t, BASE_OBJECT *> objectsById;
+
 /* Forward function declarations */
 #ifdef DEBUG
 static void objListIntegCheck();
+static void objIdIndexCheck();
 #endif
 
 
@@ -396,7 +401,7 @@ static inline void destroyObject(PerPlayerObjectLists<OBJECT, MAX_PLAYERS>& list
 	ASSERT_OR_RETURN(, object != nullptr, "Invalid pointer");
 	ASSERT(gameTime - deltaGameTime <= gameTime || gameTime == 2, "Expected %u <= %u, bad time", gameTime - deltaGameTime, gameTime);
 
-	auto it = std::find(list[object->player].begin(), list[object->player].end(), object);
+	auto it = list[object->player].find(object);
 	ASSERT(it != list[object->player].end(), "Object %s(%d) not found in list", objInfo(object), object->id);
 
 	if (it != list[object->player].end())
@@ -422,7 +427,7 @@ static inline void removeObjectFromList(PerPlayerObjectLists<OBJECT, MAX_PLAYERS
 {
 	ASSERT_OR_RETURN(, object != nullptr, "Invalid pointer");
 
-	auto it = std::find(list[player].begin(), list[player].end(), object);
+	auto it = list[player].find(object);
 	ASSERT_OR_RETURN(, it != list[player].end(), "Object %p not found in list", static_cast<void*>(object));
 	list[player].erase(it);
 }
@@ -437,8 +442,7 @@ static inline void removeObjectFromFuncList(FunctionList& list, OBJECT *object,
 {
 	ASSERT_OR_RETURN(, object != nullptr, "Invalid pointer");
 
-	// Iterate through the list and find the item before the object to delete
-	auto it = std::find(list[player].begin(), list[player].end(), object);
+	auto it = list[player].find(object);
 	ASSERT_OR_RETURN(, it != list[player].end(), "Object %p not found in list", static_cast<void*>(object));
 	list[player].erase(it);
 	object->hasExtraFunction = false;
@@ -808,7 +812,7 @@ static bool isFlagPositionInList(FLAG_POSITION *psFlagPosToAdd, const PerPlayerF
 	ASSERT_OR_RETURN(false, psFlagPosToAdd != nullptr, "Invalid FlagPosition pointer");
 	ASSERT_OR_RETURN(false, psFlagPosToAdd->player < MAX_PLAYERS, "Invalid FlagPosition player: %u", psFlagPosToAdd->player);
 	const auto& flagPosList = list[psFlagPosToAdd->player];
-	return flagPosList.end() != std::find(flagPosList.begin(), flagPosList.end(), psFlagPosToAdd);
+	return flagPosList.contains(psFlagPosToAdd);
 }
 
 /* add the Flag Position to the Flag Position Lists */
@@ -838,7 +842,7 @@ static bool removeFlagPositionFromList(FLAG_POSITION *psRemove)
 	ASSERT_OR_RETURN(false, psRemove->player < MAX_PLAYERS, "Invalid Flag Position player: %" PRIu32, psRemove->player);
 
 	auto& flagPosList = apsFlagPosLists[psRemove->player];
-	auto it = std::find(flagPosList.begin(), flagPosList.end(), psRemove);
+	auto it = flagPosList.find(psRemove);
 	if (it != flagPosList.end())
 	{
 		flagPosList.erase(it);
@@ -925,103 +929,101 @@ void checkFactoryFlags()
 
 /**************************  OBJECT ACCESS FUNCTIONALITY ********************************/
 
-static BASE_OBJECT* getBaseObjFromDroidId(const DroidList& list, unsigned id)
+void objmemRegisterObject(BASE_OBJECT *psObj)
 {
-	for (DROID* psObj : list)
+	ASSERT_OR_RETURN(, psObj != nullptr, "Invalid pointer");
+	auto res = objectsById.emplace(psObj->id, psObj);
+	ASSERT(res.second || res.first->second == psObj, "%s(%p) has the same id as %s(%p)",
+	       objInfo(psObj), static_cast<void *>(psObj), objInfo(res.first->second), static_cast<void *>(res.first->second));
+	res.first->second = psObj;
+}
+
+void objmemUnregisterObject(BASE_OBJECT *psObj)
+{
+	auto it = objectsById.find(psObj->id);
+	// Objects which were never registered (such as temporaries) have nothing to remove.
+	if (it != objectsById.end() && it->second == psObj)
 	{
-		if (psObj->id == id)
-		{
-			return psObj;
-		}
-		// if transporter check any droids in the grp
-		if ((psObj->type == OBJ_DROID) && psObj->isTransporter())
-		{
-			ASSERT_OR_RETURN(nullptr, psObj->psGroup != nullptr, "Transporter has null group?");
-			for (DROID* psTrans : psObj->psGroup->psList)
-			{
-				if (psTrans->id == id)
-				{
-					return (BASE_OBJECT*)psTrans;
-				}
-			}
-		}
+		objectsById.erase(it);
 	}
-	return nullptr;
 }
 
-// Find a base object from its id
-BASE_OBJECT *getBaseObjFromData(unsigned id, unsigned player, OBJECT_TYPE type)
+BASE_OBJECT *objmemLookupObject(uint32_t id)
 {
-	ASSERT_OR_RETURN(nullptr, player < MAX_PLAYERS || type == OBJ_FEATURE, "Invalid player: %u", player);
+	auto it = objectsById.find(id);
+	return it != objectsById.end() ? it->second : nullptr;
+}
 
-	switch (type)
+static bool droidInPlayerLists(const DROID *psDroid, unsigned player)
+{
+	return apsDroidLists[player].contains(psDroid)
+	       || mission.apsDroidLists[player].contains(psDroid)
+	       || (player == 0 && apsLimboDroids[0].contains(psDroid));
+}
+
+/* Whether psObj is in one of the lists searched for the player and type, or is carried by a transporter in one of them */
+static bool objInPlayerLists(const BASE_OBJECT *psObj, unsigned player)
+{
+	switch (psObj->type)
 	{
 	case OBJ_DROID:
 		{
-			auto pDroid = getBaseObjFromDroidId(apsDroidLists[player], id);
-			if (pDroid)
-			{
-				return pDroid;
-			}
-			pDroid = getBaseObjFromDroidId(mission.apsDroidLists[player], id);
-			if (pDroid)
+			const DROID *psDroid = static_cast<const DROID *>(psObj);
+			if (droidInPlayerLists(psDroid, player))
 			{
-				return pDroid;
+				return true;
 			}
-			if (player == 0)
+			// if in a transporter group, check the transporter
+			if (psDroid->psGroup != nullptr)
 			{
-				pDroid = getBaseObjFromDroidId(apsLimboDroids[0], id);
-				if (pDroid)
+				for (const DROID *psTrans : psDroid->psGroup->psList)
 				{
-					return pDroid;
+					if (psTrans != psDroid && psTrans->isTransporter() && psTrans->psGroup == psDroid->psGroup
+					    && droidInPlayerLists(psTrans, player))
+					{
+						return true;
+					}
 				}
 			}
-			break;
+			return false;
 		}
 	case OBJ_STRUCTURE:
 		{
-			auto pStruct = getBaseObjFromId(apsStructLists[player], id);
-			if (pStruct)
-			{
-				return pStruct;
-			}
-			pStruct = getBaseObjFromId(mission.apsStructLists[player], id);
-			if (pStruct)
-			{
-				return pStruct;
-			}
-			break;
+			const STRUCTURE *psStruct = static_cast<const STRUCTURE *>(psObj);
+			return apsStructLists[player].contains(psStruct) || mission.apsStructLists[player].contains(psStruct);
 		}
 	case OBJ_FEATURE:
 		{
-			auto pFeat = getBaseObjFromId(apsFeatureLists[0], id);
-			if (pFeat)
-			{
-				return pFeat;
-			}
-			pFeat = getBaseObjFromId(mission.apsFeatureLists[0], id);
-			if (pFeat)
-			{
-				return pFeat;
-			}
-			break;
+			const FEATURE *psFeat = static_cast<const FEATURE *>(psObj);
+			return apsFeatureLists[0].contains(psFeat) || mission.apsFeatureLists[0].contains(psFeat);
 		}
 	default:
-		break;
+		return false;
 	}
-	return nullptr;
+}
+
+// Find a base object from its id
+BASE_OBJECT *getBaseObjFromData(unsigned id, unsigned player, OBJECT_TYPE type)
+{
+	ASSERT_OR_RETURN(nullptr, player < MAX_PLAYERS || type == OBJ_FEATURE, "Invalid player: %u", player);
+
+	BASE_OBJECT *psObj = objmemLookupObject(id);
+	if (psObj == nullptr || psObj->type != type || !objInPlayerLists(psObj, type == OBJ_FEATURE ? 0 : player))
+	{
+		return nullptr;
+	}
+	return psObj;
 }
 
 // Find a base object from it's id
 BASE_OBJECT *getBaseObjFromId(UDWORD id)
 {
-	// Only cover OBJ_DROID, OBJ_STRUCTURE and OBJ_FEATURE types
-	for (size_t type = OBJ_DROID; type != OBJ_PROJECTILE; ++type)
+	BASE_OBJECT *psObj = objmemLookupObject(id);
+	if (psObj != nullptr)
 	{
-		for (size_t player = 0; player != MAX_PLAYERS; ++player)
+		for (unsigned player = 0; player != MAX_PLAYERS; ++player)
 		{
-			auto psObj = getBaseObjFromData(id, player, static_cast<OBJECT_TYPE>(type));
-			if (psObj)
+			if (objInPlayerLists(psObj, player))
 			{
 				return psObj;
 			}
@@ -1127,6 +1129,45 @@ static void objListIntegCheck()
 	{
 		ASSERT(obj->died > 0, "objListIntegCheck: Object in destroyed list but not dead!");
 	}
+	objIdIndexCheck();
+}
+
+template <typename ListType>
+static void objIdIndexCheckList(const ListType& list, const char *listName)
+{
+	for (BASE_OBJECT *psObj : list)
+	{
+		ASSERT(objmemLookupObject(psObj->id) == psObj, "objIdIndexCheck: %s(%p) in %s is not indexed by its id",
+		       objInfo(psObj), static_cast<void *>(psObj), listName);
+		if (psObj->type == OBJ_DROID && static_cast<DROID *>(psObj)->isTransporter() && static_cast<DROID *>(psObj)->psGroup != nullptr)
+		{
+			for (const DROID *psTrans : static_cast<DROID *>(psObj)->psGroup->psList)
+			{
+				ASSERT(objmemLookupObject(psTrans->id) == psTrans, "objIdIndexCheck: %s(%p) in transporter is not indexed by its id",
+				       objInfo(psTrans), static_cast<const void *>(psTrans));
+			}
+		}
+	}
+}
+
+/* Check that the id index agrees with the object lists */
+static void objIdIndexCheck()
+{
+	for (unsigned player = 0; player < MAX_PLAYERS; ++player)
+	{
+		objIdIndexCheckList(apsDroidLists[player], "apsDroidLists");
+		objIdIndexCheckList(mission.apsDroidLists[player], "mission.apsDroidLists");
+		objIdIndexCheckList(apsLimboDroids[player], "apsLimboDroids");
+		objIdIndexCheckList(apsStructLists[player], "apsStructLists");
+		objIdIndexCheckList(mission.apsStructLists[player], "mission.apsStructLists");
+	}
+	objIdIndexCheckList(apsFeatureLists[0], "apsFeatureLists");
+	objIdIndexCheckList(mission.apsFeatureLists[0], "mission.apsFeatureLists");
+	objIdIndexCheckList(psDestroyedObj, "psDestroyedObj");
+
+	// Every allocated object is registered when created, and unregistered when freed.
+	const size_t numAllocated = GlobalDroidContainer().size() + GlobalStructContainer().size() + GlobalFeatureContainer().size();
+	ASSERT(objectsById.size() == numAllocated, "objIdIndexCheck: %zu objects indexed, but %zu allocated", objectsById.size(), numAllocated);
 }
 #endif
 
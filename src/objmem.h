@@ -24,6 +24,7 @@
 #ifndef __INCLUDED_SRC_OBJMEM_H__
 #define __INCLUDED_SRC_OBJMEM_H__
 
+#include "lib/framework/paged_object_list.h"
 #include "objectdef.h"
 
 #include <array>
@@ -31,7 +32,7 @@
 
 /* The lists of objects allocated */
 template <typename ObjectType, unsigned PlayerCount>
-using PerPlayerObjectLists = std::array<std::list<ObjectType*>, PlayerCount>;
+using PerPlayerObjectLists = std::array<PagedObjectList<ObjectType>, PlayerCount>;
 
 using PerPlayerDroidLists = PerPlayerObjectLists<DROID, MAX_PLAYERS>;
 using DroidList = typename PerPlayerDroidLists::value_type;
@@ -135,15 +136,19 @@ void freeAllFlagPositions();
 // used to add flag position to a specific list (ex. from assignFactoryCommandDroid)
 void addFlagPositionToList(FLAG_POSITION* psFlagPosToAdd, PerPlayerFlagPositionLists& list);
 
-// Find a base object from it's id
+/* Add a newly allocated droid, structure or feature to the id index, once it has a stable address */
+void objmemRegisterObject(BASE_OBJECT *psObj);
+/* Remove an object from the id index, called when it is freed */
+void objmemUnregisterObject(BASE_OBJECT *psObj);
+/* Find any droid, structure or feature which has not been freed yet, whichever list it is in (if any) */
+BASE_OBJECT *objmemLookupObject(uint32_t id);
+
+// Find a base object from it's id, if in the list
 template <typename ObjectType>
-BASE_OBJECT* getBaseObjFromId(const std::list<ObjectType*>& list, unsigned id)
+BASE_OBJECT* getBaseObjFromId(const PagedObjectList<ObjectType>& list, unsigned id)
 {
-	auto objIt = std::find_if(list.begin(), list.end(), [id](ObjectType* obj)
-	{
-		return obj->id == id;
-	});
-	return objIt != list.end() ? *objIt : nullptr;
+	ObjectType *psObj = dynamic_cast<ObjectType *>(objmemLookupObject(id));
+	return psObj != nullptr && list.contains(psObj) ? psObj : nullptr;
 }
 
 BASE_OBJECT *getBaseObjFromData(unsigned id, unsigned player, OBJECT_TYPE type);
@@ -77,14 +77,32 @@ static uint64_t interleave(int32_t x, int32_t y)
 	return expandX(x) | expandY(y);
 }
 
-void PointTree::insert(void *pointData, int32_t x, int32_t y)
+void PointTree::insert(void *pointData, int32_t x, int32_t y, uint32_t order)
 {
-	points.push_back(Point(interleave(x, y), pointData));
+	dynamicPoints.push_back(OrderedPoint{interleave(x, y), order, pointData});
+}
+
+void PointTree::insertStatic(void *pointData, int32_t x, int32_t y, uint32_t order)
+{
+	OrderedPoint point{interleave(x, y), order, pointData};
+	if (numStaticPoints == staticPoints.size())
+	{
+		staticPoints.push_back(point);
+		staticPointsChanged = true;
+	}
+	else if (!(staticPoints[numStaticPoints] == point))
+	{
+		staticPoints[numStaticPoints] = point;
+		staticPointsChanged = true;
+	}
+	++numStaticPoints;
 }
 
 void PointTree::clear()
 {
 	points.clear();
+	dynamicPoints.clear();
+	numStaticPoints = 0;
 }
 
 static bool pointTreeSortFunction(std::pair<uint64_t, void *> const &a, std::pair<uint64_t, void *> const &b)
@@ -94,7 +112,28 @@ static bool pointTreeSortFunction(std::pair<uint64_t, void *> const &a, std::pai
 
 void PointTree::sort()
 {
-	std::stable_sort(points.begin(), points.end(), pointTreeSortFunction);  // Stable sort to avoid unspecified behaviour when two objects are in exactly the same place.
+	if (numStaticPoints != staticPoints.size())
+	{
+		staticPoints.resize(numStaticPoints);
+		staticPointsChanged = true;
+	}
+	if (staticPointsChanged)
+	{
+		sortedStaticPoints = staticPoints;
+		std::sort(sortedStaticPoints.begin(), sortedStaticPoints.end());  // The order is unique, so the result is well defined even if two objects are in exactly the same place.
+		staticPointsChanged = false;
+	}
+	std::sort(dynamicPoints.begin(), dynamicPoints.end());
+
+	// Merge the static and dynamic points, which is linear since both are sorted.
+	points.resize(sortedStaticPoints.size() + dynamicPoints.size());
+	OrderedVector::const_iterator s = sortedStaticPoints.begin(), d = dynamicPoints.begin();
+	for (Point &point : points)
+	{
+		OrderedPoint const &next = d == dynamicPoints.end() || (s != sortedStaticPoints.end() && *s < *d) ? *s++ : *d++;
+		point = Point(next.key, next.data);
+	}
+	++generation;
 }
 
 //#define DUMP_IMAGE  // All x and y coordinates must be in range -500 to 499, if dumping an image.
@@ -111,7 +150,7 @@ struct PointTreeRange
 
 // If !IsFiltered, function is trivially optimised to "return i;".
 template<bool IsFiltered>
-static unsigned current(std::vector<unsigned> &filterData, unsigned i)
+static unsigned current(unsigned *filterData, unsigned i)
 {
 	unsigned ret = i;
 	while (IsFiltered && filterData[ret])
@@ -129,7 +168,7 @@ static unsigned current(std::vector<unsigned> &filterData, unsigned i)
 }
 
 template<bool IsFiltered>
-PointTree::ResultVector &PointTree::queryMaybeFilter(Filter &filter, int32_t minXo, int32_t minYo, int32_t maxXo, int32_t maxYo)
+void PointTree::queryMaybeFilter(ResultVector &results, IndexVector *indices, Filter *filter, int32_t minXo, int32_t minYo, int32_t maxXo, int32_t maxYo) const
 {
 	uint64_t minX = expandX(minXo);
 	uint64_t maxX = expandX(maxXo);
@@ -225,10 +264,11 @@ PointTree::ResultVector &PointTree::queryMaybeFilter(Filter &filter, int32_t min
 		--numRanges;
 	}
 
-	lastQueryResults.clear();
+	unsigned *filterData = IsFiltered ? filter->data.data() : nullptr;
+	results.clear();
 	if (IsFiltered)
 	{
-		lastFilteredQueryIndices.clear();
+		indices->clear();
 	}
 	for (int r = 0; r != numRanges; ++r)
 	{
@@ -236,16 +276,16 @@ PointTree::ResultVector &PointTree::queryMaybeFilter(Filter &filter, int32_t min
 		unsigned i1 = std::lower_bound(points.begin(),      points.end(), Point(ranges[r].a, (void *)nullptr), pointTreeSortFunction) - points.begin();
 		unsigned i2 = std::upper_bound(points.begin() + i1, points.end(), Point(ranges[r].z, (void *)nullptr), pointTreeSortFunction) - points.begin();
 
-		for (unsigned i = current<IsFiltered>(filter.data, i1); i < i2; i = current<IsFiltered>(filter.data, i + 1))
+		for (unsigned i = current<IsFiltered>(filterData, i1); i < i2; i = current<IsFiltered>(filterData, i + 1))
 		{
 			uint64_t px = points[i].first & 0xAAAAAAAAAAAAAAAAULL;
 			uint64_t py = points[i].first & 0x5555555555555555ULL;
 			if (px >= minX && px <= maxX && py >= minY && py <= maxY)  // Only add point if it's at least in the desired square.
 			{
-				lastQueryResults.push_back(points[i].second);
+				results.push_back(points[i].second);
 				if (IsFiltered)
 				{
-					lastFilteredQueryIndices.push_back(i);
+					indices->push_back(i);
 				}
 #ifdef DUMP_IMAGE
 				if (doDump)
@@ -266,31 +306,31 @@ PointTree::ResultVector &PointTree::queryMaybeFilter(Filter &filter, int32_t min
 		fclose(f);
 	}
 #endif //DUMP_IMAGE
-
-	return lastQueryResults;
 }
 
-PointTree::ResultVector &PointTree::query(int32_t x, int32_t y, uint32_t x2, uint32_t y2)
+void PointTree::query(ResultVector &results, int32_t x, int32_t y, uint32_t x2, uint32_t y2) const
 {
-	Filter unused;
-	return queryMaybeFilter<false>(unused, x, y, x2, y2);
+	queryMaybeFilter<false>(results, nullptr, nullptr, x, y, x2, y2);
 }
 
-PointTree::ResultVector &PointTree::query(int32_t x, int32_t y, uint32_t radius)
+void PointTree::query(ResultVector &results, int32_t x, int32_t y, uint32_t radius) const
 {
-	Filter unused;
 	int32_t minXo = x - radius;
 	int32_t maxXo = x + radius;
 	int32_t minYo = y - radius;
 	int32_t maxYo = y + radius;
-	return queryMaybeFilter<false>(unused, minXo, minYo, maxXo, maxYo);
+	queryMaybeFilter<false>(results, nullptr, nullptr, minXo, minYo, maxXo, maxYo);
 }
 
-PointTree::ResultVector &PointTree::query(Filter &filter, int32_t x, int32_t y, uint32_t radius)
+void PointTree::query(ResultVector &results, IndexVector &indices, Filter &filter, int32_t x, int32_t y, uint32_t radius) const
 {
+	if (filter.generation != generation)
+	{
+		filter.reset(*this);
+	}
 	int32_t minXo = x - radius;
 	int32_t maxXo = x + radius;
 	int32_t minYo = y - radius;
 	int32_t maxYo = y + radius;
-	return queryMaybeFilter<true>(filter, minXo, minYo, maxXo, maxYo);
+	queryMaybeFilter<true>(results, &indices, &filter, minXo, minYo, maxXo, maxYo);
 }
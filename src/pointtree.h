@@ -30,14 +30,15 @@ class PointTree
 public:
 	typedef std::vector<void *> ResultVector;
 	typedef std::vector<unsigned> IndexVector;
-	class Filter  ///< Filters are invalidated when modifying the PointTree.
+	class Filter  ///< Filters are reset automatically, when used after sorting the PointTree again.
 	{
 	public:
-		Filter() : data(1) {}  ///< Must be reset before use.
-		Filter(PointTree const &pointTree) : data(pointTree.points.size() + 1) {}
+		Filter() : data(1) {}
+		Filter(PointTree const &pointTree) : data(pointTree.points.size() + 1), generation(pointTree.generation) {}
 		void reset(PointTree const &pointTree)
 		{
 			data.assign(pointTree.points.size() + 1, 0);
+			generation = pointTree.generation;
 		}
 		void erase(unsigned index)
 		{
@@ -50,33 +51,53 @@ public:
 		typedef std::vector<unsigned> Data;
 
 		Data data;
+		unsigned generation = 0;  ///< PointTree::generation when last reset.
 	};
 
-	void insert(void *pointData, int32_t x, int32_t y);                       ///< Inserts a point into the point tree.
-	void clear();                                                             ///< Clears the PointTree.
+	/// Inserts a point into the point tree. Points in the same place are sorted by order, which must be unique.
+	void insert(void *pointData, int32_t x, int32_t y, uint32_t order);
+	/// Inserts a point, which is expected to be the same as the one inserted in the same sequence before the last sort(), most of the time.
+	/// If all static points are the same, sort() reuses their sorted order instead of sorting them again.
+	void insertStatic(void *pointData, int32_t x, int32_t y, uint32_t order);
+	void clear();                                                             ///< Clears the PointTree, before inserting all points again.
 	void sort();                                                              ///< Must be done between inserting and querying, to get meaningful results.
-	/// Returns all points less than or equal to radius from (x, y), possibly plus some extra nearby points.
+	/// Sets results to all points less than or equal to radius from (x, y), possibly plus some extra nearby points.
 	/// (More specifically, returns all objects in a square with edge length 2*radius.)
-	/// Note: Not thread safe, because it modifies lastQueryResults.
-	ResultVector &query(int32_t x, int32_t y, uint32_t radius);
-	/// Returns all points which have not been filtered away, less than or equal to radius from (x, y), possibly plus some extra nearby points.
+	/// Thread safe, as long as the PointTree isn't modified at the same time. Doesn't allocate, if results already has enough capacity.
+	void query(ResultVector &results, int32_t x, int32_t y, uint32_t radius) const;
+	/// Sets results to all points which have not been filtered away, less than or equal to radius from (x, y), possibly plus some extra nearby points,
+	/// and indices to their indices, for erasing them from the filter.
 	/// (More specifically, returns objects in a square with edge length 2*radius.)
-	/// Note: Not thread safe, because it modifies lastQueryResults, lastFilteredQueryIndices and the internal filter representation for faster lookups.
-	ResultVector &query(Filter &filter, int32_t x, int32_t y, uint32_t radius);
-	/// Returns all points which have not been filtered away within given rectangle. See function above on thread safety.
-	ResultVector &query(int32_t x, int32_t y, uint32_t x2, uint32_t y2);
-
-	ResultVector lastQueryResults;
-	IndexVector lastFilteredQueryIndices;
+	/// Thread safe, if each thread uses its own filter, since this modifies the internal filter representation for faster lookups.
+	void query(ResultVector &results, IndexVector &indices, Filter &filter, int32_t x, int32_t y, uint32_t radius) const;
+	/// Sets results to all points within given rectangle. See functions above on thread safety.
+	void query(ResultVector &results, int32_t x, int32_t y, uint32_t x2, uint32_t y2) const;
 
 private:
 	typedef std::pair<uint64_t, void *> Point;
 	typedef std::vector<Point> Vector;
 
+	struct OrderedPoint
+	{
+		bool operator ==(OrderedPoint const &b) const { return key == b.key && order == b.order && data == b.data; }
+		bool operator <(OrderedPoint const &b) const { return key < b.key || (key == b.key && order < b.order); }
+
+		uint64_t key;
+		uint32_t order;
+		void *data;
+	};
+	typedef std::vector<OrderedPoint> OrderedVector;
+
 	template<bool IsFiltered>
-	ResultVector &queryMaybeFilter(Filter &filter, int32_t minXo, int32_t maxXo, int32_t minYo, int32_t maxYo);
+	void queryMaybeFilter(ResultVector &results, IndexVector *indices, Filter *filter, int32_t minXo, int32_t maxXo, int32_t minYo, int32_t maxYo) const;
 
-	Vector points;
+	Vector points;                  ///< All points, sorted by position, then by order.
+	OrderedVector dynamicPoints;    ///< Points inserted with insert() since clear().
+	OrderedVector staticPoints;     ///< Points inserted with insertStatic(), in insertion order.
+	OrderedVector sortedStaticPoints;
+	size_t numStaticPoints = 0;     ///< Points inserted with insertStatic() since clear().
+	bool staticPointsChanged = true;
+	unsigned generation = 1;        ///< Incremented by sort(), to invalidate filters.
 };
 
 #endif //_point_tree_h
@@ -58,6 +58,7 @@
 #include "modding.h"
 #include "version.h"
 #include "game.h"
+#include "wrappers.h"
 #include "warzoneconfig.h"
 #include "challenge.h"
 #include "multistat.h"
@@ -65,6 +66,8 @@
 #include "campaigninfo.h"
 #include "hci/quickchat.h"
 
+#include <algorithm>
+#include <functional>
 #include <set>
 #include <memory>
 #include <utility>
@@ -197,6 +200,7 @@ void scripting_engine::timerNode::swap(timerNode& _rhs)
 	std::swap(player, _rhs.player);
 	std::swap(calls, _rhs.calls);
 	std::swap(type, _rhs.type);
+	std::swap(order, _rhs.order);
 }
 
 scripting_engine::area_by_values_or_area_label_lookup::area_by_values_or_area_label_lookup() { }
@@ -232,8 +236,7 @@ uniqueTimerID scripting_engine::setTimer(wzapi::scripting_instance *caller, cons
 	}
 	node->type = type;
 	node->timerID = newTimerID;
-	auto inserted_iter = timers.emplace(timers.end(), std::move(node));
-	timerIDMap[newTimerID] = inserted_iter;
+	addTimerNode(std::move(node));
 	return newTimerID;
 }
 
@@ -241,8 +244,45 @@ uniqueTimerID scripting_engine::setTimer(wzapi::scripting_instance *caller, cons
 void scripting_engine::addTimerNode(std::shared_ptr<scripting_engine::timerNode>&& node)
 {
 	ASSERT(timerIDMap.count(node->timerID) == 0, "Duplicate timerID found: %s", WzString::number(node->timerID).toUtf8().c_str());
+	node->order = ++lastTimerOrder;
 	auto inserted_iter = timers.emplace(timers.end(), std::move(node));
-	timerIDMap[(*inserted_iter)->timerID] = inserted_iter;
+	const timerNode &inserted = **inserted_iter;
+	timerIDMap[inserted.timerID] = inserted_iter;
+	if (inserted.baseobj >= 0)
+	{
+		objectTimerIDs.emplace(inserted.baseobj, inserted.timerID);
+	}
+	if (inserted.type == TIMER_ONESHOT_DONE)
+	{
+		doneTimerIDs.push_back(inserted.timerID); // restored from a save after running, but before being removed
+	}
+	else
+	{
+		scheduleTimer(inserted);
+	}
+}
+
+void scripting_engine::scheduleTimer(const timerNode &node)
+{
+	timerQueue.push_back(timerQueueEntry{node.frameTime, node.order, node.timerID});
+	std::push_heap(timerQueue.begin(), timerQueue.end(), std::greater<timerQueueEntry>());
+}
+
+void scripting_engine::unindexTimer(const timerNode &node)
+{
+	if (node.baseobj < 0)
+	{
+		return;
+	}
+	auto range = objectTimerIDs.equal_range(node.baseobj);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		if (it->second == node.timerID)
+		{
+			objectTimerIDs.erase(it);
+			return;
+		}
+	}
 }
 
 /// Scripting engine (what others call the scripting context, but QtScript's nomenclature is different).
@@ -271,10 +311,14 @@ typedef struct monitor_bin
 	int overMaxTimeCalls;
 	int overHalfMaxTimeCalls;
 	uint64_t time;
-	monitor_bin() : worst(0),  worstGameTime(0), calls(0), overMaxTimeCalls(0), overHalfMaxTimeCalls(0), time(0) {}
+	int timerCalls;
+	uint64_t allocations;
+	monitor_bin() : worst(0),  worstGameTime(0), calls(0), overMaxTimeCalls(0), overHalfMaxTimeCalls(0), time(0), timerCalls(0), allocations(0) {}
 } MONITOR_BIN;
 typedef std::unordered_map<std::string, MONITOR_BIN> MONITOR;
 static std::unordered_map<wzapi::scripting_instance *, MONITOR *> monitors;
+/// Calls taking longer than this (in microseconds) are logged as warnings, 0 = disabled
+static uint32_t callWarningThreshold = 0;
 
 static bool globalDialog = false;
 
@@ -364,21 +408,104 @@ bool scripting_engine::removeTimer(uniqueTimerID timerID)
 	auto it = timerIDMap.find(timerID);
 	if (it != timerIDMap.end())
 	{
-		(*it->second)->type = TIMER_REMOVED; // in case a timer is removed while running timers
+		std::shared_ptr<timerNode> node = *it->second; // keep alive until unindexed
+		node->type = TIMER_REMOVED; // in case a timer is removed while running timers
 		timers.erase(it->second);
 		timerIDMap.erase(it);
+		unindexTimer(*node);
 		return true;
 	}
 	return false;
 }
 
+void scripting_engine::removeObjectTimers(int objectID)
+{
+	auto range = objectTimerIDs.equal_range(objectID);
+	if (range.first == range.second)
+	{
+		return;
+	}
+	std::vector<std::pair<uint64_t, uniqueTimerID>> objectTimers;
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		objectTimers.emplace_back((*timerIDMap.at(it->second))->order, it->second);
+	}
+	std::sort(objectTimers.begin(), objectTimers.end()); // remove in list order, like removeTimersIf()
+	for (const auto &objectTimer : objectTimers)
+	{
+		removeTimer(objectTimer.second);
+	}
+}
+
+bool scripting_engine::timersSelfCheck()
+{
+	auto addTimer = [this](const std::string &name, int objectID) {
+		auto node = std::make_shared<timerNode>(nullptr, [](uniqueTimerID, BASE_OBJECT *, timerAdditionalData *) {}, name, 0, 100);
+		node->timerID = getNextAvailableTimerID();
+		node->baseobj = objectID;
+		node->baseobjtype = (objectID >= 0) ? OBJ_DROID : OBJ_NUM_TYPES;
+		addTimerNode(std::move(node));
+	};
+	// Whether exactly the named timers are left, in the order they were added, and all indexes agree with the list
+	auto timersAre = [this](const std::vector<std::string> &names) -> bool {
+		if (timers.size() != names.size() || timerIDMap.size() != names.size())
+		{
+			return false;
+		}
+		size_t i = 0;
+		size_t objectTimerCount = 0;
+		for (const auto &node : timers)
+		{
+			auto it = timerIDMap.find(node->timerID);
+			if (node->timerName != names[i++] || it == timerIDMap.end() || *it->second != node)
+			{
+				return false;
+			}
+			if (node->baseobj >= 0)
+			{
+				auto range = objectTimerIDs.equal_range(node->baseobj);
+				if (std::none_of(range.first, range.second, [&node](const std::pair<const int, uniqueTimerID> &entry) { return entry.second == node->timerID; }))
+				{
+					return false;
+				}
+				++objectTimerCount;
+			}
+		}
+		return objectTimerIDs.size() == objectTimerCount;
+	};
+
+	addTimer("a", 7);
+	addTimer("b", 7);
+	addTimer("c", -1);
+	addTimer("d", 8);
+	addTimer("e", 7);
+	bool ok = timersAre({"a", "b", "c", "d", "e"});
+	ok = ok && removeTimersIf([](const timerNode &node) { return node.timerName == "b"; }).size() == 1 && timersAre({"a", "c", "d", "e"});
+	ok = ok && removeTimersIf([](const timerNode &node) { return node.timerName == "c" || node.timerName == "d"; }).size() == 2 && timersAre({"a", "e"});
+	addTimer("f", 8);
+	removeObjectTimers(7);
+	ok = ok && timersAre({"f"});
+	ok = ok && removeTimersIf([](const timerNode &) { return true; }).size() == 1 && timersAre({});
+
+	timers.clear();
+	timerIDMap.clear();
+	timerQueue.clear();
+	doneTimerIDs.clear();
+	objectTimerIDs.clear();
+	lastTimerID = 0;
+	lastTimerOrder = 0;
+	return ok;
+}
+
 void scriptRemoveObject(const BASE_OBJECT *psObj)
 {
 	// Weed out timers with dead objects
-	scripting_engine::instance().removeTimersIf([psObj](const scripting_engine::timerNode& node)
+	// Scripts may still hold the object, so let them keep its last state
+	for (auto *instance : scripts)
 	{
-		return (node.baseobj == psObj->id);
-	});
+		instance->updateObjectRemoved(psObj);
+	}
+	scripting_engine::instance().removeObjectTimers(psObj->id);
 	scripting_engine::instance().groupRemoveObject(psObj);
 }
 
@@ -416,12 +543,16 @@ bool scripting_engine::shutdownScripts()
 	scriptsReady = false;
 	jsDebugShutdown();
 	globalDialog = false;
+	if (!scripts.empty() && (autogame_enabled() || headlessGameMode()))
+	{
+		saveJSONToFile(performanceDataJSON(), "logs/scriptperformance.json");
+	}
 	for (auto *instance : scripts)
 	{
 		MONITOR *monitor = monitors.at(instance);
 		WzString scriptName = WzString::fromUtf8(instance->scriptName());
 		instance->dumpScriptLog("=== PERFORMANCE DATA ===\n");
-		instance->dumpScriptLog("    calls | avg (usec) | worst (usec) | worst call at | >=limit | >=limit/2 | function\n");
+		instance->dumpScriptLog("    calls | avg (usec) | worst (usec) | worst call at | >=limit | >=limit/2 | allocs | function\n");
 		for (MONITOR::const_iterator iter = monitor->begin(); iter != monitor->end(); ++iter)
 		{
 			const std::string &function = iter->first;
@@ -433,7 +564,8 @@ bool scripting_engine::shutdownScripts()
 			info << std::right << std::setw(13) << m.worstGameTime << " | ";
 			info << std::right << std::setw(7) << m.overMaxTimeCalls << " | ";
 			info << std::right << std::setw(9) << m.overHalfMaxTimeCalls << " | ";
-			info << function << "\n";
+			info << std::right << std::setw(6) << m.allocations << " | ";
+			info << function << (m.timerCalls > 0 ? " (timer)" : "") << "\n";
 			instance->dumpScriptLog(info.str());
 		}
 		monitor->clear();
@@ -442,7 +574,11 @@ bool scripting_engine::shutdownScripts()
 	}
 	timers.clear();
 	lastTimerID = 0;
+	lastTimerOrder = 0;
 	timerIDMap.clear();
+	timerQueue.clear();
+	doneTimerIDs.clear();
+	objectTimerIDs.clear();
 	monitors.clear();
 	for (auto& script : scripts)
 	{
@@ -475,25 +611,63 @@ bool scripting_engine::updateScripts()
 		instance->updateGameTime(gameTime);
 	}
 	// Weed out dead timers
-	removeTimersIf([](const timerNode& node)
+	std::vector<uniqueTimerID> doneTimers;
+	std::swap(doneTimers, doneTimerIDs);
+	for (uniqueTimerID timerID : doneTimers)
 	{
-		return (node.type == TIMER_ONESHOT_DONE);
-	});
+		auto it = timerIDMap.find(timerID);
+		if (it != timerIDMap.end() && (*it->second)->type == TIMER_ONESHOT_DONE) // the id may have been reused, if the timer was removed already
+		{
+			removeTimer(timerID);
+		}
+	}
 	// Check for timers, and run them if applicable.
-	// TODO - load balancing
 	std::vector<std::shared_ptr<timerNode>> runlist; // make a new list here, since we might trample all over the timer list during execution
-	for (auto &node : timers)
+	while (!timerQueue.empty() && timerQueue.front().frameTime <= gameTime)
 	{
-		if (node->frameTime <= gameTime)
+		const timerQueueEntry entry = timerQueue.front();
+		std::pop_heap(timerQueue.begin(), timerQueue.end(), std::greater<timerQueueEntry>());
+		timerQueue.pop_back();
+		auto it = timerIDMap.find(entry.timerID);
+		if (it == timerIDMap.end() || (*it->second)->order != entry.order || (*it->second)->frameTime != entry.frameTime)
 		{
-			node->frameTime = node->ms + gameTime;	// update for next invokation
-			if (node->type == TIMER_ONESHOT_READY)
+			continue; // timer was removed or rescheduled since
+		}
+		runlist.push_back(*it->second);
+	}
+	// Run due timers in the order they were added, as if checking the whole list
+	std::sort(runlist.begin(), runlist.end(), [](const std::shared_ptr<timerNode> &a, const std::shared_ptr<timerNode> &b) {
+		return a->order < b->order;
+	});
+	for (auto &node : runlist)
+	{
+		node->frameTime = node->ms + gameTime;	// update for next invokation
+		if (node->type == TIMER_ONESHOT_READY)
+		{
+			node->type = TIMER_ONESHOT_DONE; // unless there is none
+		}
+		node->calls++;
+		if (node->type == TIMER_ONESHOT_DONE)
+		{
+			doneTimerIDs.push_back(node->timerID);
+		}
+		else
+		{
+			scheduleTimer(*node);
+		}
+	}
+	// Drop entries of removed timers, if they pile up
+	if (timerQueue.size() > timers.size() * 2 + 64)
+	{
+		timerQueue.clear();
+		for (const auto &node : timers)
+		{
+			if (node->type != TIMER_ONESHOT_DONE)
 			{
-				node->type = TIMER_ONESHOT_DONE; // unless there is none
+				timerQueue.push_back(timerQueueEntry{node->frameTime, node->order, node->timerID});
 			}
-			node->calls++;
-			runlist.push_back(node);
 		}
+		std::make_heap(timerQueue.begin(), timerQueue.end(), std::greater<timerQueueEntry>());
 	}
 
 	for (auto &node : runlist)
@@ -504,7 +678,9 @@ bool scripting_engine::updateScripts()
 		{
 			continue; // skip
 		}
+		dispatchingTimer = true;
 		node->function(node->timerID, IdToObject(node->baseobjtype, node->baseobj, node->player), node->additionalTimerFuncParam.get());
+		dispatchingTimer = false;
 	}
 
 	return true;
@@ -911,6 +1087,91 @@ std::vector<scripting_engine::timerNodeSnapshot> scripting_engine::debug_GetTime
 	return debug_timer_snapshot;
 }
 
+std::vector<scripting_engine::functionPerformanceSnapshot> scripting_engine::debug_GetPerformanceSnapshot() const
+{
+	std::vector<scripting_engine::functionPerformanceSnapshot> debug_performance_snapshot;
+	for (auto *instance : scripts)
+	{
+		auto it = monitors.find(instance);
+		if (it == monitors.end())
+		{
+			continue;
+		}
+		for (const auto &entry : *(it->second))
+		{
+			const MONITOR_BIN &m = entry.second;
+			functionPerformanceSnapshot snapshot;
+			snapshot.instance = instance;
+			snapshot.function = entry.first;
+			snapshot.calls = m.calls;
+			snapshot.timerCalls = m.timerCalls;
+			snapshot.time = m.time;
+			snapshot.worst = m.worst;
+			snapshot.worstGameTime = m.worstGameTime;
+			snapshot.overMaxTimeCalls = m.overMaxTimeCalls;
+			snapshot.overHalfMaxTimeCalls = m.overHalfMaxTimeCalls;
+			snapshot.allocations = m.allocations;
+			debug_performance_snapshot.push_back(std::move(snapshot));
+		}
+	}
+	// most expensive first
+	std::stable_sort(debug_performance_snapshot.begin(), debug_performance_snapshot.end(), [](const functionPerformanceSnapshot &a, const functionPerformanceSnapshot &b) {
+		return a.time > b.time;
+	});
+	return debug_performance_snapshot;
+}
+
+nlohmann::json scripting_engine::performanceDataJSON() const
+{
+	const auto snapshot = debug_GetPerformanceSnapshot();
+	nlohmann::json instances = nlohmann::json::array();
+	for (auto *instance : scripts)
+	{
+		nlohmann::json functions = nlohmann::json::array();
+		int calls = 0;
+		uint64_t time = 0;
+		uint64_t allocations = 0;
+		for (const auto &entry : snapshot)
+		{
+			if (entry.instance != instance)
+			{
+				continue;
+			}
+			nlohmann::json function = nlohmann::json::object();
+			function["function"] = entry.function;
+			function["calls"] = entry.calls;
+			function["timerCalls"] = entry.timerCalls;
+			function["eventCalls"] = entry.calls - entry.timerCalls;
+			function["timeUs"] = entry.time;
+			function["avgUs"] = (entry.calls > 0) ? entry.time / entry.calls : 0;
+			function["worstUs"] = entry.worst;
+			function["worstGameTime"] = entry.worstGameTime;
+			function["overLimitCalls"] = entry.overMaxTimeCalls;
+			function["overHalfLimitCalls"] = entry.overHalfMaxTimeCalls;
+			function["allocations"] = entry.allocations;
+			functions.push_back(std::move(function));
+			calls += entry.calls;
+			time += entry.time;
+			allocations += entry.allocations;
+		}
+		nlohmann::json result = nlohmann::json::object();
+		result["script"] = instance->scriptName();
+		result["path"] = instance->scriptPath();
+		result["player"] = instance->player();
+		result["calls"] = calls;
+		result["timeUs"] = time;
+		result["allocations"] = allocations;
+		result["functions"] = std::move(functions);
+		instances.push_back(std::move(result));
+	}
+	nlohmann::json result = nlohmann::json::object();
+	result["gameTime"] = gameTime;
+	result["limitUs"] = MAX_US;
+	result["warningThresholdUs"] = callWarningThreshold;
+	result["instances"] = std::move(instances);
+	return result;
+}
+
 void jsAutogameSpecific(const WzString &name, int player, AIDifficulty difficulty)
 {
 	wzapi::scripting_instance* instance = loadPlayerScript(name, player, difficulty);
@@ -1462,21 +1723,24 @@ bool triggerEventSeen(BASE_OBJECT *psViewer, BASE_OBJECT *psSeen)
 bool scripting_engine::triggerEventSeen(BASE_OBJECT *psViewer, BASE_OBJECT *psSeen)
 {
 	ASSERT(scriptsReady, "Scripts not initialized yet");
-	if (!psSeen || !psViewer) { return true; }
+	if (!psSeen || !psViewer) { return false; }
+	bool triggered = false;
 	for (auto *instance : scripts)
 	{
 		std::pair<bool, int> callbacks = scripting_engine::instance().seenLabelCheck(instance, psSeen, psViewer);
 		if (callbacks.first)
 		{
 			instance->handle_eventObjectSeen(psViewer, psSeen);
+			triggered = true;
 		}
 		if (callbacks.second)
 		{
 			int groupId = callbacks.second;
 			instance->handle_eventGroupSeen(psViewer, groupId);
+			triggered = true;
 		}
 	}
-	return true;
+	return triggered;
 }
 
 //__ ## eventObjectTransfer(object, from)
@@ -2560,7 +2824,8 @@ generic_script_object scripting_engine::getObject(WZAPI_PARAMS(wzapi::object_req
 		OBJECT_TYPE type = std::get<0>(type_player_id);
 		int player = std::get<1>(type_player_id);
 		int id = std::get<2>(type_player_id);
-		SCRIPT_ASSERT_PLAYER({}, context, player);
+		// features are owned by PLAYER_FEATURE, which is what enumFeature() and the other enum functions report
+		SCRIPT_ASSERT({}, context, (player >= 0 && player < MAX_PLAYERS) || (type == OBJ_FEATURE && player == PLAYER_FEATURE), "Invalid player index %d", player);
 		return generic_script_object::fromObject(IdToObject(type, id, player));
 	}
 	else if (request.requestType == wzapi::object_request::RequestType::LABEL_REQUEST)
@@ -2653,14 +2918,9 @@ std::vector<const BASE_OBJECT *> scripting_engine::_enumAreaWorldCoords(WZAPI_PA
 	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
 	{
 		BASE_OBJECT *psObj = *gi;
-		if ((psObj->visible[player] || !seen) && !psObj->died)
+		if (wzapi::enumObjectPasses(psObj, player, playerFilter, seen))
 		{
-			if ((playerFilter >= 0 && psObj->player == playerFilter) || playerFilter == ALL_PLAYERS
-			    || (playerFilter == ALLIES && psObj->type != OBJ_FEATURE && aiCheckAlliances(psObj->player, player))
-			    || (playerFilter == ENEMIES && psObj->type != OBJ_FEATURE && !aiCheckAlliances(psObj->player, player)))
-			{
-				list.push_back(psObj);
-			}
+			list.push_back(psObj);
 		}
 	}
 	return list;
@@ -2682,6 +2942,50 @@ std::vector<const BASE_OBJECT *> scripting_engine::enumAreaJS(WZAPI_PARAMS(scrip
 	}
 }
 
+//-- ## enumAreaByType(areas, objectType[, playerFilter[, seen]])
+//--
+//-- Does the same as calling ```enumArea()``` for each of the given areas, but in one call, and only returns
+//-- objects of the given type, which can be one of ```DROID```, ```STRUCTURE``` or ```FEATURE```. The areas are
+//-- an array of area labels, or objects with x, y, x2 and y2 properties, like area labels returned by
+//-- ```getObject()```. A single area may be given instead of an array. Like ```enumRangeMulti()```, this returns an
+//-- object of typed arrays describing the objects found: ```ids```, ```types``` and ```players```, where the objects
+//-- found in the i-th area are those from index ```offsets[i]``` up to ```offsets[i + 1]```. (4.7.0+ only)
+//--
+wzapi::object_id_lists scripting_engine::enumAreaByType(WZAPI_PARAMS(scripting_engine::area_lookups areas, int objectType, optional<int> _playerFilter, optional<bool> _seen))
+{
+	int player = context.player();
+	int playerFilter = _playerFilter.value_or(ALL_PLAYERS);
+	bool seen = _seen.value_or(true);
+
+	SCRIPT_ASSERT({}, context, (playerFilter >= 0 && playerFilter < MAX_PLAYERS) || playerFilter == ALL_PLAYERS || playerFilter == ALLIES || playerFilter == ENEMIES, "Filter player index out of range: %d", playerFilter);
+	SCRIPT_ASSERT({}, context, objectType == OBJ_DROID || objectType == OBJ_STRUCTURE || objectType == OBJ_FEATURE, "Invalid object type: %d", objectType);
+
+	wzapi::object_id_lists lists;
+	lists.offsets.reserve(areas.areas.size() + 1);
+	static GridList gridList;  // static to avoid allocations. // not thread-safe
+	for (auto &area_lookup : areas.areas)
+	{
+		lists.offsets.push_back(static_cast<int32_t>(lists.ids.size()));
+		if (area_lookup.isLabel())
+		{
+			const std::string label = area_lookup.label().value();
+			auto it = instance().labels.find(label);
+			SCRIPT_ASSERT({}, context, it != instance().labels.end(), "Label %s not found", label.c_str());
+			const LABEL &p = it->second;
+			SCRIPT_ASSERT({}, context, p.type == SCRIPT_AREA, "Wrong label type for %s", label.c_str());
+			gridStartIterateArea(p.p1.x, p.p1.y, p.p2.x, p.p2.y, gridList);
+		}
+		else
+		{
+			scr_area area = area_lookup.area().value();
+			gridStartIterateArea(world_coord(area.x1), world_coord(area.y1), world_coord(area.x2), world_coord(area.y2), gridList);
+		}
+		wzapi::appendEnumObjects(lists, gridList, player, playerFilter, seen, objectType);
+	}
+	lists.offsets.push_back(static_cast<int32_t>(lists.ids.size()));
+	return lists;
+}
+
 //-- ## enumGroup(groupId)
 //--
 //-- Return an array containing all the members of a given group.
@@ -2849,7 +3153,12 @@ wzapi::no_return_value scripting_engine::hackMarkTiles_ByLabel(WZAPI_PARAMS(cons
 	return {};
 }
 
-void scripting_engine::logFunctionPerformance(wzapi::scripting_instance *instance, const std::string &function, int ticks)
+void scriptSetCallWarningThreshold(uint32_t microseconds)
+{
+	callWarningThreshold = microseconds;
+}
+
+void scripting_engine::logFunctionPerformance(wzapi::scripting_instance *instance, const std::string &function, int ticks, uint64_t allocations, bool timer)
 {
 	MONITOR *monitor = monitors.at(instance); // pick right one for this instance
 	MONITOR_BIN m;
@@ -2867,7 +3176,17 @@ void scripting_engine::logFunctionPerformance(wzapi::scripting_instance *instanc
 	{
 		m.overHalfMaxTimeCalls++;
 	}
+	if (callWarningThreshold > 0 && ticks > static_cast<int>(callWarningThreshold))
+	{
+		debug(LOG_WARNING, "%s:%d: %s %s took %dus (threshold: %uus), %" PRIu64 " allocations, at game time %u",
+		      instance->scriptName().c_str(), instance->player(), timer ? "timer" : "event", function.c_str(), ticks, callWarningThreshold, allocations, gameTime);
+	}
 	m.calls++;
+	if (timer)
+	{
+		m.timerCalls++;
+	}
+	m.allocations += allocations;
 	if (ticks > m.worst)
 	{
 		m.worst = ticks;
@@ -2887,6 +3206,10 @@ std::vector<scripting_engine::timerNodeSnapshot> scripting_engine::DebugInterfac
 {
 	return scripting_engine::instance().debug_GetTimersSnapshot();
 }
+std::vector<scripting_engine::functionPerformanceSnapshot> scripting_engine::DebugInterface::debug_GetPerformanceSnapshot() const
+{
+	return scripting_engine::instance().debug_GetPerformanceSnapshot();
+}
 std::vector<scripting_engine::LabelInfo> scripting_engine::DebugInterface::debug_GetLabelInfo() const
 {
 	return scripting_engine::instance().debug_GetLabelInfo();
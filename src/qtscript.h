@@ -91,6 +91,8 @@ extern bool bInTutorial;
 bool scriptInit();
 void scriptSetStartPos(int position, int x, int  y);
 void scriptSetDerrickPos(int x, int y);
+/// Log a warning for every script function call that takes longer than this (0 disables the warning)
+void scriptSetCallWarningThreshold(uint32_t microseconds);
 Vector2i getPlayerStartPosition(int player);
 
 /// Initialize script system
@@ -140,6 +142,7 @@ bool triggerEventDestroyed(BASE_OBJECT *psVictim);
 bool triggerEventStructureReady(STRUCTURE *psStruct);
 bool triggerEventStructureUpgradeStarted(STRUCTURE *psStruct);
 bool triggerEventDroidRankGained(const DROID *psDroid, int rankNum);
+/// Returns whether any script event was run, since that may have changed the game state.
 bool triggerEventSeen(BASE_OBJECT *psViewer, BASE_OBJECT *psSeen);
 bool triggerEventObjectTransfer(BASE_OBJECT *psObj, int from);
 bool triggerEventChat(int from, int to, const char *message);
@@ -264,6 +267,7 @@ public:
 		int player;
 		int calls;
 		timerType type;
+		uint64_t order = 0; // order of adding to the timers list, which is the order of running timers due at the same time
 		timerNode() : instance(nullptr), baseobjtype(OBJ_NUM_TYPES), additionalTimerFuncParam(nullptr) {}
 		timerNode(wzapi::scripting_instance* caller, const TimerFunc& func, const std::string& timerName, int plr, int frame, std::unique_ptr<timerAdditionalData> additionalParam = nullptr);
 		~timerNode();
@@ -289,12 +293,28 @@ private:
 	typedef std::map<wzapi::scripting_instance *, GROUPMAP *> ENGINEMAP;
 	ENGINEMAP groups;
 
-	/// List of timer events for scripts. Before running them, we sort the list then run as many as we have time for.
-	/// In this way, we implement load balancing of events and keep frame rates tidy for users. Since scripts run on the
-	/// host, we do not need to worry about each peer simulating the world differently.
+	/// List of timer events for scripts, in the order they were added.
 	std::list<std::shared_ptr<timerNode>> timers;
 	uniqueTimerID lastTimerID = 0;
+	uint64_t lastTimerOrder = 0;
+	// Set while a timer function is being called, so the performance monitor can tell timers from events
+	bool dispatchingTimer = false;
 	std::unordered_map<uniqueTimerID, std::list<std::shared_ptr<timerNode>>::iterator> timerIDMap; // a map from uniqueTimerID -> entry in the timers list
+	struct timerQueueEntry
+	{
+		int frameTime;
+		uint64_t order;
+		uniqueTimerID timerID;
+		bool operator >(const timerQueueEntry &other) const
+		{
+			return frameTime != other.frameTime ? frameTime > other.frameTime : order > other.order;
+		}
+	};
+	/// Min-heap of when timers are next due, so that updateScripts() doesn't need to check every timer. Entries are not
+	/// removed when their timer is removed or rescheduled, but skipped when they no longer match the timer.
+	std::vector<timerQueueEntry> timerQueue;
+	std::vector<uniqueTimerID> doneTimerIDs; // one-shot timers which have run, to remove on the next update
+	std::unordered_multimap<int, uniqueTimerID> objectTimerIDs; // a map from object id -> timers with that object
 private:
 	scripting_engine() { }
 public:
@@ -339,40 +359,56 @@ public:
 	std::vector<uniqueTimerID> removeTimersIf(UnaryPredicate _pred)
 	{
 		std::vector<uniqueTimerID> removedTimerIDs;
-		timers.remove_if([_pred, &removedTimerIDs](const std::shared_ptr<timerNode>& node) {
+		std::vector<std::shared_ptr<timerNode>> removedTimers; // keep alive until unindexed
+		timers.remove_if([_pred, &removedTimerIDs, &removedTimers](const std::shared_ptr<timerNode>& node) {
 			if (_pred(*node))
 			{
 				node->type = TIMER_REMOVED; // in case a timer is removed while running timers
 				removedTimerIDs.push_back(node->timerID);
+				removedTimers.push_back(node);
 				return true;
 			}
 			return false;
 		});
-		for (const auto &timerID : removedTimerIDs)
+		// The list nodes are gone, so the iterators in timerIDMap are dangling: unindex through the retained timers
+		for (const auto &node : removedTimers)
 		{
-			timerIDMap.erase(timerID);
+			unindexTimer(*node);
+			timerIDMap.erase(node->timerID);
 		}
 		return removedTimerIDs;
 	}
 
 	bool removeTimer(uniqueTimerID timerID);
+	// removes all timers with the object
+	void removeObjectTimers(int objectID);
+	// removes timers while others are still queued, and checks the indexes of the rest; for --check-script-timers
+	// (only call before any scripts are loaded, since it clears all timers)
+	bool timersSelfCheck();
 public:
 	// Monitoring performance of function calls
 	template<typename Func>
 	void executeWithPerformanceMonitoring(wzapi::scripting_instance *instance, const std::string &function, Func f)
 	{
 		using microDuration = std::chrono::duration<uint64_t, std::micro>;
+		const bool timer = dispatchingTimer;
+		dispatchingTimer = false; // anything called from inside f is not the timer itself
+		const uint64_t allocations_begin = instance->debugGetAllocationCount();
 		auto time_begin = std::chrono::steady_clock::now();
 		f(); // execute provided Func f
 		auto duration_microsec = std::chrono::duration_cast<microDuration>(std::chrono::steady_clock::now() - time_begin);
 		int ticks = duration_microsec.count();
-		logFunctionPerformance(instance, function, ticks);
+		dispatchingTimer = timer;
+		logFunctionPerformance(instance, function, ticks, instance->debugGetAllocationCount() - allocations_begin, timer);
 	}
 private:
-	void logFunctionPerformance(wzapi::scripting_instance *instance, const std::string &function, int ticks);
+	void logFunctionPerformance(wzapi::scripting_instance *instance, const std::string &function, int ticks, uint64_t allocations, bool timer);
+	nlohmann::json performanceDataJSON() const;
 	uniqueTimerID getNextAvailableTimerID();
 	// internal-only function that adds a Timer node (used for restoring saved games)
 	void addTimerNode(std::shared_ptr<timerNode>&& node);
+	void scheduleTimer(const timerNode& node);
+	void unindexTimer(const timerNode& node);
 
 // MARK: triggering events (from wz game code)
 public:
@@ -427,6 +463,11 @@ public:
 		int y2 = -1;
 	};
 	static std::vector<const BASE_OBJECT *> enumAreaJS(WZAPI_PARAMS(area_by_values_or_area_label_lookup area_lookup, optional<int> playerFilter, optional<bool> seen));
+	struct area_lookups
+	{
+		std::vector<area_by_values_or_area_label_lookup> areas;
+	};
+	static wzapi::object_id_lists enumAreaByType(WZAPI_PARAMS(area_lookups areas, int objectType, optional<int> playerFilter, optional<bool> seen));
 
 	// Group functions
 	static std::vector<const BASE_OBJECT *> enumGroup(WZAPI_PARAMS(int groupId));
@@ -473,6 +514,20 @@ public:
 		}
 	};
 
+	struct functionPerformanceSnapshot
+	{
+		wzapi::scripting_instance* instance = nullptr;
+		std::string function;
+		int calls = 0;
+		int timerCalls = 0; // how many of the calls were made by timers, the others were events
+		uint64_t time = 0; // microseconds
+		int worst = 0;
+		uint32_t worstGameTime = 0;
+		int overMaxTimeCalls = 0;
+		int overHalfMaxTimeCalls = 0;
+		uint64_t allocations = 0;
+	};
+
 	struct LabelInfo
 	{
 		WzString label;
@@ -490,6 +545,7 @@ public:
 	public:
 		std::unordered_map<wzapi::scripting_instance *, nlohmann::json> debug_GetGlobalsSnapshot() const;
 		std::vector<scripting_engine::timerNodeSnapshot> debug_GetTimersSnapshot() const;
+		std::vector<scripting_engine::functionPerformanceSnapshot> debug_GetPerformanceSnapshot() const;
 		std::vector<scripting_engine::LabelInfo> debug_GetLabelInfo() const;
 		/// Show all labels or all currently active labels
 		void markAllLabels(bool only_active);
@@ -502,6 +558,7 @@ protected:
 
 	std::unordered_map<wzapi::scripting_instance *, nlohmann::json> debug_GetGlobalsSnapshot() const;
 	std::vector<scripting_engine::timerNodeSnapshot> debug_GetTimersSnapshot() const;
+	std::vector<scripting_engine::functionPerformanceSnapshot> debug_GetPerformanceSnapshot() const;
 	std::vector<scripting_engine::LabelInfo> debug_GetLabelInfo() const;
 
 	/// Show all labels or all currently active labels
@@ -80,6 +80,15 @@
 #include "lib/framework/file.h"
 #include <unordered_map>
 #include <limits>
+#if defined(__APPLE__)
+# include <malloc/malloc.h>
+#elif defined(__linux__) || defined(__GLIBC__)
+# include <malloc.h>
+#elif defined(__FreeBSD__)
+# include <malloc_np.h>
+#elif defined(_WIN32)
+# include <malloc.h>
+#endif
 
 #if !defined(__clang__) && defined(__GNUC__) && __GNUC__ >= 8
 #pragma GCC diagnostic push
@@ -107,8 +116,10 @@ MSVC_PRAGMA(warning( pop ))
 // QuickJS-NG / QuickJS compat
 #if defined(QUICKJS_NG)
 # define WZ_QJS_IsArray(ctx, arr) JS_IsArray(arr)
+# define WZ_QJS_NewClassID(rt, pclass_id) JS_NewClassID(rt, pclass_id)
 #else
 # define WZ_QJS_IsArray(ctx, arr) JS_IsArray(ctx, arr)
+# define WZ_QJS_NewClassID(rt, pclass_id) JS_NewClassID(pclass_id)
 #endif
 
 // Alternatives for C++ - can't use the JS_CFUNC_DEF / JS_CGETSET_DEF / etc defines
@@ -139,6 +150,19 @@ static inline JSCFunctionListEntry QJS_CGETSET_DEF(const char *name, JSCFunction
 	entry.u.getset.set.setter = fsetter;
 	return entry;
 }
+// #define JS_CGETSET_MAGIC_DEF(name, fgetter, fsetter, magic) { name, JS_PROP_CONFIGURABLE, JS_DEF_CGETSET_MAGIC, magic, .u = { .getset = { .get = { .getter_magic = fgetter }, .set = { .setter_magic = fsetter } } } }
+typedef JSValue JSCFunctionGetterMagic(JSContext *ctx, JSValueConst this_val, int magic);
+static inline JSCFunctionListEntry QJS_CGETSET_MAGIC_DEF(const char *name, JSCFunctionGetterMagic *fgetter, int16_t magic)
+{
+	JSCFunctionListEntry entry;
+	entry.name = name;
+	entry.prop_flags = JS_PROP_CONFIGURABLE;
+	entry.def_type = JS_DEF_CGETSET_MAGIC;
+	entry.magic = magic;
+	entry.u.getset.get.getter_magic = fgetter;
+	entry.u.getset.set.setter_magic = nullptr;
+	return entry;
+}
 
 struct JSToJsonContext
 {
@@ -170,6 +194,177 @@ bool QuickJS_EnumerateObjectProperties(JSContext *ctx, JSValue obj, const std::f
 class quickjs_scripting_instance;
 static std::map<JSContext*, quickjs_scripting_instance *> engineToInstanceMap;
 
+// Game objects (droids, structures and features) are given to scripts as views, which only hold the
+// object's id. Their properties are resolved from the game object the first time a script reads them,
+// then stored on the view as ordinary properties. Since the game state may change between calls into
+// the script, all properties of views which survive the call are resolved when it returns (or when
+// the object is removed from the game), so that scripts keep seeing the object as it was.
+enum ObjectViewKind
+{
+	OBJECT_VIEW_DROID,
+	OBJECT_VIEW_TRANSPORTER,
+	OBJECT_VIEW_STRUCTURE,
+	OBJECT_VIEW_FEATURE,
+	OBJECT_VIEW_KINDS
+};
+
+struct ObjectView;
+
+class ObjectViews
+{
+public:
+	void init(JSRuntime *rt, JSContext *ctx);
+	void shutdown(JSContext *ctx);
+
+	JSValue create(JSContext *ctx, const BASE_OBJECT *psObj, ObjectViewKind kind);
+	/// Returns the value of a property, and stores it on the view if not yet done.
+	JSValue get(JSContext *ctx, JSValueConst value, ObjectView &view, int field);
+	/// Stores all remaining properties on the view.
+	void resolve(JSContext *ctx, ObjectView &view);
+	void resolveAll(JSContext *ctx);
+	void resolveObject(JSContext *ctx, const BASE_OBJECT *psObj);
+	void forget(ObjectView *view);
+
+	/// Returns the string, which is only converted once for each stats name.
+	JSValue statsName(JSContext *ctx, const WzString &name);
+
+	int callDepth = 0;
+
+private:
+	void resolveViews(JSContext *ctx, std::vector<ObjectView *> &views);
+
+	JSValue protos[OBJECT_VIEW_KINDS];
+	std::vector<JSAtom> fieldAtoms;
+	JSAtom idAtom = JS_ATOM_NULL;
+	std::unordered_map<const WzString *, JSAtom> statsNames;
+	std::unordered_multimap<uint32_t, ObjectView *> unresolvedViews; ///< Views with properties not stored yet, by object id
+};
+
+// MARK: - Allocator
+
+// The same as the default QuickJS allocator, except that each runtime also counts its allocations
+// (in the counter passed as opaque), so the performance monitor can attribute them to script functions.
+
+static size_t wz_qjs_malloc_usable_size(const void *ptr)
+{
+#if defined(__APPLE__)
+	return malloc_size(ptr);
+#elif defined(_WIN32)
+	return _msize(const_cast<void *>(ptr));
+#elif defined(__EMSCRIPTEN__)
+	return 0;
+#elif defined(__linux__) || defined(__GLIBC__) || defined(__FreeBSD__)
+	return malloc_usable_size(const_cast<void *>(ptr));
+#else
+	return 0;
+#endif
+}
+
+#if defined(QUICKJS_NG)
+// QuickJS-NG does the memory accounting itself
+
+static void *wz_qjs_calloc(void *opaque, size_t count, size_t size)
+{
+	++*static_cast<uint64_t *>(opaque);
+	return calloc(count, size);
+}
+
+static void *wz_qjs_malloc(void *opaque, size_t size)
+{
+	++*static_cast<uint64_t *>(opaque);
+	return malloc(size);
+}
+
+static void wz_qjs_free(void * /*opaque*/, void *ptr)
+{
+	free(ptr);
+}
+
+static void *wz_qjs_realloc(void *opaque, void *ptr, size_t size)
+{
+	if (size == 0)
+	{
+		free(ptr);
+		return nullptr;
+	}
+	++*static_cast<uint64_t *>(opaque);
+	return realloc(ptr, size);
+}
+
+static const JSMallocFunctions wz_qjs_malloc_funcs = {
+	wz_qjs_calloc,
+	wz_qjs_malloc,
+	wz_qjs_free,
+	wz_qjs_realloc,
+	wz_qjs_malloc_usable_size
+};
+#else
+#define WZ_QJS_MALLOC_OVERHEAD 8 // same estimate as QuickJS itself
+
+static void *wz_qjs_malloc(JSMallocState *s, size_t size)
+{
+	if (s->malloc_size + size > s->malloc_limit)
+	{
+		return nullptr;
+	}
+	void *ptr = malloc(size);
+	if (!ptr)
+	{
+		return nullptr;
+	}
+	s->malloc_count++;
+	s->malloc_size += wz_qjs_malloc_usable_size(ptr) + WZ_QJS_MALLOC_OVERHEAD;
+	++*static_cast<uint64_t *>(s->opaque);
+	return ptr;
+}
+
+static void wz_qjs_free(JSMallocState *s, void *ptr)
+{
+	if (!ptr)
+	{
+		return;
+	}
+	s->malloc_count--;
+	s->malloc_size -= wz_qjs_malloc_usable_size(ptr) + WZ_QJS_MALLOC_OVERHEAD;
+	free(ptr);
+}
+
+static void *wz_qjs_realloc(JSMallocState *s, void *ptr, size_t size)
+{
+	if (!ptr)
+	{
+		return (size == 0) ? nullptr : wz_qjs_malloc(s, size);
+	}
+	const size_t old_size = wz_qjs_malloc_usable_size(ptr);
+	if (size == 0)
+	{
+		s->malloc_count--;
+		s->malloc_size -= old_size + WZ_QJS_MALLOC_OVERHEAD;
+		free(ptr);
+		return nullptr;
+	}
+	if (s->malloc_size + size - old_size > s->malloc_limit)
+	{
+		return nullptr;
+	}
+	ptr = realloc(ptr, size);
+	if (!ptr)
+	{
+		return nullptr;
+	}
+	s->malloc_size += wz_qjs_malloc_usable_size(ptr) - old_size;
+	++*static_cast<uint64_t *>(s->opaque);
+	return ptr;
+}
+
+static const JSMallocFunctions wz_qjs_malloc_funcs = {
+	wz_qjs_malloc,
+	wz_qjs_free,
+	wz_qjs_realloc,
+	wz_qjs_malloc_usable_size
+};
+#endif
+
 static void QJSRuntimeFree_LeakHandler_Error(const char* msg)
 {
 	debug(LOG_ERROR, "QuickJS FreeRuntime leak: %s", msg);
@@ -187,8 +382,8 @@ public:
 	quickjs_scripting_instance(int player, const std::string& scriptName, const std::string& scriptPath)
 	: scripting_instance(player, scriptName, scriptPath)
 	{
-		rt = JS_NewRuntime();
-		ASSERT(rt != nullptr, "JS_NewRuntime failed?");
+		rt = JS_NewRuntime2(&wz_qjs_malloc_funcs, &allocationCount);
+		ASSERT(rt != nullptr, "JS_NewRuntime2 failed?");
 
 #if defined(__SANITIZE_ADDRESS__) || QUICKJS_HAS_FEATURE(address_sanitizer)
 		#pragma message("quickjs_backend: Script stack size limit disabled due to Address Sanitizer")
@@ -213,6 +408,8 @@ public:
 
 		global_obj = JS_GetGlobalObject(ctx);
 
+		objectViews.init(rt, ctx);
+
 		engineToInstanceMap.insert(std::pair<JSContext*, quickjs_scripting_instance*>(ctx, this));
 	}
 	virtual ~quickjs_scripting_instance()
@@ -227,6 +424,7 @@ public:
 			compiledScriptObj = JS_UNINITIALIZED;
 		}
 
+		objectViews.shutdown(ctx);
 		JS_FreeValue(ctx, global_obj);
 		ASSERT(ctx != nullptr, "context is null??");
 		if (ctx)
@@ -264,10 +462,13 @@ public:
 
 	bool debugEvaluateCommand(const std::string &text) override;
 
+	uint64_t debugGetAllocationCount() const override { return allocationCount; }
+
 public:
 
 	void updateGameTime(uint32_t gameTime) override;
 	void updateGroupSizes(int group, int size) override;
+	void updateObjectRemoved(const BASE_OBJECT *psObj) override;
 
 	void setSpecifiedGlobalVariables(const nlohmann::json& variables, wzapi::GlobalVariableFlags flags = wzapi::GlobalVariableFlags::ReadOnly | wzapi::GlobalVariableFlags::DoNotSave) override;
 
@@ -292,6 +493,7 @@ public:
 	void doNotSaveGlobal(const std::string &global);
 
 private:
+	uint64_t allocationCount = 0; ///< Updated by the allocator of rt
 	JSRuntime *rt;
     JSContext *ctx;
 	JSValue global_obj;
@@ -304,6 +506,7 @@ private:
 public: // temporary
 	std::vector<std::string> eventNamespaces;
 	JSValue Get_Global_Obj() const { return global_obj; }
+	ObjectViews objectViews;
 
 public:
 	// MARK: General events
@@ -799,6 +1002,495 @@ static int QuickJS_DefinePropertyValue(JSContext *ctx, JSValueConst this_obj, co
 	return ret;
 }
 
+static JSClassID objectViewClassId = 0;
+
+struct ObjectView
+{
+	ObjectViews *owner;
+	const BASE_OBJECT *psObj;
+	uint32_t id;
+	JSValue value;     ///< Not a counted reference, the view is freed together with its value
+	uint64_t unresolved; ///< Bit mask of properties not stored on the view yet
+};
+
+enum ObjectViewField
+{
+	// all objects
+	OVF_X, OVF_Y, OVF_Z, OVF_PLAYER, OVF_ARMOUR, OVF_THERMAL, OVF_TYPE, OVF_SELECTED, OVF_NAME, OVF_BORN, OVF_GROUP,
+	// droids and structures
+	OVF_IS_CB, OVF_IS_SENSOR, OVF_IS_RADAR_DETECTOR, OVF_CAN_HIT_AIR, OVF_CAN_HIT_GROUND, OVF_HAS_INDIRECT, OVF_RANGE, OVF_COST, OVF_WEAPONS,
+	// droids, structures and features
+	OVF_HEALTH,
+	// structures and features
+	OVF_STATTYPE,
+	// structures
+	OVF_STATUS, OVF_DIRECTION, OVF_MODULES,
+	// features
+	OVF_DAMAGEABLE,
+	// droids
+	OVF_ACTION, OVF_ORDER, OVF_BODY_SIZE, OVF_IS_VTOL, OVF_IS_FLYING, OVF_DROID_TYPE, OVF_EXPERIENCE, OVF_BODY, OVF_PROPULSION, OVF_ARMED, OVF_CARGO_SIZE,
+	// transporters
+	OVF_CARGO_CAPACITY, OVF_CARGO_LEFT, OVF_CARGO_COUNT,
+	OVF_COUNT
+};
+static_assert(OVF_COUNT <= 64, "Too many object view fields for the bit masks");
+
+static const char *const objectViewFieldNames[OVF_COUNT] = {
+	"x", "y", "z", "player", "armour", "thermal", "type", "selected", "name", "born", "group",
+	"isCB", "isSensor", "isRadarDetector", "canHitAir", "canHitGround", "hasIndirect", "range", "cost", "weapons",
+	"health",
+	"stattype",
+	"status", "direction", "modules",
+	"damageable",
+	"action", "order", "bodySize", "isVTOL", "isFlying", "droidType", "experience", "body", "propulsion", "armed", "cargoSize",
+	"cargoCapacity", "cargoLeft", "cargoCount",
+};
+
+#define OVF_BIT(field) (UINT64_C(1) << (field))
+#define OVF_RANGE_BITS(first, last) (OVF_BIT((last) + 1) - OVF_BIT(first))
+
+static const uint64_t objectViewFields[OBJECT_VIEW_KINDS] = {
+	// OBJECT_VIEW_DROID
+	OVF_RANGE_BITS(OVF_X, OVF_HEALTH) | OVF_RANGE_BITS(OVF_ACTION, OVF_CARGO_SIZE),
+	// OBJECT_VIEW_TRANSPORTER
+	OVF_RANGE_BITS(OVF_X, OVF_HEALTH) | OVF_RANGE_BITS(OVF_ACTION, OVF_CARGO_COUNT),
+	// OBJECT_VIEW_STRUCTURE
+	OVF_RANGE_BITS(OVF_X, OVF_MODULES),
+	// OBJECT_VIEW_FEATURE
+	OVF_RANGE_BITS(OVF_X, OVF_GROUP) | OVF_BIT(OVF_HEALTH) | OVF_BIT(OVF_STATTYPE) | OVF_BIT(OVF_DAMAGEABLE),
+};
+
+struct ObjectWeaponSummary
+{
+	bool aa = false;
+	bool ga = false;
+	bool indirect = false;
+	int range = -1;
+};
+
+static ObjectWeaponSummary summarizeWeapons(const BASE_OBJECT *psObj)
+{
+	ObjectWeaponSummary summary;
+	for (int i = 0; i < psObj->numWeaps; i++)
+	{
+		if (psObj->asWeaps[i].nStat)
+		{
+			ASSERT(psObj->asWeaps[i].nStat < asWeaponStats.size(), "Invalid nStat (%d) referenced for asWeaps[%d]; numWeaponStats (%zu); object: \"%s\" (numWeaps: %u)", psObj->asWeaps[i].nStat, i, asWeaponStats.size(), objInfo(psObj), psObj->numWeaps);
+			WEAPON_STATS *psWeap = psObj->getWeaponStats(i);
+			summary.aa = summary.aa || psWeap->surfaceToAir & SHOOT_IN_AIR;
+			summary.ga = summary.ga || psWeap->surfaceToAir & SHOOT_ON_GROUND;
+			summary.indirect = summary.indirect || psWeap->movementModel == MM_INDIRECT || psWeap->movementModel == MM_HOMINGINDIRECT;
+			summary.range = MAX(proj_GetLongRange(*psWeap, psObj->player), summary.range);
+		}
+	}
+	return summary;
+}
+
+static JSValue convWeapons(const BASE_OBJECT *psObj, JSContext *ctx, ObjectViews &views)
+{
+	JSValue weaponlist = JS_NewArray(ctx);
+	for (int j = 0; j < psObj->numWeaps; j++)
+	{
+		JSValue weapon = JS_NewObject(ctx);
+		const WEAPON_STATS *psStats = psObj->getWeaponStats(j);
+		QuickJS_DefinePropertyValue(ctx, weapon, "fullname", views.statsName(ctx, psStats->name), JS_PROP_ENUMERABLE);
+		QuickJS_DefinePropertyValue(ctx, weapon, "name", views.statsName(ctx, psStats->id), JS_PROP_ENUMERABLE); // will be changed to contain full name
+		QuickJS_DefinePropertyValue(ctx, weapon, "id", views.statsName(ctx, psStats->id), JS_PROP_ENUMERABLE);
+		QuickJS_DefinePropertyValue(ctx, weapon, "lastFired", JS_NewUint32(ctx, psObj->asWeaps[j].lastFired), JS_PROP_ENUMERABLE);
+		if (psObj->type == OBJ_DROID)
+		{
+			QuickJS_DefinePropertyValue(ctx, weapon, "armed", JS_NewInt32(ctx, droidReloadBar(psObj, &psObj->asWeaps[j], j)), JS_PROP_ENUMERABLE);
+		}
+		JS_DefinePropertyValueUint32(ctx, weaponlist, j, weapon, JS_PROP_ENUMERABLE);
+	}
+	return weaponlist;
+}
+
+static JSValue convStructureField(const STRUCTURE *psStruct, JSContext *ctx, ObjectViews &views, int field)
+{
+	switch (field)
+	{
+	case OVF_IS_CB: return JS_NewBool(ctx, structCBSensor(psStruct));
+	case OVF_IS_SENSOR: return JS_NewBool(ctx, structStandardSensor(psStruct));
+	case OVF_IS_RADAR_DETECTOR: return JS_NewBool(ctx, objRadarDetector(psStruct));
+	case OVF_CAN_HIT_AIR: return JS_NewBool(ctx, summarizeWeapons(psStruct).aa);
+	case OVF_CAN_HIT_GROUND: return JS_NewBool(ctx, summarizeWeapons(psStruct).ga);
+	case OVF_HAS_INDIRECT: return JS_NewBool(ctx, summarizeWeapons(psStruct).indirect);
+	case OVF_RANGE: return JS_NewInt32(ctx, summarizeWeapons(psStruct).range);
+	case OVF_STATUS: return JS_NewInt32(ctx, (int)psStruct->status);
+	case OVF_HEALTH: return JS_NewInt32(ctx, 100 * psStruct->body / MAX(1, psStruct->structureBody()));
+	case OVF_COST: return JS_NewInt32(ctx, psStruct->pStructureType->powerToBuild);
+	case OVF_DIRECTION: return JS_NewInt32(ctx, static_cast<int32_t>(UNDEG(psStruct->rot.direction)));
+	case OVF_STATTYPE:
+		switch (psStruct->pStructureType->type) // don't bleed our source insanities into the scripting world
+		{
+		case REF_WALL:
+		case REF_WALLCORNER:
+		case REF_GATE:
+			return JS_NewInt32(ctx, (int)REF_WALL);
+		case REF_FORTRESS:
+		case REF_DEFENSE:
+			return JS_NewInt32(ctx, (int)REF_DEFENSE);
+		default:
+			return JS_NewInt32(ctx, (int)psStruct->pStructureType->type);
+		}
+	case OVF_MODULES:
+		if (psStruct->pStructureType->type == REF_FACTORY || psStruct->pStructureType->type == REF_CYBORG_FACTORY
+		    || psStruct->pStructureType->type == REF_VTOL_FACTORY
+		    || psStruct->pStructureType->type == REF_RESEARCH
+		    || psStruct->pStructureType->type == REF_POWER_GEN)
+		{
+			return JS_NewUint32(ctx, psStruct->capacity);
+		}
+		return JS_NULL;
+	case OVF_WEAPONS: return convWeapons(psStruct, ctx, views);
+	}
+	return JS_UNDEFINED;
+}
+
+static JSValue convFeatureField(const FEATURE *psFeature, JSContext *ctx, int field)
+{
+	const FEATURE_STATS *psStats = psFeature->psStats;
+	switch (field)
+	{
+	case OVF_HEALTH: return JS_NewUint32(ctx, 100 * psStats->body / MAX(1, psFeature->body));
+	case OVF_DAMAGEABLE: return JS_NewBool(ctx, psStats->damageable);
+	case OVF_STATTYPE: return JS_NewInt32(ctx, psStats->subType);
+	}
+	return JS_UNDEFINED;
+}
+
+static JSValue convDroidField(const DROID *psDroid, JSContext *ctx, ObjectViews &views, int field)
+{
+	switch (field)
+	{
+	case OVF_ACTION: return JS_NewInt32(ctx, (int)psDroid->action);
+	case OVF_RANGE:
+		{
+			int range = summarizeWeapons(psDroid).range;
+			return range >= 0 ? JS_NewInt32(ctx, range) : JS_NULL;
+		}
+	case OVF_ORDER: return JS_NewInt32(ctx, (int)psDroid->order.type);
+	case OVF_COST: return JS_NewUint32(ctx, calcDroidPower(psDroid));
+	case OVF_HAS_INDIRECT: return JS_NewBool(ctx, summarizeWeapons(psDroid).indirect);
+	case OVF_BODY_SIZE: return JS_NewInt32(ctx, psDroid->getBodyStats()->size);
+	case OVF_CARGO_CAPACITY: return JS_NewInt32(ctx, TRANSPORTER_CAPACITY);
+	case OVF_CARGO_LEFT: return JS_NewInt32(ctx, calcRemainingCapacity(psDroid));
+	case OVF_CARGO_COUNT: return JS_NewUint32(ctx, psDroid->psGroup != nullptr? psDroid->psGroup->getNumMembers() : 0);
+	case OVF_IS_RADAR_DETECTOR: return JS_NewBool(ctx, objRadarDetector(psDroid));
+	case OVF_IS_CB: return JS_NewBool(ctx, cbSensorDroid(psDroid));
+	case OVF_IS_SENSOR: return JS_NewBool(ctx, standardSensorDroid(psDroid));
+	case OVF_CAN_HIT_AIR: return JS_NewBool(ctx, summarizeWeapons(psDroid).aa);
+	case OVF_CAN_HIT_GROUND: return JS_NewBool(ctx, summarizeWeapons(psDroid).ga);
+	case OVF_IS_VTOL: return JS_NewBool(ctx, psDroid->isVtol());
+	case OVF_IS_FLYING: return JS_NewBool(ctx, psDroid->isFlying());
+	case OVF_DROID_TYPE:
+		switch (psDroid->droidType) // hide some engine craziness
+		{
+		case DROID_CYBORG_CONSTRUCT: return JS_NewInt32(ctx, (int)DROID_CONSTRUCT);
+		case DROID_CYBORG_SUPER: return JS_NewInt32(ctx, (int)DROID_CYBORG);
+		case DROID_DEFAULT: return JS_NewInt32(ctx, (int)DROID_WEAPON);
+		case DROID_CYBORG_REPAIR: return JS_NewInt32(ctx, (int)DROID_REPAIR);
+		default: return JS_NewInt32(ctx, (int)psDroid->droidType);
+		}
+	case OVF_EXPERIENCE: return JS_NewFloat64(ctx, (double)psDroid->experience / 65536.0);
+	case OVF_HEALTH: return JS_NewFloat64(ctx, 100.0 / (double)psDroid->originalBody * (double)psDroid->body);
+	case OVF_BODY: return views.statsName(ctx, psDroid->getBodyStats()->id);
+	case OVF_PROPULSION: return views.statsName(ctx, psDroid->getPropulsionStats()->id);
+	case OVF_ARMED: return JS_NewFloat64(ctx, 0.0); // deprecated!
+	case OVF_WEAPONS: return convWeapons(psDroid, ctx, views);
+	case OVF_CARGO_SIZE: return JS_NewInt32(ctx, transporterSpaceRequired(psDroid));
+	}
+	return JS_UNDEFINED;
+}
+
+static JSValue convObjField(const BASE_OBJECT *psObj, JSContext *ctx, ObjectViews &views, int field)
+{
+	switch (field)
+	{
+	case OVF_X: return JS_NewInt32(ctx, map_coord(psObj->pos.x));
+	case OVF_Y: return JS_NewInt32(ctx, map_coord(psObj->pos.y));
+	case OVF_Z: return JS_NewInt32(ctx, map_coord(psObj->pos.z));
+	case OVF_PLAYER: return JS_NewUint32(ctx, psObj->player);
+	case OVF_ARMOUR: return JS_NewInt32(ctx, objArmour(psObj, WC_KINETIC));
+	case OVF_THERMAL: return JS_NewInt32(ctx, objArmour(psObj, WC_HEAT));
+	case OVF_TYPE: return JS_NewInt32(ctx, psObj->type);
+	case OVF_SELECTED: return JS_NewUint32(ctx, psObj->selected);
+	case OVF_NAME: return JS_NewString(ctx, objInfo(psObj));
+	case OVF_BORN: return JS_NewUint32(ctx, psObj->born);
+	case OVF_GROUP:
+		{
+			scripting_engine::GROUPMAP *psMap = scripting_engine::instance().getGroupMap(engineToInstanceMap.at(ctx));
+			if (psMap != nullptr)
+			{
+				auto it = psMap->map().find(psObj);
+				if (it != psMap->map().end())
+				{
+					return JS_NewInt32(ctx, it->second);
+				}
+			}
+			return JS_NULL;
+		}
+	}
+	switch (psObj->type)
+	{
+	case OBJ_DROID: return convDroidField(static_cast<const DROID *>(psObj), ctx, views, field);
+	case OBJ_STRUCTURE: return convStructureField(static_cast<const STRUCTURE *>(psObj), ctx, views, field);
+	case OBJ_FEATURE: return convFeatureField(static_cast<const FEATURE *>(psObj), ctx, field);
+	default: return JS_UNDEFINED;
+	}
+}
+
+static void js_objectViewFinalizer(JSRuntime * /*rt*/, JSValue value)
+{
+	ObjectView *view = static_cast<ObjectView *>(JS_GetOpaque(value, objectViewClassId));
+	if (view != nullptr)
+	{
+		if (view->unresolved != 0)
+		{
+			view->owner->forget(view);
+		}
+		delete view;
+	}
+}
+
+static JSValue js_objectViewGet(JSContext *ctx, JSValueConst this_val, int magic)
+{
+	ObjectView *view = static_cast<ObjectView *>(JS_GetOpaque(this_val, objectViewClassId));
+	if (view == nullptr)
+	{
+		return JS_UNDEFINED; // not called on a view, but on an object inheriting from one
+	}
+	return view->owner->get(ctx, this_val, *view, magic);
+}
+
+// JSON.stringify() only sees properties stored on the view
+static JSValue js_objectViewToJSON(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv)
+{
+	ObjectView *view = static_cast<ObjectView *>(JS_GetOpaque(this_val, objectViewClassId));
+	if (view != nullptr)
+	{
+		view->owner->resolve(ctx, *view);
+	}
+	return JS_DupValue(ctx, this_val);
+}
+
+void ObjectViews::init(JSRuntime *rt, JSContext *ctx)
+{
+	WZ_QJS_NewClassID(rt, &objectViewClassId);
+	JSClassDef classDef = {};
+	classDef.class_name = "GameObject";
+	classDef.finalizer = js_objectViewFinalizer;
+	JS_NewClass(rt, objectViewClassId, &classDef);
+
+	for (int kind = 0; kind < OBJECT_VIEW_KINDS; ++kind)
+	{
+		std::vector<JSCFunctionListEntry> getters;
+		for (int field = 0; field < OVF_COUNT; ++field)
+		{
+			if (objectViewFields[kind] & OVF_BIT(field))
+			{
+				getters.push_back(QJS_CGETSET_MAGIC_DEF(objectViewFieldNames[field], js_objectViewGet, static_cast<int16_t>(field)));
+				getters.back().prop_flags |= JS_PROP_ENUMERABLE; // so for-in lists fields not read yet
+			}
+		}
+		getters.push_back(QJS_CFUNC_DEF("toJSON", 1, js_objectViewToJSON));
+		protos[kind] = JS_NewObject(ctx);
+		JS_SetPropertyFunctionList(ctx, protos[kind], getters.data(), static_cast<int>(getters.size()));
+	}
+	for (int field = 0; field < OVF_COUNT; ++field)
+	{
+		fieldAtoms.push_back(JS_NewAtom(ctx, objectViewFieldNames[field]));
+	}
+	idAtom = JS_NewAtom(ctx, "id");
+}
+
+void ObjectViews::shutdown(JSContext *ctx)
+{
+	for (JSValue &proto : protos)
+	{
+		JS_FreeValue(ctx, proto);
+		proto = JS_UNDEFINED;
+	}
+	for (JSAtom atom : fieldAtoms)
+	{
+		JS_FreeAtom(ctx, atom);
+	}
+	fieldAtoms.clear();
+	JS_FreeAtom(ctx, idAtom);
+	idAtom = JS_ATOM_NULL;
+	for (const auto &statsName : statsNames)
+	{
+		JS_FreeAtom(ctx, statsName.second);
+	}
+	statsNames.clear();
+}
+
+JSValue ObjectViews::create(JSContext *ctx, const BASE_OBJECT *psObj, ObjectViewKind kind)
+{
+	JSValue value = JS_NewObjectProtoClass(ctx, protos[kind], objectViewClassId);
+	if (JS_IsException(value))
+	{
+		return value;
+	}
+	ObjectView *view = new ObjectView{this, psObj, psObj->id, value, objectViewFields[kind]};
+	JS_SetOpaque(value, view);
+	JS_DefinePropertyValue(ctx, value, idAtom, JS_NewUint32(ctx, psObj->id), 0);
+	unresolvedViews.emplace(psObj->id, view);
+	return value;
+}
+
+JSValue ObjectViews::get(JSContext *ctx, JSValueConst value, ObjectView &view, int field)
+{
+	if (objmemLookupObject(view.id) != view.psObj)
+	{
+		debug(LOG_SCRIPT, "Object %u was removed before its properties were resolved", view.id);
+		return JS_UNDEFINED;
+	}
+	JSValue result = convObjField(view.psObj, ctx, *this, field);
+	if (view.unresolved & OVF_BIT(field))
+	{
+		JS_DefinePropertyValue(ctx, value, fieldAtoms[field], JS_DupValue(ctx, result), JS_PROP_ENUMERABLE);
+		view.unresolved &= ~OVF_BIT(field);
+		if (view.unresolved == 0)
+		{
+			forget(&view);
+		}
+	}
+	return result;
+}
+
+void ObjectViews::resolve(JSContext *ctx, ObjectView &view)
+{
+	if (view.unresolved == 0)
+	{
+		return;
+	}
+	if (objmemLookupObject(view.id) == view.psObj)
+	{
+		for (int field = 0; field < OVF_COUNT; ++field)
+		{
+			if (view.unresolved & OVF_BIT(field))
+			{
+				JS_DefinePropertyValue(ctx, view.value, fieldAtoms[field], convObjField(view.psObj, ctx, *this, field), JS_PROP_ENUMERABLE);
+			}
+		}
+	}
+	else
+	{
+		debug(LOG_SCRIPT, "Object %u was removed before its properties were resolved", view.id);
+	}
+	forget(&view);
+	view.unresolved = 0;
+}
+
+void ObjectViews::resolveViews(JSContext *ctx, std::vector<ObjectView *> &views)
+{
+	// Creating property values may run the garbage collector, so keep the views alive meanwhile
+	for (ObjectView *view : views)
+	{
+		JS_DupValue(ctx, view->value);
+	}
+	for (ObjectView *view : views)
+	{
+		resolve(ctx, *view);
+	}
+	for (ObjectView *view : views)
+	{
+		JS_FreeValue(ctx, view->value);
+	}
+}
+
+void ObjectViews::resolveAll(JSContext *ctx)
+{
+	if (unresolvedViews.empty())
+	{
+		return;
+	}
+	std::vector<ObjectView *> views;
+	views.reserve(unresolvedViews.size());
+	for (const auto &unresolvedView : unresolvedViews)
+	{
+		views.push_back(unresolvedView.second);
+	}
+	resolveViews(ctx, views);
+}
+
+void ObjectViews::resolveObject(JSContext *ctx, const BASE_OBJECT *psObj)
+{
+	auto range = unresolvedViews.equal_range(psObj->id);
+	if (range.first == range.second)
+	{
+		return;
+	}
+	std::vector<ObjectView *> views;
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		views.push_back(it->second);
+	}
+	resolveViews(ctx, views);
+}
+
+void ObjectViews::forget(ObjectView *view)
+{
+	auto range = unresolvedViews.equal_range(view->id);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		if (it->second == view)
+		{
+			unresolvedViews.erase(it);
+			return;
+		}
+	}
+}
+
+JSValue ObjectViews::statsName(JSContext *ctx, const WzString &name)
+{
+	auto it = statsNames.find(&name);
+	if (it == statsNames.end())
+	{
+		const std::string utf8 = name.toUtf8();
+		it = statsNames.emplace(&name, JS_NewAtomLen(ctx, utf8.c_str(), utf8.size())).first;
+	}
+	return JS_AtomToString(ctx, it->second);
+}
+
+/// Stores all properties on the value, if it is a view of a game object.
+static void resolveObjectView(JSContext *ctx, JSValueConst value)
+{
+	ObjectView *view = static_cast<ObjectView *>(JS_GetOpaque(value, objectViewClassId));
+	if (view != nullptr)
+	{
+		view->owner->resolve(ctx, *view);
+	}
+}
+
+/// Wraps calling into a script. Views of game objects which are still referenced when the outermost
+/// scope is left get all their properties stored, since the game state may change until the next call.
+class ObjectViewScope
+{
+public:
+	explicit ObjectViewScope(JSContext *ctx)
+	: ctx(ctx)
+	, views(engineToInstanceMap.at(ctx)->objectViews)
+	{
+		++views.callDepth;
+	}
+	~ObjectViewScope()
+	{
+		if (--views.callDepth == 0)
+		{
+			views.resolveAll(ctx);
+		}
+	}
+	ObjectViewScope(const ObjectViewScope &) = delete;
+	ObjectViewScope &operator=(const ObjectViewScope &) = delete;
+
+private:
+	JSContext *ctx;
+	ObjectViews &views;
+};
+
 //;; ## Research
 //;;
 //;; Describes a research item. The following properties are defined:
@@ -865,74 +1557,7 @@ JSValue convResearch(const RESEARCH *psResearch, JSContext *ctx, int player)
 //;;
 JSValue convStructure(const STRUCTURE *psStruct, JSContext *ctx)
 {
-	bool aa = false;
-	bool ga = false;
-	bool indirect = false;
-	int range = -1;
-	for (int i = 0; i < psStruct->numWeaps; i++)
-	{
-		if (psStruct->asWeaps[i].nStat)
-		{
-			WEAPON_STATS *psWeap = psStruct->getWeaponStats(i);
-			aa = aa || psWeap->surfaceToAir & SHOOT_IN_AIR;
-			ga = ga || psWeap->surfaceToAir & SHOOT_ON_GROUND;
-			indirect = indirect || psWeap->movementModel == MM_INDIRECT || psWeap->movementModel == MM_HOMINGINDIRECT;
-			range = MAX(proj_GetLongRange(*psWeap, psStruct->player), range);
-		}
-	}
-	JSValue value = convObj(psStruct, ctx);
-	QuickJS_DefinePropertyValue(ctx, value, "isCB", JS_NewBool(ctx, structCBSensor(psStruct)), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "isSensor", JS_NewBool(ctx, structStandardSensor(psStruct)), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "canHitAir", JS_NewBool(ctx, aa), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "canHitGround", JS_NewBool(ctx, ga), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "hasIndirect", JS_NewBool(ctx, indirect), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "isRadarDetector", JS_NewBool(ctx, objRadarDetector(psStruct)), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "range", JS_NewInt32(ctx, range), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "status", JS_NewInt32(ctx, (int)psStruct->status), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "health", JS_NewInt32(ctx, 100 * psStruct->body / MAX(1, psStruct->structureBody())), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "cost", JS_NewInt32(ctx, psStruct->pStructureType->powerToBuild), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "direction", JS_NewInt32(ctx, static_cast<int32_t>(UNDEG(psStruct->rot.direction))), JS_PROP_ENUMERABLE);
-	int stattype = 0;
-	switch (psStruct->pStructureType->type) // don't bleed our source insanities into the scripting world
-	{
-	case REF_WALL:
-	case REF_WALLCORNER:
-	case REF_GATE:
-		stattype = (int)REF_WALL;
-		break;
-	case REF_FORTRESS:
-	case REF_DEFENSE:
-		stattype = (int)REF_DEFENSE;
-		break;
-	default:
-		stattype = (int)psStruct->pStructureType->type;
-		break;
-	}
-	QuickJS_DefinePropertyValue(ctx, value, "stattype", JS_NewInt32(ctx, stattype), JS_PROP_ENUMERABLE);
-	if (psStruct->pStructureType->type == REF_FACTORY || psStruct->pStructureType->type == REF_CYBORG_FACTORY
-	    || psStruct->pStructureType->type == REF_VTOL_FACTORY
-	    || psStruct->pStructureType->type == REF_RESEARCH
-	    || psStruct->pStructureType->type == REF_POWER_GEN)
-	{
-		QuickJS_DefinePropertyValue(ctx, value, "modules", JS_NewUint32(ctx, psStruct->capacity), JS_PROP_ENUMERABLE);
-	}
-	else
-	{
-		QuickJS_DefinePropertyValue(ctx, value, "modules", JS_NULL, JS_PROP_ENUMERABLE);
-	}
-	JSValue weaponlist = JS_NewArray(ctx);
-	for (int j = 0; j < psStruct->numWeaps; j++)
-	{
-		JSValue weapon = JS_NewObject(ctx);
-		const WEAPON_STATS *psStats = psStruct->getWeaponStats(j);
-		QuickJS_DefinePropertyValue(ctx, weapon, "fullname", JS_NewString(ctx, psStats->name.toUtf8().c_str()), JS_PROP_ENUMERABLE);
-		QuickJS_DefinePropertyValue(ctx, weapon, "name", JS_NewString(ctx, psStats->id.toUtf8().c_str()), JS_PROP_ENUMERABLE); // will be changed to contain full name
-		QuickJS_DefinePropertyValue(ctx, weapon, "id", JS_NewString(ctx, psStats->id.toUtf8().c_str()), JS_PROP_ENUMERABLE);
-		QuickJS_DefinePropertyValue(ctx, weapon, "lastFired", JS_NewUint32(ctx, psStruct->asWeaps[j].lastFired), JS_PROP_ENUMERABLE);
-		JS_DefinePropertyValueUint32(ctx, weaponlist, j, weapon, JS_PROP_ENUMERABLE);
-	}
-	QuickJS_DefinePropertyValue(ctx, value, "weapons", weaponlist, JS_PROP_ENUMERABLE);
-	return value;
+	return engineToInstanceMap.at(ctx)->objectViews.create(ctx, psStruct, OBJECT_VIEW_STRUCTURE);
 }
 
 //;; ## Feature
@@ -946,12 +1571,7 @@ JSValue convStructure(const STRUCTURE *psStruct, JSContext *ctx)
 //;;
 JSValue convFeature(const FEATURE *psFeature, JSContext *ctx)
 {
-	JSValue value = convObj(psFeature, ctx);
-	const FEATURE_STATS *psStats = psFeature->psStats;
-	QuickJS_DefinePropertyValue(ctx, value, "health", JS_NewUint32(ctx, 100 * psStats->body / MAX(1, psFeature->body)), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "damageable", JS_NewBool(ctx, psStats->damageable), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "stattype", JS_NewInt32(ctx, psStats->subType), JS_PROP_ENUMERABLE);
-	return value;
+	return engineToInstanceMap.at(ctx)->objectViews.create(ctx, psFeature, OBJECT_VIEW_FEATURE);
 }
 
 //;; ## Droid
@@ -1019,89 +1639,7 @@ JSValue convFeature(const FEATURE *psFeature, JSContext *ctx)
 //;;
 JSValue convDroid(const DROID *psDroid, JSContext *ctx)
 {
-	bool aa = false;
-	bool ga = false;
-	bool indirect = false;
-	int range = -1;
-	const BODY_STATS *psBodyStats = psDroid->getBodyStats();
-
-	for (int i = 0; i < psDroid->numWeaps; i++)
-	{
-		if (psDroid->asWeaps[i].nStat)
-		{
-			ASSERT(psDroid->asWeaps[i].nStat < asWeaponStats.size(), "Invalid nStat (%d) referenced for asWeaps[%d]; numWeaponStats (%zu); droid: \"%s\" (numWeaps: %u)", psDroid->asWeaps[i].nStat, i, asWeaponStats.size(), psDroid->aName, psDroid->numWeaps);
-			WEAPON_STATS *psWeap = psDroid->getWeaponStats(i);
-			aa = aa || psWeap->surfaceToAir & SHOOT_IN_AIR;
-			ga = ga || psWeap->surfaceToAir & SHOOT_ON_GROUND;
-			indirect = indirect || psWeap->movementModel == MM_INDIRECT || psWeap->movementModel == MM_HOMINGINDIRECT;
-			range = MAX(proj_GetLongRange(*psWeap, psDroid->player), range);
-		}
-	}
-	DROID_TYPE type = psDroid->droidType;
-	JSValue value = convObj(psDroid, ctx);
-	QuickJS_DefinePropertyValue(ctx, value, "action", JS_NewInt32(ctx, (int)psDroid->action), JS_PROP_ENUMERABLE);
-	if (range >= 0)
-	{
-		QuickJS_DefinePropertyValue(ctx, value, "range", JS_NewInt32(ctx, range), JS_PROP_ENUMERABLE);
-	}
-	else
-	{
-		QuickJS_DefinePropertyValue(ctx, value, "range", JS_NULL, JS_PROP_ENUMERABLE);
-	}
-	QuickJS_DefinePropertyValue(ctx, value, "order", JS_NewInt32(ctx, (int)psDroid->order.type), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "cost", JS_NewUint32(ctx, calcDroidPower(psDroid)), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "hasIndirect", JS_NewBool(ctx, indirect), JS_PROP_ENUMERABLE);
-	switch (psDroid->droidType) // hide some engine craziness
-	{
-	case DROID_CYBORG_CONSTRUCT:
-		type = DROID_CONSTRUCT; break;
-	case DROID_CYBORG_SUPER:
-		type = DROID_CYBORG; break;
-	case DROID_DEFAULT:
-		type = DROID_WEAPON; break;
-	case DROID_CYBORG_REPAIR:
-		type = DROID_REPAIR; break;
-	default:
-		break;
-	}
-	QuickJS_DefinePropertyValue(ctx, value, "bodySize", JS_NewInt32(ctx, psBodyStats->size), JS_PROP_ENUMERABLE);
-	if (psDroid->isTransporter())
-	{
-		QuickJS_DefinePropertyValue(ctx, value, "cargoCapacity", JS_NewInt32(ctx, TRANSPORTER_CAPACITY), JS_PROP_ENUMERABLE);
-		QuickJS_DefinePropertyValue(ctx, value, "cargoLeft", JS_NewInt32(ctx, calcRemainingCapacity(psDroid)), JS_PROP_ENUMERABLE);
-		QuickJS_DefinePropertyValue(ctx, value, "cargoCount", JS_NewUint32(ctx, psDroid->psGroup != nullptr? psDroid->psGroup->getNumMembers() : 0), JS_PROP_ENUMERABLE);
-	}
-	QuickJS_DefinePropertyValue(ctx, value, "isRadarDetector", JS_NewBool(ctx, objRadarDetector(psDroid)), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "isCB", JS_NewBool(ctx, cbSensorDroid(psDroid)), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "isSensor", JS_NewBool(ctx, standardSensorDroid(psDroid)), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "canHitAir", JS_NewBool(ctx, aa), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "canHitGround", JS_NewBool(ctx, ga), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "isVTOL", JS_NewBool(ctx, psDroid->isVtol()), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "isFlying", JS_NewBool(ctx, psDroid->isFlying()), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "droidType", JS_NewInt32(ctx, (int)type), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "experience", JS_NewFloat64(ctx, (double)psDroid->experience / 65536.0), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "health", JS_NewFloat64(ctx, 100.0 / (double)psDroid->originalBody * (double)psDroid->body), JS_PROP_ENUMERABLE);
-
-	QuickJS_DefinePropertyValue(ctx, value, "body", JS_NewString(ctx, psDroid->getBodyStats()->id.toUtf8().c_str()), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "propulsion", JS_NewString(ctx, psDroid->getPropulsionStats()->id.toUtf8().c_str()), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "armed", JS_NewFloat64(ctx, 0.0), JS_PROP_ENUMERABLE); // deprecated!
-
-	JSValue weaponlist = JS_NewArray(ctx);
-	for (int j = 0; j < psDroid->numWeaps; j++)
-	{
-		int armed = droidReloadBar(psDroid, &psDroid->asWeaps[j], j);
-		JSValue weapon = JS_NewObject(ctx);
-		const WEAPON_STATS *psStats = psDroid->getWeaponStats(j);
-		QuickJS_DefinePropertyValue(ctx, weapon, "fullname", JS_NewString(ctx, psStats->name.toUtf8().c_str()), JS_PROP_ENUMERABLE);
-		QuickJS_DefinePropertyValue(ctx, weapon, "name", JS_NewString(ctx, psStats->id.toUtf8().c_str()), JS_PROP_ENUMERABLE); // will be changed to contain full name
-		QuickJS_DefinePropertyValue(ctx, weapon, "id", JS_NewString(ctx, psStats->id.toUtf8().c_str()), JS_PROP_ENUMERABLE);
-		QuickJS_DefinePropertyValue(ctx, weapon, "lastFired", JS_NewUint32(ctx, psDroid->asWeaps[j].lastFired), JS_PROP_ENUMERABLE);
-		QuickJS_DefinePropertyValue(ctx, weapon, "armed", JS_NewInt32(ctx, armed), JS_PROP_ENUMERABLE);
-		JS_DefinePropertyValueUint32(ctx, weaponlist, j, weapon, JS_PROP_ENUMERABLE);
-	}
-	QuickJS_DefinePropertyValue(ctx, value, "weapons", weaponlist, JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "cargoSize", JS_NewInt32(ctx, transporterSpaceRequired(psDroid)), JS_PROP_ENUMERABLE);
-	return value;
+	return engineToInstanceMap.at(ctx)->objectViews.create(ctx, psDroid, psDroid->isTransporter() ? OBJECT_VIEW_TRANSPORTER : OBJECT_VIEW_DROID);
 }
 
 //;; ## Base Object
@@ -1124,6 +1662,12 @@ JSValue convDroid(const DROID *psDroid, JSContext *ctx)
 //;; * ```born``` The game time at which this object was produced or came into the world. (3.2+ only)
 //;; * ```group``` The group this object is member of. This is a numerical ID. If not a member of any group, will be set to \emph{null}.
 //;;
+//;; The properties are read from the game when first used, and kept as they were at the end of the event (or
+//;; timer function) that got the object, like a snapshot. Use ```getObject()``` to get the current state later.
+//;; Until a property is read, it is inherited from the prototype of the object, so ```for (key in obj)``` lists it,
+//;; but ```Object.keys()```, ```Object.assign()```, the spread syntax and ```hasOwnProperty()``` do not. Call
+//;; ```obj.toJSON()``` (as ```JSON.stringify()``` does) to store all properties on the object first.
+//;;
 JSValue convObj(const BASE_OBJECT *psObj, JSContext *ctx)
 {
 	JSValue value = JS_NewObject(ctx);
@@ -1308,6 +1852,7 @@ static JSValue callFunction(JSContext *ctx, const std::string &function, std::ve
 		{
 			JSContext *pCtx = ctx;
 			return [pCtx, func](const int player) {
+				ObjectViewScope scope(pCtx);
 				std::vector<JSValue> args;
 				args.push_back(JS_NewInt32(pCtx, player));
 				callFunction(pCtx, func.toUtf8(), args);
@@ -1864,6 +2409,82 @@ static JSValue callFunction(JSContext *ctx, const std::string &function, std::ve
 			}
 		};
 
+		template<>
+		struct unbox<wzapi::range_queries>
+		{
+			wzapi::range_queries operator()(size_t& idx, JSContext *ctx, int argc, JSValueConst *argv, const char *function)
+			{
+				if ((argc - idx) < 2)
+					return {};
+
+				JSValue positions = argv[idx++];
+				JSValue ranges = argv[idx++];
+				UNBOX_SCRIPT_ASSERT(context, WZ_QJS_IsArray(ctx, positions), "Positions must be an array");
+				uint64_t length = 0;
+				QuickJS_GetArrayLength(ctx, positions, length);
+				bool perPositionRange = WZ_QJS_IsArray(ctx, ranges);
+				int32_t range = perPositionRange ? 0 : JSValueToInt32(ctx, ranges);
+				if (perPositionRange)
+				{
+					uint64_t rangesLength = 0;
+					QuickJS_GetArrayLength(ctx, ranges, rangesLength);
+					UNBOX_SCRIPT_ASSERT(context, rangesLength == length, "Expected %zu ranges, got %zu", static_cast<size_t>(length), static_cast<size_t>(rangesLength));
+				}
+				wzapi::range_queries result;
+				result.queries.reserve(length);
+				for (uint32_t k = 0; k < length; k++)
+				{
+					JSValue position = JS_GetPropertyUint32(ctx, positions, k);
+					scr_radius query = {QuickJS_GetInt32(ctx, position, "x"), QuickJS_GetInt32(ctx, position, "y"), range};
+					JS_FreeValue(ctx, position);
+					if (perPositionRange)
+					{
+						JSValue rangeVal = JS_GetPropertyUint32(ctx, ranges, k);
+						query.radius = JSValueToInt32(ctx, rangeVal);
+						JS_FreeValue(ctx, rangeVal);
+					}
+					result.queries.push_back(query);
+				}
+				return result;
+			}
+		};
+
+		template<>
+		struct unbox<scripting_engine::area_lookups>
+		{
+			scripting_engine::area_lookups operator()(size_t& idx, JSContext *ctx, int argc, JSValueConst *argv, const char *function)
+			{
+				if (argc <= idx)
+					return {};
+
+				auto toAreaLookup = [ctx](JSValueConst area) {
+					if (JS_IsString(area))
+					{
+						return scripting_engine::area_by_values_or_area_label_lookup(JSValueToStdString(ctx, area));
+					}
+					return scripting_engine::area_by_values_or_area_label_lookup(QuickJS_GetInt32(ctx, area, "x"), QuickJS_GetInt32(ctx, area, "y"), QuickJS_GetInt32(ctx, area, "x2"), QuickJS_GetInt32(ctx, area, "y2"));
+				};
+				scripting_engine::area_lookups result;
+				JSValue areas = argv[idx++];
+				if (WZ_QJS_IsArray(ctx, areas))
+				{
+					uint64_t length = 0;
+					QuickJS_GetArrayLength(ctx, areas, length);
+					for (uint32_t k = 0; k < length; k++)
+					{
+						JSValue area = JS_GetPropertyUint32(ctx, areas, k);
+						result.areas.push_back(toAreaLookup(area));
+						JS_FreeValue(ctx, area);
+					}
+				}
+				else
+				{
+					result.areas.push_back(toAreaLookup(areas));
+				}
+				return result;
+			}
+		};
+
 		template<typename T>
 		JSValue box(T a, JSContext *);
 
@@ -2093,6 +2714,29 @@ static JSValue callFunction(JSContext *ctx, const std::string &function, std::ve
 			return result;
 		}
 
+		template<typename ElementType>
+		JSValue box_typed_array(const std::vector<ElementType>& values, const char *constructorName, JSContext* ctx)
+		{
+			JSValue global_obj = JS_GetGlobalObject(ctx);
+			JSValue constructor = JS_GetPropertyStr(ctx, global_obj, constructorName);
+			JSValue arg = values.empty() ? JS_NewInt32(ctx, 0) : JS_NewArrayBufferCopy(ctx, reinterpret_cast<const uint8_t *>(values.data()), values.size() * sizeof(ElementType));
+			JSValue result = JS_CallConstructor(ctx, constructor, 1, &arg);
+			JS_FreeValue(ctx, arg);
+			JS_FreeValue(ctx, constructor);
+			JS_FreeValue(ctx, global_obj);
+			return result;
+		}
+
+		JSValue box(const wzapi::object_id_lists& lists, JSContext* ctx)
+		{
+			JSValue result = JS_NewObject(ctx);
+			QuickJS_DefinePropertyValue(ctx, result, "offsets", box_typed_array(lists.offsets, "Int32Array", ctx), JS_PROP_ENUMERABLE);
+			QuickJS_DefinePropertyValue(ctx, result, "ids", box_typed_array(lists.ids, "Uint32Array", ctx), JS_PROP_ENUMERABLE);
+			QuickJS_DefinePropertyValue(ctx, result, "types", box_typed_array(lists.types, "Int32Array", ctx), JS_PROP_ENUMERABLE);
+			QuickJS_DefinePropertyValue(ctx, result, "players", box_typed_array(lists.players, "Int32Array", ctx), JS_PROP_ENUMERABLE);
+			return result;
+		}
+
 		template<typename OptionalType>
 		JSValue box(const optional<OptionalType>& result, JSContext* ctx)
 		{
@@ -2277,6 +2921,7 @@ static JSValue callFunction(JSContext *ctx, const std::string &function, std::ve
 		template <typename... Args>
 		bool wrap_event_handler__(const std::string &functionName, JSContext *context, Args&&... args)
 		{
+			ObjectViewScope scope(context);
 			std::vector<JSValue> args_list;
 			using expander = int[];
 //			WZ_DECL_UNUSED int dummy[] = { 0, ((void) append_value_list(args_list, std::forward<Args>(args), engine),0)... };
@@ -2494,6 +3139,7 @@ static uniqueTimerID SetQuickJSTimer(JSContext *ctx, int player, const std::stri
 	  // timerFunc
 	, [ctx, funcName](uniqueTimerID timerID, BASE_OBJECT* baseObject, timerAdditionalData* additionalParams) {
 		quickjs_timer_additionaldata* pData = static_cast<quickjs_timer_additionaldata*>(additionalParams);
+		ObjectViewScope scope(ctx);
 		std::vector<JSValue> args;
 		if (baseObject != nullptr)
 		{
@@ -2820,6 +3466,7 @@ bool quickjs_scripting_instance::loadScript(const WzString& path, int player, in
 bool quickjs_scripting_instance::readyInstanceForExecution()
 {
 	ASSERT_OR_RETURN(false, !JS_IsUninitialized(compiledScriptObj), "compiledScriptObj is uninitialized");
+	ObjectViewScope scope(ctx);
 	JSValue result = JS_EvalFunction(ctx, compiledScriptObj);
 	compiledScriptObj = JS_UNINITIALIZED;
 	if (JS_IsException(result))
@@ -2925,6 +3572,7 @@ std::tuple<TimerFunc, std::unique_ptr<timerAdditionalData>> quickjs_scripting_in
 		// timerFunc
 		[pContext, funcName](uniqueTimerID timerID, BASE_OBJECT* baseObject, timerAdditionalData* additionalParams) {
 			quickjs_timer_additionaldata* pData = static_cast<quickjs_timer_additionaldata*>(additionalParams);
+			ObjectViewScope scope(pContext);
 			std::vector<JSValue> args;
 			if (baseObject != nullptr)
 			{
@@ -2989,6 +3637,7 @@ bool quickjs_scripting_instance::debugEvaluateCommand(const std::string &text)
 		compiledFuncObj = JS_UNINITIALIZED;
 		return false;
 	}
+	ObjectViewScope scope(ctx);
 	JSValue result = JS_EvalFunction(ctx, compiledFuncObj);
 	compiledFuncObj = JS_UNINITIALIZED;
 	if (JS_IsException(result))
@@ -3012,6 +3661,11 @@ void quickjs_scripting_instance::updateGameTime(uint32_t newGameTime)
 	ASSERT(ret >= 1, "Failed to update gameTime");
 }
 
+void quickjs_scripting_instance::updateObjectRemoved(const BASE_OBJECT *psObj)
+{
+	objectViews.resolveObject(ctx, psObj);
+}
+
 void quickjs_scripting_instance::updateGroupSizes(int groupId, int size)
 {
 	JSValue groupMembersObj = JS_GetPropertyStr(ctx, global_obj, "groupSizes");
@@ -3118,6 +3772,7 @@ IMPL_EVENT_HANDLER(eventBeaconRemoved, int, int)
 IMPL_EVENT_HANDLER(eventGroupLoss, const BASE_OBJECT *, int, int)
 bool quickjs_scripting_instance::handle_eventArea(const std::string& label, const DROID *psDroid)
 {
+	ObjectViewScope scope(ctx);
 	std::vector<JSValue> args;
 	args.push_back(convDroid(psDroid, ctx));
 	std::string funcname = std::string("eventArea") + label;
@@ -3281,6 +3936,8 @@ IMPL_JS_FUNC(loadLevel, wzapi::loadLevel)
 IMPL_JS_FUNC(autoSave, wzapi::autoSave)
 IMPL_JS_FUNC(enumRange, wzapi::enumRange)
 IMPL_JS_FUNC(enumArea, scripting_engine::enumAreaJS)
+IMPL_JS_FUNC(enumRangeMulti, wzapi::enumRangeMulti)
+IMPL_JS_FUNC(enumAreaByType, scripting_engine::enumAreaByType)
 IMPL_JS_FUNC(addBeacon, wzapi::addBeacon)
 
 static JSValue js_removeBeacon(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv)
@@ -3581,6 +4238,8 @@ bool quickjs_scripting_instance::registerFunctions(const std::string& scriptName
 	JS_REGISTER_FUNC(enumResearch, 0); // WZAPI
 	JS_REGISTER_FUNC2(enumRange, 3, 5); // WZAPI
 	JS_REGISTER_FUNC2(enumArea, 1, 6); // scripting_engine
+	JS_REGISTER_FUNC2(enumRangeMulti, 2, 5); // WZAPI
+	JS_REGISTER_FUNC2(enumAreaByType, 2, 4); // scripting_engine
 	JS_REGISTER_FUNC2(getResearch, 1, 2); // WZAPI
 	JS_REGISTER_FUNC(pursueResearch, 2); // WZAPI
 	JS_REGISTER_FUNC2(findResearch, 1, 2); // WZAPI
@@ -3742,6 +4401,7 @@ nlohmann::json wz_qjs_to_json(JSToJsonContext &c, JSValue value)
 		{
 			// Handle actual objects
 			j = nlohmann::json::object();
+			resolveObjectView(c.ctx, value);
 			QuickJS_EnumerateObjectProperties(c.ctx, value, [&c, value, &j](const char *key, JSAtom &atom) {
 				JSValue jsVal = JS_GetProperty(c.ctx, value, atom);
 				std::string nameStr = key;
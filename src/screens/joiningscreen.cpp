@@ -35,6 +35,7 @@
 #include "lib/netplay/open_connection_result.h"
 #include "lib/netplay/connection_provider_registry.h"
 #include "lib/netplay/error_categories.h"
+#include "lib/netplay/wz_compression_provider.h"
 
 #include "../hci.h"
 #include "../activity.h"
@@ -808,7 +809,9 @@ private:
 	NetQueuePair *tmpJoiningQueuePair = nullptr;
 	char initialAckBuffer[10] = {'\0'};
 	size_t usedInitialAckBuffer = 0;
-	const size_t expectedInitialAckSize = sizeof(uint32_t);
+	// The result, followed by the compression algorithm picked by the host (if the result is ERROR_NOERROR)
+	const size_t initialAckResultSize = sizeof(uint32_t);
+	const size_t expectedInitialAckSize = sizeof(uint32_t) * 2;
 
 	std::chrono::steady_clock::time_point timeStarted;
 	const std::chrono::milliseconds minimumTimeBeforeAutoClose = std::chrono::milliseconds(300);
@@ -1217,8 +1220,9 @@ void WzJoiningGameScreen_HandlerRoot::processOpenConnectionResult(size_t connect
 		client_transient_socket->useNagleAlgorithm(false);
 	}
 
-	// Send initial connection data: NETCODE_VERSION_MAJOR and NETCODE_VERSION_MINOR
-	char buffer[sizeof(int32_t) * 2] = { 0 };
+	// Send initial connection data: NETCODE_VERSION_MAJOR and NETCODE_VERSION_MINOR,
+	// followed by the compression algorithms we support
+	char buffer[sizeof(int32_t) * 3] = { 0 };
 	char *p_buffer = buffer;
 	auto pushu32 = [&](uint32_t value) {
 		uint32_t swapped = wz_htonl(value);
@@ -1227,6 +1231,7 @@ void WzJoiningGameScreen_HandlerRoot::processOpenConnectionResult(size_t connect
 	};
 	pushu32(NETGetMajorVersion());
 	pushu32(NETGetMinorVersion());
+	pushu32(WzCompressionProvider::Instance().supportedAlgorithmsMask());
 
 	const auto writeResult = client_transient_socket->writeAll(buffer, sizeof(buffer), nullptr);
 	if (!writeResult.has_value())
@@ -1308,12 +1313,12 @@ bool WzJoiningGameScreen_HandlerRoot::joiningSocketNETsend()
 {
 	NetQueue *queue = &tmpJoiningQueuePair->send;
 	const NetMessage& message = queue->getMessageForNet();
-	const auto& rawData = message.rawData();
-	ssize_t rawLen = rawData.size();
+	const uint8_t* rawData = message.rawData();
+	ssize_t rawLen = message.rawDataSize();
 	uint8_t msgType = message.type();
 
 	size_t compressedRawLen = 0;
-	const auto writeResult = client_transient_socket->writeAll(rawData.data(), rawLen, &compressedRawLen);
+	const auto writeResult = client_transient_socket->writeAll(rawData, rawLen, &compressedRawLen);
 	queue->popMessageForNet();
 	if (writeResult.has_value())
 	{
@@ -1452,7 +1457,7 @@ void WzJoiningGameScreen_HandlerRoot::processJoining()
 				usedInitialAckBuffer += static_cast<size_t>(readResult.value());
 			}
 
-			if (usedInitialAckBuffer >= expectedInitialAckSize)
+			if (usedInitialAckBuffer >= initialAckResultSize)
 			{
 				uint32_t result = ERROR_CONNECTION;
 				memcpy(&result, initialAckBuffer, sizeof(result));
@@ -1477,8 +1482,24 @@ void WzJoiningGameScreen_HandlerRoot::processJoining()
 					return;
 				}
 
+				if (usedInitialAckBuffer < expectedInitialAckSize)
+				{
+					return; // wait for the compression algorithm
+				}
+
+				uint32_t compressionAlgorithm = 0;
+				memcpy(&compressionAlgorithm, initialAckBuffer + initialAckResultSize, sizeof(compressionAlgorithm));
+				compressionAlgorithm = wz_ntohl(compressionAlgorithm);
+				if (!WzCompressionProvider::Instance().isSupported(static_cast<WzCompressionAlgorithm>(compressionAlgorithm)))
+				{
+					debug(LOG_ERROR, "Host picked an unsupported compression algorithm: %" PRIu32, compressionAlgorithm);
+					closeConnectionAttempt();
+					handleFailure(FailureDetails::makeFromLobbyError(ERROR_CONNECTION));
+					return;
+				}
+
 				// transition to net message mode (enable compression, wait for messages)
-				client_transient_socket->enableCompression();
+				client_transient_socket->enableCompression(static_cast<WzCompressionAlgorithm>(compressionAlgorithm));
 				currentJoiningState = JoiningState::ProcessingJoinMessages;
 				// permit fall-through to currentJoiningState == JoiningState::ProcessingJoinMessage case below
 			}
@@ -1629,6 +1629,7 @@ STRUCTURE *buildStructureDir(STRUCTURE_STATS *pStructureType, UDWORD x, UDWORD y
 		// Emplace the structure being built in the global storage to obtain stable address.
 		STRUCTURE& stableBuilding = GlobalStructContainer().emplace(std::move(building));
 		psBuilding = &stableBuilding;
+		objmemRegisterObject(psBuilding);
 		for (int tileY = map.y; tileY < map.y + size.y; ++tileY)
 		{
 			for (int tileX = map.x; tileX < map.x + size.x; ++tileX)
@@ -25,11 +25,13 @@
 #include "lib/framework/frame.h"
 #include "lib/framework/fixedpoint.h"
 
+#include "lib/framework/wzapp.h"
 #include "lib/gamelib/gtime.h"
 #include "lib/sound/audio.h"
 #include "lib/sound/audio_id.h"
 #include "lib/ivis_opengl/ivisdef.h"
 
+#include <atomic>
 #include <limits>
 
 #include "visibility.h"
@@ -95,11 +97,30 @@ struct VisibleObjectHelp_t
 	Vector2i wall; // The position of a wall if it is on the LOS
 };
 
-static int *gNumWalls = nullptr;
-static Vector2i *gWall = nullptr;
+/// What a viewer can see, found by the vision threads.
+struct VisionResult
+{
+	BASE_OBJECT *psObj;
+	int val;
+};
+
+/// Viewers per batch taken by a vision thread.
+#define VISION_BATCH_SIZE 16
+/// Less viewers than this are handled without waking up the vision threads.
+#define VISION_MIN_PARALLEL_VIEWERS 64
+#define MAX_VISION_THREADS 8
+
+static std::vector<WZ_THREAD *> visionThreads;
+static WZ_SEMAPHORE *visionSemaphore = nullptr;      ///< Posted once per thread, when there are viewers to process.
+static WZ_SEMAPHORE *visionDoneSemaphore = nullptr;  ///< Posted by each thread, when there are no viewers left.
+static std::atomic<bool> visionQuit(false);
+static std::vector<BASE_OBJECT *> visionViewers;     ///< Viewers this tick, in the order they are processed.
+static std::vector<std::vector<VisionResult>> visionResults;  ///< Indexed like visionViewers.
+static std::atomic<size_t> visionNextViewer(0);
 
 // forward declarations
 static void setSeenBy(BASE_OBJECT *psObj, unsigned viewer, int val);
+static int visionThreadFunc(void *);
 
 // initialise the visibility stuff
 bool visInitialise()
@@ -107,9 +128,47 @@ bool visInitialise()
 	visLevelInc = 1;
 	visLevelDec = 0;
 
+	if (visionSemaphore == nullptr)
+	{
+		// subtract one for the main thread, which also processes viewers
+		size_t numThreads = std::min<size_t>(std::max<size_t>(wzGetLogicalCPUCount(), 1) - 1, MAX_VISION_THREADS);
+		visionQuit = false;
+		visionSemaphore = wzSemaphoreCreate(0);
+		visionDoneSemaphore = wzSemaphoreCreate(0);
+		for (size_t i = 0; i < numThreads; ++i)
+		{
+			visionThreads.push_back(wzThreadCreate(visionThreadFunc, nullptr, "wzVision"));
+			wzThreadStart(visionThreads.back());
+		}
+	}
+
 	return true;
 }
 
+// shutdown the visibility stuff
+void visShutdown()
+{
+	if (visionSemaphore != nullptr)
+	{
+		visionQuit = true;
+		for (size_t i = 0; i < visionThreads.size(); ++i)
+		{
+			wzSemaphorePost(visionSemaphore);  // Wake up a thread
+		}
+		for (WZ_THREAD *thread : visionThreads)
+		{
+			wzThreadJoin(thread);
+		}
+		visionThreads.clear();
+		wzSemaphoreDestroy(visionSemaphore);
+		visionSemaphore = nullptr;
+		wzSemaphoreDestroy(visionDoneSemaphore);
+		visionDoneSemaphore = nullptr;
+	}
+	visionViewers.clear();
+	visionResults.clear();
+}
+
 // update the visibility change levels
 void visUpdateLevel()
 {
@@ -482,7 +541,7 @@ void revealAll(UBYTE player)
  * psTarget can be any type of BASE_OBJECT (e.g. a tree).
  * wallsBlock controls whether structures block LOS
  */
-int visibleObject(const BASE_OBJECT *psViewer, const BASE_OBJECT *psTarget, bool wallsBlock)
+static int visibleObjectImpl(const BASE_OBJECT *psViewer, const BASE_OBJECT *psTarget, bool wallsBlock, int *numWalls, Vector2i *wall)
 {
 	ASSERT_OR_RETURN(0, psViewer != nullptr, "Invalid viewer pointer!");
 	ASSERT_OR_RETURN(0, psTarget != nullptr, "Invalid viewed pointer!");
@@ -581,10 +640,10 @@ int visibleObject(const BASE_OBJECT *psViewer, const BASE_OBJECT *psTarget, bool
 	// Cast a ray from the viewer to the target
 	rayCast(psViewer->pos.xy(), psTarget->pos.xy(), rayLOSCallback, &help);
 
-	if (gWall != nullptr && gNumWalls != nullptr) // Out globals are set
+	if (wall != nullptr && numWalls != nullptr)
 	{
-		*gWall = help.wall;
-		*gNumWalls = help.numWalls;
+		*wall = help.wall;
+		*numWalls = help.numWalls;
 	}
 
 	bool tileWatched = psTile->watchers[psViewer->player] > 0;
@@ -612,20 +671,18 @@ int visibleObject(const BASE_OBJECT *psViewer, const BASE_OBJECT *psTarget, bool
 	return 0;
 }
 
+int visibleObject(const BASE_OBJECT *psViewer, const BASE_OBJECT *psTarget, bool wallsBlock)
+{
+	return visibleObjectImpl(psViewer, psTarget, wallsBlock, nullptr, nullptr);
+}
+
 // Find the wall that is blocking LOS to a target (if any)
 STRUCTURE *visGetBlockingWall(const BASE_OBJECT *psViewer, const BASE_OBJECT *psTarget)
 {
 	int numWalls = 0;
 	Vector2i wall;
 
-	// HACK Using globals to not clutter visibleObject() interface too much
-	gNumWalls = &numWalls;
-	gWall = &wall;
-
-	visibleObject(psViewer, psTarget, true);
-
-	gNumWalls = nullptr;
-	gWall = nullptr;
+	visibleObjectImpl(psViewer, psTarget, true, &numWalls, &wall);
 
 	// see if there was a wall in the way
 	if (numWalls > 0)
@@ -723,34 +780,78 @@ static void processVisibilitySelf(BASE_OBJECT *psObj)
 	}
 }
 
-// Calculate which objects we can see. Better to call after processVisibilitySelf, since that check is cheaper.
-static void processVisibilityVision(BASE_OBJECT *psViewer)
+// Find which objects a viewer might see, and how well. Only reads the game state, so may run on any thread.
+// Objects already fully seen by the viewer's player are skipped, which may be more than processVisibilityVision skips,
+// since they can't be seen any better.
+static void findVisibleObjects(const BASE_OBJECT *psViewer, std::vector<VisionResult> &results)
 {
-	if (psViewer->type == OBJ_FEATURE)
+	static thread_local GridList gridList;  // static to avoid allocations.
+	results.clear();
+	gridStartIterateUnseen(psViewer->pos.x, psViewer->pos.y, objSensorRange(psViewer), psViewer->player, gridList);
+	for (BASE_OBJECT *psObj : gridList)
 	{
-		return;
+		int val = visibleObject(psViewer, psObj, false);
+		if (val > 0)
+		{
+			results.push_back({psObj, val});
+		}
 	}
+}
 
-	// get all the objects from the grid the droid is in
-	// Will give inconsistent results if hasSharedVision is not an equivalence relation.
-	static GridList gridList;  // static to avoid allocations.
-	gridList = gridStartIterateUnseen(psViewer->pos.x, psViewer->pos.y, objSensorRange(psViewer), psViewer->player);
-	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
+// Process the viewers in batches, until there are none left.
+static void findVisibleObjectsForViewers()
+{
+	WZ_PROFILE_SCOPE(findVisibleObjectsForViewers);
+	const size_t numViewers = visionViewers.size();
+	for (size_t begin = visionNextViewer.fetch_add(VISION_BATCH_SIZE); begin < numViewers; begin = visionNextViewer.fetch_add(VISION_BATCH_SIZE))
 	{
-		BASE_OBJECT *psObj = *gi;
-
-		int val = visibleObject(psViewer, psObj, false);
+		for (size_t i = begin; i < std::min<size_t>(begin + VISION_BATCH_SIZE, numViewers); ++i)
+		{
+			findVisibleObjects(visionViewers[i], visionResults[i]);
+		}
+	}
+}
 
-		// If we've got ranged line of sight...
-		if (val > 0)
+static int visionThreadFunc(void *)
+{
+	while (true)
+	{
+		wzSemaphoreWait(visionSemaphore);  // Go to sleep until needed.
+		if (visionQuit)
 		{
-			// Tell system that this side can see this object
-			setSeenBy(psObj, psViewer->player, val);
+			break;
+		}
+		findVisibleObjectsForViewers();
+		wzSemaphorePost(visionDoneSemaphore);  // Signal that we are done
+	}
+	return 0;
+}
 
-			// Check if scripting system wants to trigger an event for this
-			triggerEventSeen(psViewer, psObj);
+// Calculate which objects we can see. Better to call after processVisibilitySelf, since that check is cheaper.
+// Uses the results of findVisibleObjects for the viewer, and must be called for the viewers in the same order as before,
+// since the objects that each viewer checks depend on what the previous viewers have seen.
+// Returns whether a script event was run, after which the results of the following viewers may be out of date.
+static bool processVisibilityVision(BASE_OBJECT *psViewer, std::vector<VisionResult> const &results)
+{
+	bool triggered = false;
+	// Will give inconsistent results if hasSharedVision is not an equivalence relation.
+	for (VisionResult const &result : results)
+	{
+		BASE_OBJECT *psObj = result.psObj;
+
+		// Skip objects the grid would have filtered out, since seen by previous viewers.
+		if (psObj->seenThisTick[psViewer->player] == UINT8_MAX)
+		{
+			continue;
 		}
+
+		// Tell system that this side can see this object
+		setSeenBy(psObj, psViewer->player, result.val);
+
+		// Check if scripting system wants to trigger an event for this
+		triggered = triggerEventSeen(psViewer, psObj) || triggered;
 	}
+	return triggered;
 }
 
 /* Find out what can see this object */
@@ -851,17 +952,49 @@ void processVisibility()
 			processVisibilitySelf(psObj);
 		}
 	}
+
+	// Cast the rays for all viewers in parallel, since that doesn't change anything.
+	// Then apply the results in the usual order, so that the objects seen and script events are the same for any number of threads,
+	// and the same as when casting the rays of each viewer just before applying them.
+	visionViewers.clear();
 	for (int player = 0; player < MAX_PLAYERS; ++player)
 	{
 		for (BASE_OBJECT* psObj : apsDroidLists[player])
 		{
-			processVisibilityVision(psObj);
+			visionViewers.push_back(psObj);
 		}
 		for (BASE_OBJECT* psObj : apsStructLists[player])
 		{
-			processVisibilityVision(psObj);
+			visionViewers.push_back(psObj);
 		}
 	}
+	if (visionResults.size() < visionViewers.size())
+	{
+		visionResults.resize(visionViewers.size());
+	}
+	visionNextViewer = 0;
+	const size_t numThreads = visionViewers.size() >= VISION_MIN_PARALLEL_VIEWERS ? visionThreads.size() : 0;
+	for (size_t i = 0; i < numThreads; ++i)
+	{
+		wzSemaphorePost(visionSemaphore);
+	}
+	findVisibleObjectsForViewers();
+	for (size_t i = 0; i < numThreads; ++i)
+	{
+		wzSemaphoreWait(visionDoneSemaphore);
+	}
+	bool triggered = false;
+	for (size_t i = 0; i < visionViewers.size(); ++i)
+	{
+		if (triggered)
+		{
+			// A script event run for an earlier viewer may have changed what this one sees, so cast its rays again
+			// now, as if the viewers had been processed one by one. Only happens for objects and groups with labels.
+			findVisibleObjects(visionViewers[i], visionResults[i]);
+		}
+		triggered = processVisibilityVision(visionViewers[i], visionResults[i]) || triggered;
+	}
+
 	for (const BASE_OBJECT *psObj : apsSensorList[0])
 	{
 		if (objRadarDetector(psObj))
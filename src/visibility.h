@@ -31,6 +31,9 @@
 // initialise the visibility stuff
 bool visInitialise();
 
+// shutdown the visibility stuff
+void visShutdown();
+
 /* Check which tiles can be seen by an object */
 void visTilesUpdate(BASE_OBJECT *psObj);
 
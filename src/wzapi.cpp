@@ -1278,19 +1278,72 @@ std::vector<const BASE_OBJECT *> wzapi::enumRange(WZAPI_PARAMS(int _x, int _y, i
 	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
 	{
 		const BASE_OBJECT *psObj = *gi;
-		if ((!seen || (player < MAX_PLAYERS && psObj->visible[player])) && !psObj->died)
+		if (enumObjectPasses(psObj, player, playerFilter, seen))
 		{
-			if ((playerFilter >= 0 && psObj->player == playerFilter) || playerFilter == ALL_PLAYERS
-			    || (playerFilter == ALLIES && psObj->type != OBJ_FEATURE && aiCheckAlliances(psObj->player, player))
-			    || (playerFilter == ENEMIES && psObj->type != OBJ_FEATURE && !aiCheckAlliances(psObj->player, player)))
-			{
-				list.push_back(psObj);
-			}
+			list.push_back(psObj);
 		}
 	}
 	return list;
 }
 
+bool wzapi::enumObjectPasses(const BASE_OBJECT *psObj, int player, int playerFilter, bool seen)
+{
+	if ((seen && (player < 0 || player >= MAX_PLAYERS || !psObj->visible[player])) || psObj->died)
+	{
+		return false;
+	}
+	return (playerFilter >= 0 && psObj->player == playerFilter) || playerFilter == ALL_PLAYERS
+	       || (playerFilter == ALLIES && psObj->type != OBJ_FEATURE && aiCheckAlliances(psObj->player, player))
+	       || (playerFilter == ENEMIES && psObj->type != OBJ_FEATURE && !aiCheckAlliances(psObj->player, player));
+}
+
+void wzapi::appendEnumObjects(object_id_lists &lists, const std::vector<BASE_OBJECT *> &objects, int player, int playerFilter, bool seen, optional<int> objectType)
+{
+	for (const BASE_OBJECT *psObj : objects)
+	{
+		if ((!objectType.has_value() || psObj->type == objectType.value()) && enumObjectPasses(psObj, player, playerFilter, seen))
+		{
+			lists.ids.push_back(psObj->id);
+			lists.types.push_back(psObj->type);
+			lists.players.push_back(psObj->player);
+		}
+	}
+}
+
+//-- ## enumRangeMulti(positions, range[, playerFilter[, seen[, objectType]]])
+//--
+//-- Does the same as calling ```enumRange()``` for each of the given positions, but in one call, which is
+//-- much faster for many positions. The positions are an array of objects with x and y properties, like game
+//-- objects, and the range is either one range for all positions, or an array of ranges, one for each position.
+//-- The optional objectType, which can be one of ```DROID```, ```STRUCTURE``` or ```FEATURE```, only returns
+//-- objects of that type. Instead of arrays of game objects, this returns an object of typed arrays describing
+//-- the objects found: ```ids```, ```types``` and ```players```. The objects found at the i-th position are
+//-- those from index ```offsets[i]``` up to ```offsets[i + 1]```. Use ```getObject(type, player, id)``` to get
+//-- the game objects you need. (4.7.0+ only)
+//--
+wzapi::object_id_lists wzapi::enumRangeMulti(WZAPI_PARAMS(range_queries queries, optional<int> _playerFilter, optional<bool> _seen, optional<int> _objectType))
+{
+	int player = context.player();
+	int playerFilter = _playerFilter.value_or(ALL_PLAYERS);
+	bool seen = _seen.value_or(true);
+
+	SCRIPT_ASSERT({}, context, (playerFilter >= 0 && playerFilter < MAX_PLAYERS) || playerFilter == ALL_PLAYERS || playerFilter == ALLIES || playerFilter == ENEMIES, "Filter player index out of range: %d", playerFilter);
+
+	object_id_lists lists;
+	lists.offsets.reserve(queries.queries.size() + 1);
+	static GridList gridList;  // static to avoid allocations. // WARNING: THREAD-SAFETY
+	for (const scr_radius &query : queries.queries)
+	{
+		int x = world_coord(std::min<int>(std::max<int>(query.x, 0), mapWidth));
+		int y = world_coord(std::min<int>(std::max<int>(query.y, 0), mapHeight));
+		lists.offsets.push_back(static_cast<int32_t>(lists.ids.size()));
+		gridStartIterate(x, y, world_coord(query.radius), gridList);
+		appendEnumObjects(lists, gridList, player, playerFilter, seen, _objectType);
+	}
+	lists.offsets.push_back(static_cast<int32_t>(lists.ids.size()));
+	return lists;
+}
+
 //-- ## pursueResearch(labStructure, research)
 //--
 //-- Start researching the first available technology on the way to the given technology.
@@ -2549,6 +2602,7 @@ bool wzapi::gameOverMessage(WZAPI_PARAMS(bool gameWon, optional<bool> _showBackD
 		updateChallenge(gameWon);
 	}
 	GameStoryLogger::instance().logGameOver();
+	reportReplaySimulation();
 	if (autogame_enabled())
 	{
 		debug(LOG_WARNING, "Autogame completed successfully!");
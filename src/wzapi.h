@@ -648,6 +648,9 @@ namespace wzapi
 
 		virtual bool debugEvaluateCommand(const std::string &text) = 0;
 
+		// total number of allocations made by the script engine for this instance so far (0 if not tracked)
+		virtual uint64_t debugGetAllocationCount() const { return 0; }
+
 	public:
 		// output to debug log file
 		void dumpScriptLog(const std::string &info);
@@ -656,6 +659,8 @@ namespace wzapi
 	public:
 		virtual void updateGameTime(uint32_t gameTime) = 0;
 		virtual void updateGroupSizes(int group, int size) = 0;
+		// called when an object is removed from the game, while it is still valid
+		virtual void updateObjectRemoved(const BASE_OBJECT *psObj) = 0;
 
 		// set "global" variables
 		//
@@ -820,6 +825,11 @@ namespace wzapi
 		std::string label;
 	};
 
+	struct range_queries
+	{
+		std::vector<scr_radius> queries;
+	};
+
 	// retVals
 	struct no_return_value
 	{ };
@@ -838,6 +848,17 @@ namespace wzapi
 		std::vector<const RESEARCH *> resList;
 		int player;
 	};
+	struct object_id_lists
+	{
+		std::vector<int32_t> offsets; // the objects found by query i are at [offsets[i], offsets[i + 1])
+		std::vector<uint32_t> ids;
+		std::vector<int32_t> types;
+		std::vector<int32_t> players;
+	};
+	// whether psObj passes the filters of enumRange() and enumArea()
+	bool enumObjectPasses(const BASE_OBJECT *psObj, int player, int playerFilter, bool seen);
+	// appends the objects passing the filters of enumRange() and enumArea() to the lists
+	void appendEnumObjects(object_id_lists &lists, const std::vector<BASE_OBJECT *> &objects, int player, int playerFilter, bool seen, optional<int> objectType);
 	template<typename T>
 	struct returned_nullable_ptr
 	{
@@ -1033,6 +1054,7 @@ namespace wzapi
 	researchResult getResearch(WZAPI_PARAMS(std::string researchName, optional<int> _player));
 	researchResults enumResearch(WZAPI_NO_PARAMS);
 	std::vector<const BASE_OBJECT *> enumRange(WZAPI_PARAMS(int x, int y, int range, optional<int> _playerFilter, optional<bool> _seen));
+	object_id_lists enumRangeMulti(WZAPI_PARAMS(range_queries queries, optional<int> _playerFilter, optional<bool> _seen, optional<int> _objectType));
 	bool pursueResearch(WZAPI_PARAMS(const STRUCTURE *psStruct, string_or_string_list research));
 	researchResults findResearch(WZAPI_PARAMS(std::string researchName, optional<int> _player));
 	int32_t distBetweenTwoPoints(WZAPI_PARAMS(int32_t x1, int32_t y1, int32_t x2, int32_t y2));
@@ -251,6 +251,53 @@ static RowDataModel fillTriggersModel(const std::vector<scripting_engine::timerN
 	return result;
 }
 
+static RowDataModel fillPerformanceModel(const std::vector<scripting_engine::functionPerformanceSnapshot>& performance_snapshot, wzapi::scripting_instance *context)
+{
+	RowDataModel result(8);
+	int totalCalls = 0;
+	uint64_t totalTime = 0;
+	uint64_t totalAllocations = 0;
+	for (const auto &entry : performance_snapshot)
+	{
+		if (entry.instance == context)
+		{
+			totalCalls += entry.calls;
+			totalTime += entry.time;
+			totalAllocations += entry.allocations;
+		}
+	}
+	result.newRow({"(total)", "", WzString::number(totalCalls), WzString::number(totalTime / 1000), (totalCalls > 0) ? WzString::number(totalTime / totalCalls) : "-", "", "", WzString::number(totalAllocations)}, SCRIPTDEBUG_ROW_HEIGHT);
+	for (const auto &entry : performance_snapshot)
+	{
+		if (entry.instance != context)
+		{
+			continue;
+		}
+		std::vector<WzString> columnTexts;
+		columnTexts.push_back(WzString::fromUtf8(entry.function));
+		if (entry.timerCalls == 0)
+		{
+			columnTexts.push_back("Event");
+		}
+		else if (entry.timerCalls == entry.calls)
+		{
+			columnTexts.push_back("Timer");
+		}
+		else
+		{
+			columnTexts.push_back("Timer/Event");
+		}
+		columnTexts.push_back(WzString::number(entry.calls));
+		columnTexts.push_back(WzString::number(entry.time / 1000));
+		columnTexts.push_back((entry.calls > 0) ? WzString::number(entry.time / entry.calls) : "-");
+		columnTexts.push_back(WzString::number(entry.worst));
+		columnTexts.push_back(WzString::number(entry.worstGameTime));
+		columnTexts.push_back(WzString::number(entry.allocations));
+		result.newRow(columnTexts, SCRIPTDEBUG_ROW_HEIGHT);
+	}
+	return result;
+}
+
 static nlohmann::ordered_json fillMainModel()
 {
 	const std::vector<std::string> lev_type = {
@@ -2081,6 +2128,183 @@ public:
 	wzapi::scripting_instance *viewingContext = nullptr;
 };
 
+// MARK: - WzScriptPerformancePanel
+
+class WzScriptPerformancePanel : public W_FORM
+{
+public:
+	WzScriptPerformancePanel(): W_FORM() {}
+	~WzScriptPerformancePanel() {}
+public:
+	virtual void display(int xOffset, int yOffset) override
+	{
+		// no background
+	}
+	virtual void geometryChanged() override
+	{
+		updateButton->callCalcLayout();
+		contextDropdown->callCalcLayout();
+		table->callCalcLayout();
+	}
+public:
+	static std::shared_ptr<WzScriptPerformancePanel> make(const std::shared_ptr<WZScriptDebugger>& parentScriptDebugger)
+	{
+		auto result = std::make_shared<WzScriptPerformancePanel>();
+		result->scriptDebugger = parentScriptDebugger;
+
+		// Add "Viewing Context" label
+		auto contextLabel = std::make_shared<W_LABEL>();
+		contextLabel->setFont(font_regular, WZCOL_FORM_TEXT);
+		contextLabel->setString("Performance for Context:");
+		contextLabel->setGeometry(0, 0, contextLabel->getMaxLineWidth() + 10, TAB_BUTTONS_HEIGHT);
+		contextLabel->setCacheNeverExpires(true);
+		result->attach(contextLabel);
+
+		// Add "update"/refresh button
+		result->updateButton = makeDebugButton("\u21BB"); // "↻"
+		result->updateButton->setGeometry(result->updateButton->x(), result->updateButton->y(), result->updateButton->width(), iV_GetTextLineSize(font_regular));
+		result->updateButton->setTip("Update");
+		result->attach(result->updateButton);
+		result->updateButton->addOnClickHandler([](W_BUTTON& button) {
+			auto psParent = std::dynamic_pointer_cast<WzScriptPerformancePanel>(button.parent());
+			ASSERT_OR_RETURN(, psParent != nullptr, "No parent");
+			widgScheduleTask([psParent](){
+				psParent->updatePerformanceSnapshot();
+			});
+		});
+		result->updateButton->setCalcLayout(LAMBDA_CALCLAYOUT_SIMPLE({
+			auto psParent = std::dynamic_pointer_cast<WzScriptPerformancePanel>(psWidget->parent());
+			ASSERT_OR_RETURN(, psParent != nullptr, "No parent");
+			int x0 = psParent->width() - psWidget->width();
+			int y0 = TAB_BUTTONS_HEIGHT - psWidget->height();
+			psWidget->setGeometry(x0, y0, psWidget->width(), psWidget->height());
+		}));
+
+		// Add context chooser drop-down
+		const MODELMAP& modelMap = parentScriptDebugger->getModelMap();
+		result->contextDropdown = std::make_shared<DropdownWidget>();
+		result->attach(result->contextDropdown);
+		result->contextDropdown->setListHeight(TAB_BUTTONS_HEIGHT * std::min<uint32_t>(static_cast<uint32_t>(modelMap.size()), static_cast<uint32_t>(5)));
+
+		std::unordered_map<size_t, wzapi::scripting_instance *> contextButtonMap;
+		size_t numContextButtons = 0;
+		for (auto& it : modelMap)
+		{
+			WzString buttonLabel = WzString::fromUtf8(it.first->scriptName());
+			buttonLabel += ":" + WzString::number(it.first->player());
+			auto button = makeDebugButton(buttonLabel.toUtf8().c_str());
+			result->contextDropdown->addItem(button);
+			contextButtonMap[numContextButtons] = it.first;
+			numContextButtons++;
+		}
+		result->contextDropdown->setSelectedIndex(0);
+		result->contextDropdown->setOnChange([contextButtonMap](DropdownWidget& dropdown) {
+			if (auto selectedIndex = dropdown.getSelectedIndex())
+			{
+				// Switch context
+				auto it = contextButtonMap.find(selectedIndex.value());
+				ASSERT_OR_RETURN(, it != contextButtonMap.end(), "Invalid dropdown index value");
+				auto psParent = std::dynamic_pointer_cast<WzScriptPerformancePanel>(dropdown.parent());
+				ASSERT_OR_RETURN(, psParent != nullptr, "No parent");
+				psParent->viewContext(it->second);
+			}
+		});
+		int contextDropdownX0 = contextLabel->x() + contextLabel->width();
+		result->contextDropdown->setCalcLayout([contextDropdownX0](WIDGET *psWidget) {
+			auto psParent = std::dynamic_pointer_cast<WzScriptPerformancePanel>(psWidget->parent());
+			ASSERT_OR_RETURN(, psParent != nullptr, "No parent");
+			psWidget->setGeometry(contextDropdownX0, 0, psParent->updateButton->x() - contextDropdownX0 - ACTION_BUTTON_SPACING, TAB_BUTTONS_HEIGHT);
+		});
+
+		// Create column headers for performance table
+		std::vector<TableColumn> columns;
+		for (const char *header : {"Function", "Type", "Calls", "Total (ms)", "Avg (us)", "Worst (us)", "Worst at", "Allocs"})
+		{
+			columns.push_back({createColHeaderLabel(header), TableColumn::ResizeBehavior::RESIZABLE});
+		}
+		std::vector<size_t> minimumColumnWidths;
+		for (auto& column : columns)
+		{
+			minimumColumnWidths.push_back(static_cast<size_t>(std::max<int>(std::dynamic_pointer_cast<W_LABEL>(column.columnWidget)->getMaxLineWidth(), 0)));
+		}
+
+		// Create + attach "Performance" scrollable table view
+		result->table = ScrollableTableWidget::make(columns);
+		result->attach(result->table);
+		result->table->setMinimumColumnWidths(minimumColumnWidths);
+		result->table->setCalcLayout(LAMBDA_CALCLAYOUT_SIMPLE({
+			auto psParent = std::dynamic_pointer_cast<WzScriptPerformancePanel>(psWidget->parent());
+			ASSERT_OR_RETURN(, psParent != nullptr, "No parent");
+			int oldWidth = psWidget->width();
+			int y0 = psParent->contextDropdown->y() + psParent->contextDropdown->height() + ACTION_BUTTON_ROW_SPACING;
+			psWidget->setGeometry(0, y0, psParent->width(), psParent->height() - y0);
+
+			if (oldWidth != psWidget->width())
+			{
+				psParent->resizeTableColumnWidths();
+			}
+		}));
+
+		// View the first context
+		if (!parentScriptDebugger->getModelMap().empty())
+		{
+			result->viewContext(parentScriptDebugger->getModelMap().begin()->first);
+		}
+
+		return result;
+	}
+public:
+	void viewContext(wzapi::scripting_instance *context)
+	{
+		ASSERT_OR_RETURN(, context != nullptr, "context is null");
+		if (auto scriptDebuggerStrong = scriptDebugger.lock())
+		{
+			auto model = fillPerformanceModel(scriptDebuggerStrong->getPerformanceSnapshot(), context);
+			auto oldScrollPosition = table->getScrollPosition();
+			table->clearRows();
+			if (!model.rows().empty())
+			{
+				for (auto& row : model.rows())
+				{
+					table->addRow(row);
+				}
+				currentMaxColumnWidths = model.currentMaxColumnWidths();
+				table->changeColumnWidths(model.currentMaxColumnWidths());
+				table->setScrollPosition(oldScrollPosition);
+			}
+			viewingContext = context;
+		}
+	}
+	void updatePerformanceSnapshot()
+	{
+		if (auto scriptDebuggerStrong = scriptDebugger.lock())
+		{
+			scriptDebuggerStrong->updatePerformanceSnapshot();
+			viewContext(viewingContext);
+		}
+	}
+private:
+	static std::shared_ptr<W_LABEL> createColHeaderLabel(const char* text)
+	{
+		auto label = std::make_shared<W_LABEL>();
+		label->setString(text);
+		label->setGeometry(0, 0, label->getMaxLineWidth(), 0);
+		label->setCacheNeverExpires(true);
+		return label;
+	}
+	void resizeTableColumnWidths()
+	{
+		table->changeColumnWidths(currentMaxColumnWidths);
+	}
+public:
+	std::weak_ptr<WZScriptDebugger> scriptDebugger;
+	std::shared_ptr<W_BUTTON> updateButton;
+	std::shared_ptr<DropdownWidget> contextDropdown;
+	std::shared_ptr<ScrollableTableWidget> table;
+	std::vector<size_t> currentMaxColumnWidths;
+	wzapi::scripting_instance *viewingContext = nullptr;
+};
+
 // MARK: - WzScriptMessagesPanel
 
 class WzScriptMessagesPanel : public W_FORM
@@ -2607,6 +2831,9 @@ void WZScriptDebugger::switchPanel(WZScriptDebugger::ScriptDebuggerPanel newPane
 		case ScriptDebuggerPanel::Triggers:
 			psPanel = createTriggersPanel();
 			break;
+		case ScriptDebuggerPanel::Performance:
+			psPanel = createPerformancePanel();
+			break;
 		case ScriptDebuggerPanel::Messages:
 			psPanel = createMessagesPanel();
 			break;
@@ -2640,6 +2867,7 @@ WZScriptDebugger::WZScriptDebugger(const std::shared_ptr<scripting_engine::Debug
 {
 	modelMap = debugInterface->debug_GetGlobalsSnapshot();
 	trigger_snapshot = debugInterface->debug_GetTimersSnapshot();
+	performance_snapshot = debugInterface->debug_GetPerformanceSnapshot();
 	labels = debugInterface->debug_GetLabelInfo();
 }
 
@@ -2713,6 +2941,13 @@ std::shared_ptr<WIDGET> WZScriptDebugger::createTriggersPanel()
 	return panel;
 }
 
+std::shared_ptr<WIDGET> WZScriptDebugger::createPerformancePanel()
+{
+	updatePerformanceSnapshot();
+	auto panel = WzScriptPerformancePanel::make(std::dynamic_pointer_cast<WZScriptDebugger>(shared_from_this()));
+	return panel;
+}
+
 std::shared_ptr<WIDGET> WZScriptDebugger::createMessagesPanel()
 {
 	auto panel = WzScriptMessagesPanel::make();
@@ -2787,6 +3022,7 @@ std::shared_ptr<WZScriptDebugger> WZScriptDebugger::make(const std::shared_ptr<s
 	addTextTabButton(result->pageTabs, ScriptDebuggerPanel::Contexts, "Contexts");
 	addTextTabButton(result->pageTabs, ScriptDebuggerPanel::Players, "Players");
 	addTextTabButton(result->pageTabs, ScriptDebuggerPanel::Triggers, "Triggers");
+	addTextTabButton(result->pageTabs, ScriptDebuggerPanel::Performance, "Performance");
 	addTextTabButton(result->pageTabs, ScriptDebuggerPanel::Messages, "Messages");
 	addTextTabButton(result->pageTabs, ScriptDebuggerPanel::Labels, "Labels");
 	addTextTabButton(result->pageTabs, ScriptDebuggerPanel::Graphics, "Graphics");
@@ -2826,6 +3062,11 @@ void WZScriptDebugger::updateTriggerSnapshot()
 	trigger_snapshot = debugInterface->debug_GetTimersSnapshot();
 }
 
+void WZScriptDebugger::updatePerformanceSnapshot()
+{
+	performance_snapshot = debugInterface->debug_GetPerformanceSnapshot();
+}
+
 void WZScriptDebugger::updateLabelModel()
 {
 	labels = debugInterface->debug_GetLabelInfo();
@@ -60,11 +60,13 @@ public:
 
 	const MODELMAP& getModelMap() const { return modelMap; }
 	const std::vector<scripting_engine::timerNodeSnapshot> getTriggerSnapshot() const { return trigger_snapshot; }
+	const std::vector<scripting_engine::functionPerformanceSnapshot>& getPerformanceSnapshot() const { return performance_snapshot; }
 	const std::vector<scripting_engine::LabelInfo>& getLabelModel() const { return labels; }
 
 public:
 	void updateModelMap();
 	void updateTriggerSnapshot();
+	void updatePerformanceSnapshot();
 	void updateLabelModel();
 
 protected:
@@ -80,6 +82,7 @@ private:
 	std::shared_ptr<WIDGET> createContextsPanel();
 	std::shared_ptr<WIDGET> createPlayersPanel();
 	std::shared_ptr<WIDGET> createTriggersPanel();
+	std::shared_ptr<WIDGET> createPerformancePanel();
 	std::shared_ptr<WIDGET> createMessagesPanel();
 	std::shared_ptr<WIDGET> createLabelsPanel();
 	std::shared_ptr<W_FORM> createGraphicsPanel();
@@ -91,6 +94,7 @@ private:
 		Contexts,
 		Players,
 		Triggers,
+		Performance,
 		Messages,
 		Labels,
 		Graphics
@@ -119,6 +123,7 @@ private:
 	WzText		cachedTitleText;
 	MODELMAP	modelMap;
 	std::vector<scripting_engine::timerNodeSnapshot> trigger_snapshot;
+	std::vector<scripting_engine::functionPerformanceSnapshot> performance_snapshot;
 	std::vector<scripting_engine::LabelInfo> labels;
 	nlohmann::ordered_json selectedObjectDetails;
 	optional<SelectedObjectId> selectedObjectId;
@@ -0,0 +1,214 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2025  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+// Benchmarks the batched clip space culler of lib/ivis_opengl/culling.h against the
+// std::function based half space checks it replaced, on the point light culling workload.
+// See README.txt.
+
+#include "lib/ivis_opengl/culling.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+// Same as in lib/ivis_opengl/gfx_api.h
+static const size_t bucketDimension = 8;
+
+// The null backend doesn't invert the y axis (see gfx_api_null.h)
+static const bool yAxisInverted = false;
+
+// --- The previous implementation, as the reference ---
+
+using HalfSpaceCheck = std::function<bool(const glm::vec3&)>;
+using IntersectionOfHalfSpace = std::array<HalfSpaceCheck, 6>;
+
+static bool isBBoxInClipSpace(const IntersectionOfHalfSpace& intersectionOfHalfSpace, const BoundingBox& points)
+{
+	auto CheckAllPointsInSpace = [&points](const HalfSpaceCheck& predicate)
+		{
+			return std::all_of(points.begin(), points.end(), [&predicate](const auto& v) { return !predicate(v); });
+		};
+
+	for (const auto& predicate : intersectionOfHalfSpace)
+	{
+		if (CheckAllPointsInSpace(predicate))
+			return false;
+	}
+	return true;
+}
+
+static IntersectionOfHalfSpace halfSpaces(const ClipSpaceBounds& region)
+{
+	return IntersectionOfHalfSpace{
+		[region](const glm::vec3& in) { return in.x >= region.min.x; },
+		[region](const glm::vec3& in) { return in.x <= region.max.x; },
+		[region](const glm::vec3& in) { return (yAxisInverted ? -in.y : in.y) >= region.min.y; },
+		[region](const glm::vec3& in) { return (yAxisInverted ? -in.y : in.y) <= region.max.y; },
+		[region](const glm::vec3& in) { return in.z >= region.min.z; },
+		[region](const glm::vec3& in) { return in.z <= region.max.z; }
+	};
+}
+
+// --- Workload ---
+
+/// The view frustum, then the buckets of the point light grid
+static std::vector<ClipSpaceBounds> cullingRegions()
+{
+	std::vector<ClipSpaceBounds> regions = {viewFrustumClipSpaceBounds};
+	for (size_t i = 0; i < bucketDimension; i++)
+	{
+		for (size_t j = 0; j < bucketDimension; j++)
+		{
+			regions.push_back({
+				glm::vec3(-1.f + 2 * static_cast<float>(i) / bucketDimension, -1.f + 2 * static_cast<float>(j) / bucketDimension, 0.f),
+				glm::vec3(-1.f + 2 * static_cast<float>(i + 1) / bucketDimension, -1.f + 2 * static_cast<float>(j + 1) / bucketDimension, 1.f)
+			});
+		}
+	}
+	return regions;
+}
+
+/// Light sized boxes scattered over a map, around the camera
+static std::vector<BoundingBox> randomBoxes(size_t count, unsigned seed)
+{
+	std::mt19937 gen(seed);
+	std::uniform_real_distribution<float> position(-8192.f, 8192.f);
+	std::uniform_real_distribution<float> height(0.f, 1024.f);
+	std::uniform_real_distribution<float> range(64.f, 768.f);
+	std::vector<BoundingBox> boxes;
+	boxes.reserve(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		const glm::vec3 center(position(gen), height(gen), position(gen));
+		const float r = range(gen);
+		BoundingBox box;
+		for (size_t corner = 0; corner < box.size(); corner++)
+		{
+			box[corner] = center + glm::vec3((corner & 1) ? r : -r, (corner & 2) ? r : -r, (corner & 4) ? r : -r);
+		}
+		boxes.push_back(box);
+	}
+	return boxes;
+}
+
+static double cpuTime()
+{
+	return double(clock()) / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char **argv)
+{
+	size_t count = 4096;
+	int repeat = 200;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--count") == 0 && i + 1 < argc)
+		{
+			count = std::max(1, atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc)
+		{
+			repeat = std::max(1, atoi(argv[++i]));
+		}
+		else
+		{
+			fprintf(stderr, "Usage: %s [--count N] [--repeat N]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	const glm::mat4 projection = glm::perspective(glm::radians(60.f), 16.f / 9.f, 330.f, 16000.f);
+	const glm::mat4 view = glm::lookAt(glm::vec3(0.f, 2500.f, -3000.f), glm::vec3(0.f, 0.f, 0.f), glm::vec3(0.f, 1.f, 0.f));
+	const glm::mat4 worldViewProjectionMatrix = projection * view;
+
+	const std::vector<BoundingBox> boxes = randomBoxes(count, 1234);
+	const std::vector<ClipSpaceBounds> regions = cullingRegions();
+	std::vector<IntersectionOfHalfSpace> regionHalfSpaces;
+	for (const auto& region : regions)
+	{
+		regionHalfSpaces.push_back(halfSpaces(region));
+	}
+
+	// Both project the boxes every frame, as the lighting manager does
+	std::vector<BoundingBox> clipSpaceBoxes(count);
+	std::vector<uint8_t> referenceVisible(count * regions.size());
+	size_t referenceHits = 0;
+	const double referenceStart = cpuTime();
+	for (int r = 0; r < repeat; r++)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			clipSpaceBoxes[i] = transformBoundingBox(worldViewProjectionMatrix, boxes[i]);
+		}
+		for (size_t region = 0; region < regions.size(); region++)
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				referenceVisible[region * count + i] = isBBoxInClipSpace(regionHalfSpaces[region], clipSpaceBoxes[i]);
+			}
+		}
+	}
+	const double referenceTime = cpuTime() - referenceStart;
+
+	ClipSpaceBoundsList boundsList;
+	std::vector<uint8_t> visible;
+	std::vector<uint8_t> batchedVisible(count * regions.size());
+	const double batchedStart = cpuTime();
+	for (int r = 0; r < repeat; r++)
+	{
+		boundsList.clear();
+		boundsList.reserve(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			boundsList.push_back(clipSpaceBounds(transformBoundingBox(worldViewProjectionMatrix, boxes[i]), yAxisInverted));
+		}
+		for (size_t region = 0; region < regions.size(); region++)
+		{
+			boundsList.intersect(regions[region], visible);
+			std::copy(visible.begin(), visible.end(), batchedVisible.begin() + region * count);
+		}
+	}
+	const double batchedTime = cpuTime() - batchedStart;
+
+	size_t mismatches = 0;
+	for (size_t i = 0; i < referenceVisible.size(); i++)
+	{
+		referenceHits += referenceVisible[i];
+		mismatches += (referenceVisible[i] != batchedVisible[i]);
+	}
+
+	const double tests = double(count) * regions.size() * repeat;
+	printf("%zu boxes, %zu regions, %d frames, %zu hits per frame\n\n", count, regions.size(), repeat, referenceHits);
+	printf("%-24s %12s %14s\n", "culler", "ms/frame", "Mtests/s");
+	printf("%-24s %12.3f %14.1f\n", "std::function", referenceTime * 1000 / repeat, tests / referenceTime / 1e6);
+	printf("%-24s %12.3f %14.1f\n", "batched", batchedTime * 1000 / repeat, tests / batchedTime / 1e6);
+	if (mismatches != 0)
+	{
+		fprintf(stderr, "Results differ for %zu tests!\n", mismatches);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,404 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2025  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+// Benchmarks the compression algorithms for net messages on the message streams of replays.
+// See README.txt.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <zlib.h>
+#if defined(WZ_NETPLAY_ZSTD)
+# include <zstd.h>
+#endif
+
+typedef std::vector<uint8_t> Buffer;
+
+/// Output buffer for decompression, like the receive buffer of a connection.
+static uint8_t scratch[65536];
+
+/// The messages sent in one go (by one player, in a row), as they are written to a connection.
+typedef std::vector<Buffer> Chunk;
+
+static const uint32_t magicReplayNumber = 0x575A7270;  // "WZrp"
+static const uint8_t REPLAY_ENDED = 255;
+
+static uint32_t loadBE32(const uint8_t *p)
+{
+	return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+static bool readFile(const char *path, Buffer &data)
+{
+	FILE *fp = fopen(path, "rb");
+	if (!fp)
+	{
+		return false;
+	}
+	uint8_t buf[65536];
+	size_t read;
+	while ((read = fread(buf, 1, sizeof(buf), fp)) > 0)
+	{
+		data.insert(data.end(), buf, buf + read);
+	}
+	fclose(fp);
+	return true;
+}
+
+/// Extracts the net messages of a replay (see lib/netplay/netreplay.cpp for the format).
+static bool loadReplay(const char *path, std::vector<Chunk> &chunks, size_t &messageCount)
+{
+	Buffer data;
+	if (!readFile(path, data))
+	{
+		fprintf(stderr, "%s: Failed to read file\n", path);
+		return false;
+	}
+	size_t pos = 0;
+	auto have = [&](size_t size) { return data.size() - pos >= size; };
+
+	if (!have(8) || loadBE32(&data[0]) != magicReplayNumber)
+	{
+		fprintf(stderr, "%s: Not a replay file\n", path);
+		return false;
+	}
+	const uint32_t settingsSize = loadBE32(&data[4]);
+	pos = 8;
+	if (!have(settingsSize))
+	{
+		fprintf(stderr, "%s: Truncated header\n", path);
+		return false;
+	}
+	const std::string settings(data.begin() + pos, data.begin() + pos + settingsSize);
+	pos += settingsSize;
+
+	// Format versions >= 2 embed the map data after the settings.
+	const size_t verPos = settings.find("\"replayFormatVer\"");
+	const size_t colonPos = settings.find(':', verPos);
+	const unsigned long formatVer = (verPos != std::string::npos && colonPos != std::string::npos) ? strtoul(settings.c_str() + colonPos + 1, nullptr, 10) : 0;
+	if (formatVer >= 2)
+	{
+		if (!have(8))
+		{
+			fprintf(stderr, "%s: Truncated map data\n", path);
+			return false;
+		}
+		const uint32_t mapDataSize = loadBE32(&data[pos + 4]);
+		pos += 8;
+		if (!have(mapDataSize))
+		{
+			fprintf(stderr, "%s: Truncated map data\n", path);
+			return false;
+		}
+		pos += mapDataSize;
+	}
+
+	// Each message is stored as: player (1 byte), followed by the message as sent over the network:
+	// type (1 byte), payload length (2 bytes, big endian), payload.
+	int lastPlayer = -1;
+	while (have(4))
+	{
+		const uint8_t player = data[pos];
+		const uint8_t type = data[pos + 1];
+		const size_t length = (size_t(data[pos + 2]) << 8) | data[pos + 3];
+		if (type == REPLAY_ENDED || !have(4 + length))
+		{
+			break;
+		}
+		if (player != lastPlayer || chunks.empty())
+		{
+			chunks.emplace_back();
+			lastPlayer = player;
+		}
+		chunks.back().emplace_back(data.begin() + pos + 1, data.begin() + pos + 4 + length);
+		pos += 4 + length;
+		++messageCount;
+	}
+	return true;
+}
+
+/// Compresses like the `ICompressionAdapter` implementations in lib/netplay do.
+class Codec
+{
+public:
+	virtual ~Codec() = default;
+	virtual const char *name() const = 0;
+	/// Compresses a message into `out`.
+	virtual void compress(const uint8_t *src, size_t size, Buffer &out) = 0;
+	/// Flushes everything compressed so far into `out`, like `IClientConnection::flush()`.
+	virtual void flush(Buffer &out) = 0;
+	/// Decompresses `size` bytes of `src` (as made by `compress()` and `flush()`), appending to `out`.
+	virtual bool decompress(const uint8_t *src, size_t size, Buffer &out) = 0;
+};
+
+class ZlibCodec : public Codec
+{
+public:
+	explicit ZlibCodec(int level)
+		: level_(level)
+	{
+		name_ = "zlib " + std::to_string(level);
+		memset(&deflateStream_, 0, sizeof(deflateStream_));
+		memset(&inflateStream_, 0, sizeof(inflateStream_));
+		deflateInit(&deflateStream_, level_);
+		inflateInit(&inflateStream_);
+	}
+	~ZlibCodec() override
+	{
+		deflateEnd(&deflateStream_);
+		inflateEnd(&inflateStream_);
+	}
+	const char *name() const override
+	{
+		return name_.c_str();
+	}
+	void compress(const uint8_t *src, size_t size, Buffer &out) override
+	{
+		deflateStream_.next_in = const_cast<Bytef *>(src);
+		deflateStream_.avail_in = static_cast<uInt>(size);
+		deflateToBuffer(out, size + 20, Z_NO_FLUSH);
+	}
+	void flush(Buffer &out) override
+	{
+		deflateStream_.next_in = nullptr;
+		deflateStream_.avail_in = 0;
+		deflateToBuffer(out, 1000, Z_PARTIAL_FLUSH);
+	}
+	bool decompress(const uint8_t *src, size_t size, Buffer &out) override
+	{
+		inflateStream_.next_in = const_cast<Bytef *>(src);
+		inflateStream_.avail_in = static_cast<uInt>(size);
+		do
+		{
+			inflateStream_.next_out = scratch;
+			inflateStream_.avail_out = sizeof(scratch);
+			const int ret = inflate(&inflateStream_, Z_NO_FLUSH);
+			if (ret != Z_OK && ret != Z_BUF_ERROR)
+			{
+				return false;
+			}
+			out.insert(out.end(), scratch, scratch + sizeof(scratch) - inflateStream_.avail_out);
+		} while (inflateStream_.avail_in > 0 || inflateStream_.avail_out == 0);
+		return true;
+	}
+
+private:
+	void deflateToBuffer(Buffer &out, size_t extraSpace, int flush)
+	{
+		do
+		{
+			const size_t alreadyHave = out.size();
+			out.resize(alreadyHave + extraSpace);
+			deflateStream_.next_out = &out[alreadyHave];
+			deflateStream_.avail_out = static_cast<uInt>(out.size() - alreadyHave);
+			deflate(&deflateStream_, flush);
+			out.resize(out.size() - deflateStream_.avail_out);
+		} while (deflateStream_.avail_out == 0);
+	}
+
+	int level_;
+	std::string name_;
+	z_stream deflateStream_;
+	z_stream inflateStream_;
+};
+
+#if defined(WZ_NETPLAY_ZSTD)
+class ZstdCodec : public Codec
+{
+public:
+	ZstdCodec(int level, int windowLog)
+	{
+		name_ = "zstd " + std::to_string(level) + " (window 2^" + std::to_string(windowLog) + ")";
+		compressStream_ = ZSTD_createCCtx();
+		ZSTD_CCtx_setParameter(compressStream_, ZSTD_c_compressionLevel, level);
+		ZSTD_CCtx_setParameter(compressStream_, ZSTD_c_windowLog, windowLog);
+		decompressStream_ = ZSTD_createDCtx();
+		ZSTD_DCtx_setParameter(decompressStream_, ZSTD_d_windowLogMax, windowLog);
+	}
+	~ZstdCodec() override
+	{
+		ZSTD_freeCCtx(compressStream_);
+		ZSTD_freeDCtx(decompressStream_);
+	}
+	const char *name() const override
+	{
+		return name_.c_str();
+	}
+	void compress(const uint8_t *src, size_t size, Buffer &out) override
+	{
+		ZSTD_inBuffer input = { src, size, 0 };
+		compressToBuffer(out, input, ZSTD_compressBound(size), ZSTD_e_continue);
+	}
+	void flush(Buffer &out) override
+	{
+		ZSTD_inBuffer input = { nullptr, 0, 0 };
+		compressToBuffer(out, input, 1000, ZSTD_e_flush);
+	}
+	bool decompress(const uint8_t *src, size_t size, Buffer &out) override
+	{
+		ZSTD_inBuffer input = { src, size, 0 };
+		ZSTD_outBuffer output;
+		do
+		{
+			output = { scratch, sizeof(scratch), 0 };
+			const size_t ret = ZSTD_decompressStream(decompressStream_, &output, &input);
+			if (ZSTD_isError(ret))
+			{
+				return false;
+			}
+			out.insert(out.end(), scratch, scratch + output.pos);
+		} while (input.pos < input.size || output.pos == output.size);
+		return true;
+	}
+
+private:
+	void compressToBuffer(Buffer &out, ZSTD_inBuffer &input, size_t extraSpace, ZSTD_EndDirective mode)
+	{
+		size_t ret;
+		do
+		{
+			const size_t alreadyHave = out.size();
+			out.resize(alreadyHave + extraSpace);
+			ZSTD_outBuffer output = { &out[alreadyHave], extraSpace, 0 };
+			ret = ZSTD_compressStream2(compressStream_, &output, &input, mode);
+			out.resize(alreadyHave + output.pos);
+		} while (!ZSTD_isError(ret) && (input.pos < input.size || (mode != ZSTD_e_continue && ret != 0)));
+	}
+
+	std::string name_;
+	ZSTD_CCtx *compressStream_;
+	ZSTD_DCtx *decompressStream_;
+};
+#endif
+
+typedef std::unique_ptr<Codec> (*CodecFactory)();
+
+static const CodecFactory codecs[] = {
+	// Used by all builds, see ZlibCompressionAdapter.
+	[]() -> std::unique_ptr<Codec> { return std::unique_ptr<Codec>(new ZlibCodec(6)); },
+	[]() -> std::unique_ptr<Codec> { return std::unique_ptr<Codec>(new ZlibCodec(1)); },
+#if defined(WZ_NETPLAY_ZSTD)
+	// Used when both sides support it, see ZstdCompressionAdapter.
+	[]() -> std::unique_ptr<Codec> { return std::unique_ptr<Codec>(new ZstdCodec(3, 19)); },
+	[]() -> std::unique_ptr<Codec> { return std::unique_ptr<Codec>(new ZstdCodec(1, 19)); },
+	[]() -> std::unique_ptr<Codec> { return std::unique_ptr<Codec>(new ZstdCodec(-1, 19)); },
+#endif
+};
+
+static double cpuSeconds()
+{
+	return double(clock()) / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char **argv)
+{
+	int repeat = 5;
+	std::vector<Chunk> chunks;
+	size_t messageCount = 0;
+	size_t rawBytes = 0;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc)
+		{
+			repeat = std::max(1, atoi(argv[++i]));
+			continue;
+		}
+		if (!loadReplay(argv[i], chunks, messageCount))
+		{
+			return 1;
+		}
+	}
+	if (chunks.empty())
+	{
+		fprintf(stderr, "Usage: %s [--repeat N] replay.wzrp [replay.wzrp ...]\n", argv[0]);
+		return 1;
+	}
+
+	Buffer original;
+	for (const Chunk &chunk : chunks)
+	{
+		for (const Buffer &message : chunk)
+		{
+			original.insert(original.end(), message.begin(), message.end());
+		}
+	}
+	rawBytes = original.size();
+	printf("%zu messages, %zu flushes, %zu bytes\n\n", messageCount, chunks.size(), rawBytes);
+	printf("%-24s %12s %8s %14s %14s\n", "algorithm", "compressed", "ratio", "compress MB/s", "decompress MB/s");
+
+	for (CodecFactory factory : codecs)
+	{
+		double compressTime = 0, decompressTime = 0;
+		size_t compressedBytes = 0;
+		std::string name;
+		for (int r = 0; r < repeat; ++r)
+		{
+			std::unique_ptr<Codec> codec = factory();
+			name = codec->name();
+
+			// Compress, keeping what each flush sends, like the connection would.
+			std::vector<Buffer> sent;
+			sent.reserve(chunks.size());
+			Buffer out;
+			double start = cpuSeconds();
+			for (const Chunk &chunk : chunks)
+			{
+				for (const Buffer &message : chunk)
+				{
+					codec->compress(message.data(), message.size(), out);
+				}
+				codec->flush(out);
+				sent.push_back(out);
+				out.clear();
+			}
+			compressTime += cpuSeconds() - start;
+
+			compressedBytes = 0;
+			Buffer decompressed;
+			decompressed.reserve(rawBytes);
+			start = cpuSeconds();
+			for (const Buffer &packet : sent)
+			{
+				if (!codec->decompress(packet.data(), packet.size(), decompressed))
+				{
+					fprintf(stderr, "%s: Decompression failed\n", name.c_str());
+					return 1;
+				}
+				compressedBytes += packet.size();
+			}
+			decompressTime += cpuSeconds() - start;
+
+			if (decompressed != original)
+			{
+				fprintf(stderr, "%s: Decompressed data doesn't match\n", name.c_str());
+				return 1;
+			}
+		}
+		const double megabytes = double(rawBytes) * repeat / (1024 * 1024);
+		printf("%-24s %12zu %7.2fx %14.1f %14.1f\n", name.c_str(), compressedBytes, double(rawBytes) / compressedBytes,
+			megabytes / std::max(compressTime, 1e-9), megabytes / std::max(decompressTime, 1e-9));
+	}
+	return 0;
+}